@@ -16,7 +16,7 @@
 
 console.log('Renderer process started');
 
-let ipcRenderer, SerialHandler, CSVExporter, ToolLibrary, GeometryCalculator, UndoManager, ThreeViewer;
+let ipcRenderer, SerialHandler, CSVExporter, ToolLibrary, GeometryCalculator, UndoManager, ThreeViewer, LatencyTracer;
 
 try {
     ({ ipcRenderer } = require('electron'));
@@ -26,6 +26,7 @@ try {
     GeometryCalculator = require('./src/geometry-calculator');
     UndoManager = require('./src/undo-manager');
     ThreeViewer = require('./src/three-viewer');
+    LatencyTracer = require('./src/latency-trace');
     console.log('All modules loaded successfully');
 } catch (error) {
     console.error('Error loading modules:', error);
@@ -40,6 +41,8 @@ const csvExporter = new CSVExporter();
 const toolLibrary = new ToolLibrary();
 const geometryCalc = new GeometryCalculator();
 const undoManager = new UndoManager(50);
+const latencyTracer = new LatencyTracer();
+serialHandler.setTracer(latencyTracer);
 let threeViewer = null;
 
 let isRecording = false;
@@ -127,6 +130,7 @@ function setupEventListeners() {
     document.getElementById('save-settings-btn').addEventListener('click', saveSettings);
     document.getElementById('send-ppr-btn').addEventListener('click', sendEncoderPPR);
     document.getElementById('send-dimensions-btn').addEventListener('click', sendDimensions);
+    document.getElementById('save-trace-btn').addEventListener('click', saveLatencyTrace);
 
     // Tool modal
     document.getElementById('close-tool-modal').addEventListener('click', closeToolManager);
@@ -187,6 +191,7 @@ function handleKeyboard(e) {
 function initThreeViewer() {
     try {
         threeViewer = new ThreeViewer('three-viewer-container');
+        threeViewer.onFrameRendered(() => latencyTracer.framePresented());
         addLog('3D viewer initialized', 'success');
 
         // Add screenshot button handler
@@ -271,8 +276,10 @@ async function toggleConnection() {
             // Connected to regular hardware
             updateInstructionBar(); // Update instruction bar for hardware connection
         }
+        if (result.success) applyLatencyTrace();
     } else {
         await serialHandler.disconnect();
+        latencyTracer.stop();
         btn.textContent = 'Connect';
         updateConnectionStatus(false);
         enableControlButtons(false);
@@ -327,6 +334,7 @@ function handleSerialData(data) {
             };
             updatePositionDisplay();
             updateAnglesDisplay();
+            latencyTracer.positionDelivered(data.trace);
             break;
 
         case 'simulation_finished':
@@ -1093,9 +1101,14 @@ function saveSettings() {
             link2: document.getElementById('link2-input').value,
             link3: document.getElementById('link3-input').value,
             link4: document.getElementById('link4-input').value
+        },
+        latencyTrace: {
+            enabled: document.getElementById('trace-enabled-input').checked,
+            interval: document.getElementById('trace-interval-input').value
         }
     }));
 
+    applyLatencyTrace();
     closeSettings();
     addLog('Settings saved', 'success');
 }
@@ -1114,12 +1127,61 @@ function loadSettings() {
                 document.getElementById('link3-input').value = settings.dimensions.link3;
                 document.getElementById('link4-input').value = settings.dimensions.link4;
             }
+            if (settings.latencyTrace) {
+                document.getElementById('trace-enabled-input').checked = settings.latencyTrace.enabled;
+                document.getElementById('trace-interval-input').value = settings.latencyTrace.interval;
+            }
         }
     } catch (error) {
         console.error('Error loading settings:', error);
     }
 }
 
+// ============================================================================
+// LATENCY TRACING
+// ============================================================================
+// SETTRACE on the arm, matching stamps in the app (src/latency-trace.js).
+// The saved CSV is read by Host_Tools ccm_latency.
+function applyLatencyTrace() {
+    if (!serialHandler.getConnectionStatus() || isSimulatorMode) return;
+
+    const enabled = document.getElementById('trace-enabled-input').checked;
+    const interval = parseInt(document.getElementById('trace-interval-input').value);
+
+    if (enabled) {
+        if (isNaN(interval) || interval < 1 || interval > 1000) {
+            addLog('Invalid trace interval - must be 1 to 1000', 'error');
+            return;
+        }
+        serialHandler.sendCommand(`SETTRACE ${interval}`);
+        latencyTracer.start();
+        addLog(`Latency tracing: every ${interval} position lines`, 'info');
+    } else if (latencyTracer.enabled) {
+        serialHandler.sendCommand('SETTRACE OFF');
+        latencyTracer.stop();
+        addLog('Latency tracing off', 'info');
+    }
+}
+
+async function saveLatencyTrace() {
+    if (latencyTracer.getRecordCount() === 0) {
+        alert('No traced lines yet - enable latency tracing and stream some points');
+        return;
+    }
+
+    const result = await ipcRenderer.invoke('save-csv-dialog');
+
+    if (!result.canceled && result.filePath) {
+        const writeResult = await ipcRenderer.invoke('write-file', result.filePath, latencyTracer.toCSV());
+
+        if (writeResult.success) {
+            addLog(`Latency trace saved: ${result.filePath} (${latencyTracer.getRecordCount()} lines)`, 'success');
+        } else {
+            addLog(`Saving trace failed: ${writeResult.error}`, 'error');
+        }
+    }
+}
+
 // ============================================================================
 // TOOL MANAGEMENT
 // ============================================================================
@@ -0,0 +1,87 @@
+/*
+ * ============================================================================
+ * BRIDGE TRANSPORT MODULE
+ * ============================================================================
+ *
+ * Connects to a ccm_bridge service (Host_Tools) instead of opening the
+ * serial port, so the app can share the arm with other local programs.
+ * Presents the same small interface as SerialPort and SimulatorEngine
+ * (open, close, write, pipe, isOpen and the open / error / close events).
+ *
+ * Address forms: a Unix socket path ("/tmp/ccm_bridge.sock") or a TCP port
+ * on this machine ("5760").
+ */
+
+const EventEmitter = require('events');
+const net = require('net');
+
+class BridgeTransport extends EventEmitter {
+    constructor(address) {
+        super();
+        this.address = address;
+        this.socket = null;
+        this.isOpen = false;
+    }
+
+    static connectOptions(address) {
+        return /^\d+$/.test(address)
+            ? { host: '127.0.0.1', port: parseInt(address) }
+            : { path: address };
+    }
+
+    open(callback) {
+        let settled = false;
+        this.socket = net.createConnection(BridgeTransport.connectOptions(this.address));
+        this.socket.setNoDelay?.(true);
+
+        this.socket.on('connect', () => {
+            settled = true;
+            this.isOpen = true;
+            this.emit('open');
+            if (callback) callback(null);
+        });
+
+        this.socket.on('data', (data) => this.emit('data', data));
+
+        this.socket.on('error', (err) => {
+            if (!settled) {
+                settled = true;
+                if (callback) callback(err);
+                return;
+            }
+            this.emit('error', err);
+        });
+
+        this.socket.on('close', () => {
+            if (!this.isOpen) return;
+            this.isOpen = false;
+            this.emit('close');
+        });
+    }
+
+    close(callback) {
+        if (!this.socket || !this.isOpen) {
+            if (callback) callback(null);
+            return;
+        }
+        this.socket.once('close', () => { if (callback) callback(null); });
+        this.socket.end();
+    }
+
+    write(data, callback) {
+        if (!this.isOpen) {
+            if (callback) callback(new Error('Bridge not connected'));
+            return false;
+        }
+        return this.socket.write(data, callback);
+    }
+
+    pipe(destination) {
+        this.on('data', (data) => {
+            destination.write(data);
+        });
+        return destination;
+    }
+}
+
+module.exports = BridgeTransport;
@@ -120,8 +120,10 @@ class CSVExporter {
 
         let csv = '';
 
-        // Header
-        csv += 'Point,Type,X,Y,Z,GeometryID,Timestamp\n';
+        // Header. The unit is part of the column names so readers
+        // (Host_Tools ccm_export) know what the numbers are in.
+        const unit = units === 'inches' ? 'in' : 'mm';
+        csv += `Point,Type,X (${unit}),Y (${unit}),Z (${unit}),GeometryID,Timestamp\n`;
 
         // Add each point
         this.points.forEach(point => {
@@ -221,6 +223,14 @@ class CSVExporter {
                 return { success: false, error: 'Invalid CSV file' };
             }
 
+            // Points are kept in mm. Older files have no unit in the
+            // header and were written in mm unless exported in inches.
+            const unit = this.headerUnit(lines[0]);
+            if (unit === null) {
+                return { success: false, error: `Unknown units in CSV header: ${lines[0].trim()}` };
+            }
+            const toMm = unit === 'in' ? this.inchesToMm.bind(this) : (v) => v;
+
             this.clearPoints();
 
             // Find where geometry section starts
@@ -241,9 +251,9 @@ class CSVExporter {
                 const parts = lines[i].split(',');
                 if (parts.length >= 5) {
                     this.addPoint(
-                        parseFloat(parts[2]),
-                        parseFloat(parts[3]),
-                        parseFloat(parts[4]),
+                        toMm(parseFloat(parts[2])),
+                        toMm(parseFloat(parts[3])),
+                        toMm(parseFloat(parts[4])),
                         parts[1],
                         parts[5] || null,
                         parts[6] ? parseInt(parts[6]) : null
@@ -257,6 +267,14 @@ class CSVExporter {
         }
     }
 
+    // 'mm' or 'in' from an "X (mm)" header, 'mm' for an older "X" header,
+    // null for a unit we do not know
+    headerUnit(header) {
+        const match = header.split(',')[2]?.trim().match(/^X(?: \((.*)\))?$/);
+        if (!match || match[1] === undefined) return 'mm';
+        return match[1] === 'mm' || match[1] === 'in' ? match[1] : null;
+    }
+
     // ========================================================================
     // STATISTICS
     // ========================================================================
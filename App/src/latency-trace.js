@@ -0,0 +1,136 @@
+/*
+ * ============================================================================
+ * LATENCY TRACE MODULE
+ * ============================================================================
+ *
+ * Host half of end-to-end latency tracing. With tracing on, the firmware
+ * (SETTRACE n) follows every nth POS line with
+ * TRC,timestamp,snapshotUs,enqueueUs,txDoneUs. This module adds the app's
+ * own times for the same line and collects one record per traced line:
+ *
+ *   received  - the serial chunk holding the line ending arrived
+ *   parsed    - the line was split into a position
+ *   delivered - the renderer's handler had updated the position display
+ *               (serial data is read in the renderer, so there is no IPC
+ *               hop between the port and the UI)
+ *   presented - the animation frame that draws it had rendered
+ *
+ * Host times are epoch milliseconds with sub-millisecond resolution
+ * (performance.timeOrigin + performance.now()). Device times are raw
+ * micros(); Host_Tools ccm_latency maps them onto the host clock.
+ *
+ * Every POS line is stamped while tracing, because the TRC line naming it
+ * only comes after it. The last RECENT_LINES are kept to be matched.
+ */
+
+const RECENT_LINES = 64;
+const MAX_RECORDS = 100000;
+
+const CSV_HEADER = 'timestamp,snapshot_us,enqueue_us,tx_done_us,' +
+    'received_ms,parsed_ms,delivered_ms,presented_ms';
+
+class LatencyTracer {
+    constructor() {
+        this.enabled = false;
+        this.lastChunkMs = 0;
+        this.recent = [];          // Stamped POS lines waiting for their TRC line
+        this.awaitingFrame = [];   // Delivered, not drawn yet
+        this.records = [];         // Complete: matched with a TRC line
+        this.unmatched = 0;        // TRC lines whose POS line was not seen
+    }
+
+    static now() {
+        return performance.timeOrigin + performance.now();
+    }
+
+    start() {
+        this.clear();
+        this.enabled = true;
+    }
+
+    stop() {
+        this.enabled = false;
+        this.recent = [];
+        this.awaitingFrame = [];
+    }
+
+    clear() {
+        this.recent = [];
+        this.awaitingFrame = [];
+        this.records = [];
+        this.unmatched = 0;
+    }
+
+    getRecordCount() {
+        return this.records.length;
+    }
+
+    // Bytes arrived from the port (before they are split into lines)
+    chunkReceived() {
+        if (this.enabled) this.lastChunkMs = LatencyTracer.now();
+    }
+
+    // A POS line has been parsed; returns its entry, to be passed on
+    positionParsed(timestamp) {
+        if (!this.enabled) return null;
+        const entry = {
+            timestamp,
+            snapshotUs: null,
+            enqueueUs: null,
+            txDoneUs: null,
+            receivedMs: this.lastChunkMs,
+            parsedMs: LatencyTracer.now(),
+            deliveredMs: null,
+            presentedMs: null
+        };
+        this.recent.push(entry);
+        if (this.recent.length > RECENT_LINES) this.recent.shift();
+        return entry;
+    }
+
+    // The UI has taken the position
+    positionDelivered(entry) {
+        if (!entry) return;
+        entry.deliveredMs = LatencyTracer.now();
+        this.awaitingFrame.push(entry);
+    }
+
+    // A frame has been rendered (called by the 3D viewer after each frame)
+    framePresented() {
+        if (this.awaitingFrame.length === 0) return;
+        const now = LatencyTracer.now();
+        for (const entry of this.awaitingFrame) entry.presentedMs = now;
+        this.awaitingFrame = [];
+    }
+
+    // TRC,timestamp,snapshotUs,enqueueUs,txDoneUs
+    traceReceived(parts) {
+        if (!this.enabled || parts.length < 5) return;
+        const timestamp = parseInt(parts[1]);
+        const index = this.recent.findIndex(entry => entry.timestamp === timestamp);
+        if (index < 0) {
+            this.unmatched++;
+            return;
+        }
+        const entry = this.recent[index];
+        this.recent.splice(0, index + 1);  // Older lines were not traced
+
+        entry.snapshotUs = parseInt(parts[2]);
+        entry.enqueueUs = parseInt(parts[3]);
+        entry.txDoneUs = parseInt(parts[4]);
+        if (this.records.length < MAX_RECORDS) this.records.push(entry);
+    }
+
+    // One row per traced line; a stage not reached is left empty
+    toCSV() {
+        const field = (value) => value === null ? '' : String(value);
+        const ms = (value) => value === null ? '' : value.toFixed(3);
+        const rows = this.records.map(r => [
+            field(r.timestamp), field(r.snapshotUs), field(r.enqueueUs), field(r.txDoneUs),
+            ms(r.receivedMs), ms(r.parsedMs), ms(r.deliveredMs), ms(r.presentedMs)
+        ].join(','));
+        return [CSV_HEADER, ...rows].join('\n') + '\n';
+    }
+}
+
+module.exports = LatencyTracer;
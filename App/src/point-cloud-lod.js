@@ -0,0 +1,271 @@
+/*
+ * ============================================================================
+ * POINT CLOUD LEVEL OF DETAIL MODULE
+ * ============================================================================
+ *
+ * Draws streamed (LIVE) points for the 3D viewer without drawing all of
+ * them. Points go into the octree of Host_Tools/src/point_octree.h,
+ * compiled to WebAssembly as src/point-octree.wasm (build line in
+ * Host_Tools/README.md). Every frame:
+ *
+ *   1. Points added since the last frame are inserted in one call
+ *   2. The octree picks the nodes this camera needs: inside the view, and
+ *      refined until the point spacing is below errorPixels on screen, at
+ *      most pointBudget points in all
+ *   3. Each picked node is one THREE.Points. A node only ever grows, so
+ *      only the points appended since its last upload are copied and sent
+ *      to the GPU (at most uploadBudget points per frame in all)
+ *
+ * Nodes not picked are hidden, and dropped after EVICT_FRAMES frames.
+ *
+ * If the module is missing or fails to load, every point is drawn from
+ * one growing buffer instead: no level of detail, same look.
+ */
+
+const fs = require('fs');
+const path = require('path');
+const THREE = require('three');
+
+const WASM_PATH = path.join(__dirname, 'point-octree.wasm');
+const EVICT_FRAMES = 600;        // ~10 s at 60 fps
+const MIN_NODE_CAPACITY = 1024;  // Points; node buffers grow by doubling
+
+// Growable typed array
+function grow(array, needed) {
+    if (needed <= array.length) return array;
+    let size = Math.max(array.length, 1024);
+    while (size < needed) size *= 2;
+    const bigger = new array.constructor(size);
+    bigger.set(array);
+    return bigger;
+}
+
+class PointCloudLOD {
+    constructor(scene, options = {}) {
+        this.errorPixels = options.errorPixels ?? 1.5;
+        this.pointBudget = options.pointBudget ?? 3000000;
+        this.uploadBudget = options.uploadBudget ?? 500000;
+        this.halfSize = options.halfSize ?? 2048;      // Root cube (mm)
+        this.minSpacing = options.minSpacing ?? 0.05;  // Finest decimation (mm)
+
+        this.group = new THREE.Group();
+        scene.add(this.group);
+        this.material = new THREE.PointsMaterial({
+            size: options.pointSize ?? 2,
+            sizeAttenuation: false,
+            vertexColors: true
+        });
+
+        // Added, not in the octree yet (x, y, z / packed RGBA)
+        this.pendingPositions = new Float32Array(3 * 1024);
+        this.pendingColors = new Uint32Array(1024);
+        this.pendingCount = 0;
+
+        this.count = 0;
+        this.bounds = new THREE.Box3();
+        this.scratch = new THREE.Vector3();
+        this.nodes = new Map();  // Octree node id -> drawn node
+        this.frame = 0;
+        this.viewProjection = new THREE.Matrix4();
+
+        this.wasm = null;
+        this.flat = null;  // Without the module: every point, one node
+        this.load();
+    }
+
+    async load() {
+        try {
+            const bytes = await fs.promises.readFile(WASM_PATH);
+            const module = await WebAssembly.compile(bytes);
+
+            // Standalone build: whatever runtime hooks it imports are no-ops
+            const imports = {};
+            for (const entry of WebAssembly.Module.imports(module)) {
+                imports[entry.module] = imports[entry.module] || {};
+                if (entry.kind === 'function') imports[entry.module][entry.name] = () => 0;
+            }
+            const instance = await WebAssembly.instantiate(module, imports);
+            const wasm = instance.exports;
+            if (wasm._initialize) wasm._initialize();
+            wasm.octree_init(0, 0, 0, this.halfSize, this.minSpacing);
+            this.wasm = wasm;
+            console.log('Point cloud level of detail ready');
+        } catch (error) {
+            console.warn(`Point cloud level of detail unavailable, drawing every point: ${error.message}`);
+            this.flat = { positions: new Float32Array(0), colors: new Uint8Array(0), count: 0 };
+        }
+    }
+
+    add(x, y, z, color) {
+        const n = this.pendingCount;
+        this.pendingPositions = grow(this.pendingPositions, 3 * (n + 1));
+        this.pendingColors = grow(this.pendingColors, n + 1);
+        this.pendingPositions[3 * n] = x;
+        this.pendingPositions[3 * n + 1] = y;
+        this.pendingPositions[3 * n + 2] = z;
+        // THREE color 0xRRGGBB -> RGBA bytes in memory order
+        this.pendingColors[n] = (((color >> 16) & 0xff) | (color & 0xff00) |
+            ((color & 0xff) << 16) | 0xff000000) >>> 0;
+        this.pendingCount = n + 1;
+        this.count++;
+        this.bounds.expandByPoint(this.scratch.set(x, y, z));
+    }
+
+    // Once per frame, before rendering. 'height' is the drawing buffer
+    // height in pixels.
+    update(camera, height) {
+        this.frame++;
+        if (this.wasm) {
+            this.flushToOctree();
+            this.drawSelection(camera, height);
+        } else if (this.flat) {
+            this.flushToFlat();
+        }
+    }
+
+    flushToOctree() {
+        const n = this.pendingCount;
+        if (n === 0) return;
+        const wasm = this.wasm;
+        const positions = wasm.octree_input(n) >>> 0;
+        const colors = wasm.octree_input_colors() >>> 0;
+        const memory = wasm.memory.buffer;
+        new Float32Array(memory, positions, 3 * n).set(this.pendingPositions.subarray(0, 3 * n));
+        new Uint32Array(memory, colors, n).set(this.pendingColors.subarray(0, n));
+        wasm.octree_insert(n);
+        this.pendingCount = 0;
+    }
+
+    drawSelection(camera, height) {
+        const wasm = this.wasm;
+
+        // Camera as OctreeCamera: view-projection, eye, projection scale
+        camera.updateMatrixWorld();
+        this.viewProjection.multiplyMatrices(camera.projectionMatrix, camera.matrixWorldInverse);
+        const view = new Float32Array(wasm.memory.buffer, wasm.octree_camera() >>> 0, 20);
+        view.set(this.viewProjection.elements, 0);
+        view[16] = camera.position.x;
+        view[17] = camera.position.y;
+        view[18] = camera.position.z;
+        view[19] = height / (2 * Math.tan(THREE.MathUtils.degToRad(camera.fov) / 2));
+
+        const selected = wasm.octree_select(this.errorPixels, this.pointBudget);
+        const ids = new Uint32Array(wasm.memory.buffer, wasm.octree_selected() >>> 0, selected).slice();
+
+        let uploads = this.uploadBudget;
+        for (const id of ids) {
+            let node = this.nodes.get(id);
+            if (!node) {
+                node = this.createNode();
+                this.nodes.set(id, node);
+            }
+            const count = wasm.octree_node_count(id);
+            if (count > node.uploaded && uploads > 0) {
+                const upTo = Math.min(count, node.uploaded + uploads);
+                uploads -= upTo - node.uploaded;
+                // Views are taken after the last call that could grow memory
+                const memory = wasm.memory.buffer;
+                const positions = new Float32Array(memory, wasm.octree_node_positions(id) >>> 0, 3 * upTo);
+                const colors = new Uint8Array(memory, wasm.octree_node_colors(id) >>> 0, 4 * upTo);
+                this.upload(node, positions, colors, upTo);
+            }
+            node.points.visible = node.uploaded > 0;
+            node.lastSeen = this.frame;
+        }
+
+        for (const [id, node] of this.nodes) {
+            if (node.lastSeen === this.frame) continue;
+            node.points.visible = false;
+            if (this.frame - node.lastSeen > EVICT_FRAMES) {
+                this.disposeNode(node);
+                this.nodes.delete(id);
+            }
+        }
+    }
+
+    flushToFlat() {
+        const n = this.pendingCount;
+        if (n === 0) return;
+        const flat = this.flat;
+        flat.positions = grow(flat.positions, 3 * (flat.count + n));
+        flat.colors = grow(flat.colors, 4 * (flat.count + n));
+        flat.positions.set(this.pendingPositions.subarray(0, 3 * n), 3 * flat.count);
+        flat.colors.set(new Uint8Array(this.pendingColors.buffer, 0, 4 * n), 4 * flat.count);
+        flat.count += n;
+        this.pendingCount = 0;
+
+        if (!flat.node) flat.node = this.createNode();
+        this.upload(flat.node, flat.positions, flat.colors, flat.count);
+        flat.node.points.visible = true;
+    }
+
+    createNode() {
+        const points = new THREE.Points(new THREE.BufferGeometry(), this.material);
+        points.frustumCulled = false;  // The octree already culled
+        points.visible = false;
+        this.group.add(points);
+        return { points, uploaded: 0, capacity: 0, lastSeen: this.frame };
+    }
+
+    // Send points [uploaded, upTo) of a node to its buffers
+    upload(node, positions, colors, upTo) {
+        const from = node.uploaded;
+        let geometry = node.points.geometry;
+
+        if (upTo > node.capacity) {
+            // Reallocate: a new geometry, uploaded whole on first draw
+            let capacity = Math.max(node.capacity, MIN_NODE_CAPACITY);
+            while (capacity < upTo) capacity *= 2;
+            const position = new THREE.BufferAttribute(new Float32Array(3 * capacity), 3);
+            const color = new THREE.BufferAttribute(new Uint8Array(4 * capacity), 4, true);
+            if (from > 0) {
+                position.array.set(geometry.getAttribute('position').array.subarray(0, 3 * from));
+                color.array.set(geometry.getAttribute('color').array.subarray(0, 4 * from));
+            }
+            geometry.dispose();
+            geometry = new THREE.BufferGeometry();
+            geometry.setAttribute('position', position);
+            geometry.setAttribute('color', color);
+            node.points.geometry = geometry;
+            node.capacity = capacity;
+        } else {
+            geometry.getAttribute('position').addUpdateRange(3 * from, 3 * (upTo - from));
+            geometry.getAttribute('color').addUpdateRange(4 * from, 4 * (upTo - from));
+        }
+
+        const position = geometry.getAttribute('position');
+        const color = geometry.getAttribute('color');
+        position.array.set(positions.subarray(3 * from, 3 * upTo), 3 * from);
+        color.array.set(colors.subarray(4 * from, 4 * upTo), 4 * from);
+        position.needsUpdate = true;
+        color.needsUpdate = true;
+        geometry.setDrawRange(0, upTo);
+        node.uploaded = upTo;
+    }
+
+    disposeNode(node) {
+        node.points.geometry.dispose();
+        this.group.remove(node.points);
+    }
+
+    clear() {
+        for (const node of this.nodes.values()) this.disposeNode(node);
+        this.nodes.clear();
+        if (this.wasm) this.wasm.octree_clear();
+        if (this.flat) {
+            if (this.flat.node) this.disposeNode(this.flat.node);
+            this.flat = { positions: new Float32Array(0), colors: new Uint8Array(0), count: 0 };
+        }
+        this.pendingCount = 0;
+        this.count = 0;
+        this.bounds.makeEmpty();
+    }
+
+    dispose() {
+        this.clear();
+        this.material.dispose();
+        this.group.parent?.remove(this.group);
+    }
+}
+
+module.exports = PointCloudLOD;
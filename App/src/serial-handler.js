@@ -6,7 +6,14 @@
 
 const { SerialPort } = require('serialport');
 const { ReadlineParser } = require('@serialport/parser-readline');
+const fs = require('fs');
 const SimulatorEngine = require('./simulator-engine');
+const BridgeTransport = require('./bridge-transport');
+
+// Port names of the form "bridge:<socket path or TCP port>" connect to a
+// running ccm_bridge instead of the serial port
+const BRIDGE_PREFIX = 'bridge:';
+const DEFAULT_BRIDGE_SOCKET = '/tmp/ccm_bridge.sock';
 
 class SerialHandler {
     constructor() {
@@ -15,12 +22,27 @@ class SerialHandler {
         this.isConnected = false;
         this.dataCallback = null;
         this.statusCallback = null;
+        this.tracer = null;
+    }
+
+    // Stamp received / parsed times and TRC lines (see latency-trace.js)
+    setTracer(tracer) {
+        this.tracer = tracer;
     }
 
     async listPorts() {
         try {
             const ports = await SerialPort.list();
             const portList = ports.filter(port => port.vendorId || port.manufacturer);
+            // Offer a running bridge (it owns the serial port, so the arm
+            // itself is not listed)
+            if (fs.existsSync(DEFAULT_BRIDGE_SOCKET)) {
+                portList.push({
+                    path: BRIDGE_PREFIX + DEFAULT_BRIDGE_SOCKET,
+                    manufacturer: 'Shared via ccm_bridge',
+                    vendorId: 'BRIDGE'
+                });
+            }
             // Add Simulator option
             portList.push({
                 path: 'Simulator',
@@ -39,8 +61,11 @@ class SerialHandler {
             this.dataCallback = onData;
             this.statusCallback = onStatus;
 
+            const viaBridge = portPath.startsWith(BRIDGE_PREFIX);
             if (portPath === 'Simulator') {
                 this.port = new SimulatorEngine();
+            } else if (viaBridge) {
+                this.port = new BridgeTransport(portPath.slice(BRIDGE_PREFIX.length));
             } else {
                 this.port = new SerialPort({
                     path: portPath,
@@ -49,6 +74,9 @@ class SerialHandler {
                 });
             }
 
+            // Registered before the parser, so it sees each chunk first
+            this.port.on('data', () => this.tracer?.chunkReceived());
+
             this.parser = this.port.pipe(new ReadlineParser({ delimiter: '\n' }));
 
             this.port.on('open', () => {
@@ -72,7 +100,8 @@ class SerialHandler {
                 this.port.open((err) => err ? reject(err) : resolve());
             });
 
-            await this.delay(2000);
+            // Opening the serial port resets the Arduino; a bridge has it running
+            if (!viaBridge) await this.delay(2000);
             this.sendCommand('INFO');
 
             return { success: true };
@@ -106,20 +135,27 @@ class SerialHandler {
 
         switch (messageType) {
             case 'POS':
-                if (parts.length === 9) {
-                    this.dataCallback?.({
+                // One joint angle per axis: 2 to 8 (NUM_AXES)
+                if (parts.length >= 5 + 2) {
+                    const timestamp = parseInt(parts[1]);
+                    const angles = parts.slice(5).map(parseFloat);
+                    const position = {
                         type: 'position',
-                        timestamp: parseInt(parts[1]),
+                        timestamp,
                         x: parseFloat(parts[2]),
                         y: parseFloat(parts[3]),
                         z: parseFloat(parts[4]),
-                        theta1: parseFloat(parts[5]),
-                        theta2: parseFloat(parts[6]),
-                        theta3: parseFloat(parts[7]),
-                        theta4: parseFloat(parts[8])
-                    });
+                        angles,
+                        trace: this.tracer?.positionParsed(timestamp) ?? null
+                    };
+                    // theta1..theta4 for the axes the arm has
+                    angles.slice(0, 4).forEach((angle, i) => { position[`theta${i + 1}`] = angle; });
+                    this.dataCallback?.(position);
                 }
                 break;
+            case 'TRC':
+                this.tracer?.traceReceived(parts);
+                break;
             case 'ACK':
                 const ackMessage = parts.slice(1).join(',');
                 this.statusCallback?.({ type: 'info', message: ackMessage });
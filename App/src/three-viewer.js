@@ -5,6 +5,8 @@
  * 
  * Features:
  * - Real-time 3D visualization of captured points
+ * - LIVE points drawn with level of detail (point-cloud-lod.js), so
+ *   millions of streamed points keep the frame rate
  * - Sequential line connections between points
  * - Color coding by point type
  * - Point number labels
@@ -15,6 +17,7 @@
  */
 
 const THREE = require('three');
+const PointCloudLOD = require('./point-cloud-lod');
 
 // Simple Orbit Controls implementation for Electron/CommonJS
 class SimpleOrbitControls {
@@ -187,6 +190,10 @@ class ThreeViewer {
         this.linesGroup = new THREE.Group();
         this.labelsGroup = new THREE.Group();
         this.points = [];
+        this.cloud = null;  // LIVE points
+
+        // Called after every rendered frame (latency tracing)
+        this.frameListeners = [];
 
         // Color scheme for point types
         this.colors = {
@@ -275,6 +282,7 @@ class ThreeViewer {
         this.scene.add(this.pointsGroup);
         this.scene.add(this.linesGroup);
         this.scene.add(this.labelsGroup);
+        this.cloud = new PointCloudLOD(this.scene);
 
         // Handle window resize
         window.addEventListener('resize', () => this.onWindowResize());
@@ -303,7 +311,13 @@ class ThreeViewer {
     animate() {
         requestAnimationFrame(() => this.animate());
         this.controls.update();
+        this.cloud.update(this.camera, this.renderer.domElement.height);
         this.renderer.render(this.scene, this.camera);
+        for (const listener of this.frameListeners) listener();
+    }
+
+    onFrameRendered(listener) {
+        this.frameListeners.push(listener);
     }
 
     getColor(pointType) {
@@ -311,6 +325,12 @@ class ThreeViewer {
     }
 
     addPoint(x, y, z, type = 'DEFAULT', pointNumber) {
+        // Streamed points: no sphere, label or line each
+        if (type === 'LIVE') {
+            this.cloud.add(x, y, z, this.getColor(type));
+            return;
+        }
+
         const point = { x, y, z, type, number: pointNumber };
         this.points.push(point);
 
@@ -399,13 +419,14 @@ class ThreeViewer {
     }
 
     framePoints() {
-        if (this.points.length === 0) return;
+        if (this.points.length === 0 && this.cloud.count === 0) return;
 
         // Calculate bounding box
         const box = new THREE.Box3();
         this.pointsGroup.children.forEach(mesh => {
             box.expandByObject(mesh);
         });
+        box.union(this.cloud.bounds);
 
         // Get center and size
         const center = box.getCenter(new THREE.Vector3());
@@ -424,7 +445,7 @@ class ThreeViewer {
     }
 
     resetView() {
-        if (this.points.length > 0) {
+        if (this.points.length > 0 || this.cloud.count > 0) {
             // Frame all points if they exist
             this.framePoints();
         } else {
@@ -459,6 +480,7 @@ class ThreeViewer {
         }
 
         this.points = [];
+        this.cloud.clear();
         console.log('3D viewer cleared');
     }
 
@@ -488,6 +510,7 @@ class ThreeViewer {
     dispose() {
         // Clean up resources
         this.clear();
+        this.cloud.dispose();
         this.controls.dispose();
         this.renderer.dispose();
         if (this.resizeObserver) {
@@ -10,7 +10,8 @@
  * License: MIT (or your choice)
  * 
  * DESCRIPTION:
- * This sketch reads 4 rotary encoders to track the position of an articulated
+ * This sketch reads 4 rotary encoders (NUM_AXES in config.h; 5-6 for arms
+ * with a rotating wrist) to track the position of an articulated
  * arm and calculates X, Y, Z coordinates in real-time. Data is sent via serial
  * to a PC application for logging, visualization, and CSV export.
  * 
@@ -44,12 +45,18 @@
 #include "config.h"
 #include "encoder.h"
 #include "kinematics.h"
+#include "joint_filter.h"
+#include "burst.h"
+#include "motion_trigger.h"
+#include "velocity.h"
+#include "frame_history.h"
+#include "latency_trace.h"
+#include "scheduler.h"
 #include "serial_protocol.h"
 
 // ============================================================================
 // GLOBAL VARIABLES
 // ============================================================================
-unsigned long lastUpdateTime = 0;
 bool isRecording = false;
 bool isPaused = false;
 
@@ -60,6 +67,52 @@ float xOffset = 0.0;
 float yOffset = 0.0;
 float zOffset = 0.0;
 
+// ============================================================================
+// TASK TABLE
+// ============================================================================
+// Order is priority: sampling first, then command reception (so commands are
+// answered quickly), then the slower periodic work.
+void Task_Sample();
+void Task_ReceiveCommands();
+void Task_Kinematics();
+void Task_Frames();
+void Task_Transmit();
+void Task_Burst();
+void Task_Housekeeping();
+
+#define TASK_SAMPLE        0
+#define TASK_RX            1
+#define TASK_KINEMATICS    2
+#define TASK_FRAMES        3
+#define TASK_TX            4
+#define TASK_BURST         5
+#define TASK_HOUSEKEEPING  6
+#define TASK_COUNT         7
+
+SchedulerTask tasks[TASK_COUNT] = {
+  // name       run                   event                  period (us)
+  { "SAMPLE",   Task_Sample,          NULL,                  FILTER_SAMPLE_INTERVAL_US },        // 0 while nothing samples
+  { "RX",       Task_ReceiveCommands, Serial_RxReady,        0 },
+  { "KIN",      Task_Kinematics,      NULL,                  UPDATE_INTERVAL_MS * 1000UL },      // MOTION_CHECK_INTERVAL_US in motion mode
+  { "FRAMES",   Task_Frames,          FrameHistory_TxReady,  0 },
+  { "TX",       Task_Transmit,        Serial_TxReady,        0 },
+  { "BURST",    Task_Burst,           Burst_TxReady,         0 },
+  { "HOUSE",    Task_Housekeeping,    NULL,                  HOUSEKEEPING_INTERVAL_MS * 1000UL }
+};
+
+// The sampling task is only released while something uses its snapshots.
+// At 4 kHz it keeps every deadline under SCHEDULER_SLEEP_MIN_US, so while
+// it runs the CPU never sleeps.
+bool SamplingNeeded() {
+  return VELOCITY_TRACKING || JointFilter_IsActive() || Burst_IsCapturing() ||
+         MotionTrigger_IsEnabled();
+}
+
+void UpdateSampling() {
+  unsigned long periodUs = SamplingNeeded() ? FILTER_SAMPLE_INTERVAL_US : 0;
+  if (tasks[TASK_SAMPLE].periodUs != periodUs) Scheduler_SetPeriod(TASK_SAMPLE, periodUs);
+}
+
 // ============================================================================
 // SETUP FUNCTION - Runs once at startup
 // ============================================================================
@@ -73,6 +126,12 @@ void setup() {
   // Initialize encoders
   Encoder_Init();
   
+  // Initialize joint filter (seeded from current counts)
+  JointFilter_Init();
+  
+  // Initialize velocity estimation (seeded from current counts)
+  Velocity_Init();
+  
   // Initialize kinematics
   Kinematics_Init();
   
@@ -87,34 +146,96 @@ void setup() {
     digitalWrite(LED_BUILTIN, LOW);
     delay(200);
   }
+  
+  // Start the task scheduler
+  Scheduler_Init(tasks, TASK_COUNT);
 }
 
 // ============================================================================
 // MAIN LOOP - Runs continuously
 // ============================================================================
 void loop() {
-  // Check for incoming serial commands from PC
+  // Run the highest-priority ready task (or sleep until the next event)
+  Scheduler_RunOnce();
+}
+
+// ============================================================================
+// TASKS - Called by the scheduler, must not block
+// ============================================================================
+
+// Sample and filter encoders at the internal rate (several kHz)
+// One coherent snapshot feeds velocity estimation, the joint filter, a
+// burst capture and the motion trigger
+void Task_Sample() {
+  if (!SamplingNeeded()) {
+    UpdateSampling();  // The last user stopped (a burst finished, say)
+    return;
+  }
+
+  long counts[NUM_AXES];
+  unsigned long edgeMicros[NUM_AXES];
+  Encoder_GetSnapshot(counts, edgeMicros);
+  #if VELOCITY_TRACKING
+  Velocity_Sample(counts, edgeMicros);
+  #endif
+  JointFilter_SampleCounts(counts);
+  Burst_Sample(counts);
+  MotionTrigger_Sample(counts);
+}
+
+// Parse received bytes and execute commands
+void Task_ReceiveCommands() {
   Serial_CheckForCommands();
-  
-  // Update position at specified rate
-  unsigned long currentTime = millis();
-  if (currentTime - lastUpdateTime >= UPDATE_INTERVAL_MS) {
-    lastUpdateTime = currentTime;
-    
-    // Read current encoder positions
+  UpdateSampling();  // A command may have started or stopped a user of the samples
+}
+
+// Update position at the streaming rate
+void Task_Kinematics() {
+  // Motion mode: only calculate when the tip may have moved far enough
+  // (or the heartbeat is due), and only send points that really did
+  if (MotionTrigger_IsEnabled()) {
+    if (!isRecording || isPaused || !MotionTrigger_Pending()) return;
     Encoder_Update();
-    
-    // Calculate forward kinematics (angles -> XYZ coordinates)
     Kinematics_Calculate();
-    
-    // Send position data to PC (if recording and not paused)
-    if (isRecording && !isPaused) {
-      Serial_SendPositionData();
+    if (MotionTrigger_Check() && Serial_StreamPositionData()) {
+      MotionTrigger_Emitted();
     }
+    return;
   }
   
-  // Small delay to prevent overwhelming the serial buffer
-  delay(1);
+  // Read current encoder positions
+  Encoder_Update();
+  
+  // Calculate forward kinematics (angles -> XYZ coordinates)
+  Kinematics_Calculate();
+  
+  // Send position data to PC (if recording and not paused)
+  if (isRecording && !isPaused) {
+    Serial_StreamPositionData();
+  }
+}
+
+// Send sequenced frames (resent ones first) as transmit space allows
+void Task_Frames() {
+  FrameHistory_Transmit();
+}
+
+// Move queued output to the UART as space becomes available, then
+// follow a traced POS line (SETTRACE)
+void Task_Transmit() {
+  Serial_DrainTx();
+  LatencyTrace_Transmit();
+}
+
+// Send burst results and dump lines as transmit space allows
+// (independent of START/STOP, so a dump can share the link with streaming)
+void Task_Burst() {
+  Burst_Transmit();
+}
+
+// Periodic bookkeeping
+void Task_Housekeeping() {
+  Scheduler_UpdateLoad();
 }
 
 // ============================================================================
@@ -125,6 +246,8 @@ void loop() {
 void Command_StartRecording() {
   isRecording = true;
   isPaused = false;
+  MotionTrigger_Restart();  // First point right away in motion mode
+  FrameHistory_Reset();     // Sequenced frames start again at 0
   Serial_SendAcknowledge("RECORDING_STARTED");
 }
 
@@ -144,6 +267,7 @@ void Command_PauseRecording() {
 // Called when PC sends RESUME command
 void Command_ResumeRecording() {
   isPaused = false;
+  MotionTrigger_Restart();
   Serial_SendAcknowledge("RECORDING_RESUMED");
 }
 
@@ -179,18 +303,32 @@ void Command_ZeroEncoders() {
 
 // Called when PC requests current position
 void Command_GetPosition() {
+  Encoder_Update();  // Fresh sample, so the timestamp is "now"
   Kinematics_Calculate();
   Serial_SendPositionData();
 }
 
 // Called when PC sends new encoder resolution
-void Command_SetEncoderResolution(int ppr) {
+void Command_SetEncoderResolution(long ppr) {
   Encoder_SetResolution(ppr);
   Serial_SendAcknowledge("ENCODER_RESOLUTION_SET");
 }
 
-// Called when PC sends new link dimensions
-void Command_SetDimensions(float l1, float l2, float l3, float l4) {
-  Kinematics_SetDimensions(l1, l2, l3, l4);
+// Called when PC sends new link dimensions (one per axis)
+void Command_SetDimensions(const float* lengths) {
+  Kinematics_SetDimensions(lengths);
   Serial_SendAcknowledge("DIMENSIONS_SET");
-}
\ No newline at end of file
+}
+// Called when PC selects fixed-interval streaming (SETSTREAM TIME)
+void Command_SetTimeStreaming() {
+  MotionTrigger_Disable();
+  Scheduler_SetPeriod(TASK_KINEMATICS, UPDATE_INTERVAL_MS * 1000UL);
+  Serial_SendAcknowledge("STREAM_TIME");
+}
+
+// Called when PC selects motion-adaptive streaming (SETSTREAM MOTION)
+void Command_SetMotionStreaming(float distanceMm, float angleDeg, unsigned long maxIntervalMs) {
+  MotionTrigger_Enable(distanceMm, angleDeg, maxIntervalMs);
+  Scheduler_SetPeriod(TASK_KINEMATICS, MOTION_CHECK_INTERVAL_US);
+  Serial_SendAcknowledge("STREAM_MOTION");
+}
@@ -0,0 +1,342 @@
+/*
+ * ============================================================================
+ * BURST CAPTURE MODULE - IMPLEMENTATION FILE
+ * ============================================================================
+ *
+ * Capturing costs the SAMPLE task a few microseconds per snapshot: the
+ * deltas are packed and the running CRC updated in place, nothing is sent.
+ * All BURST output (DONE report, dump lines) goes out from the low-priority
+ * BURST task, one line at a time and only when the line fits in the
+ * transmit queue, so a dump never stalls sampling or command handling.
+ *
+ * ============================================================================
+ */
+
+#include "burst.h"
+#include "encoder.h"
+#include "scheduler.h"
+#include "serial_protocol.h"
+
+// ============================================================================
+// PRIVATE DEFINITIONS
+// ============================================================================
+#define BURST_END_COMPLETE 0
+#define BURST_END_FULL     1
+#define BURST_END_ABORTED  2
+
+#define DUMP_HEADER 0
+#define DUMP_DATA   1
+#define DUMP_END    2
+
+#define SAMPLE_RATE_HZ (1000000UL / FILTER_SAMPLE_INTERVAL_US)
+
+// ============================================================================
+// PRIVATE VARIABLES
+// ============================================================================
+static uint8_t buffer[BURST_BUFFER_SIZE];
+static uint16_t used = 0;                 // Encoded bytes in buffer
+static uint16_t crc = 0xFFFF;             // Running CRC of buffer[0..used)
+
+static bool capturing = false;
+static bool hasData = false;              // A finished capture can be dumped
+static unsigned long samplesWanted = 0;
+static unsigned long samplesTaken = 0;
+static uint8_t divider = 1;               // Store every Nth sampling period
+static uint8_t dividerCount = 0;
+static long countsPerRev = 0;
+
+static long firstCounts[NUM_AXES];        // Joint counts of the first sample
+static long lastRaw[NUM_AXES];            // Raw counts of the previous sample
+static unsigned long startMicros = 0;
+static unsigned long lastMicros = 0;
+static unsigned long gaps = 0;
+
+static bool donePending = false;          // DONE report waiting to be sent
+static uint8_t endReason = BURST_END_COMPLETE;
+
+static bool dumping = false;
+static uint8_t dumpPhase = DUMP_HEADER;
+static unsigned int dumpSeq = 0;
+
+// ============================================================================
+// CRC16-CCITT (byte at a time, no table)
+// ============================================================================
+uint16_t Burst_Crc16(uint16_t value, const uint8_t* data, uint16_t length) {
+  while (length--) {
+    uint8_t x = (uint8_t)(value >> 8) ^ *data++;
+    x ^= x >> 4;
+    value = (value << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x;
+  }
+  return value;
+}
+
+// ============================================================================
+// ENCODE ONE SAMPLE
+// ============================================================================
+// Returns the number of bytes written to 'out' (at most BURST_SAMPLE_MAX_BYTES)
+static uint8_t EncodeSample(const long* deltas, uint8_t* out) {
+  uint8_t length = BURST_NIBBLE_BYTES;
+  for (uint8_t b = 0; b < BURST_NIBBLE_BYTES; b++) out[b] = 0;
+
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    int32_t delta = (int32_t)deltas[i];
+    uint8_t nibble;
+
+    if (delta >= -7 && delta <= 7) {
+      nibble = (uint8_t)delta & 0x0F;
+    } else {
+      // Escape: zigzag varint after the nibble bytes
+      nibble = 0x08;
+      uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+      do {
+        uint8_t b = zigzag & 0x7F;
+        zigzag >>= 7;
+        if (zigzag != 0) b |= 0x80;
+        out[length++] = b;
+      } while (zigzag != 0);
+    }
+
+    out[i >> 1] |= (i & 1) ? nibble : (uint8_t)(nibble << 4);
+  }
+  return length;
+}
+
+// ============================================================================
+// FINISH A CAPTURE
+// ============================================================================
+static void Finish(uint8_t reason) {
+  capturing = false;
+  hasData = samplesTaken > 0;
+  endReason = reason;
+  donePending = true;
+}
+
+// ============================================================================
+// START / ABORT
+// ============================================================================
+void Burst_Start(unsigned long samples, uint8_t sampleDivider) {
+  if (capturing) {
+    Serial_SendError("Burst capture in progress");
+    return;
+  }
+
+  dumping = false;
+  hasData = false;
+  donePending = false;
+  used = 0;
+  crc = 0xFFFF;
+  samplesWanted = samples;
+  samplesTaken = 0;
+  divider = sampleDivider;
+  dividerCount = sampleDivider - 1;  // Store the very next sample
+  countsPerRev = Encoder_GetCountsPerRevolution();
+  gaps = 0;
+
+  // Report memory before anything is captured
+  // Format: BURST,START,rateHz,samples,bufferBytes,capacity,freeSram
+  serialTx.print(F("BURST,START,"));
+  serialTx.print(SAMPLE_RATE_HZ / divider);
+  serialTx.print(F(","));
+  serialTx.print(samplesWanted);
+  serialTx.print(F(","));
+  serialTx.print((unsigned long)BURST_BUFFER_SIZE);
+  serialTx.print(F(","));
+  serialTx.print((unsigned long)(BURST_BUFFER_SIZE / BURST_NIBBLE_BYTES + 1));
+  serialTx.print(F(","));
+  serialTx.println(Scheduler_GetFreeSram());
+
+  capturing = true;
+}
+
+void Burst_Command(const char* params) {
+  if (params == NULL) {
+    Serial_SendError("Use: BURST <ms>[,<hz>] or BURST ABORT");
+    return;
+  }
+  if (strcmp(params, "ABORT") == 0) {
+    Burst_Abort();
+    return;
+  }
+
+  long ms = atol(params);
+  const char* comma = strchr(params, ',');
+  long hz = comma != NULL ? atol(comma + 1) : (long)SAMPLE_RATE_HZ;
+
+  if (ms < 1 || ms > 60000L || hz < 1 || hz > (long)SAMPLE_RATE_HZ) {
+    Serial_SendError("Invalid burst (1-60000 ms, 1 Hz to sampling rate)");
+    return;
+  }
+
+  // Nearest integer divider of the sampling rate
+  unsigned long sampleDivider = (SAMPLE_RATE_HZ + hz / 2) / hz;
+  if (sampleDivider > 255) sampleDivider = 255;
+
+  unsigned long samples = (unsigned long)ms * (SAMPLE_RATE_HZ / sampleDivider) / 1000UL;
+  if (samples < 2) samples = 2;
+
+  Burst_Start(samples, (uint8_t)sampleDivider);
+}
+
+void Burst_Abort() {
+  if (capturing) Finish(BURST_END_ABORTED);
+  dumping = false;
+  Serial_SendAcknowledge("BURST_ABORTED");
+}
+
+// ============================================================================
+// SAMPLE - Store one snapshot (SAMPLE task)
+// ============================================================================
+void Burst_Sample(const long* counts) {
+  if (!capturing) return;
+  if (++dividerCount < divider) return;
+  dividerCount = 0;
+
+  unsigned long now = micros();
+
+  if (samplesTaken == 0) {
+    for (uint8_t i = 0; i < NUM_AXES; i++) {
+      firstCounts[i] = (counts[i] - encoders.zeroOffset[i]) * encoders.direction[i];
+      lastRaw[i] = counts[i];
+    }
+    startMicros = now;
+  } else {
+    long deltas[NUM_AXES];
+    for (uint8_t i = 0; i < NUM_AXES; i++) {
+      deltas[i] = (counts[i] - lastRaw[i]) * encoders.direction[i];
+    }
+
+    uint8_t encoded[BURST_SAMPLE_MAX_BYTES];
+    uint8_t length = EncodeSample(deltas, encoded);
+    if (used + length > BURST_BUFFER_SIZE) {
+      Finish(BURST_END_FULL);
+      return;
+    }
+
+    memcpy(buffer + used, encoded, length);
+    crc = Burst_Crc16(crc, encoded, length);
+    used += length;
+
+    for (uint8_t i = 0; i < NUM_AXES; i++) lastRaw[i] = counts[i];
+
+    // A late SAMPLE task (missed release) shows up as a long interval
+    unsigned long nominal = (unsigned long)FILTER_SAMPLE_INTERVAL_US * divider;
+    if (now - lastMicros > nominal + nominal / 2) gaps++;
+  }
+
+  lastMicros = now;
+  samplesTaken++;
+  if (samplesTaken >= samplesWanted) Finish(BURST_END_COMPLETE);
+}
+
+bool Burst_IsCapturing() {
+  return capturing;
+}
+
+// ============================================================================
+// DUMP
+// ============================================================================
+void Burst_Dump(unsigned int fromSeq) {
+  if (capturing) {
+    Serial_SendError("Burst capture in progress");
+    return;
+  }
+  if (!hasData) {
+    Serial_SendError("No burst data");
+    return;
+  }
+  dumping = true;
+  dumpPhase = fromSeq == 0 ? DUMP_HEADER : DUMP_DATA;
+  dumpSeq = fromSeq;
+}
+
+static unsigned int DumpLines() {
+  return (used + BURST_DUMP_CHUNK - 1) / BURST_DUMP_CHUNK;
+}
+
+static void PrintHex(uint8_t value) {
+  static const char digits[] = "0123456789ABCDEF";
+  serialTx.print(digits[value >> 4]);
+  serialTx.print(digits[value & 0x0F]);
+}
+
+static void PrintHex16(uint16_t value) {
+  PrintHex((uint8_t)(value >> 8));
+  PrintHex((uint8_t)value);
+}
+
+// ============================================================================
+// TRANSMIT (BURST task) - one line per run
+// ============================================================================
+bool Burst_TxReady() {
+  return (donePending || dumping) && serialTx.space() >= BURST_LINE_MAX_LENGTH;
+}
+
+void Burst_Transmit() {
+  static const char* const reasons[] = { "COMPLETE", "FULL", "ABORTED" };
+
+  if (donePending) {
+    // Format: BURST,DONE,samples,bytes,gaps,reason
+    serialTx.print(F("BURST,DONE,"));
+    serialTx.print(samplesTaken);
+    serialTx.print(F(","));
+    serialTx.print(used);
+    serialTx.print(F(","));
+    serialTx.print(gaps);
+    serialTx.print(F(","));
+    serialTx.println(reasons[endReason]);
+    donePending = false;
+    return;
+  }
+
+  if (!dumping) return;
+
+  if (dumpPhase == DUMP_HEADER) {
+    serialTx.print(F("BURST,HDR,"));
+    serialTx.print(samplesTaken);
+    serialTx.print(F(","));
+    serialTx.print(SAMPLE_RATE_HZ / divider);
+    serialTx.print(F(","));
+    serialTx.print(countsPerRev);
+    serialTx.print(F(","));
+    serialTx.print(startMicros);
+    serialTx.print(F(","));
+    serialTx.print(lastMicros);
+    serialTx.print(F(","));
+    serialTx.print(gaps);
+    serialTx.print(F(","));
+    serialTx.print(used);
+    serialTx.print(F(","));
+    serialTx.print(DumpLines());
+    for (uint8_t i = 0; i < NUM_AXES; i++) {
+      serialTx.print(F(","));
+      serialTx.print(firstCounts[i]);
+    }
+    serialTx.println();
+    dumpPhase = DUMP_DATA;
+    return;
+  }
+
+  if (dumpPhase == DUMP_DATA && dumpSeq < DumpLines()) {
+    uint16_t offset = (uint16_t)dumpSeq * BURST_DUMP_CHUNK;
+    uint16_t length = used - offset;
+    if (length > BURST_DUMP_CHUNK) length = BURST_DUMP_CHUNK;
+
+    serialTx.print(F("BURST,DATA,"));
+    serialTx.print(dumpSeq);
+    serialTx.print(F(","));
+    for (uint16_t i = 0; i < length; i++) PrintHex(buffer[offset + i]);
+    serialTx.print(F(","));
+    PrintHex16(Burst_Crc16(0xFFFF, buffer + offset, length));
+    serialTx.println();
+
+    dumpSeq++;
+    return;
+  }
+
+  serialTx.print(F("BURST,END,"));
+  serialTx.print(DumpLines());
+  serialTx.print(F(","));
+  PrintHex16(crc);
+  serialTx.println();
+  dumping = false;
+}
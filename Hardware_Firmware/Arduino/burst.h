@@ -0,0 +1,93 @@
+/*
+ * ============================================================================
+ * BURST CAPTURE MODULE - HEADER FILE
+ * ============================================================================
+ *
+ * Captures a short burst of encoder snapshots at the internal sampling rate
+ * (up to 1000000 / FILTER_SAMPLE_INTERVAL_US Hz) into SRAM, far faster than
+ * the serial link could stream them, and dumps the buffer afterwards.
+ * Capture runs from the SAMPLE task and does not touch the START/STOP
+ * recording state, so POS streaming can continue during a burst.
+ *
+ * COMMANDS:
+ * - BURST <ms>[,<hz>] : capture <ms> milliseconds at <hz> (default: the
+ *                       sampling rate; rounded to an integer divisor of it)
+ * - BURST ABORT       : stop a capture or dump early
+ * - BURSTDUMP [seq]   : dump the last capture (from DATA line <seq>)
+ *
+ * REPLIES:
+ * - BURST,START,rateHz,samples,bufferBytes,capacity,freeSram
+ *     sent before capture begins; capacity = samples that fit when every
+ *     delta fits in 4 bits, freeSram = unused SRAM (-1 if unknown)
+ * - BURST,DONE,samples,bytes,gaps,COMPLETE|FULL|ABORTED
+ *     gaps = sample intervals more than 1.5x the nominal period
+ * - BURST,HDR,samples,rateHz,countsPerRev,startMicros,endMicros,gaps,
+ *             bytes,lines,count1,...,countN
+ * - BURST,DATA,seq,<hex bytes>,<crc16>      (up to BURST_DUMP_CHUNK bytes)
+ * - BURST,END,lines,<crc16 over all bytes>
+ *
+ * ENCODING:
+ * HDR carries the first sample's joint counts ((raw - zero) * direction).
+ * Every following sample is stored as deltas from the previous one:
+ * - (NUM_AXES + 1) / 2 bytes of 4-bit two's complement deltas, axis 1 in
+ *   the high nibble of the first byte
+ * - nibble 0x8 is an escape: that axis' delta follows the nibble bytes as
+ *   a zigzag-encoded LEB128 varint (escaped axes in axis order)
+ *
+ * CRC16 is CCITT (polynomial 0x1021, initial value 0xFFFF), in hex.
+ *
+ * ============================================================================
+ */
+
+#ifndef BURST_H
+#define BURST_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#if BURST_BUFFER_SIZE < 64
+#error "BURST_BUFFER_SIZE must be at least 64"
+#endif
+
+// ============================================================================
+// CONSTANTS
+// ============================================================================
+#define BURST_DUMP_CHUNK       32                        // Data bytes per DATA line
+#define BURST_NIBBLE_BYTES     ((NUM_AXES + 1) / 2)      // Nibble bytes per sample
+#define BURST_SAMPLE_MAX_BYTES (BURST_NIBBLE_BYTES + 5 * NUM_AXES)  // With every axis escaped
+#define BURST_LINE_MAX_LENGTH  (64 + 12 * NUM_AXES)      // Longest BURST line (HDR)
+
+// ============================================================================
+// FUNCTION DECLARATIONS
+// ============================================================================
+
+// Start a capture of 'samples' snapshots, one every 'divider' sampling
+// periods. Replies with BURST,START or an error.
+void Burst_Start(unsigned long samples, uint8_t divider);
+
+// Start a capture from BURST command parameters ("<ms>[,<hz>]")
+void Burst_Command(const char* params);
+
+// Stop a capture or dump in progress
+void Burst_Abort();
+
+// Dump the last capture, starting at DATA line 'fromSeq'
+void Burst_Dump(unsigned int fromSeq);
+
+// Store one snapshot if a capture is running (SAMPLE task)
+void Burst_Sample(const long* counts);
+
+// True while a capture is running
+bool Burst_IsCapturing();
+
+// Scheduler event: a DONE report or dump line is waiting and fits in the
+// transmit queue
+bool Burst_TxReady();
+
+// Send the next pending BURST line (BURST task)
+void Burst_Transmit();
+
+// CRC16-CCITT, for checking dumps on the host
+uint16_t Burst_Crc16(uint16_t crc, const uint8_t* data, uint16_t length);
+
+#endif // BURST_H
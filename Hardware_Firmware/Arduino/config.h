@@ -25,6 +25,41 @@
 // Recommended: 50ms (20 updates per second)
 #define UPDATE_INTERVAL_MS 50
 
+// Timestamp units in POS / VEL lines at power-up (change with SETTS):
+// false = millis() (1 ms resolution, wraps after ~49 days)
+// true  = micros() (4 us resolution, wraps after ~71.6 minutes - hosts
+//         must unwrap it, see Host_Tools clock_sync)
+#define TIMESTAMP_DEFAULT_US false
+
+// ============================================================================
+// MOTION-ADAPTIVE STREAMING (SETSTREAM MOTION)
+// ============================================================================
+// Send a point once the tip has moved this far (mm) or a joint has turned
+// this far (degrees, 0 = off) since the last point, and at least every
+// MOTION_MAX_INTERVAL_MS (0 = no heartbeat). These are the defaults for
+// SETSTREAM MOTION without parameters. A joint flicking back one count
+// from the last point is taken as dither and ignored (see motion_trigger.cpp).
+#define MOTION_DISTANCE_MM 1.0
+#define MOTION_ANGLE_DEG 2.0
+#define MOTION_MAX_INTERVAL_MS 1000
+
+// How often the tip position is checked in motion mode (microseconds).
+// A point can land up to speed x interval past the distance threshold
+// (0.4 mm at 200 mm/s). Each check that runs costs about 1 ms of CPU.
+#define MOTION_CHECK_INTERVAL_US 2000
+
+// ============================================================================
+// ARM GEOMETRY - NUMBER OF AXES
+// ============================================================================
+// Number of jointed axes (encoders) on the arm: 2 to 8
+// (4 = CONFIG B; 5 or 6 for an arm with a rotating wrist).
+// Every per-axis list below (pins, joint types, link lengths, directions,
+// zero offsets) must have exactly NUM_AXES entries - the build fails if not.
+// Can be overridden from the build command line (e.g. for host builds).
+#ifndef NUM_AXES
+#define NUM_AXES 4
+#endif
+
 // ============================================================================
 // ENCODER SETTINGS
 // ============================================================================
@@ -41,69 +76,191 @@
 #define ENCODER_MULTIPLIER 4
 
 // Total counts per full revolution
-#define COUNTS_PER_REVOLUTION (ENCODER_PPR * ENCODER_MULTIPLIER)
+// (long math: 10,000 PPR x 4 does not fit in the Mega's 16-bit int)
+#define COUNTS_PER_REVOLUTION ((long)ENCODER_PPR * ENCODER_MULTIPLIER)
+
+// ============================================================================
+// ENCODER BACKEND
+// ============================================================================
+// How encoder counts are obtained:
+// ENCODER_BACKEND_ISR     - Encoders wired to interrupt pins (default; axes limited
+//                           by the Mega's interrupt pins)
+// ENCODER_BACKEND_LS7366R - LS7366R quadrature counter chips on SPI
+//                           (no CPU cost per count, 10k+ PPR encoders)
+// ENCODER_BACKEND_SSI     - SSI absolute encoders (no homing at power-up)
+// ENCODER_BACKEND_BISS    - BiSS-C absolute encoders (no homing, CRC checked)
+// For absolute encoders set ENCODER_PPR to the counts per turn
+// (2^ENCODER_ABS_BITS) and ENCODER_MULTIPLIER to 1.
+// Can be overridden from the build command line (e.g. for host builds).
+#ifndef ENCODER_BACKEND
+#define ENCODER_BACKEND ENCODER_BACKEND_ISR
+#endif
+
+// SPI chip select pins, one per axis (LS7366R / SSI / BiSS backends)
+// List one pin per axis (NUM_AXES entries)
+#define ENCODER_SPI_CS_PINS { 53, 49, 48, 47 }
+
+// SPI clock for LS7366R counters (Hz)
+#define ENCODER_SPI_CLOCK_HZ 4000000
+
+// Absolute encoders: clock rate (Hz), single-turn resolution (bits) and,
+// for SSI only, whether the position is Gray coded
+#define ENCODER_ABS_CLOCK_HZ 1000000
+#define ENCODER_ABS_BITS 13
+#define ENCODER_SSI_GRAY_CODE true
 
 // ============================================================================
-// ENCODER PIN ASSIGNMENTS
+// JOINT FILTER SETTINGS
 // ============================================================================
-// Arduino Mega 2560 Interrupt Pins: 2, 3, 18, 19, 20, 21
-// We need 8 pins total (4 encoders x 2 channels each)
-// Using hardware interrupts for first 3 encoders (6 pins)
-// Using pin change interrupts for 4th encoder (2 pins)
+// Encoders are sampled and filtered on the Arduino at this internal rate,
+// independent of UPDATE_INTERVAL_MS (which only controls how often data is
+// sent). 250 us = 4 kHz.
+#define FILTER_SAMPLE_INTERVAL_US 250
 
-// ENCODER 1 - Base Rotation (Axis 1)
-#define ENCODER_1_PIN_A 2   // Hardware interrupt pin
-#define ENCODER_1_PIN_B 3   // Hardware interrupt pin
+// Filter mode at power-up (can be changed with the SETFILTER command)
+// FILTER_MODE_NONE, FILTER_MODE_MEDIAN, FILTER_MODE_AB, FILTER_MODE_MEDIAN_AB
+#define FILTER_DEFAULT_MODE FILTER_MODE_NONE
 
-// ENCODER 2 - Shoulder Pitch (Axis 2)
-#define ENCODER_2_PIN_A 18  // Hardware interrupt pin
-#define ENCODER_2_PIN_B 19  // Hardware interrupt pin
+// Median window length in samples (3, 5 or 7)
+// Longer = rejects longer glitches, but adds (size-1)/2 samples of delay
+#define FILTER_MEDIAN_SIZE 5
 
-// ENCODER 3 - Elbow Pitch (Axis 3)
-#define ENCODER_3_PIN_A 20  // Hardware interrupt pin
-#define ENCODER_3_PIN_B 21  // Hardware interrupt pin
+// Alpha-beta tracker gains (0-1, can be changed with the SETAB command)
+// Lower alpha = smoother but more lag. A good starting point for a
+// critically damped response is beta = alpha^2 / (2 - alpha)
+#define FILTER_ALPHA 0.10
+#define FILTER_BETA 0.005
 
-// ENCODER 4 - Wrist Pitch (Axis 4)
-#define ENCODER_4_PIN_A 22  // Digital pin (using pin change interrupt)
-#define ENCODER_4_PIN_B 23  // Digital pin (using pin change interrupt)
+// A jump larger than this (counts per sample) re-seeds the filter instead of
+// being tracked (happens on ZERO or an encoder fault). Max 127.
+#define FILTER_RESYNC_COUNTS 100
 
 // ============================================================================
-// ARM DIMENSIONS (millimeters)
+// VELOCITY ESTIMATION SETTINGS
 // ============================================================================
-// Measure these distances CENTER-TO-CENTER between rotation axes
-// These are CRITICAL for accurate coordinate calculation
+// Joint velocity is measured between encoder edge times (see velocity.h).
+// Tracking needs an encoder snapshot every sample. That is almost free with
+// the ISR backend, but SPI backends then read every encoder at the sampling
+// rate, and the CPU busy-polls instead of sleeping between tasks. Set false
+// to stop sampling when nothing else (filter, BURST, motion streaming)
+// needs those reads. GETVEL / STREAMVEL then report 0.
+#define VELOCITY_TRACKING true
 
-// Distance from base center to shoulder axis
-#define LINK_1_LENGTH 254.0  // mm
+// A measurement closes once the count has changed by VELOCITY_MIN_COUNTS
+// (4 = one full quadrature cycle, which cancels A/B phase errors) or
+// VELOCITY_MAX_WINDOW_US has passed since the last one.
+#define VELOCITY_MIN_COUNTS 4
+#define VELOCITY_MAX_WINDOW_US 20000
 
-// Distance from shoulder axis to elbow axis
-#define LINK_2_LENGTH 254.0  // mm
+// No edge for this long = joint stopped (also the slowest speed reported:
+// one count per 250 ms)
+#define VELOCITY_TIMEOUT_US 250000
 
-// Distance from elbow axis to wrist axis
-#define LINK_3_LENGTH 254.0  // mm
+// Send a VEL line with every streamed POS line at power-up
+// (can be changed with the STREAMVEL command)
+#define VELOCITY_STREAM_DEFAULT false
 
-// Distance from wrist axis to probe tip
-#define LINK_4_LENGTH 35.0   // mm
+// ============================================================================
+// BURST CAPTURE SETTINGS
+// ============================================================================
+// SRAM reserved for BURST captures (the Mega has 8 KB in total). Samples are
+// delta-encoded in 4-bit steps, so each one normally costs NUM_AXES / 2
+// bytes: 4096 bytes hold about 2000 samples of a 4-axis arm (0.5 s at the
+// 4 kHz sampling rate, 1 s at 2 kHz).
+#define BURST_BUFFER_SIZE 4096
+
+// ============================================================================
+// SEQUENCED STREAMING (SETSEQ ON)
+// ============================================================================
+// Streamed frames kept on the device for RESEND (see frame_history.h).
+// Each costs 17 + 8 x NUM_AXES bytes of SRAM (49 bytes with 4 axes). The
+// ring is also the send queue, so it must cover the host's round trip
+// (RESEND reaching the device) plus any backlog while the link is
+// saturated: 16 frames = 0.8 s at the 20 Hz default rate.
+#define SEQ_HISTORY_SIZE 16
+
+// RESEND ranges that can wait to be sent
+#define SEQ_RESEND_QUEUE 4
+
+// Sequenced frames (SPOS) instead of POS / VEL lines at power-up
+// (can be changed with the SETSEQ command)
+#define SEQ_STREAM_DEFAULT false
+
+// ============================================================================
+// LATENCY TRACING (SETTRACE)
+// ============================================================================
+// Every nth streamed POS line is followed by a TRC line with its device
+// timestamps (see latency_trace.h). 0 = off at power-up (can be changed
+// with the SETTRACE command).
+#define TRACE_DEFAULT_INTERVAL 0
+
+// ============================================================================
+// SCHEDULER SETTINGS
+// ============================================================================
+// The CPU only sleeps when no task is due for at least this long
+// (never while the sampling task runs, see VELOCITY_TRACKING).
+// The millis() timer wakes the CPU every 1024 us, so this must be larger.
+#define SCHEDULER_SLEEP_MIN_US 1100
+
+// Period of the housekeeping task (CPU load statistics)
+#define HOUSEKEEPING_INTERVAL_MS 1000
+
+// ============================================================================
+// ENCODER PIN ASSIGNMENTS (ISR backend)
+// ============================================================================
+// Arduino Mega 2560 external interrupt pins: 2, 3, 18, 19, 20, 21
+// Pin change interrupt pins: 10-15, 50-53, A8-A15 (62-69)
+// Each axis needs 2 pins (A and B channels). The first 3 axes use the
+// external interrupt pins, axis 4 pin change interrupts on A8 / A9.
+// Any other pin fails the build; for more axes than the pins allow, use
+// an SPI encoder backend.
+// List one pin per axis (NUM_AXES entries), axis 1 first.
+//
+// Axis:                  1   2   3   4
+#define ENCODER_PINS_A {  2, 18, 20, 62 }
+#define ENCODER_PINS_B {  3, 19, 21, 63 }
+
+// ============================================================================
+// JOINT TYPES
+// ============================================================================
+// How each axis rotates, relative to the link before it:
+// JOINT_YAW   - about the vertical axis (base rotation)
+// JOINT_PITCH - up/down, in the plane of the arm
+// JOINT_ROLL  - about the link's own length (rotating wrist)
+//
+// CONFIG B (4-axis): base yaw, shoulder / elbow / wrist pitch
+// Example 6-axis with a rotating wrist:
+//   { JOINT_YAW, JOINT_PITCH, JOINT_PITCH, JOINT_PITCH, JOINT_ROLL, JOINT_PITCH }
+#define JOINT_TYPES { JOINT_YAW, JOINT_PITCH, JOINT_PITCH, JOINT_PITCH }
+
+// ============================================================================
+// ARM DIMENSIONS (millimeters)
+// ============================================================================
+// Measure these distances CENTER-TO-CENTER between rotation axes
+// These are CRITICAL for accurate coordinate calculation
+//
+// One length per axis (NUM_AXES entries), in order from the base to the
+// probe tip. CONFIG B (4-axis):
+// - Link 1: Base to shoulder
+// - Link 2: Shoulder to elbow
+// - Link 3: Elbow to wrist
+// - Link 4: Wrist to tip
+//
+#define LINK_LENGTHS { 254.0, 254.0, 254.0, 35.0 }
 
 // ============================================================================
 // ENCODER DIRECTION SETTINGS
 // ============================================================================
-// Set to 1 for normal direction, -1 to reverse
+// Set to 1 for normal direction, -1 to reverse (one per axis)
 // Change these if your encoders count backwards
-#define ENCODER_1_DIRECTION 1
-#define ENCODER_2_DIRECTION 1
-#define ENCODER_3_DIRECTION 1
-#define ENCODER_4_DIRECTION 1
+#define ENCODER_DIRECTIONS { 1, 1, 1, 1 }
 
 // ============================================================================
 // ZERO OFFSET SETTINGS
 // ============================================================================
-// Encoder counts when arm is in "home" position
+// Encoder counts when arm is in "home" position (one per axis)
 // Set these after calibration using the PC software
-#define ENCODER_1_ZERO_OFFSET 0
-#define ENCODER_2_ZERO_OFFSET 0
-#define ENCODER_3_ZERO_OFFSET 0
-#define ENCODER_4_ZERO_OFFSET 0
+#define ENCODER_ZERO_OFFSETS { 0, 0, 0, 0 }
 
 // ============================================================================
 // DEBUGGING OPTIONS
@@ -3,67 +3,52 @@
  * ENCODER MODULE - IMPLEMENTATION FILE
  * ============================================================================
  * 
- * This file implements quadrature encoder reading using interrupts.
- * Each encoder uses 2 pins (A and B channels) to determine direction.
- * 
- * QUADRATURE ENCODING:
- * - When rotating clockwise: A leads B by 90 degrees
- * - When rotating counter-clockwise: B leads A by 90 degrees
- * - We detect edges on both channels to get 4x resolution
+ * This file converts raw encoder counts to joint angles. Where the counts
+ * come from is up to the backend selected in config.h:
+ * - encoder_isr.cpp      : interrupt-driven quadrature decoding (default)
+ * - encoder_ls7366r.cpp  : LS7366R quadrature counter ICs on SPI
+ * - encoder_absolute.cpp : SSI / BiSS-C absolute encoders on SPI
  * 
  * ============================================================================
  */
 
 #include "encoder.h"
+#include "joint_filter.h"
 
 // ============================================================================
 // GLOBAL ENCODER DATA INSTANCES
 // ============================================================================
-EncoderData encoder1 = {0, 0, ENCODER_1_DIRECTION, 0.0, 0.0};
-EncoderData encoder2 = {0, 0, ENCODER_2_DIRECTION, 0.0, 0.0};
-EncoderData encoder3 = {0, 0, ENCODER_3_DIRECTION, 0.0, 0.0};
-EncoderData encoder4 = {0, 0, ENCODER_4_DIRECTION, 0.0, 0.0};
+EncoderState encoders;
+
+// Failed absolute-encoder reads (maintained by the SSI/BiSS backend)
+unsigned long encoderReadErrors = 0;
 
 // ============================================================================
 // PRIVATE VARIABLES
 // ============================================================================
-static int currentEncoderPPR = ENCODER_PPR;
+static const int8_t defaultDirections[] = ENCODER_DIRECTIONS;
+static const long defaultZeroOffsets[] = ENCODER_ZERO_OFFSETS;
+AXIS_LIST_CHECK(defaultDirections, "ENCODER_DIRECTIONS");
+AXIS_LIST_CHECK(defaultZeroOffsets, "ENCODER_ZERO_OFFSETS");
+
+static long currentEncoderPPR = ENCODER_PPR;
+static unsigned long sampleMillis = 0;   // When Encoder_Update() last sampled
+static unsigned long sampleMicros = 0;
+static long sampleCounts[NUM_AXES];      // Raw counts of that sample
 static float countsPerRadian = COUNTS_PER_REVOLUTION / (2.0 * PI);
 
 // ============================================================================
 // INITIALIZATION FUNCTION
 // ============================================================================
 void Encoder_Init() {
-  // Configure encoder pins as inputs with pullups
-  pinMode(ENCODER_1_PIN_A, INPUT_PULLUP);
-  pinMode(ENCODER_1_PIN_B, INPUT_PULLUP);
-  pinMode(ENCODER_2_PIN_A, INPUT_PULLUP);
-  pinMode(ENCODER_2_PIN_B, INPUT_PULLUP);
-  pinMode(ENCODER_3_PIN_A, INPUT_PULLUP);
-  pinMode(ENCODER_3_PIN_B, INPUT_PULLUP);
-  pinMode(ENCODER_4_PIN_A, INPUT_PULLUP);
-  pinMode(ENCODER_4_PIN_B, INPUT_PULLUP);
-  
-  // Attach hardware interrupts for encoders 1-3
-  // CHANGE mode triggers on any pin state change (rising or falling)
-  attachInterrupt(digitalPinToInterrupt(ENCODER_1_PIN_A), ISR_Encoder1_A, CHANGE);
-  attachInterrupt(digitalPinToInterrupt(ENCODER_1_PIN_B), ISR_Encoder1_B, CHANGE);
-  attachInterrupt(digitalPinToInterrupt(ENCODER_2_PIN_A), ISR_Encoder2_A, CHANGE);
-  attachInterrupt(digitalPinToInterrupt(ENCODER_2_PIN_B), ISR_Encoder2_B, CHANGE);
-  attachInterrupt(digitalPinToInterrupt(ENCODER_3_PIN_A), ISR_Encoder3_A, CHANGE);
-  attachInterrupt(digitalPinToInterrupt(ENCODER_3_PIN_B), ISR_Encoder3_B, CHANGE);
+  // Start the selected backend (pins, interrupts or SPI peripherals)
+  encoderBackend.init();
   
-  // Attach pin change interrupts for encoder 4
-  // Note: Pin 22-23 on Mega use PCINT (Pin Change Interrupt)
-  // This is implemented differently than hardware interrupts
-  attachInterrupt(digitalPinToInterrupt(ENCODER_4_PIN_A), ISR_Encoder4_A, CHANGE);
-  attachInterrupt(digitalPinToInterrupt(ENCODER_4_PIN_B), ISR_Encoder4_B, CHANGE);
-  
-  // Set initial zero offsets from config
-  encoder1.zeroOffset = ENCODER_1_ZERO_OFFSET;
-  encoder2.zeroOffset = ENCODER_2_ZERO_OFFSET;
-  encoder3.zeroOffset = ENCODER_3_ZERO_OFFSET;
-  encoder4.zeroOffset = ENCODER_4_ZERO_OFFSET;
+  // Set directions and initial zero offsets from config
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    encoders.direction[i] = defaultDirections[i];
+    encoders.zeroOffset[i] = defaultZeroOffsets[i];
+  }
   
   #if DEBUG_ENCODERS
   Serial.println(F("Encoders initialized"));
@@ -76,29 +61,26 @@ void Encoder_Init() {
 void Encoder_Update() {
   // Calculate angles for each encoder
   // Formula: angle (radians) = (count - zero) / countsPerRadian * direction
+  // When the joint filter is on, its (fractional) count is used instead
+  long counts[NUM_AXES];
+  sampleMicros = micros();
+  sampleMillis = millis();
+  Encoder_GetCounts(counts);
   
-  long adjustedCount1 = (encoder1.count - encoder1.zeroOffset) * encoder1.direction;
-  encoder1.angleRadians = (float)adjustedCount1 / countsPerRadian;
-  encoder1.angleDegrees = encoder1.angleRadians * 180.0 / PI;
-  
-  long adjustedCount2 = (encoder2.count - encoder2.zeroOffset) * encoder2.direction;
-  encoder2.angleRadians = (float)adjustedCount2 / countsPerRadian;
-  encoder2.angleDegrees = encoder2.angleRadians * 180.0 / PI;
-  
-  long adjustedCount3 = (encoder3.count - encoder3.zeroOffset) * encoder3.direction;
-  encoder3.angleRadians = (float)adjustedCount3 / countsPerRadian;
-  encoder3.angleDegrees = encoder3.angleRadians * 180.0 / PI;
-  
-  long adjustedCount4 = (encoder4.count - encoder4.zeroOffset) * encoder4.direction;
-  encoder4.angleRadians = (float)adjustedCount4 / countsPerRadian;
-  encoder4.angleDegrees = encoder4.angleRadians * 180.0 / PI;
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    sampleCounts[i] = counts[i];
+    float adjustedCount = (JointFilter_GetCount(i + 1, counts[i]) - encoders.zeroOffset[i]) * encoders.direction[i];
+    encoders.angleRadians[i] = adjustedCount / countsPerRadian;
+    encoders.angleDegrees[i] = encoders.angleRadians[i] * (180.0 / PI);
+  }
   
   #if DEBUG_ENCODERS
-  Serial.print(F("Enc Counts: "));
-  Serial.print(encoder1.count); Serial.print(F(" "));
-  Serial.print(encoder2.count); Serial.print(F(" "));
-  Serial.print(encoder3.count); Serial.print(F(" "));
-  Serial.println(encoder4.count);
+  Serial.print(F("Enc Counts:"));
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    Serial.print(F(" "));
+    Serial.print(counts[i]);
+  }
+  Serial.println();
   #endif
 }
 
@@ -107,10 +89,11 @@ void Encoder_Update() {
 // ============================================================================
 void Encoder_Zero() {
   // Store current counts as zero offsets
-  encoder1.zeroOffset = encoder1.count;
-  encoder2.zeroOffset = encoder2.count;
-  encoder3.zeroOffset = encoder3.count;
-  encoder4.zeroOffset = encoder4.count;
+  long counts[NUM_AXES];
+  Encoder_GetCounts(counts);
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    encoders.zeroOffset[i] = counts[i];
+  }
   
   #if DEBUG_ENCODERS
   Serial.println(F("Encoders zeroed at current position"));
@@ -120,9 +103,9 @@ void Encoder_Zero() {
 // ============================================================================
 // SET RESOLUTION FUNCTION - Change encoder PPR
 // ============================================================================
-void Encoder_SetResolution(int ppr) {
+void Encoder_SetResolution(long ppr) {
   currentEncoderPPR = ppr;
-  int newCountsPerRev = ppr * ENCODER_MULTIPLIER;
+  long newCountsPerRev = ppr * ENCODER_MULTIPLIER;
   countsPerRadian = (float)newCountsPerRev / (2.0 * PI);
   
   #if DEBUG_ENCODERS
@@ -135,122 +118,59 @@ void Encoder_SetResolution(int ppr) {
 // ============================================================================
 // GETTER FUNCTIONS
 // ============================================================================
+// encoderNum is 1-based (axis 1 = base)
 float Encoder_GetAngleRadians(int encoderNum) {
-  switch(encoderNum) {
-    case 1: return encoder1.angleRadians;
-    case 2: return encoder2.angleRadians;
-    case 3: return encoder3.angleRadians;
-    case 4: return encoder4.angleRadians;
-    default: return 0.0;
-  }
+  if (encoderNum < 1 || encoderNum > NUM_AXES) return 0.0;
+  return encoders.angleRadians[encoderNum - 1];
 }
 
 float Encoder_GetAngleDegrees(int encoderNum) {
-  switch(encoderNum) {
-    case 1: return encoder1.angleDegrees;
-    case 2: return encoder2.angleDegrees;
-    case 3: return encoder3.angleDegrees;
-    case 4: return encoder4.angleDegrees;
-    default: return 0.0;
-  }
+  if (encoderNum < 1 || encoderNum > NUM_AXES) return 0.0;
+  return encoders.angleDegrees[encoderNum - 1];
 }
 
 long Encoder_GetCount(int encoderNum) {
-  switch(encoderNum) {
-    case 1: return encoder1.count;
-    case 2: return encoder2.count;
-    case 3: return encoder3.count;
-    case 4: return encoder4.count;
-    default: return 0;
-  }
+  if (encoderNum < 1 || encoderNum > NUM_AXES) return 0;
+  noInterrupts();  // 32-bit read is not atomic on AVR
+  long count = encoders.count[encoderNum - 1];
+  interrupts();
+  return count;
 }
 
-// ============================================================================
-// INTERRUPT SERVICE ROUTINES (ISRs)
-// ============================================================================
-// These functions are called automatically when encoder pins change
-// They must be FAST - no Serial.print() or delays!
-// 
-// QUADRATURE DECODING LOGIC:
-// Read both A and B pins, determine direction based on their relationship
-// Increment or decrement count accordingly
+long Encoder_GetCountsPerRevolution() {
+  return currentEncoderPPR * ENCODER_MULTIPLIER;
+}
 
-void ISR_Encoder1_A() {
-  bool A = digitalRead(ENCODER_1_PIN_A);
-  bool B = digitalRead(ENCODER_1_PIN_B);
-  if (A == B) {
-    encoder1.count++;
-  } else {
-    encoder1.count--;
-  }
+float Encoder_CountsToDegrees(float counts) {
+  return counts / countsPerRadian * 180.0 / PI;
 }
 
-void ISR_Encoder1_B() {
-  bool A = digitalRead(ENCODER_1_PIN_A);
-  bool B = digitalRead(ENCODER_1_PIN_B);
-  if (A != B) {
-    encoder1.count++;
-  } else {
-    encoder1.count--;
-  }
+unsigned long Encoder_GetSampleMillis() {
+  return sampleMillis;
 }
 
-void ISR_Encoder2_A() {
-  bool A = digitalRead(ENCODER_2_PIN_A);
-  bool B = digitalRead(ENCODER_2_PIN_B);
-  if (A == B) {
-    encoder2.count++;
-  } else {
-    encoder2.count--;
-  }
+unsigned long Encoder_GetSampleMicros() {
+  return sampleMicros;
 }
 
-void ISR_Encoder2_B() {
-  bool A = digitalRead(ENCODER_2_PIN_A);
-  bool B = digitalRead(ENCODER_2_PIN_B);
-  if (A != B) {
-    encoder2.count++;
-  } else {
-    encoder2.count--;
+void Encoder_GetSampleCounts(long* counts) {
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    counts[i] = sampleCounts[i];
   }
 }
 
-void ISR_Encoder3_A() {
-  bool A = digitalRead(ENCODER_3_PIN_A);
-  bool B = digitalRead(ENCODER_3_PIN_B);
-  if (A == B) {
-    encoder3.count++;
-  } else {
-    encoder3.count--;
-  }
+void Encoder_GetCounts(long* counts) {
+  encoderBackend.readCounts(counts, NULL);
 }
 
-void ISR_Encoder3_B() {
-  bool A = digitalRead(ENCODER_3_PIN_A);
-  bool B = digitalRead(ENCODER_3_PIN_B);
-  if (A != B) {
-    encoder3.count++;
-  } else {
-    encoder3.count--;
-  }
+void Encoder_GetSnapshot(long* counts, unsigned long* edgeMicros) {
+  encoderBackend.readCounts(counts, edgeMicros);
 }
 
-void ISR_Encoder4_A() {
-  bool A = digitalRead(ENCODER_4_PIN_A);
-  bool B = digitalRead(ENCODER_4_PIN_B);
-  if (A == B) {
-    encoder4.count++;
-  } else {
-    encoder4.count--;
-  }
+const char* Encoder_GetBackendName() {
+  return encoderBackend.name;
 }
 
-void ISR_Encoder4_B() {
-  bool A = digitalRead(ENCODER_4_PIN_A);
-  bool B = digitalRead(ENCODER_4_PIN_B);
-  if (A != B) {
-    encoder4.count++;
-  } else {
-    encoder4.count--;
-  }
+unsigned long Encoder_GetReadErrors() {
+  return encoderReadErrors;
 }
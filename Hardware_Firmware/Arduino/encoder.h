@@ -4,7 +4,8 @@
  * ============================================================================
  * 
  * This module handles reading quadrature encoders to track joint angles.
- * Supports up to 4 encoders with hardware and pin-change interrupts.
+ * Supports NUM_AXES encoders (config.h) through a pluggable backend (see
+ * ENCODER BACKENDS below), selected with ENCODER_BACKEND in config.h.
  * 
  * ============================================================================
  */
@@ -15,24 +16,57 @@
 #include <Arduino.h>
 #include "config.h"
 
+#if NUM_AXES < 2 || NUM_AXES > 8
+#error "NUM_AXES must be between 2 and 8"
+#endif
+
+// Compile-time check that a per-axis list from config.h has NUM_AXES entries
+#define AXIS_LIST_CHECK(array, listName) \
+  static_assert(sizeof(array) / sizeof((array)[0]) == NUM_AXES, \
+                listName " in config.h must have NUM_AXES entries")
+
+// ============================================================================
+// ENCODER BACKENDS
+// ============================================================================
+// A backend is how raw counts are obtained. Exactly one is compiled in.
+#define ENCODER_BACKEND_ISR      0  // Quadrature decoded in pin interrupts (encoder_isr.cpp)
+#define ENCODER_BACKEND_LS7366R  1  // LS7366R 32-bit counter ICs on SPI (encoder_ls7366r.cpp)
+#define ENCODER_BACKEND_SSI      2  // SSI absolute encoders on SPI (encoder_absolute.cpp)
+#define ENCODER_BACKEND_BISS     3  // BiSS-C absolute encoders on SPI (encoder_absolute.cpp)
+
+struct EncoderBackend {
+  const char* name;                 // Shown by INFO
+  bool absolute;                    // Position valid at power-up (no homing needed)
+  void (*init)();                   // Configure pins/peripherals
+  void (*readCounts)(long* counts, unsigned long* edgeMicros);
+                                    // Coherent snapshot of all NUM_AXES counts
+                                    // (and edge times, if edgeMicros != NULL);
+                                    // also keeps encoders.count up to date
+};
+
+// The backend selected by ENCODER_BACKEND (defined in its own .cpp file)
+extern const EncoderBackend encoderBackend;
+
 // ============================================================================
 // ENCODER DATA STRUCTURE
 // ============================================================================
-struct EncoderData {
-  volatile long count;      // Raw encoder count (can be negative)
-  long zeroOffset;          // Count value at zero position
-  int direction;            // 1 = normal, -1 = reversed
-  float angleRadians;       // Current angle in radians
-  float angleDegrees;       // Current angle in degrees
+// One array per field (index 0 = axis 1), so per-axis work is a tight loop
+// over contiguous values
+struct EncoderState {
+  volatile long count[NUM_AXES];   // Raw encoder count (can be negative)
+  volatile unsigned long edgeMicros[NUM_AXES];  // micros() when the count last changed
+  long zeroOffset[NUM_AXES];       // Count value at zero position
+  int8_t direction[NUM_AXES];      // 1 = normal, -1 = reversed
+  float angleRadians[NUM_AXES];    // Current angle in radians
+  float angleDegrees[NUM_AXES];    // Current angle in degrees
 };
 
 // ============================================================================
 // GLOBAL ENCODER DATA
 // ============================================================================
-extern EncoderData encoder1;  // Base rotation
-extern EncoderData encoder2;  // Shoulder pitch
-extern EncoderData encoder3;  // Elbow pitch
-extern EncoderData encoder4;  // Wrist pitch
+extern EncoderState encoders;
+
+extern unsigned long encoderReadErrors;  // Failed absolute-encoder reads
 
 // ============================================================================
 // FUNCTION DECLARATIONS
@@ -47,29 +81,62 @@ void Encoder_Update();
 // Zero all encoders at current position
 void Encoder_Zero();
 
-// Set encoder resolution (PPR)
-void Encoder_SetResolution(int ppr);
+// Set encoder resolution (PPR, or counts per turn for absolute encoders)
+void Encoder_SetResolution(long ppr);
 
-// Get angle in radians for specified encoder (1-4)
+// Get angle in radians for specified encoder (1-NUM_AXES)
 float Encoder_GetAngleRadians(int encoderNum);
 
-// Get angle in degrees for specified encoder (1-4)
+// Get angle in degrees for specified encoder (1-NUM_AXES)
 float Encoder_GetAngleDegrees(int encoderNum);
 
-// Get raw count for specified encoder (1-4)
+// Get raw count for specified encoder (1-NUM_AXES)
 long Encoder_GetCount(int encoderNum);
 
+// Counts per revolution at the current resolution (PPR x multiplier)
+long Encoder_GetCountsPerRevolution();
+
+// Convert a count difference to degrees at the current resolution
+float Encoder_CountsToDegrees(float counts);
+
+// millis() / micros() when Encoder_Update() took its snapshot
+unsigned long Encoder_GetSampleMillis();
+unsigned long Encoder_GetSampleMicros();
+
+// Raw counts of that snapshot (the angles were calculated from these)
+void Encoder_GetSampleCounts(long* counts);
+
+// Coherent snapshot of all NUM_AXES raw counts from the backend
+void Encoder_GetCounts(long* counts);
+
+// Same, plus micros() of each axis' last count change, taken together.
+// The ISR backend stamps every edge; SPI backends stamp the read that saw
+// the change, so their edge times have the sampling period's resolution.
+void Encoder_GetSnapshot(long* counts, unsigned long* edgeMicros);
+
+// Name of the active backend ("ISR", "LS7366R", "SSI", "BISS")
+const char* Encoder_GetBackendName();
+
+// Number of failed absolute-encoder reads (bad frame / CRC) since startup
+unsigned long Encoder_GetReadErrors();
+
 // ============================================================================
-// INTERRUPT SERVICE ROUTINES (ISRs)
+// ABSOLUTE ENCODER HELPERS (used by the SSI/BiSS backend, host-testable)
 // ============================================================================
-// These are called automatically when encoder pins change state
-void ISR_Encoder1_A();
-void ISR_Encoder1_B();
-void ISR_Encoder2_A();
-void ISR_Encoder2_B();
-void ISR_Encoder3_A();
-void ISR_Encoder3_B();
-void ISR_Encoder4_A();
-void ISR_Encoder4_B();
+#define BISS_OK            0
+#define BISS_NO_START      1  // No ack/start bit found in the frame
+#define BISS_ERROR_BIT     2  // Encoder reported an error (nE low)
+#define BISS_CRC_ERROR     3  // CRC mismatch
+
+// Gray code to binary
+uint32_t Encoder_GrayToBinary(uint32_t gray);
+
+// BiSS-C CRC6 (polynomial x^6 + x + 1) over the low 'bits' bits of 'data'
+uint8_t Encoder_BissCrc6(uint32_t data, uint8_t bits);
+
+// Decode a BiSS-C frame sampled MSB-first into 'frame' (frameBytes long)
+// with 'positionBits' single-cycle data bits. Returns BISS_xxx.
+uint8_t Encoder_ParseBissFrame(const uint8_t* frame, uint8_t frameBytes,
+                               uint8_t positionBits, uint32_t* position);
 
 #endif // ENCODER_H
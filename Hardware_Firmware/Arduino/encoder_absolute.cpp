@@ -0,0 +1,239 @@
+/*
+ * ============================================================================
+ * ENCODER BACKEND - SSI / BiSS-C ABSOLUTE ENCODERS (SPI)
+ * ============================================================================
+ *
+ * Absolute encoders report their position directly, so the arm is usable
+ * immediately after power-up without re-zeroing: set ENCODER_ZERO_OFFSETS
+ * in config.h to the count each joint reads at the home pose once.
+ *
+ * WIRING:
+ * - The SPI clock (SCK, Mega pin 52) drives the encoder clock inputs and
+ *   MISO (pin 50) reads the data lines through RS-422 receivers
+ * - Each ENCODER_SPI_CS_PINS entry enables one axis' clock driver / data
+ *   receiver, so only one encoder is on the bus at a time
+ *
+ * FRAMES (clock idles high, data sampled on the falling edge = SPI mode 2):
+ * - SSI    : dummy bit, then ENCODER_ABS_BITS of position, MSB first
+ *            (binary or Gray code - see ENCODER_SSI_GRAY_CODE)
+ * - BiSS-C : ack (low) ... start (high), CDS, position bits, nE, nW,
+ *            inverted CRC6 - see Encoder_ParseBissFrame()
+ *
+ * Single-turn readings are unwrapped into a continuous count, so a joint
+ * that moves through the encoder's 0/max point does not jump a full turn.
+ *
+ * Selected with: #define ENCODER_BACKEND ENCODER_BACKEND_SSI
+ *            or: #define ENCODER_BACKEND ENCODER_BACKEND_BISS
+ *
+ * ============================================================================
+ */
+
+#include "encoder.h"
+
+#if ENCODER_ABS_BITS < 8 || ENCODER_ABS_BITS > 30
+#error "ENCODER_ABS_BITS must be between 8 and 30"
+#endif
+
+// ============================================================================
+// GRAY CODE
+// ============================================================================
+uint32_t Encoder_GrayToBinary(uint32_t gray) {
+  gray ^= gray >> 16;
+  gray ^= gray >> 8;
+  gray ^= gray >> 4;
+  gray ^= gray >> 2;
+  gray ^= gray >> 1;
+  return gray;
+}
+
+// ============================================================================
+// BiSS-C CRC6 (x^6 + x + 1), MSB first, initial value 0
+// ============================================================================
+uint8_t Encoder_BissCrc6(uint32_t data, uint8_t bits) {
+  uint8_t crc = 0;
+  for (int8_t i = bits - 1; i >= 0; i--) {
+    uint8_t feedback = ((crc >> 5) ^ (uint8_t)(data >> i)) & 1;
+    crc = (crc << 1) & 0x3F;
+    if (feedback) crc ^= 0x03;
+  }
+  return crc;
+}
+
+// ============================================================================
+// BiSS-C FRAME PARSER
+// ============================================================================
+static inline uint8_t FrameBit(const uint8_t* frame, uint16_t i) {
+  return (frame[i >> 3] >> (7 - (i & 7))) & 1;
+}
+
+uint8_t Encoder_ParseBissFrame(const uint8_t* frame, uint8_t frameBytes,
+                               uint8_t positionBits, uint32_t* position) {
+  uint16_t total = (uint16_t)frameBytes * 8;
+  uint16_t i = 0;
+
+  // Idle (high) until the encoder acknowledges (low) ...
+  while (i < total && FrameBit(frame, i)) i++;
+  // ... then stays low until the start bit (high)
+  while (i < total && !FrameBit(frame, i)) i++;
+
+  // Start bit + CDS bit + data + nE + nW + CRC6
+  uint8_t dataBits = positionBits + 2;
+  if (i + 2 + dataBits + 6 > total) return BISS_NO_START;
+  i += 2;
+
+  uint32_t data = 0;
+  for (uint8_t k = 0; k < dataBits; k++) {
+    data = (data << 1) | FrameBit(frame, i++);
+  }
+
+  uint8_t crc = 0;
+  for (uint8_t k = 0; k < 6; k++) {
+    crc = (crc << 1) | FrameBit(frame, i++);
+  }
+
+  // CRC is transmitted inverted
+  if ((uint8_t)(~crc & 0x3F) != Encoder_BissCrc6(data, dataBits)) return BISS_CRC_ERROR;
+
+  // nE (error, active low) is the second-to-last data bit
+  if (!(data & 0x02)) return BISS_ERROR_BIT;
+
+  *position = data >> 2;
+  return BISS_OK;
+}
+
+#if ENCODER_BACKEND == ENCODER_BACKEND_SSI || ENCODER_BACKEND == ENCODER_BACKEND_BISS
+
+#include <SPI.h>
+
+// ============================================================================
+// FRAME SIZES
+// ============================================================================
+// SSI: one dummy bit + position
+#define SSI_FRAME_BYTES ((ENCODER_ABS_BITS + 1 + 7) / 8)
+
+// BiSS-C: up to 8 bits of ack latency + start + CDS + position + nE + nW + CRC6
+#define BISS_FRAME_BYTES ((8 + 2 + ENCODER_ABS_BITS + 2 + 6 + 7) / 8)
+
+#define ABS_COUNTS_PER_TURN (1UL << ENCODER_ABS_BITS)
+#define ABS_POSITION_MASK   (ABS_COUNTS_PER_TURN - 1)
+
+// Power-up reads per axis before giving up (the encoder may still be
+// starting), and the pause between them
+#define ABS_INIT_TRIES      5
+#define ABS_INIT_RETRY_US   200
+
+// ============================================================================
+// PRIVATE VARIABLES
+// ============================================================================
+static const uint8_t chipSelect[] = ENCODER_SPI_CS_PINS;
+AXIS_LIST_CHECK(chipSelect, "ENCODER_SPI_CS_PINS");
+
+static uint32_t lastRaw[NUM_AXES];   // Last single-turn reading per axis
+static long unwrapped[NUM_AXES];     // Continuous count per axis
+static bool seeded[NUM_AXES];        // lastRaw holds a real reading
+
+// ============================================================================
+// READ ONE ENCODER
+// ============================================================================
+// Returns false (and leaves *raw alone) on a bad frame
+static bool ReadPosition(uint8_t axis, uint32_t* raw) {
+#if ENCODER_BACKEND == ENCODER_BACKEND_SSI
+  uint8_t frame[SSI_FRAME_BYTES];
+#else
+  uint8_t frame[BISS_FRAME_BYTES];
+#endif
+
+  digitalWrite(chipSelect[axis], LOW);
+  for (uint8_t b = 0; b < sizeof(frame); b++) {
+    frame[b] = SPI.transfer(0xFF);
+  }
+  digitalWrite(chipSelect[axis], HIGH);
+
+#if ENCODER_BACKEND == ENCODER_BACKEND_SSI
+  uint32_t bits = 0;
+  for (uint8_t b = 0; b < sizeof(frame); b++) {
+    bits = (bits << 8) | frame[b];
+  }
+  // Drop the dummy bit in front and any padding bits after the position
+  bits = (bits >> (sizeof(frame) * 8 - 1 - ENCODER_ABS_BITS)) & ABS_POSITION_MASK;
+  *raw = ENCODER_SSI_GRAY_CODE ? Encoder_GrayToBinary(bits) : bits;
+  return true;
+#else
+  return Encoder_ParseBissFrame(frame, sizeof(frame), ENCODER_ABS_BITS, raw) == BISS_OK;
+#endif
+}
+
+// ============================================================================
+// INITIALIZATION
+// ============================================================================
+static void AbsoluteBackend_Init() {
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    pinMode(chipSelect[i], OUTPUT);
+    digitalWrite(chipSelect[i], HIGH);
+  }
+  SPI.begin();
+
+  // The first reading IS the position - no homing required. An axis that
+  // gives no good reading here stays unseeded, and its first good reading
+  // in ReadCounts() is taken as the position instead of being unwrapped
+  // from 0 (which could land a whole turn off).
+  SPI.beginTransaction(SPISettings(ENCODER_ABS_CLOCK_HZ, MSBFIRST, SPI_MODE2));
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    uint32_t raw = 0;
+    seeded[i] = false;
+    for (uint8_t tries = 0; tries < ABS_INIT_TRIES && !seeded[i]; tries++) {
+      if (tries > 0) delayMicroseconds(ABS_INIT_RETRY_US);
+      seeded[i] = ReadPosition(i, &raw);
+      if (!seeded[i]) encoderReadErrors++;
+    }
+    lastRaw[i] = seeded[i] ? raw : 0;
+    unwrapped[i] = (long)lastRaw[i];
+  }
+  SPI.endTransaction();
+}
+
+// ============================================================================
+// READ COUNTS
+// ============================================================================
+static void AbsoluteBackend_ReadCounts(long* counts, unsigned long* edgeMicros) {
+  unsigned long readMicros = micros();
+  SPI.beginTransaction(SPISettings(ENCODER_ABS_CLOCK_HZ, MSBFIRST, SPI_MODE2));
+
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    uint32_t raw;
+    if (!ReadPosition(i, &raw)) {
+      encoderReadErrors++;  // Keep the previous value
+    } else if (!seeded[i]) {
+      unwrapped[i] = (long)raw;  // First good reading since power-up
+      lastRaw[i] = raw;
+      seeded[i] = true;
+    } else {
+      // Shortest way round: a jump of more than half a turn is a wrap
+      long delta = (long)((raw - lastRaw[i]) & ABS_POSITION_MASK);
+      if (delta >= (long)(ABS_COUNTS_PER_TURN / 2)) delta -= (long)ABS_COUNTS_PER_TURN;
+      unwrapped[i] += delta;
+      lastRaw[i] = raw;
+    }
+    counts[i] = unwrapped[i];
+  }
+
+  SPI.endTransaction();
+
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    if (counts[i] != encoders.count[i]) encoders.edgeMicros[i] = readMicros;
+    encoders.count[i] = counts[i];
+    if (edgeMicros != NULL) edgeMicros[i] = encoders.edgeMicros[i];
+  }
+}
+
+#if ENCODER_BACKEND == ENCODER_BACKEND_SSI
+const EncoderBackend encoderBackend = {
+  "SSI", true, AbsoluteBackend_Init, AbsoluteBackend_ReadCounts
+};
+#else
+const EncoderBackend encoderBackend = {
+  "BISS", true, AbsoluteBackend_Init, AbsoluteBackend_ReadCounts
+};
+#endif
+
+#endif // ENCODER_BACKEND == ENCODER_BACKEND_SSI || ENCODER_BACKEND == ENCODER_BACKEND_BISS
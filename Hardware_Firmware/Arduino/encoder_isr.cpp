@@ -0,0 +1,190 @@
+/*
+ * ============================================================================
+ * ENCODER BACKEND - INTERRUPT-DRIVEN QUADRATURE (ISR)
+ * ============================================================================
+ * 
+ * This file implements quadrature encoder reading using interrupts.
+ * Each encoder uses 2 pins (A and B channels) to determine direction.
+ * 
+ * QUADRATURE ENCODING:
+ * - When rotating clockwise: A leads B by 90 degrees
+ * - When rotating counter-clockwise: B leads A by 90 degrees
+ * - We detect edges on both channels to get 4x resolution
+ * 
+ * INTERRUPT PINS (Arduino Mega 2560):
+ * Pins 2, 3 and 18-21 have external interrupts (attachInterrupt). Pins
+ * 10-15, 50-53 and A8-A15 (62-69) have pin change interrupts: one vector
+ * per bank of 8 pins, so the handler compares each such pin with its last
+ * level. Any other pin would never count, and fails the build.
+ * 
+ * Selected with: #define ENCODER_BACKEND ENCODER_BACKEND_ISR
+ * 
+ * ============================================================================
+ */
+
+#include "encoder.h"
+
+#if ENCODER_BACKEND == ENCODER_BACKEND_ISR
+
+// ============================================================================
+// PIN TABLES
+// ============================================================================
+static constexpr uint8_t pinsA[] = ENCODER_PINS_A;
+static constexpr uint8_t pinsB[] = ENCODER_PINS_B;
+AXIS_LIST_CHECK(pinsA, "ENCODER_PINS_A");
+AXIS_LIST_CHECK(pinsB, "ENCODER_PINS_B");
+
+static constexpr bool HasExternalInterrupt(uint8_t pin) {
+  return pin == 2 || pin == 3 || (pin >= 18 && pin <= 21);
+}
+
+static constexpr bool HasPinChangeInterrupt(uint8_t pin) {
+  return (pin >= 10 && pin <= 15) || (pin >= 50 && pin <= 53) || (pin >= 62 && pin <= 69);
+}
+
+// Every pin from 'axis' on has an interrupt of either kind
+static constexpr bool InterruptPins(const uint8_t* pins, uint8_t axis) {
+  return axis == NUM_AXES ||
+         ((HasExternalInterrupt(pins[axis]) || HasPinChangeInterrupt(pins[axis])) &&
+          InterruptPins(pins, axis + 1));
+}
+
+static_assert(InterruptPins(pinsA, 0) && InterruptPins(pinsB, 0),
+              "ENCODER_PINS_A/B: every pin needs an interrupt (Mega: 2, 3, 10-15, 18-21, "
+              "50-53, A8-A15) - use an SPI encoder backend for more axes");
+
+// ============================================================================
+// PIN CHANGE INTERRUPTS
+// ============================================================================
+// Encoder pins without an external interrupt, with the level last seen
+struct PinChangeEdge {
+  uint8_t pin;
+  uint8_t level;
+  void (*handler)();
+};
+
+static PinChangeEdge pinChangeEdges[2 * NUM_AXES];
+static uint8_t pinChangeCount = 0;
+
+// Run the edge handler of every pin that changed since the last call
+static void PinChangeEdges() {
+  for (uint8_t i = 0; i < pinChangeCount; i++) {
+    PinChangeEdge& edge = pinChangeEdges[i];
+    uint8_t level = digitalRead(edge.pin);
+    if (level == edge.level) continue;
+    edge.level = level;
+    edge.handler();
+  }
+}
+
+ISR(PCINT0_vect) { PinChangeEdges(); }
+ISR(PCINT1_vect) { PinChangeEdges(); }
+ISR(PCINT2_vect) { PinChangeEdges(); }
+
+// External interrupt where the pin has one, pin change interrupt otherwise
+static void AttachEdge(uint8_t pin, void (*handler)()) {
+  if (HasExternalInterrupt(pin)) {
+    // CHANGE mode triggers on any pin state change (rising or falling)
+    attachInterrupt(digitalPinToInterrupt(pin), handler, CHANGE);
+    return;
+  }
+
+  PinChangeEdge& edge = pinChangeEdges[pinChangeCount++];
+  edge.pin = pin;
+  edge.level = digitalRead(pin);
+  edge.handler = handler;
+  *digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+  PCIFR = _BV(digitalPinToPCICRbit(pin));  // Drop a change seen before now
+  PCICR |= _BV(digitalPinToPCICRbit(pin));
+}
+
+// ============================================================================
+// INTERRUPT SERVICE ROUTINES (ISRs)
+// ============================================================================
+// One pair of ISRs per axis, generated at compile time from this template so
+// each one has its pins and counter baked in as constants.
+// They must be FAST - no Serial.print() or delays!
+// 
+// QUADRATURE DECODING LOGIC:
+// Read both A and B pins, determine direction based on their relationship
+// Increment or decrement count accordingly, and stamp the edge time
+// (for period-based velocity at low speed, see velocity.cpp)
+template <uint8_t AXIS>
+struct QuadratureAxis {
+  static void EdgeA() {
+    bool A = digitalRead(pinsA[AXIS]);
+    bool B = digitalRead(pinsB[AXIS]);
+    if (A == B) {
+      encoders.count[AXIS]++;
+    } else {
+      encoders.count[AXIS]--;
+    }
+    encoders.edgeMicros[AXIS] = micros();
+  }
+
+  static void EdgeB() {
+    bool A = digitalRead(pinsA[AXIS]);
+    bool B = digitalRead(pinsB[AXIS]);
+    if (A != B) {
+      encoders.count[AXIS]++;
+    } else {
+      encoders.count[AXIS]--;
+    }
+    encoders.edgeMicros[AXIS] = micros();
+  }
+
+  static void Attach() {
+    // Configure encoder pins as inputs with pullups
+    pinMode(pinsA[AXIS], INPUT_PULLUP);
+    pinMode(pinsB[AXIS], INPUT_PULLUP);
+
+    AttachEdge(pinsA[AXIS], EdgeA);
+    AttachEdge(pinsB[AXIS], EdgeB);
+  }
+};
+
+// Attach axes 0 .. COUNT-1 (unrolled at compile time)
+template <uint8_t COUNT>
+struct AttachAxes {
+  static void Run() {
+    AttachAxes<COUNT - 1>::Run();
+    QuadratureAxis<COUNT - 1>::Attach();
+  }
+};
+
+template <>
+struct AttachAxes<0> {
+  static void Run() {}
+};
+
+// ============================================================================
+// INITIALIZATION
+// ============================================================================
+static void IsrBackend_Init() {
+  pinChangeCount = 0;
+  AttachAxes<NUM_AXES>::Run();
+}
+
+// ============================================================================
+// READ COUNTS
+// ============================================================================
+// Copy all counts (and edge times) with interrupts paused
+// (a 32-bit read is not atomic on the 8-bit AVR)
+static void IsrBackend_ReadCounts(long* counts, unsigned long* edgeMicros) {
+  noInterrupts();
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    counts[i] = encoders.count[i];
+  }
+  if (edgeMicros != NULL) {
+    for (uint8_t i = 0; i < NUM_AXES; i++) {
+      edgeMicros[i] = encoders.edgeMicros[i];
+    }
+  }
+  interrupts();
+}
+
+const EncoderBackend encoderBackend = {
+  "ISR", false, IsrBackend_Init, IsrBackend_ReadCounts
+};
+
+#endif // ENCODER_BACKEND == ENCODER_BACKEND_ISR
@@ -0,0 +1,118 @@
+/*
+ * ============================================================================
+ * ENCODER BACKEND - LS7366R QUADRATURE COUNTER ICs (SPI)
+ * ============================================================================
+ *
+ * Each axis has its own LS7366R 32-bit quadrature counter. The chips decode
+ * A/B in hardware, so counting costs the Arduino nothing and encoders well
+ * above 10,000 PPR can be used. No interrupt pins are needed.
+ *
+ * WIRING:
+ * - SCK, MOSI, MISO shared (Mega: 52, 51, 50)
+ * - One chip select per axis: ENCODER_SPI_CS_PINS
+ *
+ * COHERENT SNAPSHOT:
+ * All chip selects are pulled low together and a single LOAD_OTR
+ * instruction is clocked out, so every counter is copied into its output
+ * register on the same SPI clock edge. The latched values are then read
+ * one chip at a time in the same SPI transaction.
+ *
+ * Selected with: #define ENCODER_BACKEND ENCODER_BACKEND_LS7366R
+ *
+ * ============================================================================
+ */
+
+#include "encoder.h"
+
+#if ENCODER_BACKEND == ENCODER_BACKEND_LS7366R
+
+#include <SPI.h>
+
+// ============================================================================
+// LS7366R INSTRUCTIONS AND REGISTER VALUES
+// ============================================================================
+#define LS7366R_CLR_CNTR   0x20   // Clear counter
+#define LS7366R_RD_OTR     0x68   // Read output register (4 bytes, MSB first)
+#define LS7366R_WR_MDR0    0x88   // Write mode register 0
+#define LS7366R_WR_MDR1    0x90   // Write mode register 1
+#define LS7366R_LOAD_OTR   0xE8   // Copy counter to output register
+
+#define LS7366R_MDR0_X4    0x03   // x4 quadrature, free-running, index off, filter clock /1
+#define LS7366R_MDR1_4BYTE 0x00   // 4-byte counter, counting enabled, flags off
+
+// ============================================================================
+// PRIVATE VARIABLES
+// ============================================================================
+static const uint8_t chipSelect[] = ENCODER_SPI_CS_PINS;
+AXIS_LIST_CHECK(chipSelect, "ENCODER_SPI_CS_PINS");
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+static void SelectAll(uint8_t level) {
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    digitalWrite(chipSelect[i], level);
+  }
+}
+
+// Send the same instruction (and optional data byte) to every chip at once
+static void Broadcast(uint8_t instruction, int data) {
+  SelectAll(LOW);
+  SPI.transfer(instruction);
+  if (data >= 0) SPI.transfer((uint8_t)data);
+  SelectAll(HIGH);
+}
+
+// ============================================================================
+// INITIALIZATION
+// ============================================================================
+static void Ls7366rBackend_Init() {
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    pinMode(chipSelect[i], OUTPUT);
+    digitalWrite(chipSelect[i], HIGH);
+  }
+
+  SPI.begin();
+  SPI.beginTransaction(SPISettings(ENCODER_SPI_CLOCK_HZ, MSBFIRST, SPI_MODE0));
+  Broadcast(LS7366R_WR_MDR0, LS7366R_MDR0_X4);
+  Broadcast(LS7366R_WR_MDR1, LS7366R_MDR1_4BYTE);
+  Broadcast(LS7366R_CLR_CNTR, -1);
+  SPI.endTransaction();
+}
+
+// ============================================================================
+// READ COUNTS
+// ============================================================================
+static void Ls7366rBackend_ReadCounts(long* counts, unsigned long* edgeMicros) {
+  SPI.beginTransaction(SPISettings(ENCODER_SPI_CLOCK_HZ, MSBFIRST, SPI_MODE0));
+
+  // Latch every counter at the same instant
+  unsigned long latchMicros = micros();
+  Broadcast(LS7366R_LOAD_OTR, -1);
+
+  // Read the latched values
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    digitalWrite(chipSelect[i], LOW);
+    SPI.transfer(LS7366R_RD_OTR);
+    uint32_t value = 0;
+    for (uint8_t b = 0; b < 4; b++) {
+      value = (value << 8) | SPI.transfer(0);
+    }
+    digitalWrite(chipSelect[i], HIGH);
+    counts[i] = (long)(int32_t)value;  // Two's complement 32-bit count
+  }
+
+  SPI.endTransaction();
+
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    if (counts[i] != encoders.count[i]) encoders.edgeMicros[i] = latchMicros;
+    encoders.count[i] = counts[i];
+    if (edgeMicros != NULL) edgeMicros[i] = encoders.edgeMicros[i];
+  }
+}
+
+const EncoderBackend encoderBackend = {
+  "LS7366R", false, Ls7366rBackend_Init, Ls7366rBackend_ReadCounts
+};
+
+#endif // ENCODER_BACKEND == ENCODER_BACKEND_LS7366R
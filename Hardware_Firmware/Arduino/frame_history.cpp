@@ -0,0 +1,219 @@
+/*
+ * ============================================================================
+ * FRAME HISTORY MODULE - IMPLEMENTATION FILE
+ * ============================================================================
+ *
+ * Frame seq lives in slot seq % SEQ_HISTORY_SIZE. The ring holds seqs
+ * oldest..next-1; sendSeq..next-1 have not been sent yet. Resent frames
+ * are formatted from the same stored values, so they come out identical
+ * to the original line (same checksum), and the host can simply drop
+ * duplicates.
+ *
+ * ============================================================================
+ */
+
+#include "frame_history.h"
+#include "encoder.h"
+#include "kinematics.h"
+#include "velocity.h"
+#include "serial_protocol.h"
+
+// ============================================================================
+// PRIVATE DEFINITIONS
+// ============================================================================
+struct HistoryFrame {
+  unsigned long timestamp;
+  float position[3];
+  float angles[NUM_AXES];
+  float velocity[NUM_AXES];  // Only valid if hasVelocity
+  bool hasVelocity;
+};
+
+struct ResendRange {
+  unsigned long from;
+  unsigned long to;
+};
+
+// ============================================================================
+// PRIVATE VARIABLES
+// ============================================================================
+static bool enabled = SEQ_STREAM_DEFAULT;
+
+static HistoryFrame frames[SEQ_HISTORY_SIZE];
+static unsigned long nextSeq = 0;         // Seq of the next frame pushed
+static unsigned long sendSeq = 0;         // Oldest frame not sent yet
+static unsigned long overruns = 0;        // Frames overwritten before being sent
+
+static ResendRange resends[SEQ_RESEND_QUEUE];
+static uint8_t resendHead = 0;            // Range being sent
+static uint8_t resendCount = 0;
+
+// ============================================================================
+// CHECKSUMMED OUTPUT
+// ============================================================================
+// Prints into the transmit queue and keeps a CRC-8 of everything printed
+class ChecksumPrint : public Print {
+public:
+  virtual size_t write(uint8_t c) {
+    crc ^= c;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+    return serialTx.write(c);
+  }
+  using Print::write;
+
+  uint8_t crc = 0;
+};
+
+static unsigned long OldestSeq() {
+  return nextSeq > SEQ_HISTORY_SIZE ? nextSeq - SEQ_HISTORY_SIZE : 0;
+}
+
+// ============================================================================
+// CONFIGURATION
+// ============================================================================
+void FrameHistory_SetEnabled(bool on) {
+  enabled = on;
+}
+
+bool FrameHistory_IsEnabled() {
+  return enabled;
+}
+
+void FrameHistory_Reset() {
+  nextSeq = 0;
+  sendSeq = 0;
+  overruns = 0;
+  resendHead = 0;
+  resendCount = 0;
+}
+
+// ============================================================================
+// STORE A FRAME
+// ============================================================================
+void FrameHistory_Push() {
+  // Ring full of unsent frames: the oldest one is lost for good
+  if (nextSeq - sendSeq >= SEQ_HISTORY_SIZE) {
+    sendSeq++;
+    overruns++;
+  }
+
+  HistoryFrame* frame = &frames[nextSeq % SEQ_HISTORY_SIZE];
+  frame->timestamp = Serial_GetSampleTimestamp();
+  frame->position[0] = Kinematics_GetX();
+  frame->position[1] = Kinematics_GetY();
+  frame->position[2] = Kinematics_GetZ();
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    frame->angles[i] = encoders.angleDegrees[i];
+  }
+
+  frame->hasVelocity = Velocity_IsStreaming();
+  if (frame->hasVelocity) {
+    unsigned long now = Encoder_GetSampleMicros();
+    for (uint8_t i = 0; i < NUM_AXES; i++) {
+      frame->velocity[i] = Velocity_GetDegreesPerSecond(i + 1, now);
+    }
+  }
+
+  nextSeq++;
+}
+
+// ============================================================================
+// RESEND REQUESTS
+// ============================================================================
+void FrameHistory_Resend(unsigned long from, unsigned long to) {
+  // Frames not taken yet cannot be resent
+  if (nextSeq == 0 || from >= nextSeq) return;
+  if (to >= nextSeq) to = nextSeq - 1;
+  if (from > to) return;
+
+  if (resendCount == SEQ_RESEND_QUEUE) {
+    Serial_SendError("Resend queue full");
+    return;
+  }
+  ResendRange* range = &resends[(resendHead + resendCount) % SEQ_RESEND_QUEUE];
+  range->from = from;
+  range->to = to;
+  resendCount++;
+}
+
+void FrameHistory_SendStatus() {
+  // Format: SEQ,next,oldest,overruns
+  serialTx.print(F("SEQ,"));
+  serialTx.print(nextSeq);
+  serialTx.print(F(","));
+  serialTx.print(OldestSeq());
+  serialTx.print(F(","));
+  serialTx.println(overruns);
+}
+
+// ============================================================================
+// TRANSMIT
+// ============================================================================
+bool FrameHistory_TxReady() {
+  return (resendCount > 0 || sendSeq != nextSeq) &&
+         serialTx.space() >= SPOS_LINE_MAX_LENGTH;
+}
+
+static void SendFrame(unsigned long seq) {
+  const HistoryFrame* frame = &frames[seq % SEQ_HISTORY_SIZE];
+  ChecksumPrint out;
+
+  out.print(F("SPOS,"));
+  out.print(seq);
+  out.print(F(","));
+  out.print(frame->timestamp);
+  for (uint8_t i = 0; i < 3; i++) {
+    out.print(F(","));
+    out.print(frame->position[i], 3);  // Same precision as POS
+  }
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    out.print(F(","));
+    out.print(frame->angles[i], 2);
+  }
+  if (frame->hasVelocity) {
+    for (uint8_t i = 0; i < NUM_AXES; i++) {
+      out.print(F(","));
+      out.print(frame->velocity[i], 2);
+    }
+  }
+
+  static const char digits[] = "0123456789ABCDEF";
+  uint8_t crc = out.crc;
+  serialTx.print('*');
+  serialTx.print(digits[crc >> 4]);
+  serialTx.println(digits[crc & 0x0F]);
+}
+
+void FrameHistory_Transmit() {
+  // Resent frames go first, one line per run
+  if (resendCount > 0) {
+    ResendRange* range = &resends[resendHead];
+    unsigned long oldest = OldestSeq();
+
+    if (range->from < oldest) {
+      // Already overwritten: tell the host not to wait for these
+      unsigned long lostTo = range->to < oldest ? range->to : oldest - 1;
+      serialTx.print(F("SLOST,"));
+      serialTx.print(range->from);
+      serialTx.print(F(","));
+      serialTx.println(lostTo);
+      range->from = lostTo + 1;
+    } else {
+      SendFrame(range->from);
+      range->from++;
+    }
+
+    if (range->from > range->to) {
+      resendHead = (resendHead + 1) % SEQ_RESEND_QUEUE;
+      resendCount--;
+    }
+    return;
+  }
+
+  if (sendSeq != nextSeq) {
+    SendFrame(sendSeq);
+    sendSeq++;
+  }
+}
@@ -0,0 +1,84 @@
+/*
+ * ============================================================================
+ * FRAME HISTORY MODULE - HEADER FILE
+ * ============================================================================
+ *
+ * Sequenced streaming: after SETSEQ ON, every streamed sample becomes a
+ * numbered frame with a checksum, and the last SEQ_HISTORY_SIZE frames are
+ * kept on the device so the host can ask for lost or corrupted ones again.
+ * Plain POS streaming (the default) is unchanged.
+ *
+ * FRAME LINE:
+ *   SPOS,seq,timestamp,x,y,z,theta1,...,thetaN[,omega1,...,omegaN]*CC
+ * - seq counts from 0 at START (32 bits, continues over PAUSE / RESUME)
+ * - the fields are those of the POS line, followed by the VEL line's joint
+ *   velocities when STREAMVEL was ON for that sample (one line per frame,
+ *   so a frame is either received whole or not at all)
+ * - CC = CRC-8 (polynomial 0x07, initial value 0) of every character
+ *   before the '*', as two hex digits
+ *
+ * HISTORY RING = SEND QUEUE:
+ * Frames are stored in binary (timestamp and floats) and only formatted
+ * when sent, by the FRAMES task, whenever a line fits in the transmit
+ * queue. When the link is saturated, frames wait in the ring instead of
+ * being dropped; only when the ring is full of unsent frames is the oldest
+ * one overwritten (counted as an overrun - the host sees a gap it cannot
+ * recover).
+ *
+ * COMMANDS:
+ * - SETSEQ ON|OFF    : sequenced frames instead of POS / VEL lines
+ * - RESEND from,to   : send frames from..to (inclusive) again, ahead of new
+ *                      frames. Up to SEQ_RESEND_QUEUE ranges can wait.
+ *                      The part of the range no longer in the ring is
+ *                      answered with SLOST,from,to.
+ * - GETSEQ           : SEQ,next,oldest,overruns
+ *                      next = seq of the next frame, oldest = oldest seq
+ *                      still in the ring. Sent after STOP, it tells the host
+ *                      where the stream ended so it can ask for the tail.
+ *
+ * ============================================================================
+ */
+
+#ifndef FRAME_HISTORY_H
+#define FRAME_HISTORY_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#if SEQ_HISTORY_SIZE < 2
+#error "SEQ_HISTORY_SIZE must be at least 2"
+#endif
+
+// ============================================================================
+// CONSTANTS
+// ============================================================================
+#define SPOS_LINE_MAX_LENGTH (72 + 22 * NUM_AXES)  // Worst-case SPOS line (with velocities)
+
+// ============================================================================
+// FUNCTION DECLARATIONS
+// ============================================================================
+
+// Sequenced streaming on / off (SETSEQ)
+void FrameHistory_SetEnabled(bool enabled);
+bool FrameHistory_IsEnabled();
+
+// Start a new stream at seq 0 with an empty ring (START)
+void FrameHistory_Reset();
+
+// Store the current sample (kinematics already calculated) as the next
+// frame. It is sent by the FRAMES task.
+void FrameHistory_Push();
+
+// Queue frames from..to for sending again (RESEND)
+void FrameHistory_Resend(unsigned long from, unsigned long to);
+
+// Send SEQ,next,oldest,overruns (GETSEQ)
+void FrameHistory_SendStatus();
+
+// Scheduler event: a frame is waiting and a line fits in the transmit queue
+bool FrameHistory_TxReady();
+
+// Send the next frame: resent frames first, then new ones (FRAMES task)
+void FrameHistory_Transmit();
+
+#endif // FRAME_HISTORY_H
@@ -0,0 +1,190 @@
+/*
+ * ============================================================================
+ * JOINT FILTER MODULE - IMPLEMENTATION FILE
+ * ============================================================================
+ *
+ * ALPHA-BETA TRACKER (per axis, one step per sample, dt = 1 sample):
+ *   predicted = position + velocity
+ *   residual  = measured - predicted
+ *   position  = predicted + alpha * residual
+ *   velocity  = velocity  + beta  * residual
+ *
+ * A residual larger than FILTER_RESYNC_COUNTS cannot come from real motion
+ * at the sampling rate (e.g. ZERO or an encoder fault). The axis is then
+ * re-seeded from the measurement. This also keeps every product inside
+ * 32 bits: |residual| < 2^15 (Q8) and gains <= 2^15 (Q15).
+ *
+ * ============================================================================
+ */
+
+#include "joint_filter.h"
+#include "encoder.h"
+
+#if FILTER_MEDIAN_SIZE < 3 || FILTER_MEDIAN_SIZE > 7 || (FILTER_MEDIAN_SIZE % 2) == 0
+#error "FILTER_MEDIAN_SIZE must be 3, 5 or 7"
+#endif
+
+#if FILTER_RESYNC_COUNTS > 127
+#error "FILTER_RESYNC_COUNTS must be 127 or less (32-bit fixed-point headroom)"
+#endif
+
+// ============================================================================
+// PRIVATE VARIABLES
+// ============================================================================
+struct AxisFilter {
+  long history[FILTER_MEDIAN_SIZE];  // Last raw counts (median window)
+  uint8_t historyIndex;
+  long positionQ8;                   // Filtered count x 256
+  long velocityQ16;                  // Counts per sample x 65536
+};
+
+static AxisFilter axes[NUM_AXES];
+static uint8_t filterMode = FILTER_DEFAULT_MODE;
+static uint16_t alphaQ15 = (uint16_t)(FILTER_ALPHA * 32768.0);
+static uint16_t betaQ15 = (uint16_t)(FILTER_BETA * 32768.0);
+
+static const char* const modeNames[] = { "NONE", "MEDIAN", "AB", "MEDIAN_AB" };
+
+// ============================================================================
+// MEDIAN OF THE HISTORY WINDOW
+// ============================================================================
+static long MedianOf(const long* values) {
+  long sorted[FILTER_MEDIAN_SIZE];
+  for (uint8_t i = 0; i < FILTER_MEDIAN_SIZE; i++) {
+    long v = values[i];
+    int8_t j = i - 1;
+    while (j >= 0 && sorted[j] > v) {
+      sorted[j + 1] = sorted[j];
+      j--;
+    }
+    sorted[j + 1] = v;
+  }
+  return sorted[FILTER_MEDIAN_SIZE / 2];
+}
+
+// ============================================================================
+// SEED ONE AXIS
+// ============================================================================
+static void SeedAxis(AxisFilter* f, long count) {
+  for (uint8_t i = 0; i < FILTER_MEDIAN_SIZE; i++) {
+    f->history[i] = count;
+  }
+  f->historyIndex = 0;
+  f->positionQ8 = count * 256L;
+  f->velocityQ16 = 0;
+}
+
+// ============================================================================
+// INITIALIZATION FUNCTION
+// ============================================================================
+void JointFilter_Init() {
+  JointFilter_Reset();
+}
+
+void JointFilter_Reset() {
+  long counts[NUM_AXES];
+  Encoder_GetCounts(counts);
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    SeedAxis(&axes[i], counts[i]);
+  }
+}
+
+// ============================================================================
+// SAMPLE FUNCTION - One filter step for every axis
+// ============================================================================
+void JointFilter_Sample() {
+  if (filterMode == FILTER_MODE_NONE) return;
+
+  long counts[NUM_AXES];
+  Encoder_GetCounts(counts);
+  JointFilter_SampleCounts(counts);
+}
+
+void JointFilter_SampleCounts(const long* counts) {
+  if (filterMode == FILTER_MODE_NONE) return;
+
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    AxisFilter* f = &axes[i];
+    long measured = counts[i];
+
+    // Glitch rejection
+    if (filterMode & FILTER_MODE_MEDIAN) {
+      f->history[f->historyIndex] = measured;
+      if (++f->historyIndex >= FILTER_MEDIAN_SIZE) f->historyIndex = 0;
+      measured = MedianOf(f->history);
+    }
+
+    if (!(filterMode & FILTER_MODE_AB)) {
+      f->positionQ8 = measured * 256L;
+      continue;
+    }
+
+    // Alpha-beta step
+    long predictedQ8 = f->positionQ8 + (f->velocityQ16 >> 8);
+    long residualQ8 = measured * 256L - predictedQ8;
+
+    if (residualQ8 > FILTER_RESYNC_COUNTS * 256L || residualQ8 < -FILTER_RESYNC_COUNTS * 256L) {
+      SeedAxis(f, counts[i]);
+      continue;
+    }
+
+    f->positionQ8 = predictedQ8 + (((long)alphaQ15 * residualQ8) >> 15);
+    f->velocityQ16 += ((long)betaQ15 * residualQ8) >> 7;
+  }
+}
+
+// ============================================================================
+// CONFIGURATION FUNCTIONS
+// ============================================================================
+void JointFilter_SetMode(uint8_t mode) {
+  if (mode > FILTER_MODE_MEDIAN_AB) return;
+  filterMode = mode;
+  JointFilter_Reset();
+}
+
+uint8_t JointFilter_GetMode() {
+  return filterMode;
+}
+
+const char* JointFilter_GetModeName() {
+  return modeNames[filterMode];
+}
+
+bool JointFilter_ParseMode(const char* name, uint8_t* mode) {
+  for (uint8_t i = 0; i <= FILTER_MODE_MEDIAN_AB; i++) {
+    if (strcmp(name, modeNames[i]) == 0) {
+      *mode = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+void JointFilter_SetGains(float alpha, float beta) {
+  alpha = constrain(alpha, 0.0f, 1.0f);
+  beta = constrain(beta, 0.0f, 1.0f);
+  alphaQ15 = (uint16_t)(alpha * 32768.0);
+  betaQ15 = (uint16_t)(beta * 32768.0);
+}
+
+// ============================================================================
+// GETTER FUNCTIONS
+// ============================================================================
+bool JointFilter_IsActive() {
+  return filterMode != FILTER_MODE_NONE;
+}
+
+float JointFilter_GetCount(int axis, long rawCount) {
+  if (filterMode == FILTER_MODE_NONE || axis < 1 || axis > NUM_AXES) {
+    return (float)rawCount;
+  }
+  return axes[axis - 1].positionQ8 / 256.0;
+}
+
+float JointFilter_GetVelocity(int axis) {
+  if (!(filterMode & FILTER_MODE_AB) || axis < 1 || axis > NUM_AXES) {
+    return 0.0;
+  }
+  // counts/sample (Q16) -> counts/second
+  return axes[axis - 1].velocityQ16 / 65536.0 * (1000000.0 / FILTER_SAMPLE_INTERVAL_US);
+}
@@ -0,0 +1,78 @@
+/*
+ * ============================================================================
+ * JOINT FILTER MODULE - HEADER FILE
+ * ============================================================================
+ *
+ * This module filters each joint's encoder count on the Arduino, at the
+ * internal sampling rate (several kHz), so the PC receives clean values at
+ * the normal streaming rate without extra link bandwidth.
+ *
+ * FILTER MODES:
+ * - NONE      : Raw counts (original behaviour)
+ * - MEDIAN    : Short running median - rejects single-sample glitches
+ * - AB        : Alpha-beta tracker - smooths quantization/tremor and
+ *               estimates joint velocity
+ * - MEDIAN_AB : Median first, then alpha-beta
+ *
+ * FIXED-POINT FORMATS (the Mega has no FPU):
+ * - Positions: counts x 256 (Q8) in 32-bit integers
+ * - Velocity:  counts per sample x 65536 (Q16)
+ * - Gains:     alpha, beta x 32768 (Q15)
+ *
+ * ============================================================================
+ */
+
+#ifndef JOINT_FILTER_H
+#define JOINT_FILTER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// FILTER MODES
+// ============================================================================
+#define FILTER_MODE_NONE       0
+#define FILTER_MODE_MEDIAN     1
+#define FILTER_MODE_AB         2
+#define FILTER_MODE_MEDIAN_AB  3
+
+// ============================================================================
+// FUNCTION DECLARATIONS
+// ============================================================================
+
+// Initialize filter state from the current encoder counts
+void JointFilter_Init();
+
+// Take one sample of all axes and advance the filters
+// Call every FILTER_SAMPLE_INTERVAL_US
+void JointFilter_Sample();
+
+// Same, with a snapshot the caller already took (Encoder_GetCounts)
+void JointFilter_SampleCounts(const long* counts);
+
+// Seed every axis with the current counts (after mode change or glitch)
+void JointFilter_Reset();
+
+// Set / get filter mode (FILTER_MODE_xxx)
+void JointFilter_SetMode(uint8_t mode);
+uint8_t JointFilter_GetMode();
+const char* JointFilter_GetModeName();
+
+// Parse a mode name ("NONE", "MEDIAN", "AB", "MEDIAN_AB"); returns false if unknown
+bool JointFilter_ParseMode(const char* name, uint8_t* mode);
+
+// Set alpha-beta gains (0 < alpha <= 1, 0 <= beta <= 1)
+void JointFilter_SetGains(float alpha, float beta);
+
+// True when the filtered output should be used instead of raw counts
+bool JointFilter_IsActive();
+
+// Filtered count for an axis (1-NUM_AXES), with fractional counts
+// Returns rawCount unchanged when the filter is off
+float JointFilter_GetCount(int axis, long rawCount);
+
+// Estimated joint velocity for an axis (1-NUM_AXES) in counts per second
+// (0 unless an alpha-beta mode is selected)
+float JointFilter_GetVelocity(int axis);
+
+#endif // JOINT_FILTER_H
@@ -7,16 +7,17 @@
  * Hartenberg (DH) convention for articulated robot arms.
  * 
  * MATHEMATICAL APPROACH:
- * 1. Get current joint angles from encoders (θ1, θ2, θ3, θ4)
- * 2. Apply transformation matrices for each joint
+ * 1. Get current joint angles from encoders (θ1 ... θN)
+ * 2. Apply the rotation for each joint, then the link that follows it
  * 3. Calculate final tip position in base coordinate frame
  * 
  * REFERENCE FRAMES:
  * - Frame 0: Fixed base frame (world coordinates)
- * - Frame 1: After base rotation (θ1)
- * - Frame 2: After shoulder pitch (θ2)
- * - Frame 3: After elbow pitch (θ3)
- * - Frame 4: After wrist pitch (θ4) - tip location
+ * - Frame k: After joint k's rotation (θk)
+ * - Frame N: After the last joint - the tip is along its X axis
+ * 
+ * For CONFIG B (base rotation + 3 pitch joints) frames 1-4 are the base,
+ * shoulder, elbow and wrist.
  * 
  * VERSION 2.1.0-Fix CHANGES:
  * - Added extern declarations for XYZ origin offsets
@@ -45,20 +46,24 @@ Position3D currentPosition = {0.0, 0.0, 0.0};
 Position3D toolOffset = {0.0, 0.0, 0.0};
 
 // Link lengths (initialized from config, can be changed)
-float link1_length = LINK_1_LENGTH;
-float link2_length = LINK_2_LENGTH;
-float link3_length = LINK_3_LENGTH;
-float link4_length = LINK_4_LENGTH;
+float linkLengths[NUM_AXES] = LINK_LENGTHS;
+
+// ============================================================================
+// PRIVATE VARIABLES
+// ============================================================================
+static const uint8_t jointTypes[] = JOINT_TYPES;
+static const float defaultLinkLengths[] = LINK_LENGTHS;
+AXIS_LIST_CHECK(jointTypes, "JOINT_TYPES");
+AXIS_LIST_CHECK(defaultLinkLengths, "LINK_LENGTHS");
 
 // ============================================================================
 // INITIALIZATION FUNCTION
 // ============================================================================
 void Kinematics_Init() {
   // Set default dimensions from config
-  link1_length = LINK_1_LENGTH;
-  link2_length = LINK_2_LENGTH;
-  link3_length = LINK_3_LENGTH;
-  link4_length = LINK_4_LENGTH;
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    linkLengths[i] = defaultLinkLengths[i];
+  }
   
   // Initialize tool offset to zero (no offset)
   toolOffset.x = 0.0;
@@ -67,95 +72,99 @@ void Kinematics_Init() {
   
   #if DEBUG_KINEMATICS
   Serial.println(F("Kinematics initialized"));
-  Serial.print(F("Link lengths: "));
-  Serial.print(link1_length); Serial.print(F(", "));
-  Serial.print(link2_length); Serial.print(F(", "));
-  Serial.print(link3_length); Serial.print(F(", "));
-  Serial.println(link4_length);
+  Serial.print(F("Link lengths:"));
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    Serial.print(F(" "));
+    Serial.print(linkLengths[i]);
+  }
+  Serial.println();
   #endif
 }
 
+// ============================================================================
+// FRAME ROTATION HELPER
+// ============================================================================
+// Rotate the frame about its third axis by rotating axes a and b into each
+// other: a' = c*a + s*b, b' = c*b - s*a
+static inline void RotateAxes(float* a, float* b, float c, float s) {
+  for (uint8_t k = 0; k < 3; k++) {
+    float ak = a[k];
+    a[k] = c * ak + s * b[k];
+    b[k] = c * b[k] - s * ak;
+  }
+}
+
 // ============================================================================
 // FORWARD KINEMATICS CALCULATION
 // ============================================================================
 void Kinematics_Calculate() {
-  // Get current joint angles in radians
-  float theta1 = Encoder_GetAngleRadians(1);  // Base rotation
-  float theta2 = Encoder_GetAngleRadians(2);  // Shoulder pitch
-  float theta3 = Encoder_GetAngleRadians(3);  // Elbow pitch
-  float theta4 = Encoder_GetAngleRadians(4);  // Wrist pitch
-  
   /*
-   * FORWARD KINEMATICS FOR 4-AXIS ARTICULATED ARM (CONFIG B)
+   * FORWARD KINEMATICS FOR AN N-AXIS ARTICULATED ARM
    * 
-   * This is a 4-DOF manipulator with:
-   * - 1 rotational joint (base - around Z)
-   * - 3 pitch joints (shoulder, elbow, wrist - around Y)
+   * We walk the chain from the base, keeping the current frame as its X, Y
+   * and Z directions in base coordinates (the columns of a rotation matrix):
+   * 1. Each joint rotates the frame about its own Z (yaw), Y (pitch) or
+   *    X (roll) axis by the joint angle
+   * 2. The link after it moves the position along the frame's X direction
    * 
-   * Mathematical breakdown:
-   * 1. Base rotation (theta1) rotates everything in XY plane
-   * 2. Shoulder pitch (theta2) lifts/lowers upper arm
-   * 3. Elbow pitch (theta3) lifts/lowers forearm
-   * 4. Wrist pitch (theta4) adjusts final tip angle
-   * 
-   * For articulated arms, we work in the vertical plane first,
-   * then rotate the result around the base.
+   * Links follow joints 2..N, and the last link (to the tip) also follows
+   * joint N. For CONFIG B this is exactly the classic planar solution:
+   *   r = L1 cos(θ2) + L2 cos(θ2+θ3) + (L3 + L4) cos(θ2+θ3+θ4)
+   *   z = L1 sin(θ2) + L2 sin(θ2+θ3) + (L3 + L4) sin(θ2+θ3+θ4)
+   * rotated around the base by θ1.
    */
-  
-  // Step 1: Calculate position in the vertical plane (assuming base at 0°)
-  // This is a 2D problem in the X-Z plane
-  
-  // Accumulated angles for each segment
-  // Each joint adds to the previous angle
-  float angle2 = theta2;                    // Shoulder absolute angle
-  float angle3 = theta2 + theta3;           // Elbow absolute angle
-  float angle4 = theta2 + theta3 + theta4;  // Wrist absolute angle
-  
-  // Calculate X (horizontal) and Z (vertical) components in 2D plane
-  float x_2d = link1_length * cos(angle2);
-  float z_2d = link1_length * sin(angle2);
-  
-  x_2d += link2_length * cos(angle3);
-  z_2d += link2_length * sin(angle3);
-  
-  x_2d += link3_length * cos(angle4);
-  z_2d += link3_length * sin(angle4);
-  
-  x_2d += link4_length * cos(angle4);
-  z_2d += link4_length * sin(angle4);
-  
-  // Step 2: Rotate the 2D result around the base (theta1)
-  // This projects the 2D arm into 3D space
-  float cos_theta1 = cos(theta1);
-  float sin_theta1 = sin(theta1);
-  
-  // Calculate 3D coordinates BEFORE applying origin offset
-  float x_raw = x_2d * cos_theta1;
-  float y_raw = x_2d * sin_theta1;
-  float z_raw = z_2d;
-  
-  // Step 3: Apply tool offset if any (for different probe tips)
-  // Rotate tool offset by base angle and add to position
-  float tool_x_rotated = toolOffset.x * cos_theta1 - toolOffset.y * sin_theta1;
-  float tool_y_rotated = toolOffset.x * sin_theta1 + toolOffset.y * cos_theta1;
-  
-  x_raw += tool_x_rotated;
-  y_raw += tool_y_rotated;
-  z_raw += toolOffset.z;
-  
-  // Step 4: Apply origin offset (NEW in v2.1.0-Fix)
+  float axisX[3] = {1.0, 0.0, 0.0};
+  float axisY[3] = {0.0, 1.0, 0.0};
+  float axisZ[3] = {0.0, 0.0, 1.0};
+  float p[3] = {0.0, 0.0, 0.0};
+  float tool[3];
+  
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    // Step 1: Joint rotation
+    float theta = encoders.angleRadians[i];
+    float c = cos(theta);
+    float s = sin(theta);
+    
+    switch (jointTypes[i]) {
+      case JOINT_YAW:   RotateAxes(axisX, axisY, c, s); break;
+      case JOINT_PITCH: RotateAxes(axisX, axisZ, c, s); break;
+      case JOINT_ROLL:  RotateAxes(axisY, axisZ, c, s); break;
+    }
+    
+    // Step 2: Link from the previous joint to this one
+    if (i > 0) {
+      float length = linkLengths[i - 1];
+      for (uint8_t k = 0; k < 3; k++) p[k] += length * axisX[k];
+    }
+    
+    // Tool offset is applied in the base-rotated frame (for different
+    // probe tips), as it always has been
+    if (i == 0) {
+      for (uint8_t k = 0; k < 3; k++) {
+        tool[k] = toolOffset.x * axisX[k] + toolOffset.y * axisY[k] + toolOffset.z * axisZ[k];
+      }
+    }
+  }
+  
+  // Last link: wrist to tip
+  for (uint8_t k = 0; k < 3; k++) {
+    p[k] += linkLengths[NUM_AXES - 1] * axisX[k] + tool[k];
+  }
+  
+  // Step 3: Apply origin offset (NEW in v2.1.0-Fix)
   // Subtract the stored origin point to make coordinates relative to zero point
   // This is THE FIX for the "X coordinate not zeroing" issue
-  currentPosition.x = x_raw - xOffset;
-  currentPosition.y = y_raw - yOffset;
-  currentPosition.z = z_raw - zOffset;
+  currentPosition.x = p[0] - xOffset;
+  currentPosition.y = p[1] - yOffset;
+  currentPosition.z = p[2] - zOffset;
   
   #if DEBUG_KINEMATICS
-  Serial.print(F("Angles (deg): "));
-  Serial.print(theta1 * 180.0 / PI); Serial.print(F(", "));
-  Serial.print(theta2 * 180.0 / PI); Serial.print(F(", "));
-  Serial.print(theta3 * 180.0 / PI); Serial.print(F(", "));
-  Serial.println(theta4 * 180.0 / PI);
+  Serial.print(F("Angles (deg):"));
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    Serial.print(F(" "));
+    Serial.print(encoders.angleDegrees[i]);
+  }
+  Serial.println();
   Serial.print(F("Position (mm): X="));
   Serial.print(currentPosition.x);
   Serial.print(F(", Y="));
@@ -168,11 +177,10 @@ void Kinematics_Calculate() {
 // ============================================================================
 // SET DIMENSIONS FUNCTION
 // ============================================================================
-void Kinematics_SetDimensions(float l1, float l2, float l3, float l4) {
-  link1_length = l1;
-  link2_length = l2;
-  link3_length = l3;
-  link4_length = l4;
+void Kinematics_SetDimensions(const float* lengths) {
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    linkLengths[i] = lengths[i];
+  }
   
   #if DEBUG_KINEMATICS
   Serial.println(F("Dimensions updated"));
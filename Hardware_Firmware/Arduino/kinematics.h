@@ -3,8 +3,10 @@
  * KINEMATICS MODULE - HEADER FILE
  * ============================================================================
  * 
- * This module calculates forward kinematics for the 4-axis articulated arm.
+ * This module calculates forward kinematics for the articulated arm.
  * Converts joint angles (from encoders) to X, Y, Z coordinates in 3D space.
+ * The joint chain (NUM_AXES joints, each yaw, pitch or roll) is described
+ * by JOINT_TYPES and LINK_LENGTHS in config.h.
  * 
  * COORDINATE SYSTEM:
  * - Origin (0,0,0) is at the base rotation axis
@@ -12,7 +14,7 @@
  * - Y-axis: Left from base (when base angle = 0)
  * - Z-axis: Upward from base
  * 
- * ARM CONFIGURATION (CONFIG B):
+ * ARM CONFIGURATION (CONFIG B, the 4-axis default):
  * - Axis 1: Base rotation around Z-axis
  * - Axis 2: Shoulder pitch around Y-axis
  * - Axis 3: Elbow pitch around Y-axis
@@ -28,6 +30,13 @@
 #include "config.h"
 #include "encoder.h"
 
+// ============================================================================
+// JOINT TYPES (used in JOINT_TYPES in config.h)
+// ============================================================================
+#define JOINT_YAW    0  // Rotation about the vertical (local Z) axis
+#define JOINT_PITCH  1  // Up/down rotation in the plane of the arm (local Y)
+#define JOINT_ROLL   2  // Rotation about the link's own length (local X)
+
 // ============================================================================
 // POSITION DATA STRUCTURE
 // ============================================================================
@@ -46,10 +55,8 @@ extern Position3D toolOffset;       // Tool tip offset from wrist center
 // ============================================================================
 // LINK LENGTHS (can be changed at runtime)
 // ============================================================================
-extern float link1_length;  // Base to shoulder
-extern float link2_length;  // Shoulder to elbow
-extern float link3_length;  // Elbow to wrist
-extern float link4_length;  // Wrist to tip
+// One per axis, base to tip (see LINK_LENGTHS in config.h)
+extern float linkLengths[NUM_AXES];
 
 // ============================================================================
 // FUNCTION DECLARATIONS
@@ -61,8 +68,8 @@ void Kinematics_Init();
 // Calculate forward kinematics (angles -> XYZ position)
 void Kinematics_Calculate();
 
-// Set custom link dimensions at runtime
-void Kinematics_SetDimensions(float l1, float l2, float l3, float l4);
+// Set custom link dimensions at runtime (NUM_AXES lengths, base to tip)
+void Kinematics_SetDimensions(const float* lengths);
 
 // Set tool offset (for different probe tips)
 void Kinematics_SetToolOffset(float offsetX, float offsetY, float offsetZ);
@@ -0,0 +1,102 @@
+/*
+ * ============================================================================
+ * LATENCY TRACE MODULE - IMPLEMENTATION FILE
+ * ============================================================================
+ *
+ * A traced line is located in the output stream by byte count: the
+ * transmit queue counts every byte it hands to the UART, so the line has
+ * reached the UART buffer once that count passes its end mark (bytes sent
+ * + bytes queued, taken right after the line was printed).
+ *
+ * ============================================================================
+ */
+
+#include "latency_trace.h"
+#include "encoder.h"
+#include "serial_protocol.h"
+
+// ============================================================================
+// PRIVATE VARIABLES
+// ============================================================================
+static unsigned int interval = TRACE_DEFAULT_INTERVAL;
+static unsigned int untilNext = 0;      // Lines to skip before the next trace
+
+static bool tracing = false;            // A line is being followed
+static bool stamped = false;            // ...and its txDone is known
+static unsigned long endMark = 0;       // Sent-byte count at its line ending
+static unsigned long traceTimestamp = 0;
+static unsigned long snapshotUs = 0;
+static unsigned long enqueueUs = 0;
+static unsigned long txDoneUs = 0;
+
+// ============================================================================
+// SETTINGS
+// ============================================================================
+void LatencyTrace_SetInterval(unsigned int every) {
+  if (every > TRACE_MAX_INTERVAL) every = TRACE_MAX_INTERVAL;
+  interval = every;
+  untilNext = 0;
+  tracing = false;
+  stamped = false;
+}
+
+unsigned int LatencyTrace_GetInterval() {
+  return interval;
+}
+
+bool LatencyTrace_IsEnabled() {
+  return interval > 0;
+}
+
+// ============================================================================
+// LINE QUEUED
+// ============================================================================
+void LatencyTrace_LineQueued(unsigned long queuedUs) {
+  if (interval == 0) return;
+  if (untilNext > 0) {
+    untilNext--;
+    return;
+  }
+  if (tracing) return;  // Previous one still on its way - try the next line
+
+  tracing = true;
+  stamped = false;
+  endMark = serialTx.sent() + serialTx.pending();
+  traceTimestamp = Serial_GetSampleTimestamp();
+  snapshotUs = Encoder_GetSampleMicros();
+  enqueueUs = queuedUs;
+  untilNext = interval - 1;
+}
+
+// ============================================================================
+// TRANSMIT
+// ============================================================================
+void LatencyTrace_Transmit() {
+  if (!tracing) return;
+
+  if (!stamped) {
+    unsigned long sent = serialTx.sent();
+    if ((long)(sent - endMark) < 0) return;  // Not in the UART yet
+
+    // Bytes in the UART buffer up to and including the line ending
+    // (drain may already have moved bytes of later lines behind it)
+    long inUart = (long)(SERIAL_TX_BUFFER_SIZE - 1 - Serial.availableForWrite()) -
+                  (long)(sent - endMark);
+    if (inUart < 0) inUart = 0;
+    unsigned long byteUs = 10000000UL / SERIAL_BAUD_RATE;  // 10 bits per byte
+    txDoneUs = micros() + (unsigned long)inUart * byteUs;
+    stamped = true;
+  }
+
+  if (serialTx.space() < TRC_LINE_MAX_LENGTH) return;  // Next time
+
+  serialTx.print(F("TRC,"));
+  serialTx.print(traceTimestamp);
+  serialTx.print(F(","));
+  serialTx.print(snapshotUs);
+  serialTx.print(F(","));
+  serialTx.print(enqueueUs);
+  serialTx.print(F(","));
+  serialTx.println(txDoneUs);
+  tracing = false;
+}
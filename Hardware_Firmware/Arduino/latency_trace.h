@@ -0,0 +1,67 @@
+/*
+ * ============================================================================
+ * LATENCY TRACE MODULE - HEADER FILE
+ * ============================================================================
+ *
+ * Device half of end-to-end latency tracing (encoder sample -> point on
+ * the host's screen). After SETTRACE n, every nth streamed POS line is
+ * followed, once its line ending has left the UART, by:
+ *
+ *   TRC,timestamp,snapshotUs,enqueueUs,txDoneUs
+ *
+ * - timestamp  : the traced POS line's timestamp (same units, SETTS), so
+ *                the host can pair the two lines
+ * - snapshotUs : micros() when the encoders were read for the sample
+ * - enqueueUs  : micros() when the line started going into the transmit
+ *                queue (after kinematics)
+ * - txDoneUs   : micros() when the line ending will have left the UART:
+ *                stamped when the line has been moved to the UART buffer,
+ *                plus the time for the bytes still ahead of it there (the
+ *                same estimate as the SYNC reply's txMicros)
+ *
+ * All three are raw 32-bit micros() values (they wrap after ~71.6
+ * minutes). The host adds its own receive / parse / display times and
+ * builds the per-stage histograms (Host_Tools ccm_latency).
+ *
+ * Only one line is traced at a time: if the previous one has not left yet
+ * (link saturated), the next eligible line is traced instead. Sequenced
+ * frames (SETSEQ ON) and GETPOS replies are not traced.
+ *
+ * COMMANDS:
+ * - SETTRACE n   : trace every nth streamed POS line (1 - TRACE_MAX_INTERVAL)
+ * - SETTRACE OFF : stop tracing
+ *
+ * ============================================================================
+ */
+
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// CONSTANTS
+// ============================================================================
+#define TRACE_MAX_INTERVAL 1000
+#define TRC_LINE_MAX_LENGTH 48  // TRC, + four 10-digit fields + line ending
+
+// ============================================================================
+// FUNCTION DECLARATIONS
+// ============================================================================
+
+// Trace every nth streamed POS line, 0 = off (SETTRACE)
+void LatencyTrace_SetInterval(unsigned int every);
+unsigned int LatencyTrace_GetInterval();
+bool LatencyTrace_IsEnabled();
+
+// A POS line for the current sample has just been queued; enqueueUs is
+// micros() from just before it was printed. Called for every streamed
+// line, picks the ones to trace.
+void LatencyTrace_LineQueued(unsigned long enqueueUs);
+
+// After the transmit queue was drained (TX task): stamp the traced line
+// once it has reached the UART, and send its TRC line when it fits
+void LatencyTrace_Transmit();
+
+#endif // LATENCY_TRACE_H
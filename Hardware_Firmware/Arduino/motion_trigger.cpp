@@ -0,0 +1,206 @@
+/*
+ * ============================================================================
+ * MOTION TRIGGER MODULE - IMPLEMENTATION FILE
+ * ============================================================================
+ *
+ * The joint-space bound is kept in fixed point: weightQ16[i] is how much of
+ * the distance threshold one count of joint i can move the tip at most
+ * (x 65536). A joint whose single count already covers the threshold gets
+ * a weight of 65536, so the products always fit in 32 bits.
+ *
+ * DITHER:
+ * A joint resting on a count boundary flips between two counts, which
+ * moves the tip by up to about 2 mm at full reach with the default arm.
+ * A joint one count away from its count at the last point sent is
+ * therefore left out of both tests, unless that count continues the way
+ * the joint was turning when the point was sent: a joint in motion keeps
+ * one-count resolution, a joint flicking back is ignored. A point is only
+ * sent once some joint has really moved.
+ *
+ * ============================================================================
+ */
+
+#include "motion_trigger.h"
+#include "encoder.h"
+#include "kinematics.h"
+
+// ============================================================================
+// PRIVATE VARIABLES
+// ============================================================================
+static bool enabled = false;
+static float distanceMm = MOTION_DISTANCE_MM;
+static float angleDeg = MOTION_ANGLE_DEG;
+static unsigned long maxIntervalMs = MOTION_MAX_INTERVAL_MS;
+
+static long angleCounts = 0;             // Angle threshold in counts (0 = off)
+static uint32_t weightQ16[NUM_AXES];     // Tip travel per count / distance, x 65536
+
+static long emittedCounts[NUM_AXES];     // Raw counts at the last point sent
+static int8_t emittedTurn[NUM_AXES];     // Direction of the last count change then (-1, 0, 1)
+static long lastCounts[NUM_AXES];        // Counts at the previous sample
+static int8_t lastTurn[NUM_AXES];        // Direction of the last count change
+static Position3D emittedPosition;       // Tip position at the last point sent
+static unsigned long emittedMillis = 0;
+
+static bool restart = true;              // Send the next checked point
+static bool candidate = false;           // Tip may have moved far enough
+static bool angleExceeded = false;       // A joint turned past the angle threshold
+
+// ============================================================================
+// THRESHOLDS IN COUNTS
+// ============================================================================
+// Recomputed at every point sent, so SETDIM / SETTOOL / SETPPR are picked
+// up without any hooks
+static void UpdateWeights() {
+  float countsPerRadian = Encoder_GetCountsPerRevolution() / (2.0 * PI);
+
+  float toolLength = sqrt(toolOffset.x * toolOffset.x + toolOffset.y * toolOffset.y +
+                          toolOffset.z * toolOffset.z);
+
+  // Reach from joint i to the tip: joint i turns link i-1 and everything
+  // after it (link k follows joint k+1, see Kinematics_Calculate), and the
+  // tool offset only turns with the base joint
+  float reach = fabs(linkLengths[NUM_AXES - 1]);
+  for (int8_t i = NUM_AXES - 1; i >= 0; i--) {
+    if (i > 0) reach += fabs(linkLengths[i - 1]);
+    float jointReach = (i == 0) ? reach + toolLength : reach;
+
+    float weight = jointReach / countsPerRadian / distanceMm * 65536.0;
+    weightQ16[i] = weight >= 65536.0 ? 65536UL : (uint32_t)weight + 1;  // Round up: stay conservative
+  }
+
+  angleCounts = angleDeg > 0.0 ? (long)(angleDeg / 360.0 * Encoder_GetCountsPerRevolution()) : 0;
+  if (angleDeg > 0.0 && angleCounts < 1) angleCounts = 1;
+}
+
+// ============================================================================
+// CONFIGURATION
+// ============================================================================
+void MotionTrigger_Enable(float distance, float angle, unsigned long maxInterval) {
+  distanceMm = distance;
+  angleDeg = angle;
+  maxIntervalMs = maxInterval;
+  UpdateWeights();
+  enabled = true;
+  MotionTrigger_Restart();
+}
+
+void MotionTrigger_Disable() {
+  enabled = false;
+}
+
+bool MotionTrigger_IsEnabled() {
+  return enabled;
+}
+
+void MotionTrigger_Restart() {
+  restart = true;
+}
+
+// ============================================================================
+// STAGE 1 - JOINT-SPACE TEST (every sample)
+// ============================================================================
+// False for a one-count change back against the joint's direction at the
+// last point sent (dither on a count boundary)
+static bool Moved(uint8_t axis, long change) {
+  if (change == 1 || change == -1) return change == emittedTurn[axis];
+  return change != 0;
+}
+
+void MotionTrigger_Sample(const long* counts) {
+  if (!enabled) return;
+
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    if (counts[i] != lastCounts[i]) lastTurn[i] = counts[i] > lastCounts[i] ? 1 : -1;
+    lastCounts[i] = counts[i];
+  }
+  if (candidate || restart) return;
+
+  uint32_t boundQ16 = 0;
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    long change = counts[i] - emittedCounts[i];
+    if (!Moved(i, change)) continue;
+    if (change < 0) change = -change;
+
+    if (angleCounts > 0 && change >= angleCounts) {
+      angleExceeded = true;
+      candidate = true;
+      return;
+    }
+
+    // Weight <= 2^16 and change < 2^15 keep every step inside 32 bits
+    if (change >= 0x8000L) {
+      candidate = true;
+      return;
+    }
+    boundQ16 += (uint32_t)change * weightQ16[i];
+    if (boundQ16 >= 65536UL) {
+      candidate = true;
+      return;
+    }
+  }
+}
+
+// ============================================================================
+// STAGE 2 - CARTESIAN TEST (KIN task)
+// ============================================================================
+// True if a joint has moved since the last point, not just dithered, in
+// the counts currentPosition was calculated from
+static bool JointsMoved() {
+  long counts[NUM_AXES];
+  Encoder_GetSampleCounts(counts);
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    if (Moved(i, counts[i] - emittedCounts[i])) return true;
+  }
+  return false;
+}
+
+bool MotionTrigger_Pending() {
+  if (restart || candidate) return true;
+  return maxIntervalMs > 0 && millis() - emittedMillis >= maxIntervalMs;
+}
+
+bool MotionTrigger_Check() {
+  if (restart || angleExceeded) return true;
+
+  if (candidate) {
+    float dx = currentPosition.x - emittedPosition.x;
+    float dy = currentPosition.y - emittedPosition.y;
+    float dz = currentPosition.z - emittedPosition.z;
+    if (dx * dx + dy * dy + dz * dz >= distanceMm * distanceMm && JointsMoved()) return true;
+
+    // Joints moved but the tip did not get far enough (yet), or they only
+    // dithered: let the sampling task look again
+    candidate = false;
+  }
+
+  return maxIntervalMs > 0 && millis() - emittedMillis >= maxIntervalMs;
+}
+
+void MotionTrigger_Emitted() {
+  // The counts currentPosition was calculated from, not a fresh read
+  Encoder_GetSampleCounts(emittedCounts);
+  for (uint8_t i = 0; i < NUM_AXES; i++) emittedTurn[i] = lastTurn[i];
+  emittedPosition = currentPosition;
+  emittedMillis = Encoder_GetSampleMillis();
+
+  UpdateWeights();
+  restart = false;
+  candidate = false;
+  angleExceeded = false;
+}
+
+// ============================================================================
+// GETTER FUNCTIONS
+// ============================================================================
+float MotionTrigger_GetDistance() {
+  return distanceMm;
+}
+
+float MotionTrigger_GetAngle() {
+  return angleDeg;
+}
+
+unsigned long MotionTrigger_GetMaxInterval() {
+  return maxIntervalMs;
+}
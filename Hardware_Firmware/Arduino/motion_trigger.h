@@ -0,0 +1,76 @@
+/*
+ * ============================================================================
+ * MOTION TRIGGER MODULE - HEADER FILE
+ * ============================================================================
+ *
+ * Motion-adaptive streaming: instead of one POS line every
+ * UPDATE_INTERVAL_MS, a point is sent only after the tip has moved at least
+ * a set distance, or a joint has turned more than a set angle, since the
+ * last point sent. A heartbeat point is still sent after a maximum interval
+ * without one. Point spacing along the path is then even whatever the
+ * operator's speed, and pauses cost no link bandwidth.
+ *
+ * HOW IT WORKS (two stages, because forward kinematics takes about a
+ * millisecond on the 16 MHz AVR - too long for the 4 kHz sampling task):
+ * 1. Every sample (SAMPLE task, integer only): joint count changes since
+ *    the last point are compared against the angle threshold, and against
+ *    a conservative bound on tip travel:
+ *      |tip motion| <= sum over joints of reach_i * |angle change_i|
+ *    where reach_i is the link length from joint i to the tip. Below the
+ *    bound the tip cannot have moved far enough, so nothing else is done.
+ * 2. Once the bound is crossed, the KIN task (every MOTION_CHECK_INTERVAL_US)
+ *    computes the real tip position and sends a point when it is at least
+ *    the distance away from the last point.
+ *
+ * A joint one count away from its count at the last point, against the
+ * direction it was turning then, is taken as dithering on a count boundary
+ * and ignored by both stages, so a still arm does not send a point every
+ * check.
+ *
+ * ============================================================================
+ */
+
+#ifndef MOTION_TRIGGER_H
+#define MOTION_TRIGGER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// FUNCTION DECLARATIONS
+// ============================================================================
+
+// Switch to motion-adaptive streaming
+// distanceMm > 0; angleDeg = 0 disables the angle test; maxIntervalMs = 0
+// disables the heartbeat
+void MotionTrigger_Enable(float distanceMm, float angleDeg, unsigned long maxIntervalMs);
+
+// Back to fixed-interval streaming
+void MotionTrigger_Disable();
+
+bool MotionTrigger_IsEnabled();
+
+// Send the next checked point regardless of motion (START / RESUME)
+void MotionTrigger_Restart();
+
+// Cheap joint-space test on one snapshot (SAMPLE task)
+void MotionTrigger_Sample(const long* counts);
+
+// True when the KIN task should compute the position and call
+// MotionTrigger_Check(): a threshold may have been crossed or the
+// heartbeat is due
+bool MotionTrigger_Pending();
+
+// Exact test against the freshly calculated currentPosition
+// Returns true if this point should be sent
+bool MotionTrigger_Check();
+
+// Record the point just sent as the new reference
+void MotionTrigger_Emitted();
+
+// Settings (for INFO)
+float MotionTrigger_GetDistance();
+float MotionTrigger_GetAngle();
+unsigned long MotionTrigger_GetMaxInterval();
+
+#endif // MOTION_TRIGGER_H
@@ -0,0 +1,172 @@
+/*
+ * ============================================================================
+ * SCHEDULER MODULE - IMPLEMENTATION FILE
+ * ============================================================================
+ *
+ * All times are micros() values compared with unsigned subtraction, so the
+ * 70-minute micros() wrap is handled naturally.
+ *
+ * ============================================================================
+ */
+
+#include "scheduler.h"
+
+#ifdef __AVR__
+#include <avr/sleep.h>
+
+// Heap bounds from avr-libc (for Scheduler_GetFreeSram)
+extern char __heap_start;
+extern char* __brkval;
+#endif
+
+// ============================================================================
+// PRIVATE VARIABLES
+// ============================================================================
+static SchedulerTask* taskTable = NULL;
+static uint8_t taskCount = 0;
+
+static unsigned long busyUs = 0;         // Time spent in tasks since last load update
+static unsigned long loadWindowStart = 0;
+static uint8_t loadPercent = 0;
+
+// True if any task's event check fires (timer releases are covered by the
+// sleep margin)
+#ifdef __AVR__
+static bool EventPending() {
+  for (uint8_t i = 0; i < taskCount; i++) {
+    if (taskTable[i].event != NULL && taskTable[i].event()) return true;
+  }
+  return false;
+}
+#endif
+
+// ============================================================================
+// INITIALIZATION FUNCTION
+// ============================================================================
+void Scheduler_Init(SchedulerTask* tasks, uint8_t count) {
+  taskTable = tasks;
+  taskCount = count;
+
+  unsigned long now = micros();
+  for (uint8_t i = 0; i < taskCount; i++) {
+    taskTable[i].nextReleaseUs = now + taskTable[i].periodUs;
+  }
+  loadWindowStart = now;
+  Scheduler_ResetStats();
+}
+
+// ============================================================================
+// RUN ONCE - Dispatch one task or idle
+// ============================================================================
+void Scheduler_RunOnce() {
+  unsigned long now = micros();
+  unsigned long nearestDeadline = 0xFFFFFFFFUL;
+
+  for (uint8_t i = 0; i < taskCount; i++) {
+    SchedulerTask* task = &taskTable[i];
+
+    bool timerDue = false;
+    if (task->periodUs > 0) {
+      unsigned long untilRelease = task->nextReleaseUs - now;
+      timerDue = (long)untilRelease <= 0;
+      if (!timerDue && untilRelease < nearestDeadline) nearestDeadline = untilRelease;
+    }
+
+    bool eventDue = !timerDue && task->event != NULL && task->event();
+    if (!timerDue && !eventDue) continue;
+
+    if (timerDue) {
+      // Release accounting: how late are we, and did we skip releases?
+      unsigned long late = now - task->nextReleaseUs;
+      if (late > task->maxLateUs) task->maxLateUs = late;
+
+      unsigned long skipped = late / task->periodUs;
+      task->misses += skipped;
+      task->nextReleaseUs += (skipped + 1) * task->periodUs;
+    }
+
+    unsigned long start = micros();
+    task->run();
+    unsigned long runTime = micros() - start;
+
+    task->runs++;
+    if (runTime > task->maxRunUs) task->maxRunUs = runTime;
+    busyUs += runTime;
+    return;  // Re-evaluate from the highest priority
+  }
+
+  // Nothing ready. Sleep only if the next deadline is beyond the next
+  // millis() timer tick, which is what guarantees a timely wake-up.
+#ifdef __AVR__
+  if (nearestDeadline > SCHEDULER_SLEEP_MIN_US) {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+
+    // An interrupt between the checks above and sleep_cpu() (a received
+    // byte, say) would otherwise leave its task waiting for the next
+    // wake-up. Check the events again with interrupts off; sei() takes
+    // effect only after the following instruction, so nothing can slip
+    // in before the CPU is asleep.
+    cli();
+    if (EventPending()) {
+      sei();
+      return;
+    }
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+  }
+#endif
+}
+
+// ============================================================================
+// CONFIGURATION
+// ============================================================================
+void Scheduler_SetPeriod(uint8_t taskIndex, unsigned long periodUs) {
+  if (taskIndex >= taskCount) return;
+  taskTable[taskIndex].periodUs = periodUs;
+  taskTable[taskIndex].nextReleaseUs = micros() + periodUs;
+}
+
+// ============================================================================
+// STATISTICS
+// ============================================================================
+void Scheduler_UpdateLoad() {
+  unsigned long now = micros();
+  unsigned long window = now - loadWindowStart;
+  if (window == 0) return;
+
+  loadPercent = (uint8_t)constrain((busyUs / (window / 100UL + 1)), 0UL, 100UL);
+  busyUs = 0;
+  loadWindowStart = now;
+}
+
+void Scheduler_ResetStats() {
+  for (uint8_t i = 0; i < taskCount; i++) {
+    taskTable[i].runs = 0;
+    taskTable[i].misses = 0;
+    taskTable[i].maxLateUs = 0;
+    taskTable[i].maxRunUs = 0;
+  }
+}
+
+uint8_t Scheduler_GetTaskCount() {
+  return taskCount;
+}
+
+const SchedulerTask* Scheduler_GetTask(uint8_t taskIndex) {
+  return taskIndex < taskCount ? &taskTable[taskIndex] : NULL;
+}
+
+uint8_t Scheduler_GetLoadPercent() {
+  return loadPercent;
+}
+
+int Scheduler_GetFreeSram() {
+#ifdef __AVR__
+  char top;  // Lives at the current top of the stack
+  return (int)(&top - (__brkval != NULL ? __brkval : &__heap_start));
+#else
+  return -1;
+#endif
+}
@@ -0,0 +1,90 @@
+/*
+ * ============================================================================
+ * SCHEDULER MODULE - HEADER FILE
+ * ============================================================================
+ *
+ * Small cooperative task scheduler that replaces the old polling loop
+ * (poll serial, check millis(), delay(1)).
+ *
+ * HOW IT WORKS:
+ * - Tasks live in a table; table order IS priority order (index 0 first)
+ * - A task becomes ready when its period elapses (timer) and/or when its
+ *   event check returns true (e.g. UART has received bytes)
+ * - Each pass runs the single highest-priority ready task, then starts
+ *   again from the top, so a long low-priority task can never delay a
+ *   ready high-priority one by more than one task run
+ * - Tasks run to completion - they must not block
+ * - When nothing is ready and the next deadline is far enough away
+ *   (SCHEDULER_SLEEP_MIN_US), the CPU sleeps (idle mode) until the next
+ *   interrupt: UART receive, encoder edge or the millis() timer. While a
+ *   task is released more often than that (the sampling task, whenever
+ *   something uses its snapshots), the CPU busy-polls instead
+ *
+ * STATISTICS (per task):
+ * - runs      : number of times the task ran
+ * - misses    : timer releases that were skipped because the task started
+ *               a whole period or more late (deadline misses)
+ * - maxLateUs : worst start delay after the release time
+ * - maxRunUs  : worst execution time
+ *
+ * ============================================================================
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// TASK STRUCTURE
+// ============================================================================
+typedef void (*TaskFunction)();
+typedef bool (*TaskEventCheck)();
+
+struct SchedulerTask {
+  SchedulerTask(const char* name, TaskFunction run, TaskEventCheck event, unsigned long periodUs)
+    : name(name), run(run), event(event), periodUs(periodUs),
+      nextReleaseUs(0), runs(0), misses(0), maxLateUs(0), maxRunUs(0) {}
+
+  const char* name;           // Short name for STATS output
+  TaskFunction run;           // Task body (runs to completion)
+  TaskEventCheck event;       // Event check, NULL = timer only
+  unsigned long periodUs;     // Timer period, 0 = event only
+
+  // Maintained by the scheduler
+  unsigned long nextReleaseUs;
+  unsigned long runs;
+  unsigned long misses;
+  unsigned long maxLateUs;
+  unsigned long maxRunUs;
+};
+
+// ============================================================================
+// FUNCTION DECLARATIONS
+// ============================================================================
+
+// Start scheduling a task table (index 0 = highest priority)
+void Scheduler_Init(SchedulerTask* tasks, uint8_t count);
+
+// Run the highest-priority ready task, or idle. Call from loop().
+void Scheduler_RunOnce();
+
+// Change a task's timer period at runtime (0 = event only)
+void Scheduler_SetPeriod(uint8_t taskIndex, unsigned long periodUs);
+
+// Housekeeping hook: updates the CPU load figure (call about once a second)
+void Scheduler_UpdateLoad();
+
+// Clear all statistics
+void Scheduler_ResetStats();
+
+// Access for reporting
+uint8_t Scheduler_GetTaskCount();
+const SchedulerTask* Scheduler_GetTask(uint8_t taskIndex);
+uint8_t Scheduler_GetLoadPercent();
+
+// Unused SRAM between the heap and the stack in bytes (-1 if unknown)
+int Scheduler_GetFreeSram();
+
+#endif // SCHEDULER_H
@@ -23,6 +23,15 @@ void ProcessCommand(char* cmd);
 // ============================================================================
 static char commandBuffer[SERIAL_BUFFER_SIZE];
 static int bufferIndex = 0;
+static bool discardingLine = false;       // Rest of a line that overflowed the buffer
+static unsigned long droppedSamples = 0;  // Streamed POS lines dropped (link saturated)
+static unsigned long commandRxMicros = 0; // When the current command's line ending arrived
+static bool timestampMicros = TIMESTAMP_DEFAULT_US;
+
+// ============================================================================
+// GLOBAL TRANSMIT QUEUE
+// ============================================================================
+TxQueue serialTx;
 
 // Firmware version
 #define FIRMWARE_VERSION "1.0.2"
@@ -40,15 +49,16 @@ void Serial_Init() {
 // SEND STARTUP MESSAGE
 // ============================================================================
 void Serial_SendStartupMessage() {
-  Serial.println(F("====================================="));
-  Serial.println(F("4-Axis CCM Digitizing Arm"));
-  Serial.print(F("Firmware Version: "));
-  Serial.println(F(FIRMWARE_VERSION));
-  Serial.print(F("Date: "));
-  Serial.println(F(FIRMWARE_DATE));
-  Serial.println(F("====================================="));
-  Serial.println(F("Ready for commands"));
-  Serial.println();
+  serialTx.println(F("====================================="));
+  serialTx.print(NUM_AXES);
+  serialTx.println(F("-Axis CCM Digitizing Arm"));
+  serialTx.print(F("Firmware Version: "));
+  serialTx.println(F(FIRMWARE_VERSION));
+  serialTx.print(F("Date: "));
+  serialTx.println(F(FIRMWARE_DATE));
+  serialTx.println(F("====================================="));
+  serialTx.println(F("Ready for commands"));
+  serialTx.println();
 }
 
 // ============================================================================
@@ -61,7 +71,11 @@ void Serial_CheckForCommands() {
     
     // Check for newline (command terminator)
     if (incomingChar == '\n' || incomingChar == '\r') {
-      if (bufferIndex > 0) {
+      if (discardingLine) {
+        discardingLine = false;
+      } else if (bufferIndex > 0) {
+        commandRxMicros = micros();
+        
         // Null-terminate the string
         commandBuffer[bufferIndex] = '\0';
         
@@ -71,21 +85,96 @@ void Serial_CheckForCommands() {
         // Reset buffer
         bufferIndex = 0;
         memset(commandBuffer, 0, SERIAL_BUFFER_SIZE);
+        
+        // Yield to the scheduler after each command
+        return;
       }
     } 
+    else if (discardingLine) {
+      continue;
+    }
     // Add character to buffer
     else if (bufferIndex < SERIAL_BUFFER_SIZE - 1) {
       commandBuffer[bufferIndex++] = incomingChar;
     }
-    // Buffer overflow protection
+    // Buffer overflow protection: drop the whole line, not just its start
     else {
       Serial_SendError("Command too long");
       bufferIndex = 0;
       memset(commandBuffer, 0, SERIAL_BUFFER_SIZE);
+      discardingLine = true;
     }
   }
 }
 
+// ============================================================================
+// SCHEDULER EVENTS
+// ============================================================================
+bool Serial_RxReady() {
+  return Serial.available() > 0;
+}
+
+bool Serial_TxReady() {
+  return serialTx.pending() > 0 && Serial.availableForWrite() > 0;
+}
+
+void Serial_DrainTx() {
+  serialTx.drain();
+}
+
+// ============================================================================
+// TRANSMIT QUEUE
+// ============================================================================
+size_t TxQueue::write(uint8_t c) {
+  if (count == TX_QUEUE_SIZE) pushOne();
+  buffer[head] = c;
+  head = (head + 1) % TX_QUEUE_SIZE;
+  count++;
+  return 1;
+}
+
+void TxQueue::drain() {
+  int room = Serial.availableForWrite();
+  while (room > 0 && count > 0) {
+    // Largest contiguous run that fits
+    uint16_t run = (tail + count <= TX_QUEUE_SIZE) ? count : TX_QUEUE_SIZE - tail;
+    if (run > (uint16_t)room) run = room;
+    Serial.write(buffer + tail, run);
+    tail = (tail + run) % TX_QUEUE_SIZE;
+    count -= run;
+    room -= run;
+    sentTotal += run;
+  }
+}
+
+void TxQueue::pushOne() {
+  Serial.write(buffer[tail]);
+  tail = (tail + 1) % TX_QUEUE_SIZE;
+  count--;
+  sentTotal++;
+}
+
+// ============================================================================
+// PARSE A NUMBER LIST - "a,b,c"
+// ============================================================================
+// Parsed in place with strtod (Arduino sscanf doesn't support %f).
+// Returns how many numbers there were, or -1 if a field is not a number
+// or there are more than maxCount
+static int ParseFloatList(const char* text, float* values, int maxCount) {
+  int count = 0;
+  while (true) {
+    char* end;
+    double value = strtod(text, &end);
+    if (end == text || count == maxCount) return -1;
+    values[count++] = value;
+
+    while (*end == ' ') end++;
+    if (*end == '\0') return count;
+    if (*end != ',') return -1;
+    text = end + 1;
+  }
+}
+
 // ============================================================================
 // PROCESS COMMAND - Parse and execute commands
 // ============================================================================
@@ -157,11 +246,11 @@ void ProcessCommand(char* cmd) {
   // ============================================================================
   else if (strcmp(cmd, CMD_SET_PPR) == 0) {
     if (params != NULL) {
-      int ppr = atoi(params);
-      if (ppr > 0 && ppr <= 10000) {
+      long ppr = atol(params);
+      if (ppr > 0 && ppr <= 1000000L) {
         Command_SetEncoderResolution(ppr);
       } else {
-        Serial_SendError("Invalid PPR value (1-10000)");
+        Serial_SendError("Invalid PPR value (1-1000000)");
       }
     } else {
       Serial_SendError("SETPPR requires parameter: SETPPR <value>");
@@ -170,35 +259,18 @@ void ProcessCommand(char* cmd) {
   
   // ============================================================================
   // COMMAND: SETDIM - Set link dimensions
-  // Format: SETDIM 254,254,254,35
+  // Format: SETDIM 254,254,254,35 (one length per axis)
   // ============================================================================
   else if (strcmp(cmd, CMD_SET_DIM) == 0) {
     if (params != NULL) {
-      // Manual parsing since Arduino sscanf doesn't support %f
-      char* token;
-      float values[4];
-      int count = 0;
-      
-      // Make a copy of params since strtok modifies the string
-      char paramsCopy[64];
-      strncpy(paramsCopy, params, 63);
-      paramsCopy[63] = '\0';
-      
-      // Parse comma-separated values
-      token = strtok(paramsCopy, ",");
-      while (token != NULL && count < 4) {
-        values[count] = atof(token);
-        count++;
-        token = strtok(NULL, ",");
-      }
-      
-      if (count == 4) {
-        Command_SetDimensions(values[0], values[1], values[2], values[3]);
+      float values[NUM_AXES];
+      if (ParseFloatList(params, values, NUM_AXES) == NUM_AXES) {
+        Command_SetDimensions(values);
       } else {
-        Serial_SendError("Invalid format. Use: SETDIM l1,l2,l3,l4");
+        Serial_SendError("Invalid format. Use: SETDIM l1,l2,... (one length per axis)");
       }
     } else {
-      Serial_SendError("SETDIM requires parameters: SETDIM l1,l2,l3,l4");
+      Serial_SendError("SETDIM requires parameters: SETDIM l1,l2,... (one length per axis)");
     }
   }
   
@@ -208,25 +280,8 @@ void ProcessCommand(char* cmd) {
   // ============================================================================
   else if (strcmp(cmd, CMD_SET_TOOL) == 0) {
     if (params != NULL) {
-      // Manual parsing since Arduino sscanf doesn't support %f
-      char* token;
       float values[3];
-      int count = 0;
-      
-      // Make a copy of params since strtok modifies the string
-      char paramsCopy[64];
-      strncpy(paramsCopy, params, 63);
-      paramsCopy[63] = '\0';
-      
-      // Parse comma-separated values
-      token = strtok(paramsCopy, ",");
-      while (token != NULL && count < 3) {
-        values[count] = atof(token);
-        count++;
-        token = strtok(NULL, ",");
-      }
-      
-      if (count == 3) {
+      if (ParseFloatList(params, values, 3) == 3) {
         Kinematics_SetToolOffset(values[0], values[1], values[2]);
         Serial_SendAcknowledge("TOOL_OFFSET_SET");
       } else {
@@ -237,6 +292,147 @@ void ProcessCommand(char* cmd) {
     }
   }
   
+  // ============================================================================
+  // COMMAND: SETFILTER - Set joint filter mode
+  // Format: SETFILTER NONE|MEDIAN|AB|MEDIAN_AB
+  // ============================================================================
+  else if (strcmp(cmd, CMD_SET_FILTER) == 0) {
+    uint8_t mode;
+    if (params != NULL && JointFilter_ParseMode(params, &mode)) {
+      JointFilter_SetMode(mode);
+      Serial_SendAcknowledge("FILTER_SET");
+    } else {
+      Serial_SendError("Use: SETFILTER NONE|MEDIAN|AB|MEDIAN_AB");
+    }
+  }
+  
+  // ============================================================================
+  // COMMAND: SETAB - Set alpha-beta filter gains
+  // Format: SETAB 0.1,0.005
+  // ============================================================================
+  else if (strcmp(cmd, CMD_SET_AB) == 0) {
+    if (params != NULL) {
+      char* comma = strchr(params, ',');
+      if (comma != NULL) {
+        float alpha = atof(params);
+        float beta = atof(comma + 1);
+        if (alpha > 0.0 && alpha <= 1.0 && beta >= 0.0 && beta <= 1.0) {
+          JointFilter_SetGains(alpha, beta);
+          Serial_SendAcknowledge("FILTER_GAINS_SET");
+        } else {
+          Serial_SendError("Invalid gains (0 < alpha <= 1, 0 <= beta <= 1)");
+        }
+      } else {
+        Serial_SendError("Invalid format. Use: SETAB alpha,beta");
+      }
+    } else {
+      Serial_SendError("SETAB requires parameters: SETAB alpha,beta");
+    }
+  }
+  
+  // ============================================================================
+  // COMMAND: SETSTREAM - Set streaming mode
+  // Format: SETSTREAM TIME
+  //         SETSTREAM MOTION [distance_mm[,angle_deg[,max_interval_ms]]]
+  // ============================================================================
+  else if (strcmp(cmd, CMD_SET_STREAM) == 0) {
+    if (params != NULL && strcmp(params, "TIME") == 0) {
+      Command_SetTimeStreaming();
+    } else if (params != NULL && strncmp(params, "MOTION", 6) == 0 &&
+               (params[6] == '\0' || params[6] == ' ')) {
+      float distance = MOTION_DISTANCE_MM;
+      float angle = MOTION_ANGLE_DEG;
+      unsigned long maxInterval = MOTION_MAX_INTERVAL_MS;
+      
+      // Optional comma-separated values, missing ones keep their defaults
+      char* values = params + 6;
+      while (*values == ' ') values++;
+      if (*values != '\0') {
+        distance = atof(values);
+        char* comma = strchr(values, ',');
+        if (comma != NULL) {
+          angle = atof(comma + 1);
+          comma = strchr(comma + 1, ',');
+          if (comma != NULL) maxInterval = strtoul(comma + 1, NULL, 10);
+        }
+      }
+      
+      if (distance > 0.0 && angle >= 0.0) {
+        Command_SetMotionStreaming(distance, angle, maxInterval);
+      } else {
+        Serial_SendError("Invalid values (distance > 0 mm, angle >= 0 deg)");
+      }
+    } else {
+      Serial_SendError("Use: SETSTREAM TIME or SETSTREAM MOTION [mm[,deg[,max_ms]]]");
+    }
+  }
+  
+  // ============================================================================
+  // COMMAND: GETVEL - Get joint velocities
+  // ============================================================================
+  else if (strcmp(cmd, CMD_GET_VEL) == 0) {
+    Encoder_Update();  // Fresh sample time
+    Serial_SendVelocityData();
+  }
+  
+  // ============================================================================
+  // COMMAND: STREAMVEL - Stream VEL lines with POS lines
+  // Format: STREAMVEL ON|OFF
+  // ============================================================================
+  else if (strcmp(cmd, CMD_STREAM_VEL) == 0) {
+    if (params != NULL && strcmp(params, "ON") == 0) {
+      Velocity_SetStreaming(true);
+      Serial_SendAcknowledge("VELOCITY_STREAM_ON");
+    } else if (params != NULL && strcmp(params, "OFF") == 0) {
+      Velocity_SetStreaming(false);
+      Serial_SendAcknowledge("VELOCITY_STREAM_OFF");
+    } else {
+      Serial_SendError("Use: STREAMVEL ON|OFF");
+    }
+  }
+  
+  // ============================================================================
+  // COMMAND: SETSEQ - Sequenced frames with retransmission
+  // Format: SETSEQ ON|OFF
+  // ============================================================================
+  else if (strcmp(cmd, CMD_SET_SEQ) == 0) {
+    if (params != NULL && strcmp(params, "ON") == 0) {
+      FrameHistory_SetEnabled(true);
+      Serial_SendAcknowledge("SEQUENCED_STREAM_ON");
+    } else if (params != NULL && strcmp(params, "OFF") == 0) {
+      FrameHistory_SetEnabled(false);
+      Serial_SendAcknowledge("SEQUENCED_STREAM_OFF");
+    } else {
+      Serial_SendError("Use: SETSEQ ON|OFF");
+    }
+  }
+  
+  // ============================================================================
+  // COMMAND: RESEND - Send sequenced frames again
+  // Format: RESEND 120,124 (first and last seq)
+  // ============================================================================
+  else if (strcmp(cmd, CMD_RESEND) == 0) {
+    char* comma = params != NULL ? strchr(params, ',') : NULL;
+    if (comma != NULL) {
+      unsigned long from = strtoul(params, NULL, 10);
+      unsigned long to = strtoul(comma + 1, NULL, 10);
+      if (from <= to) {
+        FrameHistory_Resend(from, to);
+      } else {
+        Serial_SendError("Invalid range (from <= to)");
+      }
+    } else {
+      Serial_SendError("Use: RESEND from,to");
+    }
+  }
+  
+  // ============================================================================
+  // COMMAND: GETSEQ - Sequenced stream status
+  // ============================================================================
+  else if (strcmp(cmd, CMD_GET_SEQ) == 0) {
+    FrameHistory_SendStatus();
+  }
+  
   // ============================================================================
   // COMMAND: INFO - Send system information
   // ============================================================================
@@ -244,79 +440,289 @@ void ProcessCommand(char* cmd) {
     Serial_SendInfo();
   }
   
+  // ============================================================================
+  // COMMAND: STATS - Send scheduler statistics
+  // ============================================================================
+  else if (strcmp(cmd, CMD_STATS) == 0) {
+    Serial_SendStats();
+  }
+  
+  // ============================================================================
+  // COMMAND: BURST - High-rate capture to SRAM
+  // Format: BURST 1000,2000 (duration ms, rate Hz) or BURST ABORT
+  // ============================================================================
+  else if (strcmp(cmd, CMD_BURST) == 0) {
+    Burst_Command(params);
+  }
+  
+  // ============================================================================
+  // COMMAND: BURSTDUMP - Dump the last burst capture
+  // Format: BURSTDUMP or BURSTDUMP 12 (resume from DATA line 12)
+  // ============================================================================
+  else if (strcmp(cmd, CMD_BURST_DUMP) == 0) {
+    Burst_Dump(params != NULL ? (unsigned int)atol(params) : 0);
+  }
+  
+  // ============================================================================
+  // COMMAND: SYNC - Clock synchronization probe
+  // Format: SYNC 17
+  // ============================================================================
+  else if (strcmp(cmd, CMD_SYNC) == 0) {
+    Serial_SendSyncReply(params != NULL ? strtoul(params, NULL, 10) : 0);
+  }
+  
+  // ============================================================================
+  // COMMAND: SETTS - Set timestamp units
+  // Format: SETTS MS|US
+  // ============================================================================
+  else if (strcmp(cmd, CMD_SET_TS) == 0) {
+    if (params != NULL && strcmp(params, "US") == 0) {
+      timestampMicros = true;
+      Serial_SendAcknowledge("TIMESTAMP_US");
+    } else if (params != NULL && strcmp(params, "MS") == 0) {
+      timestampMicros = false;
+      Serial_SendAcknowledge("TIMESTAMP_MS");
+    } else {
+      Serial_SendError("Use: SETTS MS|US");
+    }
+  }
+  
+  // ============================================================================
+  // COMMAND: SETTRACE - Latency trace of streamed POS lines
+  // Format: SETTRACE 20 (every 20th line) or SETTRACE OFF
+  // ============================================================================
+  else if (strcmp(cmd, CMD_SET_TRACE) == 0) {
+    long every = params != NULL ? atol(params) : 0;
+    if (params != NULL && strcmp(params, "OFF") == 0) {
+      LatencyTrace_SetInterval(0);
+      Serial_SendAcknowledge("TRACE_OFF");
+    } else if (every >= 1 && every <= TRACE_MAX_INTERVAL) {
+      LatencyTrace_SetInterval((unsigned int)every);
+      Serial_SendAcknowledge("TRACE_ON");
+    } else {
+      Serial_SendError("Use: SETTRACE 1-1000|OFF");
+    }
+  }
+  
   // ============================================================================
   // COMMAND: VERSION - Send firmware version
   // ============================================================================
   else if (strcmp(cmd, CMD_VERSION) == 0) {
-    Serial.print(F("VERSION,"));
-    Serial.print(F(FIRMWARE_VERSION));
-    Serial.print(F(","));
-    Serial.println(F(FIRMWARE_DATE));
+    serialTx.print(F("VERSION,"));
+    serialTx.print(F(FIRMWARE_VERSION));
+    serialTx.print(F(","));
+    serialTx.println(F(FIRMWARE_DATE));
   }
   
   // ============================================================================
   // UNKNOWN COMMAND
   // ============================================================================
   else {
-    Serial.print(F("ERROR,Unknown command: "));
-    Serial.println(cmd);
+    serialTx.print(F("ERROR,Unknown command: "));
+    serialTx.println(cmd);
   }
 }
 
+// ============================================================================
+// SAMPLE TIMESTAMP
+// ============================================================================
+// When the encoders were sampled, in the selected units
+unsigned long Serial_GetSampleTimestamp() {
+  return timestampMicros ? Encoder_GetSampleMicros() : Encoder_GetSampleMillis();
+}
+
 // ============================================================================
 // SEND POSITION DATA
 // ============================================================================
 void Serial_SendPositionData() {
-  // Format: POS,timestamp,x,y,z,theta1,theta2,theta3,theta4
-  Serial.print(F("POS,"));
-  Serial.print(millis());
-  Serial.print(F(","));
-  Serial.print(Kinematics_GetX(), 3);  // 3 decimal places
-  Serial.print(F(","));
-  Serial.print(Kinematics_GetY(), 3);
-  Serial.print(F(","));
-  Serial.print(Kinematics_GetZ(), 3);
-  Serial.print(F(","));
-  Serial.print(Encoder_GetAngleDegrees(1), 2);  // 2 decimal places for angles
-  Serial.print(F(","));
-  Serial.print(Encoder_GetAngleDegrees(2), 2);
-  Serial.print(F(","));
-  Serial.print(Encoder_GetAngleDegrees(3), 2);
-  Serial.print(F(","));
-  Serial.println(Encoder_GetAngleDegrees(4), 2);
+  // Format: POS,timestamp,x,y,z,theta1,...,thetaN
+  serialTx.print(F("POS,"));
+  serialTx.print(Serial_GetSampleTimestamp());
+  serialTx.print(F(","));
+  serialTx.print(Kinematics_GetX(), 3);  // 3 decimal places
+  serialTx.print(F(","));
+  serialTx.print(Kinematics_GetY(), 3);
+  serialTx.print(F(","));
+  serialTx.print(Kinematics_GetZ(), 3);
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    serialTx.print(F(","));
+    serialTx.print(encoders.angleDegrees[i], 2);  // 2 decimal places for angles
+  }
+  serialTx.println();
+}
+
+// ============================================================================
+// STREAM POSITION DATA
+// ============================================================================
+bool Serial_StreamPositionData() {
+  // Sequenced mode: the frame waits in the history ring until it can be sent
+  if (FrameHistory_IsEnabled()) {
+    FrameHistory_Push();
+    return true;
+  }
+  
+  bool withVelocity = Velocity_IsStreaming();
+  unsigned int needed = POS_LINE_MAX_LENGTH + (withVelocity ? VEL_LINE_MAX_LENGTH : 0);
+  
+  // If the link is saturated, drop this sample rather than stall sampling
+  if (serialTx.space() < needed) {
+    droppedSamples++;
+    return false;
+  }
+  unsigned long enqueueUs = LatencyTrace_IsEnabled() ? micros() : 0;
+  Serial_SendPositionData();
+  LatencyTrace_LineQueued(enqueueUs);
+  if (withVelocity) Serial_SendVelocityData();
+  return true;
+}
+
+// ============================================================================
+// SEND VELOCITY DATA
+// ============================================================================
+void Serial_SendVelocityData() {
+  // Format: VEL,timestamp,omega1,...,omegaN (degrees per second)
+  // Velocities are as of the sample time, so they line up with POS
+  unsigned long now = Encoder_GetSampleMicros();
+  serialTx.print(F("VEL,"));
+  serialTx.print(Serial_GetSampleTimestamp());
+  for (int axis = 1; axis <= NUM_AXES; axis++) {
+    serialTx.print(F(","));
+    serialTx.print(Velocity_GetDegreesPerSecond(axis, now), 2);
+  }
+  serialTx.println();
 }
 
 // ============================================================================
 // SEND ACKNOWLEDGMENT
 // ============================================================================
 void Serial_SendAcknowledge(const char* message) {
-  Serial.print(F("ACK,"));
-  Serial.println(message);
+  serialTx.print(F("ACK,"));
+  serialTx.println(message);
 }
 
 // ============================================================================
 // SEND ERROR
 // ============================================================================
 void Serial_SendError(const char* message) {
-  Serial.print(F("ERROR,"));
-  Serial.println(message);
+  serialTx.print(F("ERROR,"));
+  serialTx.println(message);
 }
 
 // ============================================================================
 // SEND SYSTEM INFORMATION
 // ============================================================================
 void Serial_SendInfo() {
-  Serial.println(F("INFO,System Information:"));
-  Serial.print(F("INFO,Firmware: "));
-  Serial.println(F(FIRMWARE_VERSION));
-  Serial.print(F("INFO,Encoder PPR: "));
-  Serial.println(ENCODER_PPR);
-  Serial.print(F("INFO,Update Rate: "));
-  Serial.print(1000 / UPDATE_INTERVAL_MS);
-  Serial.println(F(" Hz"));
-  Serial.print(F("INFO,Link Lengths: "));
-  Serial.print(link1_length); Serial.print(F(","));
-  Serial.print(link2_length); Serial.print(F(","));
-  Serial.print(link3_length); Serial.print(F(","));
-  Serial.println(link4_length);
-}
\ No newline at end of file
+  serialTx.println(F("INFO,System Information:"));
+  serialTx.print(F("INFO,Firmware: "));
+  serialTx.println(F(FIRMWARE_VERSION));
+  serialTx.print(F("INFO,Axes: "));
+  serialTx.println(NUM_AXES);
+  serialTx.print(F("INFO,Encoder PPR: "));
+  serialTx.println(ENCODER_PPR);
+  serialTx.print(F("INFO,Encoder Backend: "));
+  serialTx.println(Encoder_GetBackendName());
+  serialTx.print(F("INFO,Update Rate: "));
+  serialTx.print(1000 / UPDATE_INTERVAL_MS);
+  serialTx.println(F(" Hz"));
+  serialTx.print(F("INFO,Streaming: "));
+  if (MotionTrigger_IsEnabled()) {
+    serialTx.print(F("MOTION "));
+    serialTx.print(MotionTrigger_GetDistance());
+    serialTx.print(F(" mm, "));
+    serialTx.print(MotionTrigger_GetAngle());
+    serialTx.print(F(" deg, max "));
+    serialTx.print(MotionTrigger_GetMaxInterval());
+    serialTx.println(F(" ms"));
+  } else {
+    serialTx.println(F("TIME"));
+  }
+  serialTx.print(F("INFO,Velocity Stream: "));
+  serialTx.println(Velocity_IsStreaming() ? F("ON") : F("OFF"));
+  serialTx.print(F("INFO,Sequenced Stream: "));
+  serialTx.print(FrameHistory_IsEnabled() ? F("ON") : F("OFF"));
+  serialTx.print(F(", History: "));
+  serialTx.print(SEQ_HISTORY_SIZE);
+  serialTx.println(F(" frames"));
+  serialTx.print(F("INFO,Joint Filter: "));
+  serialTx.print(JointFilter_GetModeName());
+  serialTx.print(F(" @ "));
+  serialTx.print(1000000L / FILTER_SAMPLE_INTERVAL_US);
+  serialTx.println(F(" Hz"));
+  serialTx.print(F("INFO,Burst Buffer: "));
+  serialTx.print((unsigned long)BURST_BUFFER_SIZE);
+  serialTx.print(F(" bytes, Free SRAM: "));
+  serialTx.print(Scheduler_GetFreeSram());
+  serialTx.println(F(" bytes"));
+  serialTx.print(F("INFO,Timestamps: "));
+  serialTx.println(timestampMicros ? F("US") : F("MS"));
+  serialTx.print(F("INFO,Latency Trace: "));
+  if (LatencyTrace_IsEnabled()) {
+    serialTx.print(F("every "));
+    serialTx.println(LatencyTrace_GetInterval());
+  } else {
+    serialTx.println(F("OFF"));
+  }
+  serialTx.print(F("INFO,Link Lengths: "));
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    if (i > 0) serialTx.print(F(","));
+    serialTx.print(linkLengths[i]);
+  }
+  serialTx.println();
+}
+// ============================================================================
+// SEND SCHEDULER STATISTICS
+// ============================================================================
+void Serial_SendStats() {
+  // Format: STATS,task,runs,misses,maxLateUs,maxRunUs
+  for (uint8_t i = 0; i < Scheduler_GetTaskCount(); i++) {
+    const SchedulerTask* task = Scheduler_GetTask(i);
+    serialTx.print(F("STATS,"));
+    serialTx.print(task->name);
+    serialTx.print(F(","));
+    serialTx.print(task->runs);
+    serialTx.print(F(","));
+    serialTx.print(task->misses);
+    serialTx.print(F(","));
+    serialTx.print(task->maxLateUs);
+    serialTx.print(F(","));
+    serialTx.println(task->maxRunUs);
+  }
+  serialTx.print(F("STATS,LOAD,"));
+  serialTx.print(Scheduler_GetLoadPercent());
+  serialTx.print(F("%,DROPPED,"));
+  serialTx.println(droppedSamples);
+}
+
+// ============================================================================
+// SEND CLOCK SYNC REPLY
+// ============================================================================
+void Serial_SendSyncReply(unsigned long seq) {
+  // The host pairs these with its own send/receive times (NTP style).
+  // Both device times refer to line endings, like the host's, so the
+  // serialization time of the two lines cancels out.
+  //
+  // txMicros is stamped ahead: now + time for the bytes already queued and
+  // this reply to leave the UART. It is printed zero-padded to 10 digits so
+  // the reply length is known before it is formatted.
+  char seqText[11];
+  char rxText[11];
+  ultoa(seq, seqText, 10);
+  ultoa(commandRxMicros, rxText, 10);
+
+  unsigned long queuedBytes = serialTx.pending() +
+                              (SERIAL_TX_BUFFER_SIZE - 1 - Serial.availableForWrite());
+  unsigned long lineBytes = 5 + strlen(seqText) + 1 + strlen(rxText) + 1 + 10 + 2;
+  unsigned long byteUs = 10000000UL / SERIAL_BAUD_RATE;  // 10 bits per byte
+  unsigned long txMicros = micros() + (queuedBytes + lineBytes) * byteUs;
+
+  char txText[11];
+  ultoa(txMicros, txText, 10);
+
+  serialTx.print(F("SYNC,"));
+  serialTx.print(seqText);
+  serialTx.print(F(","));
+  serialTx.print(rxText);
+  serialTx.print(F(","));
+  for (uint8_t i = strlen(txText); i < 10; i++) serialTx.print('0');
+  serialTx.println(txText);
+}
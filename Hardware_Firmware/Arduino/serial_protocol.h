@@ -16,9 +16,19 @@
  * - Format: COMMAND_NAME [parameters]\n
  * 
  * DATA FORMAT (Arduino -> PC):
- * - Position data: POS,timestamp,x,y,z,theta1,theta2,theta3,theta4\n
+ * - Position data: POS,timestamp,x,y,z,theta1,...,thetaN\n (N = NUM_AXES)
+ * - Velocity data: VEL,timestamp,omega1,...,omegaN\n (deg/s)
+ * - Sequenced frames: SPOS,seq,...*CC, SLOST,from,to, SEQ,... (see frame_history.h)
  * - Acknowledgment: ACK,message\n
  * - Error: ERROR,message\n
+ * - Statistics: STATS,task,runs,misses,maxLateUs,maxRunUs\n
+ * - Clock sync: SYNC,seq,rxMicros,txMicros\n
+ * - Burst capture: BURST,START|DONE|HDR|DATA|END,... (see burst.h)
+ * - Latency trace: TRC,timestamp,snapshotUs,enqueueUs,txDoneUs (see latency_trace.h)
+ * 
+ * TIMESTAMPS:
+ * - POS / VEL timestamps are taken when the encoders were sampled, in
+ *   milliseconds (default) or microseconds (SETTS US)
  * 
  * ============================================================================
  */
@@ -30,12 +40,28 @@
 #include "config.h"
 #include "encoder.h"
 #include "kinematics.h"
+#include "joint_filter.h"
+#include "scheduler.h"
+#include "burst.h"
+#include "motion_trigger.h"
+#include "velocity.h"
+#include "frame_history.h"
+#include "latency_trace.h"
 
 // ============================================================================
 // PROTOCOL CONSTANTS
 // ============================================================================
 #define SERIAL_BUFFER_SIZE 128
 #define MAX_COMMAND_LENGTH 64
+#define TX_QUEUE_SIZE 256         // Outgoing bytes waiting for the UART
+#define POS_LINE_MAX_LENGTH (56 + 10 * NUM_AXES)  // Worst-case POS line, checked before streaming
+#define VEL_LINE_MAX_LENGTH (16 + 12 * NUM_AXES)  // Worst-case VEL line
+
+// Size of the Arduino core's UART transmit buffer (used to estimate how
+// long queued bytes take to leave)
+#ifndef SERIAL_TX_BUFFER_SIZE
+#define SERIAL_TX_BUFFER_SIZE 64
+#endif
 
 // ============================================================================
 // COMMAND DEFINITIONS
@@ -52,23 +78,82 @@
 // Calibration commands
 #define CMD_ZERO        "ZERO"        // Zero encoders at current position
 #define CMD_GET_POS     "GETPOS"      // Request current position
+#define CMD_GET_VEL     "GETVEL"      // Request joint velocities (edge timing)
 
 // Configuration commands
 #define CMD_SET_PPR     "SETPPR"      // Set encoder PPR: SETPPR 600
-#define CMD_SET_DIM     "SETDIM"      // Set dimensions: SETDIM 254,254,254,35
+#define CMD_SET_DIM     "SETDIM"      // Set dimensions: SETDIM 254,254,254,35 (one per axis)
 #define CMD_SET_TOOL    "SETTOOL"     // Set tool offset: SETTOOL 0,0,10
+#define CMD_SET_FILTER  "SETFILTER"   // Set joint filter: SETFILTER MEDIAN_AB
+#define CMD_SET_AB      "SETAB"       // Set alpha-beta gains: SETAB 0.1,0.005
+#define CMD_SET_STREAM  "SETSTREAM"   // Streaming mode: SETSTREAM TIME or SETSTREAM MOTION 1.0,2.0,1000
+#define CMD_STREAM_VEL  "STREAMVEL"   // VEL line with every streamed POS: STREAMVEL ON|OFF
 
 // Information commands
 #define CMD_INFO        "INFO"        // Get system information
+#define CMD_STATS       "STATS"       // Get scheduler task statistics
 #define CMD_VERSION     "VERSION"     // Get firmware version
 
+// Burst capture commands
+#define CMD_BURST       "BURST"       // Capture to SRAM: BURST 1000,2000 (ms, Hz) or BURST ABORT
+#define CMD_BURST_DUMP  "BURSTDUMP"   // Dump the last capture: BURSTDUMP [seq]
+
+// Sequenced streaming commands
+#define CMD_SET_SEQ     "SETSEQ"      // Sequenced frames: SETSEQ ON|OFF
+#define CMD_RESEND      "RESEND"      // Send frames again: RESEND from,to
+#define CMD_GET_SEQ     "GETSEQ"      // Sequenced stream status
+
+// Clock synchronization commands
+#define CMD_SYNC        "SYNC"        // Clock sync probe: SYNC <seq>
+#define CMD_SET_TS      "SETTS"       // Timestamp units: SETTS MS|US
+#define CMD_SET_TRACE   "SETTRACE"    // Latency trace every nth POS line: SETTRACE 20 or SETTRACE OFF
+
 // ============================================================================
 // RESPONSE PREFIXES
 // ============================================================================
 #define RESP_POS        "POS"         // Position data
+#define RESP_VEL        "VEL"         // Joint velocity data
 #define RESP_ACK        "ACK"         // Acknowledgment
 #define RESP_ERROR      "ERROR"       // Error message
 #define RESP_INFO       "INFO"        // Information response
+#define RESP_STATS      "STATS"       // Scheduler statistics
+#define RESP_SYNC       "SYNC"        // Clock sync reply
+#define RESP_BURST      "BURST"       // Burst capture report / dump
+#define RESP_SPOS       "SPOS"        // Sequenced frame
+#define RESP_SLOST      "SLOST"       // Resend range no longer available
+#define RESP_TRC        "TRC"         // Latency trace of a POS line
+#define RESP_SEQ        "SEQ"         // Sequenced stream status
+
+// ============================================================================
+// TRANSMIT QUEUE
+// ============================================================================
+// All protocol output is printed into this queue and moved to the UART by
+// Serial_DrainTx() only as fast as the UART can take it, so sending never
+// stalls the scheduler. If a message does not fit, the oldest bytes are
+// pushed out to the UART (blocking) so no response is ever lost.
+class TxQueue : public Print {
+public:
+  virtual size_t write(uint8_t c);
+  using Print::write;
+
+  uint16_t pending() const { return count; }
+  uint16_t space() const { return TX_QUEUE_SIZE - count; }
+  unsigned long sent() const { return sentTotal; }  // Bytes handed to the UART (wraps)
+
+  // Move as many bytes as the UART accepts without blocking
+  void drain();
+
+private:
+  void pushOne();  // Blocking: send the oldest byte
+
+  uint8_t buffer[TX_QUEUE_SIZE];
+  uint16_t head = 0;   // Next write position
+  uint16_t tail = 0;   // Oldest unsent byte
+  uint16_t count = 0;
+  unsigned long sentTotal = 0;
+};
+
+extern TxQueue serialTx;
 
 // ============================================================================
 // FUNCTION DECLARATIONS
@@ -81,11 +166,34 @@ void Serial_Init();
 void Serial_SendStartupMessage();
 
 // Check for incoming commands and process them
+// Returns after at most one complete command so other tasks get a turn
 void Serial_CheckForCommands();
 
+// True when received bytes are waiting (scheduler RX event)
+bool Serial_RxReady();
+
+// True when queued output can be moved to the UART (scheduler TX event)
+bool Serial_TxReady();
+
+// Move queued output to the UART without blocking
+void Serial_DrainTx();
+
 // Send current position data
 void Serial_SendPositionData();
 
+// Stream position data: like Serial_SendPositionData(), but the sample is
+// dropped (and counted) instead of blocking when the link is saturated.
+// Followed by a VEL line for the same sample after STREAMVEL ON.
+// After SETSEQ ON the sample is stored as a sequenced frame instead.
+// Returns false if the sample was dropped
+bool Serial_StreamPositionData();
+
+// When the current sample was taken, in the selected units (SETTS)
+unsigned long Serial_GetSampleTimestamp();
+
+// Send joint velocity estimates (edge timing, see velocity.h)
+void Serial_SendVelocityData();
+
 // Send acknowledgment message
 void Serial_SendAcknowledge(const char* message);
 
@@ -95,6 +203,14 @@ void Serial_SendError(const char* message);
 // Send system information
 void Serial_SendInfo();
 
+// Send scheduler statistics (one STATS line per task)
+void Serial_SendStats();
+
+// Answer a SYNC probe: SYNC,seq,rxMicros,txMicros
+// rxMicros = when the command's line ending arrived
+// txMicros = when the reply's line ending will have left the UART
+void Serial_SendSyncReply(unsigned long seq);
+
 // ============================================================================
 // COMMAND HANDLER DECLARATIONS (implemented in main sketch)
 // ============================================================================
@@ -105,7 +221,9 @@ extern void Command_PauseRecording();
 extern void Command_ResumeRecording();
 extern void Command_ZeroEncoders();
 extern void Command_GetPosition();
-extern void Command_SetEncoderResolution(int ppr);
-extern void Command_SetDimensions(float l1, float l2, float l3, float l4);
+extern void Command_SetEncoderResolution(long ppr);
+extern void Command_SetDimensions(const float* lengths);
+extern void Command_SetTimeStreaming();
+extern void Command_SetMotionStreaming(float distanceMm, float angleDeg, unsigned long maxIntervalMs);
 
 #endif // SERIAL_PROTOCOL_H
@@ -0,0 +1,105 @@
+/*
+ * ============================================================================
+ * VELOCITY MODULE - IMPLEMENTATION FILE
+ * ============================================================================
+ *
+ * The sampling task only does integer bookkeeping (a subtraction and a
+ * compare per axis); the division happens when a VEL line is formatted.
+ *
+ * ============================================================================
+ */
+
+#include "velocity.h"
+#include "encoder.h"
+
+// ============================================================================
+// PRIVATE VARIABLES
+// ============================================================================
+struct AxisVelocity {
+  long refCount;                 // Count at the reference edge
+  unsigned long refMicros;       // Time of the reference edge
+  long spanCounts;               // Last completed measurement: counts ...
+  unsigned long spanMicros;      // ... between these two edge times
+  unsigned long lastEdgeMicros;  // Newest edge seen
+};
+
+static AxisVelocity axes[NUM_AXES];
+static bool streaming = VELOCITY_STREAM_DEFAULT;
+
+// ============================================================================
+// INITIALIZATION FUNCTION
+// ============================================================================
+void Velocity_Init() {
+  long counts[NUM_AXES];
+  unsigned long edges[NUM_AXES];
+  Encoder_GetSnapshot(counts, edges);
+
+  unsigned long now = micros();
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    axes[i].refCount = counts[i];
+    axes[i].refMicros = now;
+    axes[i].spanCounts = 0;
+    axes[i].spanMicros = 0;
+    axes[i].lastEdgeMicros = edges[i];
+  }
+}
+
+// ============================================================================
+// SAMPLE FUNCTION - Close a measurement window when it is long enough
+// ============================================================================
+void Velocity_Sample(const long* counts, const unsigned long* edgeMicros) {
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    AxisVelocity* a = &axes[i];
+    unsigned long edge = edgeMicros[i];
+    if (edge == a->lastEdgeMicros) continue;  // No new edge
+    a->lastEdgeMicros = edge;
+
+    long change = counts[i] - a->refCount;
+    unsigned long elapsed = edge - a->refMicros;
+    if (change >= VELOCITY_MIN_COUNTS || change <= -VELOCITY_MIN_COUNTS ||
+        elapsed >= VELOCITY_MAX_WINDOW_US) {
+      a->spanCounts = change;
+      a->spanMicros = elapsed;
+      a->refCount = counts[i];
+      a->refMicros = edge;
+    }
+  }
+}
+
+// ============================================================================
+// GETTER FUNCTIONS
+// ============================================================================
+float Velocity_GetCountsPerSecond(int axis, unsigned long nowMicros) {
+  if (axis < 1 || axis > NUM_AXES) return 0.0;
+  const AxisVelocity* a = &axes[axis - 1];
+  if (a->spanCounts == 0 || a->spanMicros == 0) return 0.0;
+
+  unsigned long since = nowMicros - a->lastEdgeMicros;
+  if ((long)since < 0) since = 0;  // Edge stamped just after 'now'
+  if (since >= VELOCITY_TIMEOUT_US) return 0.0;
+
+  float velocity = a->spanCounts * 1000000.0 / a->spanMicros;
+
+  // No edge for 'since' microseconds: the joint is now slower than one
+  // count per 'since'
+  if (since > 0) {
+    float bound = 1000000.0 / since;
+    if (velocity > bound) velocity = bound;
+    else if (velocity < -bound) velocity = -bound;
+  }
+  return velocity;
+}
+
+float Velocity_GetDegreesPerSecond(int axis, unsigned long nowMicros) {
+  if (axis < 1 || axis > NUM_AXES) return 0.0;
+  float countsPerSecond = Velocity_GetCountsPerSecond(axis, nowMicros) * encoders.direction[axis - 1];
+  return Encoder_CountsToDegrees(countsPerSecond);
+}
+
+void Velocity_SetStreaming(bool enabled) {
+  streaming = enabled;
+}
+
+bool Velocity_IsStreaming() {
+  return streaming;
+}
@@ -0,0 +1,59 @@
+/*
+ * ============================================================================
+ * VELOCITY MODULE - HEADER FILE
+ * ============================================================================
+ *
+ * Per-joint angular velocity from encoder edge timing.
+ *
+ * The encoder backend stamps every count change with micros(). Each
+ * sample, the count and the time of its last edge are compared with a
+ * reference edge; once enough counts (or time) have accumulated, the
+ * velocity is counts / time between the two EDGES, and the newer edge
+ * becomes the reference. This is the classic M/T method:
+ * - Low speed (less than one count per sample): the window spans a full
+ *   quadrature cycle between edges - period measurement, accurate even at
+ *   a few counts per second, where differencing 50 ms POS samples gives
+ *   0 or 1 count
+ * - High speed (several counts per sample): the window closes every sample
+ *   - count differencing, but over exact edge times instead of the jittery
+ *   sample times
+ * While no edge arrives, the speed cannot be higher than one count per
+ * time since the last edge, so the estimate decays towards zero instead of
+ * holding the last value when the joint stops.
+ *
+ * VEL lines: VEL,timestamp,omega1,...,omegaN (degrees per second, same
+ * timestamp as the POS line of the same sample). Sent on GETVEL, and with
+ * every streamed POS line after STREAMVEL ON.
+ *
+ * ============================================================================
+ */
+
+#ifndef VELOCITY_H
+#define VELOCITY_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// FUNCTION DECLARATIONS
+// ============================================================================
+
+// Seed every axis from the current counts
+void Velocity_Init();
+
+// Advance the measurement with one snapshot (SAMPLE task)
+void Velocity_Sample(const long* counts, const unsigned long* edgeMicros);
+
+// Velocity of an axis (1-NUM_AXES) in counts per second, as of nowMicros
+// (raw count direction, before ENCODER_DIRECTIONS)
+float Velocity_GetCountsPerSecond(int axis, unsigned long nowMicros);
+
+// Joint velocity of an axis in degrees per second, as of nowMicros
+// (ENCODER_DIRECTIONS applied, as in VEL lines)
+float Velocity_GetDegreesPerSecond(int axis, unsigned long nowMicros);
+
+// Send a VEL line with every streamed POS line
+void Velocity_SetStreaming(bool enabled);
+bool Velocity_IsStreaming();
+
+#endif // VELOCITY_H
@@ -0,0 +1,150 @@
+/*
+ * ============================================================================
+ * HOST HAL - Arduino.h
+ * ============================================================================
+ *
+ * Host (PC) implementation of the subset of the Arduino API used by the
+ * firmware in Hardware_Firmware/Arduino. Building the firmware sources
+ * against this directory lets the real encoder, kinematics and protocol
+ * code run on the PC, driven through hal_control.h:
+ *
+ *   g++ -std=gnu++11 -IHost_Tools/hal -IHardware_Firmware/Arduino ...
+ *
+ * Time is simulated (it only moves when the host advances it) and pins,
+ * interrupts, the serial port and SPI devices are all in-memory.
+ *
+ * ============================================================================
+ */
+
+#ifndef HOST_HAL_ARDUINO_H
+#define HOST_HAL_ARDUINO_H
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// TYPES AND CONSTANTS
+// ============================================================================
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PI 3.1415926535897932384626433832795
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define LED_BUILTIN 13
+#define DEC 10
+#define HEX 16
+
+#define HAL_NUM_PINS 70  // Arduino Mega 2560
+
+// Flash-string helpers are no-ops on the PC
+#define F(s) (s)
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+
+// External interrupts as on the Mega: 0-5 on pins 2, 3, 21, 20, 19, 18;
+// attachInterrupt() ignores any other pin
+#define NOT_AN_INTERRUPT -1
+#define digitalPinToInterrupt(p) \
+  ((p) == 2 ? 0 : ((p) == 3 ? 1 : ((p) >= 18 && (p) <= 21 ? 23 - (p) : NOT_AN_INTERRUPT)))
+
+// Pin change interrupts as on the Mega: banks 0-2 on pins 50-53 / 10-13,
+// 15 / 14 and A8-A15 (62-69). The registers are plain bytes; when an
+// enabled pin changes, Hal_SetPin() calls the bank's ISR(PCINTn_vect).
+#define _BV(bit) (1 << (bit))
+#define ISR(vector) extern "C" void vector()
+
+extern uint8_t PCICR, PCIFR, PCMSK0, PCMSK1, PCMSK2;
+
+#define digitalPinToPCICRbit(p) \
+  (((p) >= 10 && (p) <= 13) || ((p) >= 50 && (p) <= 53) ? 0 : ((p) == 14 || (p) == 15 ? 1 : 2))
+#define digitalPinToPCICR(p) \
+  (((p) >= 10 && (p) <= 15) || ((p) >= 50 && (p) <= 53) || ((p) >= 62 && (p) <= 69) ? &PCICR : (uint8_t*)0)
+#define digitalPinToPCMSK(p) \
+  (digitalPinToPCICR(p) == 0 ? (uint8_t*)0 : \
+   (digitalPinToPCICRbit(p) == 0 ? &PCMSK0 : (digitalPinToPCICRbit(p) == 1 ? &PCMSK1 : &PCMSK2)))
+#define digitalPinToPCMSKbit(p) \
+  ((p) >= 10 && (p) <= 13 ? (p) - 6 : ((p) >= 50 && (p) <= 53 ? 53 - (p) : \
+   ((p) == 14 ? 2 : ((p) == 15 ? 1 : (p) - 62))))
+
+template <class T> T constrain(T value, T low, T high) {
+  return value < low ? low : (value > high ? high : value);
+}
+
+// ============================================================================
+// CORE FUNCTIONS
+// ============================================================================
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+
+// avr-libc number formatting (not in the PC C library)
+char* ultoa(unsigned long value, char* buffer, int radix);
+
+void attachInterrupt(uint8_t interruptNum, void (*handler)(), int mode);
+void detachInterrupt(uint8_t interruptNum);
+void noInterrupts();
+void interrupts();
+
+// ============================================================================
+// PRINT
+// ============================================================================
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+
+  size_t print(const char* str) { return write(str); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+
+  size_t println() { return write("\r\n"); }
+  template <class T> size_t println(T value) { size_t n = print(value); return n + println(); }
+  template <class T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+// ============================================================================
+// SERIAL PORT (in-memory, see hal_control.h)
+// ============================================================================
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long baud);
+  void end() {}
+  operator bool() { return true; }
+
+  int available();
+  int read();
+  int peek();
+  int availableForWrite();
+  void flush() {}
+
+  virtual size_t write(uint8_t c);
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif // HOST_HAL_ARDUINO_H
@@ -0,0 +1,51 @@
+/*
+ * ============================================================================
+ * HOST HAL - SPI.h
+ * ============================================================================
+ *
+ * SPI transfers are routed to the mock devices registered with
+ * Hal_AttachSpiDevice() whose chip select pin is currently LOW. When several
+ * chip selects are low at once (broadcast), every selected device receives
+ * the byte and the returned MISO byte is the AND of their outputs
+ * (idle-high bus).
+ *
+ * ============================================================================
+ */
+
+#ifndef HOST_HAL_SPI_H
+#define HOST_HAL_SPI_H
+
+#include "Arduino.h"
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings {
+public:
+  SPISettings() : clock(4000000), bitOrder(MSBFIRST), dataMode(SPI_MODE0) {}
+  SPISettings(uint32_t clockHz, uint8_t order, uint8_t mode)
+      : clock(clockHz), bitOrder(order), dataMode(mode) {}
+
+  uint32_t clock;
+  uint8_t bitOrder;
+  uint8_t dataMode;
+};
+
+class SPIClass {
+public:
+  void begin() {}
+  void end() {}
+  void beginTransaction(SPISettings settings) { current = settings; }
+  void endTransaction() {}
+  uint8_t transfer(uint8_t data);
+
+  SPISettings current;
+};
+
+extern SPIClass SPI;
+
+#endif // HOST_HAL_SPI_H
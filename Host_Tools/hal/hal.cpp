@@ -0,0 +1,238 @@
+/*
+ * ============================================================================
+ * HOST HAL - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "hal_control.h"
+#include "mock_spi_devices.h"
+
+#include <deque>
+#include <vector>
+
+// ============================================================================
+// GLOBAL INSTANCES
+// ============================================================================
+HardwareSerial Serial;
+SPIClass SPI;
+
+// ============================================================================
+// PRIVATE STATE
+// ============================================================================
+static uint64_t nowMicros = 0;
+
+struct PinState {
+  uint8_t level = HIGH;  // Inputs idle high (pull-ups)
+  uint8_t mode = INPUT;
+  void (*handler)() = nullptr;
+  int edgeMode = CHANGE;
+};
+static PinState pins[HAL_NUM_PINS];
+
+// Pin of each external interrupt number (see digitalPinToInterrupt)
+static const uint8_t INTERRUPT_PINS[] = {2, 3, 21, 20, 19, 18};
+
+uint8_t PCICR = 0, PCIFR = 0, PCMSK0 = 0, PCMSK1 = 0, PCMSK2 = 0;
+
+// Pin change vectors, defined by the firmware with ISR() when it uses them
+extern "C" void PCINT0_vect() __attribute__((weak));
+extern "C" void PCINT1_vect() __attribute__((weak));
+extern "C" void PCINT2_vect() __attribute__((weak));
+
+static std::deque<uint8_t> serialRx;
+static std::string serialTx;
+static int serialTxRoom = 63;
+
+static MockSpiDevice* spiDevices[HAL_NUM_PINS];
+
+// ============================================================================
+// TIME
+// ============================================================================
+unsigned long millis() { return (unsigned long)(nowMicros / 1000); }
+unsigned long micros() { return (unsigned long)nowMicros; }
+void delay(unsigned long ms) { nowMicros += (uint64_t)ms * 1000; }
+void delayMicroseconds(unsigned int us) { nowMicros += us; }
+
+void Hal_SetMicros(uint64_t us) { nowMicros = us; }
+void Hal_AdvanceMicros(uint64_t us) { nowMicros += us; }
+uint64_t Hal_GetMicros64() { return nowMicros; }
+
+// ============================================================================
+// PINS AND INTERRUPTS
+// ============================================================================
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < HAL_NUM_PINS) pins[pin].mode = mode;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < HAL_NUM_PINS ? pins[pin].level : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  if (pin >= HAL_NUM_PINS) return;
+  uint8_t previous = pins[pin].level;
+  pins[pin].level = level ? HIGH : LOW;
+
+  MockSpiDevice* device = spiDevices[pin];
+  if (device != nullptr && previous != pins[pin].level) {
+    if (pins[pin].level == LOW) device->select();
+    else device->deselect();
+  }
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*handler)(), int mode) {
+  if (interruptNum >= sizeof(INTERRUPT_PINS)) return;
+  PinState& p = pins[INTERRUPT_PINS[interruptNum]];
+  p.handler = handler;
+  p.edgeMode = mode;
+}
+
+void detachInterrupt(uint8_t interruptNum) {
+  if (interruptNum < sizeof(INTERRUPT_PINS)) pins[INTERRUPT_PINS[interruptNum]].handler = nullptr;
+}
+
+// Run the pin's bank vector if its pin change interrupt is enabled
+static void PinChange(uint8_t pin) {
+  uint8_t* mask = digitalPinToPCMSK(pin);
+  if (mask == nullptr) return;
+  uint8_t bank = digitalPinToPCICRbit(pin);
+  if (!(PCICR & _BV(bank)) || !(*mask & _BV(digitalPinToPCMSKbit(pin)))) return;
+
+  void (*vector)() = bank == 0 ? PCINT0_vect : (bank == 1 ? PCINT1_vect : PCINT2_vect);
+  if (vector != nullptr) vector();
+}
+
+// Interrupts are delivered synchronously from Hal_SetPin(), never in the
+// middle of firmware code, so there is nothing to mask
+void noInterrupts() {}
+void interrupts() {}
+
+void Hal_SetPin(uint8_t pin, uint8_t level) {
+  if (pin >= HAL_NUM_PINS) return;
+  PinState& p = pins[pin];
+  uint8_t previous = p.level;
+  p.level = level ? HIGH : LOW;
+  if (previous == p.level) return;
+  PinChange(pin);
+  if (p.handler == nullptr) return;
+
+  bool fire = p.edgeMode == CHANGE ||
+              (p.edgeMode == RISING && p.level == HIGH) ||
+              (p.edgeMode == FALLING && p.level == LOW);
+  if (fire) p.handler();
+}
+
+uint8_t Hal_GetPin(uint8_t pin) {
+  return pin < HAL_NUM_PINS ? pins[pin].level : LOW;
+}
+
+// ============================================================================
+// AVR-LIBC HELPERS
+// ============================================================================
+char* ultoa(unsigned long value, char* buffer, int radix) {
+  char digits[33];
+  int n = 0;
+  do {
+    int d = (int)(value % radix);
+    digits[n++] = (char)(d < 10 ? '0' + d : 'a' + d - 10);
+    value /= radix;
+  } while (value != 0);
+
+  for (int i = 0; i < n; i++) buffer[i] = digits[n - 1 - i];
+  buffer[n] = '\0';
+  return buffer;
+}
+
+// ============================================================================
+// PRINT
+// ============================================================================
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while (size--) n += write(*buffer++);
+  return n;
+}
+
+size_t Print::print(long value, int base) {
+  char text[24];
+  if (base == HEX) snprintf(text, sizeof(text), "%lX", value);
+  else snprintf(text, sizeof(text), "%ld", value);
+  return write(text);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  char text[24];
+  if (base == HEX) snprintf(text, sizeof(text), "%lX", value);
+  else snprintf(text, sizeof(text), "%lu", value);
+  return write(text);
+}
+
+size_t Print::print(double value, int digits) {
+  char text[64];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return write(text);
+}
+
+// ============================================================================
+// SERIAL PORT
+// ============================================================================
+void HardwareSerial::begin(unsigned long) {}
+
+int HardwareSerial::available() { return (int)serialRx.size(); }
+
+int HardwareSerial::read() {
+  if (serialRx.empty()) return -1;
+  uint8_t c = serialRx.front();
+  serialRx.pop_front();
+  return c;
+}
+
+int HardwareSerial::peek() { return serialRx.empty() ? -1 : serialRx.front(); }
+
+int HardwareSerial::availableForWrite() { return serialTxRoom; }
+
+size_t HardwareSerial::write(uint8_t c) {
+  serialTx.push_back((char)c);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  serialTx.append((const char*)buffer, size);
+  return size;
+}
+
+void Hal_SerialInject(const char* data, size_t length) {
+  serialRx.insert(serialRx.end(), data, data + length);
+}
+
+void Hal_SerialInject(const char* text) { Hal_SerialInject(text, strlen(text)); }
+
+std::string Hal_SerialTake() {
+  std::string out;
+  out.swap(serialTx);
+  return out;
+}
+
+void Hal_SetSerialTxRoom(int bytes) { serialTxRoom = bytes; }
+
+// ============================================================================
+// SPI
+// ============================================================================
+void Hal_AttachSpiDevice(uint8_t chipSelectPin, MockSpiDevice* device) {
+  if (chipSelectPin < HAL_NUM_PINS) spiDevices[chipSelectPin] = device;
+}
+
+void Hal_DetachSpiDevices() {
+  for (int i = 0; i < HAL_NUM_PINS; i++) spiDevices[i] = nullptr;
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+  uint8_t miso = 0xFF;
+  for (int pin = 0; pin < HAL_NUM_PINS; pin++) {
+    if (spiDevices[pin] != nullptr && pins[pin].level == LOW) {
+      miso &= spiDevices[pin]->transfer(data);
+    }
+  }
+  return miso;
+}
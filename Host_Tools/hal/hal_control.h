@@ -0,0 +1,57 @@
+/*
+ * ============================================================================
+ * HOST HAL - CONTROL INTERFACE
+ * ============================================================================
+ *
+ * The PC side of the host HAL: advance simulated time, drive input pins
+ * (attached interrupts fire on the edge), feed and collect serial bytes,
+ * and plug mock SPI devices onto chip select pins.
+ *
+ * ============================================================================
+ */
+
+#ifndef HOST_HAL_CONTROL_H
+#define HOST_HAL_CONTROL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+class MockSpiDevice;
+
+// ============================================================================
+// TIME
+// ============================================================================
+void Hal_SetMicros(uint64_t us);
+void Hal_AdvanceMicros(uint64_t us);
+uint64_t Hal_GetMicros64();
+
+// ============================================================================
+// PINS AND INTERRUPTS
+// ============================================================================
+// Drive an input pin; an attached interrupt handler runs if the edge matches,
+// and the pin change vector if the pin has its interrupt enabled
+void Hal_SetPin(uint8_t pin, uint8_t level);
+uint8_t Hal_GetPin(uint8_t pin);
+
+// ============================================================================
+// SERIAL PORT
+// ============================================================================
+// Bytes the firmware will read with Serial.read()
+void Hal_SerialInject(const char* data, size_t length);
+void Hal_SerialInject(const char* text);
+
+// Everything the firmware has written since the last call
+std::string Hal_SerialTake();
+
+// Value returned by Serial.availableForWrite() (63 = empty AVR TX buffer)
+void Hal_SetSerialTxRoom(int bytes);
+
+// ============================================================================
+// SPI
+// ============================================================================
+void Hal_AttachSpiDevice(uint8_t chipSelectPin, MockSpiDevice* device);
+void Hal_DetachSpiDevices();
+
+#endif // HOST_HAL_CONTROL_H
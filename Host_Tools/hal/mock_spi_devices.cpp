@@ -0,0 +1,148 @@
+/*
+ * ============================================================================
+ * HOST HAL - MOCK SPI DEVICES - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "mock_spi_devices.h"
+
+// ============================================================================
+// LS7366R
+// ============================================================================
+// Instruction byte: IR[7:6] = operation, IR[5:3] = register
+#define OP_CLR  0
+#define OP_RD   1
+#define OP_WR   2
+#define OP_LOAD 3
+
+#define REG_MDR0 1
+#define REG_MDR1 2
+#define REG_DTR  3
+#define REG_CNTR 4
+#define REG_OTR  5
+#define REG_STR  6
+
+uint32_t MockLS7366R::counterMask() const {
+  int n = counterBytes();
+  return n == 4 ? 0xFFFFFFFFu : ((1u << (8 * n)) - 1);
+}
+
+void MockLS7366R::addCounts(int32_t delta) {
+  cntr = (cntr + (uint32_t)delta) & counterMask();
+}
+
+void MockLS7366R::select() {
+  byteIndex = 0;
+  readOut.clear();
+}
+
+uint8_t MockLS7366R::transfer(uint8_t mosi) {
+  if (byteIndex++ == 0) {
+    instruction = mosi;
+    int op = mosi >> 6;
+    int reg = (mosi >> 3) & 0x07;
+
+    switch (op) {
+      case OP_CLR:
+        if (reg == REG_MDR0) regMdr0 = 0;
+        if (reg == REG_MDR1) regMdr1 = 0;
+        if (reg == REG_CNTR) cntr = 0;
+        if (reg == REG_STR) str = 0;
+        break;
+
+      case OP_LOAD:
+        if (reg == REG_CNTR) cntr = dtr & counterMask();
+        if (reg == REG_OTR) { otr = cntr; loads++; }
+        break;
+
+      case OP_RD: {
+        uint32_t value = 0;
+        int width = 1;
+        if (reg == REG_MDR0) value = regMdr0;
+        else if (reg == REG_MDR1) value = regMdr1;
+        else if (reg == REG_STR) value = str;
+        else {
+          width = counterBytes();
+          value = reg == REG_CNTR ? cntr : (reg == REG_OTR ? otr : dtr);
+        }
+        for (int i = width - 1; i >= 0; i--) readOut.push_back((uint8_t)(value >> (8 * i)));
+        break;
+      }
+    }
+    return 0xFF;
+  }
+
+  int op = instruction >> 6;
+  int reg = (instruction >> 3) & 0x07;
+  int dataIndex = byteIndex - 2;  // 0 = first data byte
+
+  if (op == OP_WR) {
+    if (reg == REG_MDR0 && dataIndex == 0) regMdr0 = mosi;
+    else if (reg == REG_MDR1 && dataIndex == 0) regMdr1 = mosi;
+    else if (reg == REG_DTR) dtr = (dtr << 8) | mosi;
+    return 0xFF;
+  }
+
+  if (op == OP_RD && dataIndex < (int)readOut.size()) return readOut[dataIndex];
+  return 0xFF;
+}
+
+// ============================================================================
+// SSI
+// ============================================================================
+void MockSsiEncoder::select() {
+  // First clock edge latches the position; the first bit read is a dummy
+  uint32_t value = position & ((1u << bits) - 1);
+  if (gray) value ^= value >> 1;
+
+  frameBits.clear();
+  frameBits.push_back(1);
+  for (int i = bits - 1; i >= 0; i--) frameBits.push_back((value >> i) & 1);
+  bitIndex = 0;
+}
+
+uint8_t MockSsiEncoder::nextByte() {
+  uint8_t out = 0;
+  for (int i = 0; i < 8; i++) {
+    // After the frame the data line returns low (monoflop time), then high
+    uint8_t bit = bitIndex < frameBits.size() ? frameBits[bitIndex] : 0;
+    bitIndex++;
+    out = (out << 1) | bit;
+  }
+  return out;
+}
+
+uint8_t MockSsiEncoder::transfer(uint8_t) {
+  return nextByte();
+}
+
+// ============================================================================
+// BiSS-C
+// ============================================================================
+uint8_t MockBissEncoder::crc6(uint64_t data, int bitCount) {
+  // Polynomial long division by 0b1000011, MSB first
+  uint64_t remainder = data << 6;
+  for (int i = bitCount + 5; i >= 6; i--) {
+    if (remainder & (1ULL << i)) remainder ^= 0x43ULL << (i - 6);
+  }
+  return (uint8_t)(remainder & 0x3F);
+}
+
+void MockBissEncoder::select() {
+  uint64_t data = position & ((1u << bits) - 1);
+  data = (data << 1) | (error ? 0 : 1);
+  data = (data << 1) | (warning ? 0 : 1);
+  int dataBits = bits + 2;
+
+  uint8_t crc = (uint8_t)(~crc6(data, dataBits) & 0x3F);
+  if (corruptCrc) crc ^= 0x01;
+
+  frameBits.clear();
+  frameBits.push_back(1);                                   // Line idle
+  for (int i = 0; i < ackBits; i++) frameBits.push_back(0); // Ack
+  frameBits.push_back(1);                                   // Start
+  frameBits.push_back(0);                                   // CDS
+  for (int i = dataBits - 1; i >= 0; i--) frameBits.push_back((data >> i) & 1);
+  for (int i = 5; i >= 0; i--) frameBits.push_back((crc >> i) & 1);
+  bitIndex = 0;
+}
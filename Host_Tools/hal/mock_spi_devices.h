@@ -0,0 +1,116 @@
+/*
+ * ============================================================================
+ * HOST HAL - MOCK SPI DEVICES
+ * ============================================================================
+ *
+ * Behavioural models of the SPI encoder hardware supported by the firmware,
+ * for driving the encoder backends on the PC:
+ *
+ * - MockLS7366R     : LS7366R quadrature counter (instruction set, MDR0/MDR1,
+ *                     CNTR/OTR/DTR/STR registers, 1-4 byte counter width)
+ * - MockSsiEncoder  : SSI absolute encoder (binary or Gray output)
+ * - MockBissEncoder : BiSS-C absolute encoder with ack latency, error and
+ *                     warning bits and CRC6 (optionally corrupted)
+ *
+ * Attach a device to its chip select pin with Hal_AttachSpiDevice().
+ *
+ * ============================================================================
+ */
+
+#ifndef HOST_HAL_MOCK_SPI_DEVICES_H
+#define HOST_HAL_MOCK_SPI_DEVICES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// ============================================================================
+// BASE CLASS
+// ============================================================================
+class MockSpiDevice {
+public:
+  virtual ~MockSpiDevice() {}
+  virtual void select() {}                        // Chip select went LOW
+  virtual void deselect() {}                      // Chip select went HIGH
+  virtual uint8_t transfer(uint8_t mosi) = 0;     // One byte each way
+};
+
+// ============================================================================
+// LS7366R QUADRATURE COUNTER
+// ============================================================================
+class MockLS7366R : public MockSpiDevice {
+public:
+  // Host side: move the encoder by 'delta' counts
+  void addCounts(int32_t delta);
+
+  uint32_t counter() const { return cntr; }
+  uint8_t mdr0() const { return regMdr0; }
+  uint8_t mdr1() const { return regMdr1; }
+  unsigned long loadOtrCount() const { return loads; }
+
+  virtual void select();
+  virtual uint8_t transfer(uint8_t mosi);
+
+private:
+  int counterBytes() const { return 4 - (regMdr1 & 0x03); }
+  uint32_t counterMask() const;
+
+  uint8_t regMdr0 = 0;
+  uint8_t regMdr1 = 0;
+  uint32_t dtr = 0;
+  uint32_t cntr = 0;
+  uint32_t otr = 0;
+  uint8_t str = 0;
+
+  // Current transaction
+  int byteIndex = 0;
+  uint8_t instruction = 0;
+  std::vector<uint8_t> readOut;
+  unsigned long loads = 0;
+};
+
+// ============================================================================
+// SSI ABSOLUTE ENCODER
+// ============================================================================
+class MockSsiEncoder : public MockSpiDevice {
+public:
+  MockSsiEncoder(int positionBits, bool grayCode) : bits(positionBits), gray(grayCode) {}
+
+  uint32_t position = 0;  // Single-turn position (binary)
+
+  virtual void select();
+  virtual uint8_t transfer(uint8_t mosi);
+
+protected:
+  std::vector<uint8_t> frameBits;  // Latched on select, one bit per entry
+  size_t bitIndex = 0;
+  uint8_t nextByte();
+
+private:
+  int bits;
+  bool gray;
+};
+
+// ============================================================================
+// BiSS-C ABSOLUTE ENCODER
+// ============================================================================
+class MockBissEncoder : public MockSsiEncoder {
+public:
+  explicit MockBissEncoder(int positionBits) : MockSsiEncoder(positionBits, false), bits(positionBits) {}
+
+  int ackBits = 2;         // Processing delay before the start bit
+  bool error = false;      // Drives nE low
+  bool warning = false;    // Drives nW low
+  bool corruptCrc = false; // Send a wrong CRC
+
+  // Reference CRC6 (x^6 + x + 1) - independent of the firmware's
+  static uint8_t crc6(uint64_t data, int bitCount);
+
+  virtual void select();
+
+private:
+  int bits;
+};
+
+#endif // HOST_HAL_MOCK_SPI_DEVICES_H
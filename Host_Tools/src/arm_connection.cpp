@@ -0,0 +1,233 @@
+/*
+ * ============================================================================
+ * ARM CONNECTION - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "arm_connection.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// How long a SYNC reply may take during setup
+static const int SETUP_PROBE_TIMEOUT_MS = 250;
+
+ArmConnection::ArmConnection(size_t index, const std::string& name, const std::string& path,
+                             const RigidTransform& toFixture)
+    : armIndex(index), armName(name), portPath(path), transform(toFixture) {}
+
+bool ArmConnection::loadCompensation(const std::string& mapPath) {
+  if (!errorMap.load(mapPath)) {
+    lastError = errorMap.error();
+    return false;
+  }
+  return true;
+}
+
+bool ArmConnection::open(int baud) {
+  if (!port.open(portPath, baud)) {
+    lastError = port.error();
+    return false;
+  }
+  return true;
+}
+
+// ============================================================================
+// SETUP (BLOCKING)
+// ============================================================================
+// Send a command and wait for its ACK; other lines are handled (and any
+// samples discarded)
+bool ArmConnection::command(const char* text, const char* ack) {
+  if (!port.writeLine(text)) {
+    lastError = port.error();
+    return false;
+  }
+  std::string line;
+  int64_t receivedNs;
+  std::string expected = std::string("ACK,") + ack;
+  std::vector<ArmSample> ignored;
+  while (port.readLine(line, receivedNs, 2000)) {
+    if (line == expected) return true;
+    handleLine(line, receivedNs, ignored);
+  }
+  lastError = std::string("No response to ") + text;
+  return false;
+}
+
+bool ArmConnection::prepare(bool waitForBanner, int probes, bool useSequenced) {
+  std::string line;
+  int64_t receivedNs;
+  std::vector<ArmSample> ignored;
+
+  // Opening the port resets the Arduino: wait for it to come up
+  if (waitForBanner) {
+    while (port.readLine(line, receivedNs, 3000)) {
+      if (line == "Ready for commands") break;
+    }
+  }
+
+  if (!command("SETTS US", "TIMESTAMP_US")) return false;
+
+  for (int i = 0; i < probes; i++) {
+    if (!sendProbe(HostClock_NowNs())) return false;
+    int64_t deadline = pendingSentNs + SETUP_PROBE_TIMEOUT_MS * 1000000LL;
+    while (pendingSeq != 0) {
+      int waitMs = static_cast<int>((deadline - HostClock_NowNs()) / 1000000);
+      if (waitMs < 0 || !port.readLine(line, receivedNs, waitMs)) break;
+      handleLine(line, receivedNs, ignored);
+    }
+  }
+  if (!clock.synchronized()) {
+    lastError = "No SYNC replies received";
+    return false;
+  }
+
+  if (useSequenced && !command("SETSEQ ON", "SEQUENCED_STREAM_ON")) return false;
+  sequenced = useSequenced;
+  tracker.reset();
+  return true;
+}
+
+bool ArmConnection::start() {
+  count = ArmCounters();  // Lines seen during setup do not count
+  tracker.reset();
+  nextProbeNs = HostClock_NowNs() + syncIntervalNs;
+  if (!port.writeLine("START")) {
+    lastError = port.error();
+    return false;
+  }
+  return true;
+}
+
+void ArmConnection::stop() {
+  port.writeLine("STOP");
+  if (sequenced) port.writeLine("SETSEQ OFF");
+}
+
+// ============================================================================
+// CLOCK SYNC
+// ============================================================================
+bool ArmConnection::sendProbe(int64_t nowNs) {
+  pendingSeq = nextSeq++;
+  pendingSentNs = nowNs;
+  if (!port.writeLine("SYNC " + std::to_string(pendingSeq))) {
+    lastError = port.error();
+    return false;
+  }
+  return true;
+}
+
+// ============================================================================
+// EVENT LOOP
+// ============================================================================
+bool ArmConnection::onReadable(std::vector<ArmSample>& out) {
+  bool open = port.readAvailable();
+
+  std::string line;
+  int64_t receivedNs;
+  while (port.nextLine(line, receivedNs)) {
+    handleLine(line, receivedNs, out);
+  }
+
+  if (!open) lastError = port.error();
+  return open;
+}
+
+void ArmConnection::onTimer(int64_t nowNs) {
+  if (nowNs >= nextProbeNs) {
+    // A probe that got no reply is simply replaced
+    sendProbe(nowNs);
+    nextProbeNs = nowNs + syncIntervalNs;
+  }
+  if (sequenced) {
+    for (const std::string& request : tracker.resendRequests(nowNs)) {
+      port.writeLine(request);
+    }
+  }
+}
+
+int64_t ArmConnection::nextTimerNs() const {
+  // RESENDs are retried on time even if the arm sends nothing else
+  return sequenced ? std::min(nextProbeNs, tracker.nextRetryNs()) : nextProbeNs;
+}
+
+// ============================================================================
+// LINE HANDLING
+// ============================================================================
+void ArmConnection::handleLine(const std::string& line, int64_t receivedNs,
+                               std::vector<ArmSample>& out) {
+  count.lines++;
+
+  if (line.compare(0, 4, "POS,") == 0) {
+    addSample(line.c_str() + 4, receivedNs, out);
+    return;
+  }
+
+  if (sequenced && tracker.handleLine(line)) {
+    SequencedFrame frame;
+    while (tracker.popFrame(frame)) {
+      addSample(frame.fields.c_str(), receivedNs, out);
+    }
+    for (const std::string& request : tracker.resendRequests(receivedNs)) {
+      port.writeLine(request);
+    }
+    return;
+  }
+
+  if (line.compare(0, 5, "SYNC,") == 0) {
+    // SYNC,seq,rxMicros,txMicros
+    char* end;
+    unsigned long seq = strtoul(line.c_str() + 5, &end, 10);
+    if (*end != ',') return;
+    uint32_t rxUs = static_cast<uint32_t>(strtoul(end + 1, &end, 10));
+    if (*end != ',') return;
+    uint32_t txUs = static_cast<uint32_t>(strtoul(end + 1, &end, 10));
+
+    if (seq != pendingSeq) return;  // Late reply to a replaced probe
+    clock.addExchange(pendingSentNs, rxUs, txUs, receivedNs);
+    pendingSeq = 0;
+    return;
+  }
+
+  if (line.compare(0, 6, "ERROR,") == 0) {
+    count.deviceErrors++;
+    lastError = line;
+  }
+}
+
+void ArmConnection::addSample(const char* fields, int64_t receivedNs, std::vector<ArmSample>& out) {
+  // timestamp,x,y,z,joints...
+  char* end;
+  uint32_t deviceUs = static_cast<uint32_t>(strtoul(fields, &end, 10));
+  if (*end != ',') {
+    count.malformed++;
+    return;
+  }
+
+  double p[3];
+  for (int i = 0; i < 3; i++) {
+    const char* start = end + 1;
+    p[i] = strtod(start, &end);
+    if (end == start || (*end != ',' && *end != '\0')) {
+      count.malformed++;
+      return;
+    }
+  }
+
+  if (!clock.synchronized()) {
+    count.unsynced++;
+    return;
+  }
+
+  out.emplace_back();
+  ArmSample& sample = out.back();
+  sample.hostNs = clock.toHostNs(deviceUs);
+  sample.receivedNs = receivedNs;
+  sample.arm = armIndex;
+  errorMap.apply(p, p);
+  transform.apply(p, sample.xyz);
+  if (*end == ',') sample.joints.assign(end + 1);
+  clock.observeLatency(deviceUs, receivedNs);
+  count.samples++;
+}
@@ -0,0 +1,146 @@
+/*
+ * ============================================================================
+ * ARM CONNECTION - HEADER FILE
+ * ============================================================================
+ *
+ * One arm as seen by a multi-arm host process: its serial port, a model of
+ * its micros() clock (SYNC exchanges, see clock_sync.h), an optional
+ * volumetric error map (error_map.h) and the transform from its base
+ * frame to the shared fixture frame.
+ *
+ * Setup (prepare / start) is blocking and done once. After that the
+ * connection is driven by an event loop: onReadable() when the port's
+ * descriptor is readable, onTimer() at nextTimerNs(). Neither blocks, so
+ * one thread serves any number of arms.
+ *
+ * Every POS line (or SPOS frame with sequenced streaming) becomes an
+ * ArmSample stamped with the sample time on the HOST clock, so samples
+ * from different arms can be ordered against each other. Samples that
+ * arrive before the first SYNC reply cannot be placed and are counted as
+ * unsynced.
+ *
+ * ============================================================================
+ */
+
+#ifndef ARM_CONNECTION_H
+#define ARM_CONNECTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "clock_sync.h"
+#include "error_map.h"
+#include "frame_tracker.h"
+#include "rigid_transform.h"
+#include "serial_port.h"
+
+struct ArmSample {
+  int64_t hostNs = 0;        // Sample time, host monotonic clock
+  int64_t receivedNs = 0;    // When the line was read
+  size_t arm = 0;            // Index of the arm that sent it
+  double xyz[3] = {0, 0, 0}; // Tip position in the fixture frame (mm), compensated
+  std::string joints;        // theta1,...,thetaN[,omega1,...] as sent
+};
+
+struct ArmCounters {
+  uint64_t lines = 0;        // Lines received
+  uint64_t samples = 0;      // Samples produced
+  uint64_t malformed = 0;    // POS / SPOS fields that did not parse
+  uint64_t unsynced = 0;     // Samples dropped before the first SYNC reply
+  uint64_t deviceErrors = 0; // ERROR lines from the firmware
+};
+
+class ArmConnection {
+public:
+  ArmConnection(size_t index, const std::string& name, const std::string& path,
+                const RigidTransform& toFixture);
+
+  ArmConnection(const ArmConnection&) = delete;
+  ArmConnection& operator=(const ArmConnection&) = delete;
+
+  bool open(int baud);
+
+  // Load the arm's error map; it is applied in the base frame, before the
+  // fixture transform. Returns false and sets error().
+  bool loadCompensation(const std::string& mapPath);
+
+  // Blocking setup: wait for the startup banner (optional), switch to
+  // microsecond timestamps, run 'probes' SYNC exchanges and, if
+  // 'sequenced', switch to SPOS frames. Returns false and sets error().
+  bool prepare(bool waitForBanner, int probes, bool sequenced);
+
+  // START / STOP recording (the ACK is consumed by the event loop)
+  bool start();
+  void stop();
+
+  // SYNC probe period while streaming (default 250 ms)
+  void setSyncInterval(int64_t intervalNs) { syncIntervalNs = intervalNs; }
+
+  // How long to wait for a resent frame before asking again (default:
+  // FrameTracker's)
+  void setResendRetry(int64_t retryNs) { tracker.setRetry(retryNs); }
+
+  // --------------------------------------------------------------------------
+  // Event loop
+  // --------------------------------------------------------------------------
+  int descriptor() const { return port.descriptor(); }
+
+  // Read what has arrived and append the complete samples to 'out'.
+  // Returns false when the port is gone (error() says why).
+  bool onReadable(std::vector<ArmSample>& out);
+
+  // Send a SYNC probe and RESEND requests when due
+  void onTimer(int64_t nowNs);
+  int64_t nextTimerNs() const;
+
+  // --------------------------------------------------------------------------
+  // State and metrics
+  // --------------------------------------------------------------------------
+  size_t index() const { return armIndex; }
+  const std::string& name() const { return armName; }
+  const std::string& path() const { return portPath; }
+  const std::string& error() const { return lastError; }
+
+  const ArmCounters& counters() const { return count; }
+  const ClockSyncMetrics& clockMetrics() const { return clock.metrics(); }
+  const FrameTrackerStats& frameStats() const { return tracker.stats(); }
+  const ErrorMap& compensation() const { return errorMap; }
+
+  // Sequenced frames are missing and being asked for again. Later samples
+  // are held back until they arrive or are given up on, at most
+  // recoveryBudgetNs() after the first RESEND.
+  bool recovering() const {
+    return sequenced && (tracker.missingCount() > 0 || tracker.heldCount() > 0);
+  }
+  int64_t recoveryBudgetNs() const { return tracker.retryBudgetNs(); }
+
+private:
+  void handleLine(const std::string& line, int64_t receivedNs, std::vector<ArmSample>& out);
+  void addSample(const char* fields, int64_t receivedNs, std::vector<ArmSample>& out);
+  bool sendProbe(int64_t nowNs);
+  bool command(const char* text, const char* ack);
+
+  size_t armIndex;
+  std::string armName;
+  std::string portPath;
+  RigidTransform transform;
+  ErrorMap errorMap;
+
+  SerialPort port;
+  DeviceClock clock;
+  FrameTracker tracker;
+  bool sequenced = false;
+
+  int64_t syncIntervalNs = 250000000;
+  unsigned long nextSeq = 1;
+  unsigned long pendingSeq = 0;   // Outstanding SYNC, 0 = none
+  int64_t pendingSentNs = 0;
+  int64_t nextProbeNs = 0;
+
+  ArmCounters count;
+  std::string lastError;
+};
+
+#endif  // ARM_CONNECTION_H
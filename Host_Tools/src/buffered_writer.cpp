@@ -0,0 +1,182 @@
+/*
+ * ============================================================================
+ * BUFFERED WRITER - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "buffered_writer.h"
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstring>
+
+// ============================================================================
+// CONSTRUCTION
+// ============================================================================
+BufferedWriter::BufferedWriter(size_t blockBytes, size_t queueDepth)
+    : blockSize(blockBytes), maxQueued(queueDepth == 0 ? 1 : queueDepth) {}
+
+BufferedWriter::~BufferedWriter() {
+  close();
+}
+
+// ============================================================================
+// OPEN / CLOSE
+// ============================================================================
+bool BufferedWriter::open(const std::string& path) {
+  close();
+
+  filePath = path;
+  if (path == "-") {
+    file = stdout;
+    ownsFile = false;
+  } else {
+    file = fopen(path.c_str(), "wb");
+    ownsFile = true;
+  }
+
+  if (file == nullptr) {
+    lastError = "Cannot create " + path + ": " + strerror(errno);
+    return false;
+  }
+
+  // We do our own buffering; stdio's would only add a copy
+  setvbuf(file, nullptr, _IONBF, 0);
+
+  struct stat info;
+  isSeekable = ownsFile && fstat(fileno(file), &info) == 0 && S_ISREG(info.st_mode);
+
+  current.assign(blockSize, 0);
+  used = 0;
+  totalBytes = 0;
+  stopping = false;
+  failed = false;
+  lastError.clear();
+
+  writer = std::thread(&BufferedWriter::writerLoop, this);
+  return true;
+}
+
+bool BufferedWriter::close() {
+  if (file == nullptr) return !failed;
+
+  if (used > 0) rotate(0);
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopping = true;
+  }
+  changed.notify_all();
+  if (writer.joinable()) writer.join();
+
+  if (ownsFile) {
+    if (fclose(file) != 0 && !failed) {
+      failed = true;
+      lastError = "Close failed: " + std::string(strerror(errno));
+    }
+  } else {
+    fflush(file);
+  }
+  file = nullptr;
+
+  current.clear();
+  current.shrink_to_fit();
+  spare.clear();
+  return !failed;
+}
+
+// ============================================================================
+// PRODUCER SIDE
+// ============================================================================
+void BufferedWriter::write(const void* data, size_t bytes) {
+  const char* src = static_cast<const char*>(data);
+  while (bytes > 0) {
+    if (used == current.size()) rotate(0);
+    size_t chunk = current.size() - used;
+    if (chunk > bytes) chunk = bytes;
+    memcpy(current.data() + used, src, chunk);
+    used += chunk;
+    src += chunk;
+    bytes -= chunk;
+  }
+}
+
+// Queue the current block (if it holds anything) and start a fresh one
+// with room for at least minBytes.
+void BufferedWriter::rotate(size_t minBytes) {
+  std::vector<char> next;
+
+  {
+    std::unique_lock<std::mutex> guard(lock);
+
+    if (used > 0) {
+      // Backpressure: wait for the writer thread to catch up
+      changed.wait(guard, [this] { return pending.size() < maxQueued || failed; });
+
+      current.resize(used);
+      totalBytes += used;
+      pending.push_back(std::move(current));
+    }
+
+    if (!spare.empty()) {
+      next = std::move(spare.back());
+      spare.pop_back();
+    }
+  }
+  changed.notify_all();
+
+  size_t size = minBytes > blockSize ? minBytes : blockSize;
+  next.resize(size);
+  current = std::move(next);
+  used = 0;
+}
+
+// ============================================================================
+// WRITER THREAD
+// ============================================================================
+void BufferedWriter::writerLoop() {
+  std::unique_lock<std::mutex> guard(lock);
+
+  for (;;) {
+    changed.wait(guard, [this] { return !pending.empty() || stopping; });
+    if (pending.empty()) break;
+
+    std::vector<char> block = std::move(pending.front());
+    pending.pop_front();
+    guard.unlock();
+
+    bool ok = failed || fwrite(block.data(), 1, block.size(), file) == block.size();
+    int savedErrno = errno;
+
+    guard.lock();
+    if (!ok && !failed) {
+      failed = true;
+      lastError = "Write to " + filePath + " failed: " + strerror(savedErrno);
+    }
+    spare.push_back(std::move(block));
+    changed.notify_all();
+  }
+}
+
+// ============================================================================
+// HEADER PATCHING
+// ============================================================================
+bool BufferedWriter::patch(uint64_t offset, const void* data, size_t bytes) {
+  if (!isSeekable) {
+    lastError = "Output is not seekable";
+    return false;
+  }
+
+  FILE* f = fopen(filePath.c_str(), "r+b");
+  if (f == nullptr) {
+    lastError = "Cannot reopen " + filePath + ": " + strerror(errno);
+    return false;
+  }
+
+  bool ok = fseeko(f, static_cast<off_t>(offset), SEEK_SET) == 0 &&
+            fwrite(data, 1, bytes, f) == bytes;
+  ok = (fclose(f) == 0) && ok;
+  if (!ok) lastError = "Cannot patch " + filePath;
+  return ok;
+}
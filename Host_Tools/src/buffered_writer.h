@@ -0,0 +1,98 @@
+/*
+ * ============================================================================
+ * BUFFERED WRITER - HEADER FILE
+ * ============================================================================
+ *
+ * Output file written by a dedicated thread.
+ *
+ * The producer formats into a large block (4 MiB by default). Full blocks
+ * go through a small bounded queue to the writer thread, which issues one
+ * fwrite() per block. When the queue is full the producer waits, so memory
+ * use is capped at (queueDepth + 1) blocks no matter how big the file gets.
+ *
+ * Typical use:
+ *   BufferedWriter out;
+ *   out.open("scan.ply");
+ *   char* p = out.reserve(256);  ...format into p...  out.commit(p);
+ *   out.close();
+ *
+ * ============================================================================
+ */
+
+#ifndef BUFFERED_WRITER_H
+#define BUFFERED_WRITER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class BufferedWriter {
+public:
+  explicit BufferedWriter(size_t blockBytes = 4 << 20, size_t queueDepth = 3);
+  ~BufferedWriter();
+
+  BufferedWriter(const BufferedWriter&) = delete;
+  BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+  // Open output file ("-" writes stdout) and start the writer thread
+  bool open(const std::string& path);
+
+  // Flush everything, stop the writer thread and close the file.
+  // Returns false if any write failed.
+  bool close();
+
+  // Get a pointer with room for at least maxBytes; finish with commit()
+  char* reserve(size_t maxBytes) {
+    if (current.size() - used < maxBytes) rotate(maxBytes);
+    return current.data() + used;
+  }
+
+  // Mark everything up to 'end' (returned by formatting into reserve()) as used
+  void commit(const char* end) { used = end - current.data(); }
+
+  // Copy raw bytes
+  void write(const void* data, size_t bytes);
+
+  // Overwrite bytes at an absolute file offset after close()
+  // (used to patch header fields such as the PLY vertex count).
+  // Only works for regular files.
+  bool patch(uint64_t offset, const void* data, size_t bytes);
+
+  uint64_t bytesWritten() const { return totalBytes + used; }
+  bool seekable() const { return isSeekable; }
+  const std::string& error() const { return lastError; }
+
+private:
+  void rotate(size_t minBytes);
+  void writerLoop();
+
+  std::string filePath;
+  FILE* file = nullptr;
+  bool ownsFile = false;
+  bool isSeekable = false;
+
+  size_t blockSize;
+  size_t maxQueued;
+
+  std::vector<char> current;  // block being filled by the producer
+  size_t used = 0;
+  uint64_t totalBytes = 0;    // bytes handed to the writer thread
+
+  // Hand-off to the writer thread
+  std::mutex lock;
+  std::condition_variable changed;
+  std::deque<std::vector<char>> pending;   // full blocks, oldest first
+  std::vector<std::vector<char>> spare;    // recycled empty blocks
+  bool stopping = false;
+  bool failed = false;
+  std::thread writer;
+
+  std::string lastError;
+};
+
+#endif // BUFFERED_WRITER_H
@@ -0,0 +1,206 @@
+/*
+ * ============================================================================
+ * CAPTURE FILE - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "capture_file.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+static const char CAPTURE_MAGIC[8] = {'C', 'C', 'M', 'C', 'A', 'P', '1', '\n'};
+static const size_t CAPTURE_HEADER_BYTES = 32;
+
+static void PutLe(uint8_t* out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+static uint64_t GetLe(const uint8_t* in, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+  return value;
+}
+
+static size_t PutVarint(uint8_t* out, uint64_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = static_cast<uint8_t>(value);
+  return n;
+}
+
+// ============================================================================
+// WRITER
+// ============================================================================
+CaptureWriter::~CaptureWriter() {
+  close();
+}
+
+bool CaptureWriter::open(const std::string& path, int baud, int64_t startNs) {
+  close();
+
+  file = fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    lastError = "Cannot create " + path + ": " + strerror(errno);
+    return false;
+  }
+  setvbuf(file, nullptr, _IOFBF, 1 << 16);
+
+  int64_t unixUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now().time_since_epoch()).count();
+
+  uint8_t header[CAPTURE_HEADER_BYTES] = {};
+  memcpy(header, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+  PutLe(header + 8, static_cast<uint32_t>(baud), 4);
+  PutLe(header + 16, static_cast<uint64_t>(unixUs), 8);
+
+  originNs = startNs;
+  lastUs = 0;
+  recordCount = 0;
+  dataBytes = 0;
+  failed = fwrite(header, 1, sizeof(header), file) != sizeof(header);
+  lastError.clear();
+  if (failed) lastError = std::string("Write failed: ") + strerror(errno);
+  return !failed;
+}
+
+bool CaptureWriter::write(int64_t timeNs, CaptureDirection direction, const void* data,
+                          size_t length) {
+  if (file == nullptr || failed) return false;
+
+  int64_t us = (timeNs - originNs) / 1000;
+  if (us < lastUs) us = lastUs;
+
+  uint8_t prefix[20];
+  size_t n = PutVarint(prefix, static_cast<uint64_t>(us - lastUs));
+  n += PutVarint(prefix + n, (static_cast<uint64_t>(length) << 1) | direction);
+  lastUs = us;
+
+  if (fwrite(prefix, 1, n, file) != n || fwrite(data, 1, length, file) != length) {
+    failed = true;
+    lastError = std::string("Write failed: ") + strerror(errno);
+    return false;
+  }
+  recordCount++;
+  dataBytes += length;
+  return true;
+}
+
+bool CaptureWriter::close() {
+  if (file == nullptr) return !failed;
+  if (fclose(file) != 0 && !failed) {
+    failed = true;
+    lastError = std::string("Write failed: ") + strerror(errno);
+  }
+  file = nullptr;
+  return !failed;
+}
+
+// ============================================================================
+// READER
+// ============================================================================
+CaptureReader::CaptureReader(size_t chunkBytes) : buffer(chunkBytes < 4096 ? 4096 : chunkBytes) {}
+
+CaptureReader::~CaptureReader() {
+  close();
+}
+
+bool CaptureReader::open(const std::string& path) {
+  close();
+
+  file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    lastError = "Cannot open " + path + ": " + strerror(errno);
+    return false;
+  }
+  lastError.clear();
+  return rewind();
+}
+
+void CaptureReader::close() {
+  if (file != nullptr) fclose(file);
+  file = nullptr;
+}
+
+bool CaptureReader::rewind() {
+  if (file == nullptr || fseek(file, 0, SEEK_SET) != 0) {
+    lastError = "Capture is not open or not seekable";
+    return false;
+  }
+  head = tail = 0;
+  endOfFile = false;
+  cutShort = false;
+  timeUs = 0;
+
+  if (!ensure(CAPTURE_HEADER_BYTES) || memcmp(buffer.data(), CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0) {
+    lastError = "Not a capture file (bad header)";
+    return false;
+  }
+  const uint8_t* header = reinterpret_cast<const uint8_t*>(buffer.data());
+  headerBaud = static_cast<int>(GetLe(header + 8, 4));
+  headerStartUs = static_cast<int64_t>(GetLe(header + 16, 8));
+  head = CAPTURE_HEADER_BYTES;
+  return true;
+}
+
+// Make at least 'bytes' unread bytes available; false at end of file
+bool CaptureReader::ensure(size_t bytes) {
+  if (tail - head >= bytes) return true;
+
+  // Move the unread tail to the front, growing only for oversized records
+  memmove(buffer.data(), buffer.data() + head, tail - head);
+  tail -= head;
+  head = 0;
+  if (buffer.size() < bytes) buffer.resize(bytes);
+
+  while (tail < bytes && !endOfFile) {
+    size_t n = fread(buffer.data() + tail, 1, buffer.size() - tail, file);
+    if (n == 0) endOfFile = true;
+    tail += n;
+  }
+  return tail >= bytes;
+}
+
+bool CaptureReader::readVarint(uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (!ensure(1)) return false;
+    uint8_t byte = static_cast<uint8_t>(buffer[head++]);
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+bool CaptureReader::next(CaptureRecord& record) {
+  if (file == nullptr || !lastError.empty()) return false;
+  if (!ensure(1)) return false;  // Clean end
+
+  uint64_t delta, lengthDir;
+  if (!readVarint(delta) || !readVarint(lengthDir)) {
+    cutShort = true;
+    return false;
+  }
+
+  size_t length = static_cast<size_t>(lengthDir >> 1);
+  if (length > CAPTURE_MAX_RECORD) {
+    lastError = "Corrupt capture (record of " + std::to_string(length) + " bytes)";
+    return false;
+  }
+  if (!ensure(length)) {
+    cutShort = true;
+    return false;
+  }
+
+  timeUs += static_cast<int64_t>(delta);
+  record.timeUs = timeUs;
+  record.direction = static_cast<uint8_t>(lengthDir & 1);
+  record.data = buffer.data() + head;
+  record.length = length;
+  head += length;
+  return true;
+}
@@ -0,0 +1,138 @@
+/*
+ * ============================================================================
+ * CAPTURE FILE - HEADER FILE
+ * ============================================================================
+ *
+ * Raw serial traffic with host receive times, so a session can be played
+ * back byte for byte (ccm_capture writes these, ccm_replay and ccm_bench
+ * read them).
+ *
+ * FORMAT (little-endian):
+ *
+ *   Header, 32 bytes:
+ *     char    magic[8]     "CCMCAP1\n"
+ *     uint32  baud         Serial baud rate of the capture
+ *     uint32  flags        0
+ *     int64   startUnixUs  Wall-clock time the capture started
+ *     int64   reserved     0
+ *
+ *   Records, one per read() from the port (or command written to it):
+ *     varint  deltaUs      Host monotonic time since the previous record
+ *                          (the first: since the start)
+ *     varint  lengthDir    (length << 1) | direction
+ *                          direction 0 = from the arm, 1 = to the arm
+ *     bytes   data[length]
+ *
+ * Varints are LEB128 (7 bits per byte, low bits first). A 1 kHz POS stream
+ * costs about 4 bytes of overhead per read.
+ *
+ * A capture cut short (power loss, kill -9) ends in a partial record; the
+ * reader stops before it and reports truncated().
+ *
+ * ============================================================================
+ */
+
+#ifndef CAPTURE_FILE_H
+#define CAPTURE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+enum CaptureDirection : uint8_t {
+  CAPTURE_FROM_ARM = 0,
+  CAPTURE_TO_ARM   = 1
+};
+
+// Longest record accepted by the reader (anything longer means corruption)
+static const size_t CAPTURE_MAX_RECORD = 1 << 20;
+
+struct CaptureRecord {
+  int64_t timeUs = 0;        // Since the start of the capture
+  uint8_t direction = CAPTURE_FROM_ARM;
+  const char* data = nullptr; // Valid until the next call to next()
+  size_t length = 0;
+};
+
+// ============================================================================
+// WRITER
+// ============================================================================
+class CaptureWriter {
+public:
+  CaptureWriter() = default;
+  ~CaptureWriter();
+
+  CaptureWriter(const CaptureWriter&) = delete;
+  CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+  // Create the file and write the header; startNs is the host monotonic
+  // time that record times are measured from. Returns false and sets error().
+  bool open(const std::string& path, int baud, int64_t startNs);
+
+  // Append one record. Times must not go backwards.
+  bool write(int64_t timeNs, CaptureDirection direction, const void* data, size_t length);
+
+  // Flush and close. Returns false if any write failed.
+  bool close();
+
+  uint64_t records() const { return recordCount; }
+  uint64_t bytes() const { return dataBytes; }  // Payload bytes, both directions
+  const std::string& error() const { return lastError; }
+
+private:
+  FILE* file = nullptr;
+  int64_t lastUs = 0;
+  int64_t originNs = 0;
+  uint64_t recordCount = 0;
+  uint64_t dataBytes = 0;
+  bool failed = false;
+  std::string lastError;
+};
+
+// ============================================================================
+// READER
+// ============================================================================
+class CaptureReader {
+public:
+  explicit CaptureReader(size_t chunkBytes = 1 << 20);
+  ~CaptureReader();
+
+  CaptureReader(const CaptureReader&) = delete;
+  CaptureReader& operator=(const CaptureReader&) = delete;
+
+  // Open a capture and check its header. Returns false and sets error().
+  bool open(const std::string& path);
+  void close();
+
+  // Next record. Returns false at the end of the file or on corruption
+  // (error() is set only for corruption).
+  bool next(CaptureRecord& record);
+
+  // Back to the first record
+  bool rewind();
+
+  int baud() const { return headerBaud; }
+  int64_t startUnixUs() const { return headerStartUs; }
+  bool truncated() const { return cutShort; }
+  const std::string& error() const { return lastError; }
+
+private:
+  bool ensure(size_t bytes);
+  bool readVarint(uint64_t& value);
+
+  FILE* file = nullptr;
+  std::vector<char> buffer;
+  size_t head = 0;  // First unread byte
+  size_t tail = 0;  // One past the last valid byte
+  bool endOfFile = false;
+
+  int headerBaud = 0;
+  int64_t headerStartUs = 0;
+  int64_t timeUs = 0;
+  bool cutShort = false;
+  std::string lastError;
+};
+
+#endif  // CAPTURE_FILE_H
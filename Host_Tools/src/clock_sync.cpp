@@ -0,0 +1,155 @@
+/*
+ * ============================================================================
+ * CLOCK SYNC - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "clock_sync.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Exchanges must span at least this long before drift is estimated;
+// over shorter spans the round-trip jitter swamps the slope
+static const int64_t MIN_DRIFT_SPAN_US = 2000000;
+
+DeviceClock::DeviceClock(size_t window) : windowSize(std::max<size_t>(window, 2)) {}
+
+void DeviceClock::reset() {
+  history.clear();
+  haveLast = false;
+  baseDeviceUs = 0;
+  baseHostNs = 0;
+  drift = 0;
+  stats = ClockSyncMetrics();
+}
+
+// ============================================================================
+// WRAP HANDLING
+// ============================================================================
+int64_t DeviceClock::unwrap(uint32_t deviceUs) {
+  if (!haveLast) {
+    haveLast = true;
+    lastRaw = deviceUs;
+    lastUnwrapped = deviceUs;
+    return lastUnwrapped;
+  }
+  // Signed 32-bit difference: correct across a wrap, and for values
+  // slightly older than the last one (e.g. a sample stamped before a SYNC)
+  int32_t step = static_cast<int32_t>(deviceUs - lastRaw);
+  int64_t value = lastUnwrapped + step;
+  if (step > 0) {
+    lastRaw = deviceUs;
+    lastUnwrapped = value;
+  }
+  return value;
+}
+
+// ============================================================================
+// SYNC EXCHANGES
+// ============================================================================
+void DeviceClock::addExchange(int64_t hostSendNs, uint32_t deviceRxUs, uint32_t deviceTxUs,
+                              int64_t hostReceiveNs) {
+  int64_t t2 = unwrap(deviceRxUs);
+  int64_t t3 = unwrap(deviceTxUs);
+
+  Exchange e;
+  e.deviceMidUs = t2 + (t3 - t2) / 2;
+  e.hostMidNs = hostSendNs + (hostReceiveNs - hostSendNs) / 2;
+  e.rttUs = std::max(0.0, (hostReceiveNs - hostSendNs) / 1000.0 - static_cast<double>(t3 - t2));
+
+  history.push_back(e);
+  if (history.size() > windowSize) history.pop_front();
+
+  stats.exchanges++;
+  stats.lastRttUs = e.rttUs;
+  refit();
+}
+
+void DeviceClock::refit() {
+  // Keep the best (lowest round trip) half of the window
+  std::vector<const Exchange*> used;
+  for (const Exchange& e : history) used.push_back(&e);
+  std::sort(used.begin(), used.end(),
+            [](const Exchange* a, const Exchange* b) { return a->rttUs < b->rttUs; });
+  used.resize(std::max<size_t>(1, (used.size() + 1) / 2));
+
+  // Fit offsetNs = hostMid - deviceMid*1000 against deviceMid, relative to
+  // the newest exchange so the doubles keep their precision
+  int64_t refDevice = history.back().deviceMidUs;
+  int64_t refOffset = history.back().hostMidNs - refDevice * 1000;
+
+  double n = static_cast<double>(used.size());
+  double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+  int64_t minX = 0, maxX = 0;
+  for (size_t i = 0; i < used.size(); i++) {
+    int64_t dx = used[i]->deviceMidUs - refDevice;
+    double x = static_cast<double>(dx);
+    double y = static_cast<double>(used[i]->hostMidNs - used[i]->deviceMidUs * 1000 - refOffset);
+    sumX += x;
+    sumY += y;
+    sumXX += x * x;
+    sumXY += x * y;
+    if (i == 0 || dx < minX) minX = dx;
+    if (i == 0 || dx > maxX) maxX = dx;
+  }
+
+  double slope = 0;  // ns of offset per us of device time
+  double denominator = n * sumXX - sumX * sumX;
+  if (used.size() >= 2 && maxX - minX >= MIN_DRIFT_SPAN_US && denominator > 0) {
+    slope = (n * sumXY - sumX * sumY) / denominator;
+  } else {
+    slope = drift * 1000.0;  // Keep the previous drift estimate
+  }
+  double intercept = (sumY - slope * sumX) / n;
+
+  double sumSquares = 0;
+  for (const Exchange* e : used) {
+    double x = static_cast<double>(e->deviceMidUs - refDevice);
+    double y = static_cast<double>(e->hostMidNs - e->deviceMidUs * 1000 - refOffset);
+    double r = y - (intercept + slope * x);
+    sumSquares += r * r;
+  }
+
+  drift = slope / 1000.0;
+  baseDeviceUs = refDevice;
+  baseHostNs = refDevice * 1000 + refOffset + static_cast<int64_t>(std::llround(intercept));
+
+  stats.exchangesUsed = used.size();
+  stats.offsetUs = (baseHostNs - baseDeviceUs * 1000) / 1000.0;
+  stats.driftPpm = -drift * 1e6;  // Device fast = fewer host ns per device us
+  stats.residualUs = std::sqrt(sumSquares / n) / 1000.0;
+  stats.minRttUs = used.front()->rttUs;
+  stats.uncertaintyUs = used.front()->rttUs / 2.0;
+}
+
+// ============================================================================
+// CONVERSION
+// ============================================================================
+int64_t DeviceClock::unwrappedToHostNs(int64_t deviceUs) const {
+  double elapsedUs = static_cast<double>(deviceUs - baseDeviceUs);
+  return baseHostNs + static_cast<int64_t>(std::llround(elapsedUs * 1000.0 * (1.0 + drift)));
+}
+
+int64_t DeviceClock::toHostNs(uint32_t deviceUs) {
+  return unwrappedToHostNs(unwrap(deviceUs));
+}
+
+// ============================================================================
+// LATENCY
+// ============================================================================
+double DeviceClock::observeLatency(uint32_t deviceUs, int64_t hostReceiveNs) {
+  double latencyUs = (hostReceiveNs - toHostNs(deviceUs)) / 1000.0;
+
+  if (stats.latencySamples == 0) {
+    stats.latencyMinUs = latencyUs;
+    stats.latencyMaxUs = latencyUs;
+  }
+  stats.latencySamples++;
+  stats.latencyLastUs = latencyUs;
+  stats.latencyMinUs = std::min(stats.latencyMinUs, latencyUs);
+  stats.latencyMaxUs = std::max(stats.latencyMaxUs, latencyUs);
+  stats.latencyMeanUs += (latencyUs - stats.latencyMeanUs) / stats.latencySamples;
+  return latencyUs;
+}
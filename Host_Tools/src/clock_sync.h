@@ -0,0 +1,106 @@
+/*
+ * ============================================================================
+ * CLOCK SYNC - HEADER FILE
+ * ============================================================================
+ *
+ * Model of the arm's micros() clock in terms of the host monotonic clock,
+ * so every device timestamp can be converted to host time.
+ *
+ * SYNC EXCHANGE (NTP style):
+ *   host  t1 --- "SYNC seq" ---> device t2 (line ending received)
+ *   host  t4 <-- "SYNC,seq,t2,t3" -- device t3 (line ending sent)
+ *
+ *   round trip   = (t4 - t1) - (t3 - t2)
+ *   offset       = midpoint(t1, t4) - midpoint(t2, t3)
+ *
+ * The offset error of one exchange is at most half its round trip (when
+ * all the delay was on one side), so only the lowest-delay exchanges in
+ * the window are used. A least-squares line through them gives the offset
+ * and the drift of the device crystal against the host clock.
+ *
+ * WRAP HANDLING:
+ * micros() is 32 bits and wraps every ~71.6 minutes. All device times go
+ * through unwrap(), which extends them to 64 bits by assuming consecutive
+ * values are less than half a wrap (~35 minutes) apart.
+ *
+ * ============================================================================
+ */
+
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+struct ClockSyncMetrics {
+  uint64_t exchanges = 0;       // SYNC round trips added
+  size_t exchangesUsed = 0;     // Low-delay exchanges in the current fit
+  double offsetUs = 0;          // Host minus device clock, now
+  double driftPpm = 0;          // Device clock rate error (+ = device runs fast)
+  double residualUs = 0;        // RMS misfit of the used exchanges (sync error)
+  double uncertaintyUs = 0;     // Half the best round trip (asymmetry bound)
+  double lastRttUs = 0;
+  double minRttUs = 0;
+
+  // One-way latency: device sample time -> host receive time
+  uint64_t latencySamples = 0;
+  double latencyLastUs = 0;
+  double latencyMinUs = 0;
+  double latencyMeanUs = 0;
+  double latencyMaxUs = 0;
+};
+
+class DeviceClock {
+public:
+  // window = number of recent exchanges the fit is computed from
+  explicit DeviceClock(size_t window = 64);
+
+  void reset();
+
+  // Extend a 32-bit micros() value to 64 bits
+  int64_t unwrap(uint32_t deviceUs);
+
+  // Add one SYNC exchange (host times from HostClock_NowNs())
+  void addExchange(int64_t hostSendNs, uint32_t deviceRxUs, uint32_t deviceTxUs,
+                   int64_t hostReceiveNs);
+
+  // True once at least one exchange has been added
+  bool synchronized() const { return !history.empty(); }
+
+  // Host monotonic time (ns) of a device timestamp
+  int64_t toHostNs(uint32_t deviceUs);
+  int64_t unwrappedToHostNs(int64_t deviceUs) const;
+
+  // Record the one-way latency of a sample received at hostReceiveNs;
+  // returns it in microseconds
+  double observeLatency(uint32_t deviceUs, int64_t hostReceiveNs);
+
+  const ClockSyncMetrics& metrics() const { return stats; }
+
+private:
+  struct Exchange {
+    int64_t deviceMidUs;   // Unwrapped midpoint of t2, t3
+    int64_t hostMidNs;     // Midpoint of t1, t4
+    double rttUs;
+  };
+
+  void refit();
+
+  size_t windowSize;
+  std::deque<Exchange> history;
+
+  // Unwrapping state
+  bool haveLast = false;
+  uint32_t lastRaw = 0;
+  int64_t lastUnwrapped = 0;
+
+  // Model: host = baseHostNs + (device - baseDeviceUs) * 1000 * (1 + drift)
+  int64_t baseDeviceUs = 0;
+  int64_t baseHostNs = 0;
+  double drift = 0;
+
+  ClockSyncMetrics stats;
+};
+
+#endif // CLOCK_SYNC_H
@@ -0,0 +1,391 @@
+/*
+ * ============================================================================
+ * ERROR MAP - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "error_map.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+// Largest grid accepted (nodes); 256^3 is 200 MB of cells
+static const size_t MAX_NODES = 256 * 256 * 256;
+
+// Conjugate gradient stops at this relative residual or iteration count
+static const double FIT_TOLERANCE = 1e-10;
+static const int FIT_MAX_ITERATIONS = 5000;
+
+// Keeps the fit solvable for nodes that neither samples nor smoothing reach
+static const double FIT_DIAGONAL = 1e-9;
+
+bool ErrorMap::create(const double origin[3], const double spacing[3], const int size[3]) {
+  size_t total = 1;
+  for (int a = 0; a < 3; a++) {
+    if (size[a] < 2 || !(spacing[a] > 0)) {
+      lastError = "Grid needs at least 2 nodes and a positive spacing per axis";
+      return false;
+    }
+    total *= static_cast<size_t>(size[a]);
+    if (total > MAX_NODES) {
+      lastError = "Grid too large";
+      return false;
+    }
+  }
+
+  for (int a = 0; a < 3; a++) {
+    gridOrigin[a] = origin[a];
+    gridSpacing[a] = spacing[a];
+    inverseSpacing[a] = 1.0 / spacing[a];
+    gridSize[a] = size[a];
+  }
+  nodes.assign(total * 3, 0.0f);
+  buildCells();
+  outsideCount = 0;
+  return true;
+}
+
+void ErrorMap::buildCells() {
+  const int nx = gridSize[0], ny = gridSize[1], nz = gridSize[2];
+  cells.resize(static_cast<size_t>(nx - 1) * (ny - 1) * (nz - 1) * 24);
+
+  float* cell = cells.data();
+  for (int k = 0; k < nz - 1; k++) {
+    for (int j = 0; j < ny - 1; j++) {
+      for (int i = 0; i < nx - 1; i++) {
+        for (int corner = 0; corner < 8; corner++) {
+          size_t n = (static_cast<size_t>(k + ((corner >> 2) & 1)) * ny +
+                      (j + ((corner >> 1) & 1))) * nx + (i + (corner & 1));
+          *cell++ = nodes[n * 3];
+          *cell++ = nodes[n * 3 + 1];
+          *cell++ = nodes[n * 3 + 2];
+        }
+      }
+    }
+  }
+}
+
+// ============================================================================
+// FILE
+// ============================================================================
+bool ErrorMap::load(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) {
+    lastError = "Cannot open " + path;
+    return false;
+  }
+
+  double origin[3], spacing[3];
+  int size[3];
+  bool haveOrigin = false, haveSpacing = false, haveSize = false;
+  size_t filled = 0;
+  size_t expected = 0;
+
+  std::string text;
+  int lineNumber = 0;
+  while (std::getline(in, text)) {
+    lineNumber++;
+    size_t hash = text.find('#');
+    if (hash != std::string::npos) text.erase(hash);
+
+    std::istringstream fields(text);
+    std::string first;
+    if (!(fields >> first)) continue;  // Blank line
+
+    auto fail = [&](const std::string& what) {
+      lastError = path + ":" + std::to_string(lineNumber) + ": " + what;
+      cells.clear();
+      return false;
+    };
+
+    if (first == "origin" || first == "spacing" || first == "size") {
+      if (haveSize && first == "size") return fail("size given twice");
+      double v[3];
+      if (!(fields >> v[0] >> v[1] >> v[2])) return fail("expected three numbers");
+      if (first == "origin") {
+        std::copy(v, v + 3, origin);
+        haveOrigin = true;
+      } else if (first == "spacing") {
+        std::copy(v, v + 3, spacing);
+        haveSpacing = true;
+      } else {
+        for (int a = 0; a < 3; a++) size[a] = static_cast<int>(v[a]);
+        haveSize = true;
+      }
+      continue;
+    }
+
+    // Node correction
+    if (!haveOrigin || !haveSpacing || !haveSize) {
+      return fail("origin, spacing and size must come before the corrections");
+    }
+    if (expected == 0) {
+      if (!create(origin, spacing, size)) return fail(lastError);
+      expected = nodes.size() / 3;
+    }
+    if (filled == expected) return fail("more corrections than nodes");
+
+    double c[3];
+    char* end;
+    c[0] = strtod(first.c_str(), &end);
+    if (*end != '\0' || !(fields >> c[1] >> c[2])) return fail("expected three numbers");
+    for (int a = 0; a < 3; a++) nodes[filled * 3 + a] = static_cast<float>(c[a]);
+    filled++;
+  }
+
+  if (expected == 0) {
+    lastError = path + ": no corrections";
+    return false;
+  }
+  if (filled != expected) {
+    lastError = path + ": expected " + std::to_string(expected) + " corrections, found " +
+                std::to_string(filled);
+    cells.clear();
+    return false;
+  }
+
+  buildCells();
+  return true;
+}
+
+bool ErrorMap::save(const std::string& path) const {
+  FILE* file = fopen(path.c_str(), "w");
+  if (file == nullptr) return false;
+
+  fprintf(file, "# CCM error map: corrections (mm) per node, X fastest\n");
+  fprintf(file, "origin %.6f %.6f %.6f\n", gridOrigin[0], gridOrigin[1], gridOrigin[2]);
+  fprintf(file, "spacing %.6f %.6f %.6f\n", gridSpacing[0], gridSpacing[1], gridSpacing[2]);
+  fprintf(file, "size %d %d %d\n", gridSize[0], gridSize[1], gridSize[2]);
+  for (size_t n = 0; n < nodes.size(); n += 3) {
+    fprintf(file, "%.6f %.6f %.6f\n", nodes[n], nodes[n + 1], nodes[n + 2]);
+  }
+
+  bool ok = !ferror(file);
+  if (fclose(file) != 0) ok = false;
+  return ok;
+}
+
+// ============================================================================
+// APPLY
+// ============================================================================
+size_t ErrorMap::locate(double x, double y, double z, double frac[3]) const {
+  const double p[3] = {x, y, z};
+  int cell[3];
+  bool outside = false;
+  for (int a = 0; a < 3; a++) {
+    double u = (p[a] - gridOrigin[a]) * inverseSpacing[a];
+    double last = gridSize[a] - 1;
+    if (!(u >= 0)) {  // Also catches NaN
+      u = 0;
+      outside = true;
+    } else if (u > last) {
+      u = last;
+      outside = true;
+    }
+    int i = std::min(static_cast<int>(u), gridSize[a] - 2);
+    cell[a] = i;
+    frac[a] = u - i;
+  }
+  if (outside) outsideCount++;
+  return (static_cast<size_t>(cell[2]) * (gridSize[1] - 1) + cell[1]) * (gridSize[0] - 1) + cell[0];
+}
+
+void ErrorMap::correction(double x, double y, double z, double out[3]) const {
+  if (cells.empty()) {
+    out[0] = out[1] = out[2] = 0;
+    return;
+  }
+
+  double f[3];
+  const float* c = &cells[locate(x, y, z, f) * 24];
+  for (int a = 0; a < 3; a++) {
+    // Along X (corners 0-1, 2-3, 4-5, 6-7), then Y, then Z
+    double c00 = c[a] + (c[3 + a] - c[a]) * f[0];
+    double c10 = c[6 + a] + (c[9 + a] - c[6 + a]) * f[0];
+    double c01 = c[12 + a] + (c[15 + a] - c[12 + a]) * f[0];
+    double c11 = c[18 + a] + (c[21 + a] - c[18 + a]) * f[0];
+    double c0 = c00 + (c10 - c00) * f[1];
+    double c1 = c01 + (c11 - c01) * f[1];
+    out[a] = c0 + (c1 - c0) * f[2];
+  }
+}
+
+void ErrorMap::apply(double* x, double* y, double* z, size_t count) const {
+  if (cells.empty()) return;
+  for (size_t i = 0; i < count; i++) {
+    double c[3];
+    correction(x[i], y[i], z[i], c);
+    x[i] += c[0];
+    y[i] += c[1];
+    z[i] += c[2];
+  }
+}
+
+void ErrorMap::node(int i, int j, int k, double out[3]) const {
+  size_t n = (static_cast<size_t>(k) * gridSize[1] + j) * gridSize[0] + i;
+  for (int a = 0; a < 3; a++) out[a] = nodes[n * 3 + a];
+}
+
+// ============================================================================
+// FIT
+// ============================================================================
+// The normal equations (W^T W + smoothing * L + eps * I) c = W^T r are
+// solved once per axis by conjugate gradient without forming the matrix:
+// W holds each sample's eight trilinear weights, L is the graph Laplacian
+// of the grid (node minus its neighbours).
+namespace {
+
+struct SampleWeights {
+  size_t node[8];
+  double weight[8];
+};
+
+class FitSystem {
+public:
+  FitSystem(const int size[3], const std::vector<SampleWeights>& rows, double smoothing)
+      : nx(size[0]), ny(size[1]), nz(size[2]), rows(rows), smoothing(smoothing) {}
+
+  size_t unknowns() const { return static_cast<size_t>(nx) * ny * nz; }
+
+  void multiply(const std::vector<double>& in, std::vector<double>& out) const {
+    for (size_t n = 0; n < in.size(); n++) out[n] = FIT_DIAGONAL * in[n];
+
+    for (const SampleWeights& row : rows) {
+      double dot = 0;
+      for (int c = 0; c < 8; c++) dot += row.weight[c] * in[row.node[c]];
+      for (int c = 0; c < 8; c++) out[row.node[c]] += row.weight[c] * dot;
+    }
+
+    if (smoothing <= 0) return;
+    const size_t strideY = nx, strideZ = static_cast<size_t>(nx) * ny;
+    for (int k = 0; k < nz; k++) {
+      for (int j = 0; j < ny; j++) {
+        for (int i = 0; i < nx; i++) {
+          size_t n = k * strideZ + j * strideY + i;
+          if (i + 1 < nx) addEdge(in, out, n, n + 1);
+          if (j + 1 < ny) addEdge(in, out, n, n + strideY);
+          if (k + 1 < nz) addEdge(in, out, n, n + strideZ);
+        }
+      }
+    }
+  }
+
+private:
+  void addEdge(const std::vector<double>& in, std::vector<double>& out, size_t a, size_t b) const {
+    double d = smoothing * (in[a] - in[b]);
+    out[a] += d;
+    out[b] -= d;
+  }
+
+  int nx, ny, nz;
+  const std::vector<SampleWeights>& rows;
+  double smoothing;
+};
+
+int SolveConjugateGradient(const FitSystem& system, const std::vector<double>& rhs,
+                           std::vector<double>& x) {
+  size_t n = rhs.size();
+  std::vector<double> r(rhs), p(rhs), ap(n);
+  std::fill(x.begin(), x.end(), 0.0);
+
+  double rr = 0, bb = 0;
+  for (size_t i = 0; i < n; i++) rr += r[i] * r[i];
+  bb = rr;
+  if (bb == 0) return 0;
+
+  int iteration = 0;
+  while (iteration < FIT_MAX_ITERATIONS && rr > FIT_TOLERANCE * FIT_TOLERANCE * bb) {
+    system.multiply(p, ap);
+    double pap = 0;
+    for (size_t i = 0; i < n; i++) pap += p[i] * ap[i];
+    if (!(pap > 0)) break;
+
+    double alpha = rr / pap;
+    double next = 0;
+    for (size_t i = 0; i < n; i++) {
+      x[i] += alpha * p[i];
+      r[i] -= alpha * ap[i];
+      next += r[i] * r[i];
+    }
+    double beta = next / rr;
+    for (size_t i = 0; i < n; i++) p[i] = r[i] + beta * p[i];
+    rr = next;
+    iteration++;
+  }
+  return iteration;
+}
+
+}  // namespace
+
+bool ErrorMap::fit(const std::vector<ErrorSample>& samples, double smoothing,
+                   ErrorMapFitStats& stats) {
+  if (cells.empty()) {
+    lastError = "Grid not created";
+    return false;
+  }
+  if (samples.empty()) {
+    lastError = "No samples";
+    return false;
+  }
+
+  // Trilinear weights of every sample on its cell's corners
+  const int nx = gridSize[0], ny = gridSize[1];
+  std::vector<SampleWeights> rows(samples.size());
+  uint64_t outsideBefore = outsideCount;
+  for (size_t s = 0; s < samples.size(); s++) {
+    const double* m = samples[s].measured;
+    double f[3];
+    size_t cell = locate(m[0], m[1], m[2], f);
+    size_t i = cell % (nx - 1);
+    size_t j = (cell / (nx - 1)) % (ny - 1);
+    size_t k = cell / (static_cast<size_t>(nx - 1) * (ny - 1));
+    for (int corner = 0; corner < 8; corner++) {
+      int bx = corner & 1, by = (corner >> 1) & 1, bz = (corner >> 2) & 1;
+      rows[s].node[corner] = ((k + bz) * ny + (j + by)) * nx + (i + bx);
+      rows[s].weight[corner] = (bx ? f[0] : 1 - f[0]) * (by ? f[1] : 1 - f[1]) *
+                               (bz ? f[2] : 1 - f[2]);
+    }
+  }
+  outsideCount = outsideBefore;
+
+  FitSystem system(gridSize, rows, smoothing);
+  size_t n = system.unknowns();
+  std::vector<double> rhs(n), solution(n);
+  stats = ErrorMapFitStats();
+  stats.samples = samples.size();
+
+  for (int a = 0; a < 3; a++) {
+    std::fill(rhs.begin(), rhs.end(), 0.0);
+    for (size_t s = 0; s < samples.size(); s++) {
+      double target = samples[s].reference[a] - samples[s].measured[a];
+      for (int c = 0; c < 8; c++) rhs[rows[s].node[c]] += rows[s].weight[c] * target;
+    }
+    stats.iterations = std::max(stats.iterations, SolveConjugateGradient(system, rhs, solution));
+    for (size_t node = 0; node < n; node++) nodes[node * 3 + a] = static_cast<float>(solution[node]);
+  }
+  buildCells();
+
+  // Residuals before and after, over the samples themselves
+  double sumBefore = 0, sumAfter = 0;
+  for (const ErrorSample& s : samples) {
+    double corrected[3];
+    apply(s.measured, corrected);
+    double before = 0, after = 0;
+    for (int a = 0; a < 3; a++) {
+      before += (s.reference[a] - s.measured[a]) * (s.reference[a] - s.measured[a]);
+      after += (s.reference[a] - corrected[a]) * (s.reference[a] - corrected[a]);
+    }
+    sumBefore += before;
+    sumAfter += after;
+    stats.maxBefore = std::max(stats.maxBefore, sqrt(before));
+    stats.maxAfter = std::max(stats.maxAfter, sqrt(after));
+  }
+  stats.rmsBefore = sqrt(sumBefore / samples.size());
+  stats.rmsAfter = sqrt(sumAfter / samples.size());
+  outsideCount = outsideBefore;
+  return true;
+}
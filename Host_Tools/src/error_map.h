@@ -0,0 +1,125 @@
+/*
+ * ============================================================================
+ * ERROR MAP - HEADER FILE
+ * ============================================================================
+ *
+ * Volumetric error compensation: a regular 3D grid of corrections in the
+ * arm's base frame, interpolated trilinearly.
+ *
+ *   p_corrected = p + c(p)
+ *
+ * c is what the kinematic model leaves out: link bending under the arm's
+ * own weight, joint runout, encoder eccentricity. A map is built once from
+ * artefact measurements (the arm's reading of a feature paired with the
+ * feature's certified position, see ccm_errormap) and applied to every
+ * sample afterwards, live or when a session is reprocessed.
+ *
+ * APPLYING:
+ * Corrections are stored per CELL, not per node: the eight corners of a
+ * cell sit next to each other (8 x 3 floats, 96 bytes), so a lookup is one
+ * index computation and two cache lines. Spacing is stored inverted so
+ * locating a point takes no division. A point outside the grid gets the
+ * correction of the nearest point on its boundary and is counted.
+ *
+ * FILE FORMAT (text, '#' starts a comment):
+ *
+ *   origin  x0 y0 z0       Corner node with the lowest coordinates (mm)
+ *   spacing dx dy dz       Node spacing (mm)
+ *   size    nx ny nz       Nodes per axis (2 or more)
+ *   cx cy cz               One correction per node (mm), nx * ny * nz lines,
+ *   ...                    X varying fastest, then Y, then Z
+ *
+ * ============================================================================
+ */
+
+#ifndef ERROR_MAP_H
+#define ERROR_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One artefact measurement: where the arm says a feature is, and where it is
+struct ErrorSample {
+  double measured[3];
+  double reference[3];
+};
+
+struct ErrorMapFitStats {
+  size_t samples = 0;
+  int iterations = 0;
+  double rmsBefore = 0;   // |reference - measured|, RMS (mm)
+  double maxBefore = 0;
+  double rmsAfter = 0;    // |reference - corrected|, RMS (mm)
+  double maxAfter = 0;
+};
+
+class ErrorMap {
+public:
+  // Empty map (no correction)
+  ErrorMap() = default;
+
+  // Zero corrections over nx * ny * nz nodes. Returns false for a size
+  // below 2 nodes or a spacing that is not positive.
+  bool create(const double origin[3], const double spacing[3], const int size[3]);
+
+  // Read / write the text format above. Returns false and sets error().
+  bool load(const std::string& path);
+  bool save(const std::string& path) const;
+
+  // Least-squares fit of the node corrections to artefact measurements.
+  // Each sample pulls on the eight nodes around its measured position by
+  // their trilinear weights; 'smoothing' penalizes differences between
+  // neighbouring nodes (relative to a sample's pull), which fills nodes
+  // with no samples near them and keeps noise from being fitted. The grid
+  // must have been created first.
+  bool fit(const std::vector<ErrorSample>& samples, double smoothing, ErrorMapFitStats& stats);
+
+  bool empty() const { return cells.empty(); }
+
+  // out = in + c(in) (in and out may be the same array)
+  void apply(const double in[3], double out[3]) const {
+    double c[3];
+    correction(in[0], in[1], in[2], c);
+    out[0] = in[0] + c[0];
+    out[1] = in[1] + c[1];
+    out[2] = in[2] + c[2];
+  }
+
+  // The same for coordinate arrays (the PointBatch layout)
+  void apply(double* x, double* y, double* z, size_t count) const;
+
+  // Interpolated correction at a point
+  void correction(double x, double y, double z, double out[3]) const;
+
+  // Correction at a node
+  void node(int i, int j, int k, double out[3]) const;
+
+  // Points corrected so far that were outside the grid
+  uint64_t outside() const { return outsideCount; }
+
+  const double* origin() const { return gridOrigin; }
+  const double* spacing() const { return gridSpacing; }
+  const int* size() const { return gridSize; }
+
+  const std::string& error() const { return lastError; }
+
+private:
+  // Cell holding a point, and the point's position inside it (0..1)
+  size_t locate(double x, double y, double z, double frac[3]) const;
+  void buildCells();
+
+  double gridOrigin[3] = {0, 0, 0};
+  double gridSpacing[3] = {1, 1, 1};
+  double inverseSpacing[3] = {1, 1, 1};
+  int gridSize[3] = {0, 0, 0};
+
+  std::vector<float> nodes;  // Per node: cx, cy, cz (the file layout)
+  std::vector<float> cells;  // Per cell: 8 corners (i, j, k bits) x cx, cy, cz
+
+  mutable uint64_t outsideCount = 0;
+  std::string lastError;
+};
+
+#endif  // ERROR_MAP_H
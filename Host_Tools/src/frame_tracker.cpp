@@ -0,0 +1,210 @@
+/*
+ * ============================================================================
+ * FRAME TRACKER - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "frame_tracker.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+FrameTracker::FrameTracker(int64_t retry, int attempts)
+    : retryNs(retry), maxAttempts(attempts < 1 ? 1 : attempts) {}
+
+void FrameTracker::reset() {
+  nextDeliver = 0;
+  nextExpected = 0;
+  endKnown = false;
+  endSeq = 0;
+  held.clear();
+  missing.clear();
+  lostFrames.clear();
+  counters = FrameTrackerStats();
+}
+
+// ============================================================================
+// LINE PARSING
+// ============================================================================
+uint8_t FrameTracker::crc8(const char* data, size_t length) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= static_cast<uint8_t>(data[i]);
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+    }
+  }
+  return crc;
+}
+
+bool FrameTracker::parseFrame(const std::string& line, SequencedFrame& frame) {
+  // SPOS,seq,fields...*CC
+  if (line.compare(0, 5, "SPOS,") != 0) return false;
+  size_t star = line.rfind('*');
+  if (star == std::string::npos || star + 3 != line.size()) return false;
+
+  char* end;
+  unsigned long expected = strtoul(line.c_str() + star + 1, &end, 16);
+  if (end != line.c_str() + line.size()) return false;
+  if (crc8(line.data(), star) != expected) return false;
+
+  const char* seqText = line.c_str() + 5;
+  unsigned long seq = strtoul(seqText, &end, 10);
+  if (end == seqText || *end != ',') return false;
+
+  frame.seq = static_cast<uint32_t>(seq);
+  size_t fieldsStart = static_cast<size_t>(end + 1 - line.c_str());
+  frame.fields.assign(line, fieldsStart, star - fieldsStart);
+  return true;
+}
+
+// ============================================================================
+// RECEIVING
+// ============================================================================
+void FrameTracker::markMissing(uint32_t from, uint32_t to) {
+  for (uint64_t seq = from; seq <= to; seq++) {
+    missing[static_cast<uint32_t>(seq)] = MissingFrame();  // Never requested: due right away
+    counters.missed++;
+  }
+}
+
+void FrameTracker::giveUp(uint32_t seq) {
+  missing.erase(seq);
+  lostFrames.insert(seq);
+  counters.lost++;
+}
+
+bool FrameTracker::handleLine(const std::string& line) {
+  if (line.compare(0, 5, "SPOS,") == 0) {
+    SequencedFrame frame;
+    if (!parseFrame(line, frame)) {
+      counters.corrupted++;
+      return true;
+    }
+    counters.received++;
+
+    uint32_t seq = frame.seq;
+    if (seq < nextDeliver || held.count(seq) != 0) {
+      counters.duplicates++;
+      return true;
+    }
+
+    if (seq >= nextExpected) {
+      if (seq > nextExpected) markMissing(nextExpected, seq - 1);
+      nextExpected = seq + 1;
+    } else if (missing.erase(seq) != 0) {
+      counters.recovered++;
+    } else if (lostFrames.erase(seq) != 0) {
+      // Given up on, but it made it before being passed over
+      counters.lost--;
+      counters.recovered++;
+    }
+    held.emplace(seq, std::move(frame.fields));
+    return true;
+  }
+
+  if (line.compare(0, 6, "SLOST,") == 0) {
+    // SLOST,from,to: the device no longer has these frames
+    char* end;
+    uint32_t from = static_cast<uint32_t>(strtoul(line.c_str() + 6, &end, 10));
+    if (*end != ',') return true;
+    uint32_t to = static_cast<uint32_t>(strtoul(end + 1, nullptr, 10));
+
+    auto it = missing.lower_bound(from);
+    while (it != missing.end() && it->first <= to) {
+      uint32_t seq = it->first;
+      ++it;
+      giveUp(seq);
+    }
+    return true;
+  }
+
+  return false;
+}
+
+void FrameTracker::setEnd(uint32_t nextSeq) {
+  endKnown = true;
+  endSeq = nextSeq;
+  if (nextSeq > nextExpected) {
+    markMissing(nextExpected, nextSeq - 1);
+    nextExpected = nextSeq;
+  }
+}
+
+// ============================================================================
+// RETRANSMISSION
+// ============================================================================
+std::vector<std::string> FrameTracker::resendRequests(int64_t nowNs, size_t maxRanges) {
+  std::vector<std::string> requests;
+
+  auto due = [&](const MissingFrame& m) {
+    return m.attempts == 0 || nowNs - m.requestedNs >= retryNs;
+  };
+
+  auto it = missing.begin();
+  while (it != missing.end() && requests.size() < maxRanges) {
+    if (!due(it->second)) {
+      ++it;
+      continue;
+    }
+    if (it->second.attempts >= maxAttempts) {
+      uint32_t seq = it->first;
+      ++it;
+      giveUp(seq);
+      continue;
+    }
+
+    // One range over this frame and the following due ones with
+    // consecutive seqs
+    uint32_t from = it->first;
+    uint32_t to = from;
+    do {
+      to = it->first;
+      it->second.requestedNs = nowNs;
+      it->second.attempts++;
+      ++it;
+    } while (it != missing.end() && it->first == to + 1 && due(it->second) &&
+             it->second.attempts < maxAttempts);
+
+    requests.push_back("RESEND " + std::to_string(from) + "," + std::to_string(to));
+    counters.resendRequests++;
+  }
+  return requests;
+}
+
+int64_t FrameTracker::nextRetryNs() const {
+  int64_t next = std::numeric_limits<int64_t>::max();
+  for (const auto& entry : missing) {
+    const MissingFrame& m = entry.second;
+    int64_t due = m.attempts == 0 ? 0 : m.requestedNs + retryNs;
+    if (due < next) next = due;
+  }
+  return next;
+}
+
+// ============================================================================
+// DELIVERY
+// ============================================================================
+bool FrameTracker::popFrame(SequencedFrame& frame) {
+  while (true) {
+    auto it = held.find(nextDeliver);
+    if (it != held.end()) {
+      frame.seq = nextDeliver;
+      frame.fields = std::move(it->second);
+      held.erase(it);
+      nextDeliver++;
+      counters.delivered++;
+      return true;
+    }
+    if (lostFrames.erase(nextDeliver) != 0) {
+      nextDeliver++;
+      continue;
+    }
+    return false;
+  }
+}
+
+bool FrameTracker::complete() const {
+  return endKnown && nextDeliver >= endSeq;
+}
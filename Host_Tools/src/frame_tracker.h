@@ -0,0 +1,123 @@
+/*
+ * ============================================================================
+ * FRAME TRACKER - HEADER FILE
+ * ============================================================================
+ *
+ * Receiving side of the firmware's sequenced stream (SETSEQ ON, see
+ * frame_history.h): checks every SPOS line's CRC-8, drops duplicates,
+ * notices gaps in the sequence numbers and asks for the missing frames
+ * with RESEND until they arrive, the device reports them lost (SLOST), or
+ * the retries run out. Frames come out strictly in sequence order.
+ *
+ * A corrupted line is simply discarded: its seq cannot be trusted, and the
+ * gap it leaves is found when the next good frame arrives. Frames missing
+ * at the very end of a stream are found with setEnd() (from the device's
+ * GETSEQ reply after STOP).
+ *
+ * Sequence numbers are 32 bits, as on the device; a stream is assumed to
+ * stay well below 2^32 frames.
+ *
+ * ============================================================================
+ */
+
+#ifndef FRAME_TRACKER_H
+#define FRAME_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+struct SequencedFrame {
+  uint32_t seq = 0;
+  std::string fields;  // timestamp,x,y,z,theta1,...[,omega1,...] (as sent)
+};
+
+struct FrameTrackerStats {
+  uint64_t received = 0;        // Good SPOS lines, duplicates included
+  uint64_t duplicates = 0;      // Frames received more than once
+  uint64_t corrupted = 0;       // SPOS lines with a bad checksum or format
+  uint64_t missed = 0;          // Frames found missing (gaps)
+  uint64_t recovered = 0;       // Missing frames that arrived after a RESEND
+  uint64_t lost = 0;            // Missing frames given up on
+  uint64_t resendRequests = 0;  // RESEND commands issued
+  uint64_t delivered = 0;       // Frames returned by popFrame()
+};
+
+class FrameTracker {
+public:
+  // retryNs: how long to wait for a resent frame before asking again;
+  // maxAttempts: RESENDs per frame before it is counted as lost
+  explicit FrameTracker(int64_t retryNs = 300000000, int maxAttempts = 3);
+
+  // Forget everything; the next stream starts at seq 0
+  void reset();
+
+  // Change the wait before asking again (takes effect from the next request)
+  void setRetry(int64_t retry) { retryNs = retry; }
+
+  // Longest a missing frame is waited for, from its first RESEND
+  int64_t retryBudgetNs() const { return retryNs * maxAttempts; }
+
+  // Account one received line. Returns false if it is not part of the
+  // sequenced stream (not SPOS / SLOST), so callers can handle it.
+  bool handleLine(const std::string& line);
+
+  // Next frame in sequence order, once every earlier frame has been
+  // delivered or given up on. Returns false if none is ready.
+  bool popFrame(SequencedFrame& frame);
+
+  // RESEND commands to send now: new gaps, and gaps whose last request
+  // timed out. At most maxRanges (the device queues SEQ_RESEND_QUEUE).
+  std::vector<std::string> resendRequests(int64_t nowNs, size_t maxRanges = 4);
+
+  // When resendRequests() next has something to do (INT64_MAX if nothing
+  // is missing)
+  int64_t nextRetryNs() const;
+
+  // The stream ended before frame nextSeq (SEQ,next,... reply)
+  void setEnd(uint32_t nextSeq);
+
+  // End known, and every frame before it delivered or lost
+  bool complete() const;
+
+  // Frames still being waited for
+  size_t missingCount() const { return missing.size(); }
+
+  // Frames received but not delivered yet (waiting behind a missing one)
+  size_t heldCount() const { return held.size(); }
+
+  const FrameTrackerStats& stats() const { return counters; }
+
+  // Check an SPOS line's checksum and split it. Returns false if corrupt.
+  static bool parseFrame(const std::string& line, SequencedFrame& frame);
+
+  // CRC-8, polynomial 0x07, as used by the firmware
+  static uint8_t crc8(const char* data, size_t length);
+
+private:
+  struct MissingFrame {
+    int64_t requestedNs = 0;
+    int attempts = 0;
+  };
+
+  void markMissing(uint32_t from, uint32_t to);
+  void giveUp(uint32_t seq);
+
+  int64_t retryNs;
+  int maxAttempts;
+
+  uint32_t nextDeliver = 0;                 // Next seq popFrame() returns
+  uint32_t nextExpected = 0;                // One past the highest seq seen
+  bool endKnown = false;
+  uint32_t endSeq = 0;
+
+  std::map<uint32_t, std::string> held;     // Received, not delivered yet
+  std::map<uint32_t, MissingFrame> missing; // Gaps being recovered
+  std::set<uint32_t> lostFrames;            // Given up, not passed yet
+  FrameTrackerStats counters;
+};
+
+#endif  // FRAME_TRACKER_H
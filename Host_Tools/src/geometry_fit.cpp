@@ -0,0 +1,313 @@
+/*
+ * ============================================================================
+ * GEOMETRY FIT - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "geometry_fit.h"
+
+#include <cmath>
+
+// A plane fit fails when the points spread less than this (relative to
+// their largest spread) in a second direction: they lie on a line
+static const double GEOMETRY_FLAT_RATIO = 1e-12;
+
+// Weight of point i (1 without weights)
+static inline double Geometry_Weight(const double* weights, size_t i) {
+  return weights != nullptr ? weights[i] : 1.0;
+}
+
+// Centroid and the (unnormalized) covariance sums about it
+struct Spread {
+  double c[3];
+  double xx, xy, xz, yy, yz, zz;
+  double w;  // Sum of weights
+};
+
+static Spread Geometry_Spread(const double* x, const double* y, const double* z, size_t n,
+                              const double* weights) {
+  Spread s = {};
+  for (size_t i = 0; i < n; i++) {
+    double w = Geometry_Weight(weights, i);
+    s.c[0] += w * x[i];
+    s.c[1] += w * y[i];
+    s.c[2] += w * z[i];
+    s.w += w;
+  }
+  for (int k = 0; k < 3; k++) s.c[k] /= s.w;
+
+  for (size_t i = 0; i < n; i++) {
+    double w = Geometry_Weight(weights, i);
+    double dx = x[i] - s.c[0], dy = y[i] - s.c[1], dz = z[i] - s.c[2];
+    s.xx += w * dx * dx;
+    s.xy += w * dx * dy;
+    s.xz += w * dx * dz;
+    s.yy += w * dy * dy;
+    s.yz += w * dy * dz;
+    s.zz += w * dz * dz;
+  }
+  return s;
+}
+
+static bool Geometry_Normalize(double v[3]) {
+  double length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  if (!(length > 0)) return false;
+  for (int k = 0; k < 3; k++) v[k] /= length;
+  return true;
+}
+
+// Eigenvalues (ascending) and unit eigenvectors (vectors[k] belongs to
+// values[k]) of the covariance sums, by cyclic Jacobi rotations. Each sweep
+// zeroes the off-diagonal elements in turn; a 3x3 converges to full double
+// precision within a handful of sweeps.
+static void Geometry_Eigen(const Spread& s, double values[3], double vectors[3][3]) {
+  double a[3][3] = {{s.xx, s.xy, s.xz}, {s.xy, s.yy, s.yz}, {s.xz, s.yz, s.zz}};
+  double v[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};  // Columns are the eigenvectors
+
+  for (int sweep = 0; sweep < 50; sweep++) {
+    double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+    double diagonal = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+    if (off <= 1e-30 * diagonal || off == 0) break;
+
+    for (int p = 0; p < 2; p++) {
+      for (int q = p + 1; q < 3; q++) {
+        if (a[p][q] == 0) continue;
+        double theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+        double t = (theta >= 0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1));
+        double c = 1 / std::sqrt(t * t + 1), sn = t * c;
+
+        for (int k = 0; k < 3; k++) {  // a = a * J
+          double akp = a[k][p], akq = a[k][q];
+          a[k][p] = c * akp - sn * akq;
+          a[k][q] = sn * akp + c * akq;
+        }
+        for (int k = 0; k < 3; k++) {  // a = J^T * a
+          double apk = a[p][k], aqk = a[q][k];
+          a[p][k] = c * apk - sn * aqk;
+          a[q][k] = sn * apk + c * aqk;
+        }
+        for (int k = 0; k < 3; k++) {  // v = v * J
+          double vkp = v[k][p], vkq = v[k][q];
+          v[k][p] = c * vkp - sn * vkq;
+          v[k][q] = sn * vkp + c * vkq;
+        }
+      }
+    }
+  }
+
+  int order[3] = {0, 1, 2};
+  for (int i = 0; i < 2; i++) {
+    for (int j = i + 1; j < 3; j++) {
+      if (a[order[j]][order[j]] < a[order[i]][order[i]]) {
+        int t = order[i]; order[i] = order[j]; order[j] = t;
+      }
+    }
+  }
+  for (int k = 0; k < 3; k++) {
+    values[k] = a[order[k]][order[k]];
+    for (int r = 0; r < 3; r++) vectors[k][r] = v[r][order[k]];
+  }
+}
+
+// ============================================================================
+// CIRCLE (GeometryCalculator.fitCircle)
+// ============================================================================
+bool Geometry_FitCircle(const double* x, const double* y, const double* z, size_t count,
+                        CircleFit& out, const double* weights) {
+  if (count < 3) return false;
+
+  double n = 0;
+  double sumX = 0, sumY = 0, sumX2 = 0, sumY2 = 0, sumXY = 0;
+  double sumX3 = 0, sumY3 = 0, sumX2Y = 0, sumXY2 = 0, sumZ = 0;
+  for (size_t i = 0; i < count; i++) {
+    double w = Geometry_Weight(weights, i);
+    double px = x[i], py = y[i];
+    double x2 = px * px, y2 = py * py;
+    n += w;
+    sumX += w * px;
+    sumY += w * py;
+    sumX2 += w * x2;
+    sumY2 += w * y2;
+    sumXY += w * px * py;
+    sumX3 += w * x2 * px;
+    sumY3 += w * y2 * py;
+    sumX2Y += w * x2 * py;
+    sumXY2 += w * px * y2;
+    sumZ += w * z[i];
+  }
+
+  // Cramer's rule
+  double a = n * sumX2 - sumX * sumX;
+  double b = n * sumXY - sumX * sumY;
+  double c = n * sumY2 - sumY * sumY;
+  double d = 0.5 * (n * (sumX3 + sumXY2) - sumX * (sumX2 + sumY2));
+  double e = 0.5 * (n * (sumX2Y + sumY3) - sumY * (sumX2 + sumY2));
+
+  double denominator = a * c - b * b;
+  if (std::fabs(denominator) < 1e-10) return false;  // Collinear
+
+  double cx = (d * c - b * e) / denominator;
+  double cy = (a * e - b * d) / denominator;
+
+  double sumR2 = 0;
+  for (size_t i = 0; i < count; i++) {
+    double dx = x[i] - cx, dy = y[i] - cy;
+    sumR2 += Geometry_Weight(weights, i) * (dx * dx + dy * dy);
+  }
+  double radius = std::sqrt(sumR2 / n);
+
+  double sumResidual = 0;
+  for (size_t i = 0; i < count; i++) {
+    double dx = x[i] - cx, dy = y[i] - cy;
+    double error = std::sqrt(dx * dx + dy * dy) - radius;
+    sumResidual += Geometry_Weight(weights, i) * error * error;
+  }
+
+  out.center[0] = cx;
+  out.center[1] = cy;
+  out.center[2] = sumZ / n;
+  out.radius = radius;
+  out.residual = std::sqrt(sumResidual / n);
+  return true;
+}
+
+// ============================================================================
+// PLANE - normal along the least spread of the points
+// ============================================================================
+bool Geometry_FitPlane(const double* x, const double* y, const double* z, size_t count,
+                       PlaneFit& out, const double* weights) {
+  if (count < 3) return false;
+
+  Spread s = Geometry_Spread(x, y, z, count, weights);
+  double values[3], vectors[3][3];
+  Geometry_Eigen(s, values, vectors);
+
+  // Collinear (or coincident) points span no plane
+  if (!(values[1] > GEOMETRY_FLAT_RATIO * values[2])) return false;
+
+  double* normal = vectors[0];
+  if (!Geometry_Normalize(normal)) return false;
+  double d = -(normal[0] * s.c[0] + normal[1] * s.c[1] + normal[2] * s.c[2]);
+
+  double sumResidual = 0;
+  for (size_t i = 0; i < count; i++) {
+    double dist = normal[0] * (x[i] - s.c[0]) + normal[1] * (y[i] - s.c[1]) + normal[2] * (z[i] - s.c[2]);
+    sumResidual += Geometry_Weight(weights, i) * dist * dist;
+  }
+
+  for (int k = 0; k < 3; k++) {
+    out.normal[k] = normal[k];
+    out.point[k] = s.c[k];
+  }
+  out.d = d;
+  out.residual = std::sqrt(sumResidual / s.w);
+  return true;
+}
+
+// ============================================================================
+// LINE - direction along the greatest spread of the points
+// ============================================================================
+bool Geometry_FitLine(const double* x, const double* y, const double* z, size_t count,
+                      LineFit& out, const double* weights) {
+  if (count < 2) return false;
+
+  Spread s = Geometry_Spread(x, y, z, count, weights);
+  double values[3], vectors[3][3];
+  Geometry_Eigen(s, values, vectors);
+
+  if (!(values[2] > 0)) return false;  // All points in one place
+  double* direction = vectors[2];
+  if (!Geometry_Normalize(direction)) return false;
+
+  double sumResidual = 0;
+  for (size_t i = 0; i < count; i++) {
+    double dx = x[i] - s.c[0], dy = y[i] - s.c[1], dz = z[i] - s.c[2];
+    double dot = dx * direction[0] + dy * direction[1] + dz * direction[2];
+    double px = dx - dot * direction[0], py = dy - dot * direction[1], pz = dz - dot * direction[2];
+    sumResidual += Geometry_Weight(weights, i) * (px * px + py * py + pz * pz);
+  }
+
+  for (int k = 0; k < 3; k++) {
+    out.point[k] = s.c[k];
+    out.direction[k] = direction[k];
+  }
+  out.residual = std::sqrt(sumResidual / s.w);
+  return true;
+}
+
+// ============================================================================
+// PLANE, APP PARITY (GeometryCalculator.fitPlane)
+// ============================================================================
+bool Geometry_FitPlaneAppParity(const double* x, const double* y, const double* z, size_t count,
+                                PlaneFit& out, const double* weights) {
+  if (count < 3) return false;
+
+  Spread s = Geometry_Spread(x, y, z, count, weights);
+
+  // Normal from the most dominant pair of axes
+  double detXY = s.xx * s.yy - s.xy * s.xy;
+  double detXZ = s.xx * s.zz - s.xz * s.xz;
+  double detYZ = s.yy * s.zz - s.yz * s.yz;
+
+  double normal[3];
+  if (detXY > detXZ && detXY > detYZ) {
+    normal[0] = s.xy; normal[1] = s.xz; normal[2] = -(s.xx + s.yy);
+  } else if (detXZ > detYZ) {
+    normal[0] = s.xz; normal[1] = -(s.xx + s.zz); normal[2] = s.xy;
+  } else {
+    normal[0] = -(s.yy + s.zz); normal[1] = s.yz; normal[2] = s.xy;
+  }
+  if (!Geometry_Normalize(normal)) return false;
+
+  double d = -(normal[0] * s.c[0] + normal[1] * s.c[1] + normal[2] * s.c[2]);
+
+  double sumResidual = 0;
+  for (size_t i = 0; i < count; i++) {
+    double dist = normal[0] * x[i] + normal[1] * y[i] + normal[2] * z[i] + d;
+    sumResidual += Geometry_Weight(weights, i) * dist * dist;
+  }
+
+  for (int k = 0; k < 3; k++) {
+    out.normal[k] = normal[k];
+    out.point[k] = s.c[k];
+  }
+  out.d = d;
+  out.residual = std::sqrt(sumResidual / s.w);
+  return true;
+}
+
+// ============================================================================
+// LINE, APP PARITY (GeometryCalculator.fitLine)
+// ============================================================================
+bool Geometry_FitLineAppParity(const double* x, const double* y, const double* z, size_t count,
+                               LineFit& out, const double* weights) {
+  if (count < 2) return false;
+
+  Spread s = Geometry_Spread(x, y, z, count, weights);
+
+  // Principal direction, led by the largest diagonal element
+  double direction[3];
+  if (s.xx >= s.yy && s.xx >= s.zz) {
+    direction[0] = 1; direction[1] = s.xy / s.xx; direction[2] = s.xz / s.xx;
+  } else if (s.yy >= s.xx && s.yy >= s.zz) {
+    direction[0] = s.xy / s.yy; direction[1] = 1; direction[2] = s.yz / s.yy;
+  } else {
+    direction[0] = s.xz / s.zz; direction[1] = s.yz / s.zz; direction[2] = 1;
+  }
+  if (!Geometry_Normalize(direction)) return false;
+
+  double sumResidual = 0;
+  for (size_t i = 0; i < count; i++) {
+    double dx = x[i] - s.c[0], dy = y[i] - s.c[1], dz = z[i] - s.c[2];
+    double dot = dx * direction[0] + dy * direction[1] + dz * direction[2];
+    double px = dx - dot * direction[0], py = dy - dot * direction[1], pz = dz - dot * direction[2];
+    sumResidual += Geometry_Weight(weights, i) * (px * px + py * py + pz * pz);
+  }
+
+  for (int k = 0; k < 3; k++) {
+    out.point[k] = s.c[k];
+    out.direction[k] = direction[k];
+  }
+  out.residual = std::sqrt(sumResidual / s.w);
+  return true;
+}
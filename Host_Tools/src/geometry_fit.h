@@ -0,0 +1,69 @@
+/*
+ * ============================================================================
+ * GEOMETRY FIT - HEADER FILE
+ * ============================================================================
+ *
+ * Best-fit circle, plane and line through captured points:
+ *
+ * - Circle: algebraic (Kasa) least squares in X/Y, center Z = mean Z
+ *           (the app's GeometryCalculator.fitCircle)
+ * - Plane:  centroid + normal along the eigenvector of the covariance
+ *           matrix with the smallest eigenvalue (total least squares)
+ * - Line:   centroid + direction along the eigenvector with the largest
+ *           eigenvalue
+ *
+ * The app's plane and line (geometry-calculator.js) take shortcuts instead
+ * of the eigenvectors, and their normal is wrong even for exactly planar
+ * points. Geometry_FitPlaneAppParity / Geometry_FitLineAppParity keep those
+ * algorithms, so ccm_bench can time the app's work; nothing else should
+ * use them.
+ *
+ * Points are passed as coordinate arrays (the PointBatch layout). Where the
+ * app throws (too few points, collinear points) the fit returns false.
+ *
+ * Optional per-point weights (e.g. inverse variances from uncertainty.h)
+ * turn every sum into a weighted sum, so a point measured in a pose where
+ * the arm is less certain pulls less on the fit. Residuals are then
+ * weighted RMS.
+ *
+ * ============================================================================
+ */
+
+#ifndef GEOMETRY_FIT_H
+#define GEOMETRY_FIT_H
+
+#include <cstddef>
+
+struct CircleFit {
+  double center[3] = {0, 0, 0};
+  double radius = 0;
+  double residual = 0;  // RMS radial error
+};
+
+struct PlaneFit {
+  double normal[3] = {0, 0, 1};
+  double point[3] = {0, 0, 0};  // Centroid
+  double d = 0;                 // normal . p + d = 0
+  double residual = 0;          // RMS distance from the plane
+};
+
+struct LineFit {
+  double point[3] = {0, 0, 0};  // Centroid
+  double direction[3] = {1, 0, 0};
+  double residual = 0;          // RMS distance from the line
+};
+
+bool Geometry_FitCircle(const double* x, const double* y, const double* z, size_t count,
+                        CircleFit& out, const double* weights = nullptr);
+bool Geometry_FitPlane(const double* x, const double* y, const double* z, size_t count,
+                       PlaneFit& out, const double* weights = nullptr);
+bool Geometry_FitLine(const double* x, const double* y, const double* z, size_t count,
+                      LineFit& out, const double* weights = nullptr);
+
+// The app's plane and line algorithms, for benchmarks only (see above)
+bool Geometry_FitPlaneAppParity(const double* x, const double* y, const double* z, size_t count,
+                                PlaneFit& out, const double* weights = nullptr);
+bool Geometry_FitLineAppParity(const double* x, const double* y, const double* z, size_t count,
+                               LineFit& out, const double* weights = nullptr);
+
+#endif  // GEOMETRY_FIT_H
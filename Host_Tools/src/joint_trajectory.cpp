@@ -0,0 +1,73 @@
+/*
+ * ============================================================================
+ * JOINT TRAJECTORY - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "joint_trajectory.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Peak speed of a minimum-jerk move = 1.875 x mean speed
+static const double MIN_JERK_PEAK = 1.875;
+
+JointTrajectory::JointTrajectory(const TrajectoryConfig& config)
+    : cfg(config),
+      rng(config.seed),
+      from(config.axes, 0.0),
+      to(config.axes, 0.0),
+      tremorHz(config.axes),
+      tremorPhase(config.axes) {
+  std::uniform_real_distribution<double> hz(8.0, 12.0), phase(0.0, 2 * M_PI);
+  for (int i = 0; i < cfg.axes; i++) {
+    tremorHz[i] = hz(rng);
+    tremorPhase[i] = phase(rng);
+  }
+  // Start with a dwell at the power-up pose
+  dwellEnd = 0.5;
+}
+
+void JointTrajectory::planNext() {
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  from = to;
+  burst = unit(rng) < cfg.burstFraction;
+
+  // Normal moves go up to half the range from the current pose (from one
+  // probing spot to the next); bursts are short flicks
+  double largest = 0;
+  for (int i = 0; i < cfg.axes; i++) {
+    double range = i == 0 ? cfg.baseRangeDeg : cfg.jointRangeDeg;
+    double reach = (burst ? 0.15 : 0.5) * range;
+    double target = from[i] + (unit(rng) * 2 - 1) * reach;
+    to[i] = std::max(-range, std::min(range, target));
+    largest = std::max(largest, std::fabs(to[i] - from[i]));
+  }
+
+  double speed = cfg.maxSpeedDegS * (burst ? cfg.burstSpeedFactor : 1.0);
+  double duration = std::max(0.1, MIN_JERK_PEAK * largest / speed);
+  moveStart = dwellEnd;
+  moveEnd = moveStart + duration;
+  dwellEnd = moveEnd + (burst ? 0.0 : 0.2 + 1.3 * unit(rng));
+  moving = true;
+  moveCount++;
+  if (burst) burstCount++;
+}
+
+void JointTrajectory::anglesAt(double t, double* deg) {
+  while (t >= dwellEnd) planNext();
+
+  double s = 1.0;  // Dwelling at the target
+  moving = t < moveEnd;
+  if (t < moveStart) {
+    s = 0.0;
+  } else if (moving) {
+    double u = (t - moveStart) / (moveEnd - moveStart);
+    s = u * u * u * (10 - 15 * u + 6 * u * u);
+  }
+
+  for (int i = 0; i < cfg.axes; i++) {
+    double tremor = cfg.tremorDeg * sin(2 * M_PI * tremorHz[i] * t + tremorPhase[i]);
+    deg[i] = from[i] + (to[i] - from[i]) * s + tremor;
+  }
+}
@@ -0,0 +1,72 @@
+/*
+ * ============================================================================
+ * JOINT TRAJECTORY - HEADER FILE
+ * ============================================================================
+ *
+ * Plausible hand-guided joint motion for the arm simulator: the operator
+ * moves the arm from pose to pose and holds it still in between (probing).
+ *
+ * - Each move is a minimum-jerk profile (10t^3 - 15t^4 + 6t^5) from the
+ *   current pose to a random pose up to half the joint range away (within
+ *   the limits). Its duration keeps every joint under maxSpeedDegS at the
+ *   profile's peak.
+ * - After a move the arm dwells for 0.2 - 1.5 s.
+ * - A fraction of moves are bursts: short flicks at burstSpeedFactor times
+ *   the normal speed, with no dwell (stress for filters and for motion
+ *   streaming).
+ * - A small hand tremor (8 - 12 Hz) is added to every joint.
+ *
+ * Angles are in degrees from the power-up pose. The sequence is fully
+ * determined by the seed.
+ *
+ * ============================================================================
+ */
+
+#ifndef JOINT_TRAJECTORY_H
+#define JOINT_TRAJECTORY_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+struct TrajectoryConfig {
+  int axes = 4;
+  double maxSpeedDegS = 90.0;      // Peak joint speed of a normal move
+  double burstFraction = 0.1;      // Share of moves that are bursts
+  double burstSpeedFactor = 4.0;
+  double tremorDeg = 0.01;         // Tremor amplitude
+  double baseRangeDeg = 170.0;     // Joint 1 limits: +/- this
+  double jointRangeDeg = 100.0;    // Other joints: +/- this
+  uint32_t seed = 1;
+};
+
+class JointTrajectory {
+public:
+  explicit JointTrajectory(const TrajectoryConfig& config);
+
+  // Joint angles at t seconds; t must not go backwards between calls
+  void anglesAt(double t, double* deg);
+
+  // True while the current move is a burst
+  bool inBurst() const { return burst && moving; }
+
+  uint64_t moves() const { return moveCount; }
+  uint64_t bursts() const { return burstCount; }
+
+private:
+  void planNext();
+
+  TrajectoryConfig cfg;
+  std::mt19937 rng;
+
+  std::vector<double> from, to;
+  double moveStart = 0, moveEnd = 0, dwellEnd = 0;
+  bool burst = false;
+  bool moving = false;
+
+  std::vector<double> tremorHz, tremorPhase;
+  uint64_t moveCount = 0;
+  uint64_t burstCount = 0;
+};
+
+#endif // JOINT_TRAJECTORY_H
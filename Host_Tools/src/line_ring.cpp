@@ -0,0 +1,169 @@
+/*
+ * ============================================================================
+ * LINE RING - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "line_ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+static size_t RoundUpPowerOfTwo(size_t n) {
+  size_t p = 1;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+// ============================================================================
+// RING
+// ============================================================================
+LineRing::LineRing(size_t count) : slots(RoundUpPowerOfTwo(count < 2 ? 2 : count)) {
+  mask = slots.size() - 1;
+}
+
+bool LineRing::push(const char* text, size_t length, bool sample) {
+  bool whole = length < LINE_RING_SLOT_BYTES;
+  if (!whole) length = LINE_RING_SLOT_BYTES - 1;
+
+  Slot& slot = slots[next & mask];
+  memcpy(slot.data, text, length);
+  slot.data[length] = '\n';
+  slot.length = static_cast<uint16_t>(length + 1);
+  slot.sample = sample;
+  next++;
+  return whole;
+}
+
+// ============================================================================
+// READER
+// ============================================================================
+RingReader::RingReader(const LineRing& source) : ring(source), cursor(source.head()) {}
+
+void RingReader::beforeOverwrite() {
+  if (ring.next < ring.capacity()) return;
+  uint64_t overwritten = ring.next - ring.capacity();
+  if (cursor > overwritten) return;
+
+  // Finish the line this reader is halfway through from a private copy,
+  // ahead of any private lines (none of which has been offered yet: they
+  // wait for the line to be finished)
+  if (partial > 0) {
+    const LineRing::Slot& slot = ring.slots[cursor & ring.mask];
+    privateOut.insert(0, slot.data + partial, slot.length - partial);
+    partial = 0;
+    cursor++;
+    counters.sent++;
+  }
+
+  // Skip ahead to the middle of the ring, so this does not repeat every
+  // line, and thin the stream further: the current rate was too much
+  uint64_t resume = ring.next - ring.capacity() / 2;
+  if (resume > cursor) {
+    counters.dropped += resume - cursor;
+    cursor = resume;
+  }
+  if (keepEvery < LINE_RING_MAX_DECIMATION) keepEvery *= 2;
+  lagAtChange = 0;
+  changedAt = ring.next;
+}
+
+void RingReader::sendPrivate(const std::string& line) {
+  privateOut += line;
+  privateOut += '\n';
+}
+
+// Double the decimation while the lag keeps growing past half the ring.
+// Halve it once the reader has stayed nearly caught up while a quarter of
+// the ring was written - skipping lines lets it catch up in one burst, which
+// alone says nothing about whether it can take more.
+void RingReader::adjustDecimation() {
+  uint64_t lagNow = lag();
+  if (lagNow > ring.capacity() / 2 && lagNow > lagAtChange &&
+      keepEvery < LINE_RING_MAX_DECIMATION) {
+    keepEvery *= 2;
+    lagAtChange = lagNow;
+    changedAt = ring.head();
+  } else if (lagNow >= ring.capacity() / 8) {
+    changedAt = std::max(changedAt, ring.head());
+  } else if (keepEvery > 1 && ring.head() - changedAt >= ring.capacity() / 4) {
+    keepEvery /= 2;
+    lagAtChange = 0;
+    changedAt = ring.head();
+  }
+}
+
+// Depends only on the line number, so a line offered but not sent yet is
+// judged the same way by the next gather() (unless the decimation changed)
+bool RingReader::skip(uint64_t line) const {
+  return keepEvery > 1 && ring.slots[line & ring.mask].sample && line % keepEvery != 0;
+}
+
+int RingReader::gather(struct iovec* iov, int maxIov) {
+  int n = 0;
+  offered.clear();
+  offeredPrivate = false;
+
+  // Private lines go out between ring lines, never inside one: with a ring
+  // line partly sent, offer just its rest, and the private lines next time
+  bool privateWaiting = privateSent < privateOut.size();
+  if (partial > 0 && privateWaiting) maxIov = 1;
+  if (partial == 0 && privateWaiting) {
+    iov[n].iov_base = const_cast<char*>(privateOut.data() + privateSent);
+    iov[n].iov_len = privateOut.size() - privateSent;
+    n++;
+    offeredPrivate = true;
+  }
+
+  adjustDecimation();
+
+  // Lines skipped at the front are settled now; a line partly sent is not
+  // reconsidered
+  while (partial == 0 && cursor < ring.head() && skip(cursor)) {
+    cursor++;
+    counters.decimated++;
+  }
+
+  offeredPartial = partial;
+  for (uint64_t line = cursor; line < ring.head() && n < maxIov; line++) {
+    if (line != cursor && skip(line)) continue;
+    const LineRing::Slot& slot = ring.slots[line & ring.mask];
+    size_t from = line == cursor ? partial : 0;
+    iov[n].iov_base = const_cast<char*>(slot.data + from);
+    iov[n].iov_len = slot.length - from;
+    n++;
+    offered.push_back(line);
+  }
+  return n;
+}
+
+void RingReader::consumed(size_t bytes) {
+  counters.bytes += bytes;
+
+  if (offeredPrivate) {
+    size_t take = std::min(bytes, privateOut.size() - privateSent);
+    privateSent += take;
+    bytes -= take;
+    if (privateSent < privateOut.size()) return;
+    privateOut.clear();
+    privateSent = 0;
+  }
+
+  for (size_t i = 0; i < offered.size(); i++) {
+    uint64_t line = offered[i];
+    size_t from = i == 0 ? offeredPartial : 0;
+    size_t rest = ring.slots[line & ring.mask].length - from;
+
+    // Lines between the previous offered line and this one were skipped
+    counters.decimated += line - cursor;
+    if (bytes < rest) {
+      cursor = line;
+      partial = from + bytes;
+      return;
+    }
+    bytes -= rest;
+    cursor = line + 1;
+    partial = 0;
+    counters.sent++;
+  }
+}
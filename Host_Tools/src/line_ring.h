@@ -0,0 +1,120 @@
+/*
+ * ============================================================================
+ * LINE RING - HEADER FILE
+ * ============================================================================
+ *
+ * Fan-out of the arm's output lines to several readers (ccm_bridge clients)
+ * without copying them per reader.
+ *
+ * LineRing holds the newest lines in fixed-size slots. Lines are numbered
+ * in arrival order, and the writer never waits for a reader. Each RingReader
+ * keeps its own position and builds iovecs that point straight into the
+ * slots, so a line is copied once into the ring and then only by the
+ * kernel into each socket.
+ *
+ * Backpressure is per reader. A reader that falls more than half the ring
+ * behind gets every 2nd, 4th, ... sample line (POS / VEL), up to
+ * LINE_RING_MAX_DECIMATION, until it has caught up again. Other lines
+ * (ACK, ERROR, INFO, SPOS, ...) are never decimated. A reader that is
+ * lapped anyway is moved forward and the skipped lines are counted as
+ * dropped; a line it was halfway through is finished first, so the byte
+ * stream always stays line-aligned.
+ *
+ * ============================================================================
+ */
+
+#ifndef LINE_RING_H
+#define LINE_RING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sys/uio.h>
+
+// Longest line kept whole, including its '\n' (longer lines are cut)
+static const size_t LINE_RING_SLOT_BYTES = 256;
+static const unsigned LINE_RING_MAX_DECIMATION = 64;
+
+class LineRing {
+public:
+  // slots is rounded up to a power of two
+  explicit LineRing(size_t slots);
+
+  // Append one line (without its line ending). Sample lines may be
+  // decimated for slow readers. Returns false if the line was cut.
+  bool push(const char* text, size_t length, bool sample);
+
+  uint64_t head() const { return next; }  // Number of the next line
+  size_t capacity() const { return slots.size(); }
+
+  // Oldest line still held
+  uint64_t oldest() const { return next > slots.size() ? next - slots.size() : 0; }
+
+private:
+  friend class RingReader;
+
+  struct Slot {
+    uint16_t length;  // Including '\n'
+    bool sample;
+    char data[LINE_RING_SLOT_BYTES];
+  };
+
+  std::vector<Slot> slots;
+  size_t mask;
+  uint64_t next = 0;
+};
+
+struct RingReaderStats {
+  uint64_t sent = 0;        // Lines handed to the socket
+  uint64_t decimated = 0;   // Sample lines skipped to keep up
+  uint64_t dropped = 0;     // Lines overwritten before they could be sent
+  uint64_t bytes = 0;
+};
+
+class RingReader {
+public:
+  // Starts at the ring's current head: only new lines are delivered
+  explicit RingReader(const LineRing& ring);
+
+  // Must be called for every reader before each LineRing::push() once the
+  // ring is full: moves this reader off the slot about to be overwritten.
+  void beforeOverwrite();
+
+  // Queue a line for this reader only (replies from the bridge itself).
+  // Sent before any further ring lines, once a ring line the socket took
+  // only part of has been finished.
+  void sendPrivate(const std::string& line);
+
+  // Fill iov with what should go out next (at most maxIov entries).
+  // Returns the entry count; 0 when this reader has caught up.
+  int gather(struct iovec* iov, int maxIov);
+
+  // The socket took 'bytes' of what gather() offered
+  void consumed(size_t bytes);
+
+  bool pending() const { return !privateOut.empty() || cursor < ring.head(); }
+  uint64_t lag() const { return ring.head() - cursor; }
+  unsigned decimation() const { return keepEvery; }
+  const RingReaderStats& stats() const { return counters; }
+
+private:
+  void adjustDecimation();
+  bool skip(uint64_t line) const;
+
+  const LineRing& ring;
+  uint64_t cursor;              // Next line to look at
+  size_t partial = 0;           // Bytes of the line at cursor already sent
+  std::string privateOut;       // Bridge replies and cut-off remainders
+  size_t privateSent = 0;
+  unsigned keepEvery = 1;       // Decimation: keep 1 sample line in N
+  uint64_t lagAtChange = 0;
+  uint64_t changedAt = 0;       // Ring head when the lag was last high
+  std::vector<uint64_t> offered;  // Ring lines behind the last gather()
+  size_t offeredPartial = 0;      // Bytes of offered[0] already sent
+  bool offeredPrivate = false;
+  RingReaderStats counters;
+};
+
+#endif // LINE_RING_H
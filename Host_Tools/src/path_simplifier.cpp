@@ -0,0 +1,126 @@
+/*
+ * ============================================================================
+ * PATH SIMPLIFIER - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "path_simplifier.h"
+
+#include <algorithm>
+
+PathSimplifier::PathSimplifier(double tolerance, size_t window)
+    : toleranceSquared(tolerance * tolerance), capacity(std::max<size_t>(window, 3)) {
+  x.resize(capacity);
+  y.resize(capacity);
+  z.resize(capacity);
+  ids.resize(capacity);
+  keep.resize(capacity);
+  stack.reserve(2 * capacity);
+}
+
+void PathSimplifier::push(const double p[3], uint64_t id, bool force,
+                          std::vector<uint64_t>& kept) {
+  counters.points++;
+
+  if (count == 0) {
+    // First point of a path: always kept
+    x[0] = p[0];
+    y[0] = p[1];
+    z[0] = p[2];
+    ids[0] = id;
+    count = 1;
+    kept.push_back(id);
+    counters.kept++;
+    if (force) counters.forced++;
+    return;
+  }
+
+  x[count] = p[0];
+  y[count] = p[1];
+  z[count] = p[2];
+  ids[count] = id;
+  count++;
+
+  if (force) {
+    counters.forced++;
+    simplify(true, kept);
+  } else if (count == capacity) {
+    simplify(false, kept);
+  }
+}
+
+void PathSimplifier::finish(std::vector<uint64_t>& kept) {
+  if (count > 1) simplify(true, kept);
+  count = 0;
+}
+
+// Distance from point i to the segment a-b, squared
+double PathSimplifier::distanceSquared(size_t i, size_t a, size_t b) const {
+  double ux = x[b] - x[a], uy = y[b] - y[a], uz = z[b] - z[a];
+  double vx = x[i] - x[a], vy = y[i] - y[a], vz = z[i] - z[a];
+  double length2 = ux * ux + uy * uy + uz * uz;
+  double t = length2 > 0 ? (ux * vx + uy * vy + uz * vz) / length2 : 0;
+  t = std::min(1.0, std::max(0.0, t));
+  double dx = vx - t * ux, dy = vy - t * uy, dz = vz - t * uz;
+  return dx * dx + dy * dy + dz * dz;
+}
+
+// Douglas-Peucker over the buffer. With 'final' everything kept is
+// committed and the last point becomes the anchor; otherwise the part
+// after the last interior kept point stays buffered.
+void PathSimplifier::simplify(bool final, std::vector<uint64_t>& kept) {
+  size_t last = count - 1;
+  std::fill(keep.begin(), keep.begin() + count, 0);
+  keep[0] = keep[last] = 1;
+
+  stack.clear();
+  stack.push_back(0);
+  stack.push_back(last);
+  while (!stack.empty()) {
+    size_t b = stack.back();
+    stack.pop_back();
+    size_t a = stack.back();
+    stack.pop_back();
+
+    double worst = toleranceSquared;
+    size_t split = 0;
+    for (size_t i = a + 1; i < b; i++) {
+      double d = distanceSquared(i, a, b);
+      if (d > worst) {
+        worst = d;
+        split = i;
+      }
+    }
+    if (split != 0) {
+      keep[split] = 1;
+      stack.push_back(a);
+      stack.push_back(split);
+      stack.push_back(split);
+      stack.push_back(b);
+    }
+  }
+
+  // Where to cut: the last interior kept point, or the end of the buffer
+  // when that would leave more than half a window to look at again
+  size_t cut = last;
+  if (!final) {
+    size_t interior = last - 1;
+    while (interior > 0 && !keep[interior]) interior--;
+    if (interior > 0 && last - interior <= capacity / 2) cut = interior;
+  }
+
+  for (size_t i = 1; i <= cut; i++) {
+    if (keep[i] || i == cut) {
+      kept.push_back(ids[i]);
+      counters.kept++;
+    }
+  }
+
+  // The cut point is the new anchor; anything after it stays buffered
+  size_t remaining = count - cut;
+  std::copy(x.begin() + cut, x.begin() + count, x.begin());
+  std::copy(y.begin() + cut, y.begin() + count, y.begin());
+  std::copy(z.begin() + cut, z.begin() + count, z.begin());
+  std::copy(ids.begin() + cut, ids.begin() + count, ids.begin());
+  count = remaining;
+}
@@ -0,0 +1,82 @@
+/*
+ * ============================================================================
+ * PATH SIMPLIFIER - HEADER FILE
+ * ============================================================================
+ *
+ * Streaming polyline simplification: Douglas-Peucker over a bounded
+ * look-ahead window.
+ *
+ * A continuous recording is mostly short straight runs sampled far more
+ * densely than its shape needs. Points are buffered behind the last kept
+ * point (the anchor) until the window is full; Douglas-Peucker then runs
+ * over the buffer, everything up to its last interior kept point is
+ * committed, and the rest stays buffered as the start of the next window.
+ * Every dropped point lies within the tolerance of the segment between the
+ * kept points around it, exactly as with whole-path Douglas-Peucker. Where
+ * a straight run is longer than the window it is cut at the window's end,
+ * which costs one extra point per window and nothing in accuracy.
+ *
+ * - Distances are to the SEGMENT, not the infinite line, so a path that
+ *   doubles back on itself is not folded away
+ * - A forced point (a captured boundary or hole point) is always kept and
+ *   the path is simplified up to it
+ * - finish() (end of stream, pause, anything that is not a sample) keeps
+ *   the last point and starts a new path
+ *
+ * Memory is the window; each point is examined O(log window) times on
+ * average.
+ *
+ * Points are identified by a caller-chosen id (e.g. the position of its
+ * line in the caller's own buffer). Kept ids come out in input order.
+ *
+ * ============================================================================
+ */
+
+#ifndef PATH_SIMPLIFIER_H
+#define PATH_SIMPLIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct PathSimplifierStats {
+  uint64_t points = 0;  // Pushed
+  uint64_t kept = 0;
+  uint64_t forced = 0;  // Kept because they were forced
+};
+
+class PathSimplifier {
+public:
+  // tolerance: largest distance (mm) of a dropped point from the kept path.
+  // window: most points held before the oldest are committed (3 or more).
+  PathSimplifier(double tolerance, size_t window);
+
+  // Add a point; ids of points now known to be kept are appended to 'kept'
+  void push(const double p[3], uint64_t id, bool force, std::vector<uint64_t>& kept);
+
+  // End the current path: commit everything buffered
+  void finish(std::vector<uint64_t>& kept);
+
+  // Points still waiting for a decision (at most window - 1)
+  size_t held() const { return count > 0 ? count - 1 : 0; }
+
+  const PathSimplifierStats& stats() const { return counters; }
+
+private:
+  void simplify(bool final, std::vector<uint64_t>& kept);
+  double distanceSquared(size_t i, size_t a, size_t b) const;
+
+  double toleranceSquared;
+  size_t capacity;
+
+  // Buffer: [0] is the anchor (already kept), the rest are undecided
+  std::vector<double> x, y, z;
+  std::vector<uint64_t> ids;
+  std::vector<uint8_t> keep;
+  std::vector<size_t> stack;
+  size_t count = 0;
+
+  PathSimplifierStats counters;
+};
+
+#endif  // PATH_SIMPLIFIER_H
@@ -0,0 +1,345 @@
+/*
+ * ============================================================================
+ * PIPELINE - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "pipeline.h"
+
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+// Waiting on a queue: a few yields (under load the next batch is already
+// on its way), then sleeps doubling up to WAIT_MAX_SLEEP_US. Spinning
+// longer costs a core per idle stage at the arm's usual rates; the sleep
+// adds at most WAIT_MAX_SLEEP_US per stage to a sample's latency.
+static const int WAIT_YIELDS = 4;
+static const int WAIT_MIN_SLEEP_US = 100;
+static const int WAIT_MAX_SLEEP_US = 1000;
+
+// Live input is polled this often for stop()
+static const int SOURCE_POLL_MS = 50;
+
+static int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+namespace {
+class Backoff {
+public:
+  void wait() {
+    if (tries++ < WAIT_YIELDS) {
+      std::this_thread::yield();
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(sleepUs));
+    if (sleepUs < WAIT_MAX_SLEEP_US) sleepUs *= 2;
+  }
+
+private:
+  int tries = 0;
+  int sleepUs = WAIT_MIN_SLEEP_US;
+};
+}  // namespace
+
+// ============================================================================
+// STAGE THREAD
+// ============================================================================
+PipelineStage::~PipelineStage() {
+  join();
+}
+
+bool PipelineStage::start(int cpu) {
+  thread = std::thread([this] {
+    run();
+    closeOutputs();
+    done.store(true, std::memory_order_release);
+  });
+
+  bool pinned = true;
+#ifdef __linux__
+  // Thread names show up in top -H / perf; the kernel keeps 15 characters
+  pthread_setname_np(thread.native_handle(), stageName.substr(0, 15).c_str());
+  if (cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pinned = pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+  }
+#else
+  pinned = cpu < 0;
+#endif
+  return pinned;
+}
+
+void PipelineStage::join() {
+  if (thread.joinable()) thread.join();
+}
+
+void PipelineStage::run() {
+  BatchPtr batch;
+  while (receive(batch)) {
+    int64_t begin = NowNs();
+    int64_t blockedBefore = blockedNs.load(std::memory_order_relaxed);
+    size_t handled = process(batch);
+    int64_t blocked = blockedNs.load(std::memory_order_relaxed) - blockedBefore;
+    countProcessed(handled, NowNs() - begin - blocked);
+    batch.reset();
+  }
+  finish();
+}
+
+StageCounters PipelineStage::counters() const {
+  StageCounters c;
+  c.batches = batches.load(std::memory_order_relaxed);
+  c.samples = samples.load(std::memory_order_relaxed);
+  c.busyNs = busyNs.load(std::memory_order_relaxed);
+  c.starvedNs = starvedNs.load(std::memory_order_relaxed);
+  c.blockedNs = blockedNs.load(std::memory_order_relaxed);
+  c.stalls = stalls.load(std::memory_order_relaxed);
+  return c;
+}
+
+void PipelineStage::countProcessed(size_t count, int64_t ns) {
+  batches.fetch_add(1, std::memory_order_relaxed);
+  samples.fetch_add(count, std::memory_order_relaxed);
+  busyNs.fetch_add(ns, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// HAND-OFF
+// ============================================================================
+bool PipelineStage::receive(BatchPtr& batch) {
+  if (input == nullptr) return false;
+  if (input->queue.tryPop(batch)) return true;
+
+  int64_t begin = NowNs();
+  Backoff backoff;
+  bool got;
+  for (;;) {
+    if (input->queue.tryPop(batch)) {
+      got = true;
+      break;
+    }
+    // Anything pushed before 'closed' was set is visible after it is seen
+    if (input->closed.load(std::memory_order_acquire)) {
+      got = input->queue.tryPop(batch);
+      break;
+    }
+    backoff.wait();
+  }
+  starvedNs.fetch_add(NowNs() - begin, std::memory_order_relaxed);
+  return got;
+}
+
+bool PipelineStage::send(BatchPtr& batch) {
+  bool delivered = true;
+  for (size_t i = 0; i < outputs.size(); i++) {
+    PipelineLink* link = outputs[i];
+    // The last output takes the caller's reference, the others a copy
+    BatchPtr item = i + 1 < outputs.size() ? batch : std::move(batch);
+    size_t count = item->samples.size();
+    size_t bytes = item->text.size();
+
+    if (!link->queue.tryPush(item)) {
+      if (link->policy == LINK_DROP) {
+        link->droppedBatches.fetch_add(1, std::memory_order_relaxed);
+        link->droppedSamples.fetch_add(count, std::memory_order_relaxed);
+        link->droppedBytes.fetch_add(bytes, std::memory_order_relaxed);
+        delivered = false;
+        continue;
+      }
+      int64_t begin = NowNs();
+      Backoff backoff;
+      while (!link->queue.tryPush(item)) backoff.wait();
+      blockedNs.fetch_add(NowNs() - begin, std::memory_order_relaxed);
+      stalls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    link->batches.fetch_add(1, std::memory_order_relaxed);
+    size_t depth = link->queue.size();
+    for (std::atomic<size_t>* most : {&link->maxDepth, &link->windowMaxDepth}) {
+      if (depth > most->load(std::memory_order_relaxed)) {
+        most->store(depth, std::memory_order_relaxed);
+      }
+    }
+  }
+  return delivered;
+}
+
+void PipelineStage::closeOutputs() {
+  for (PipelineLink* link : outputs) link->closed.store(true, std::memory_order_release);
+}
+
+// ============================================================================
+// SOURCE
+// ============================================================================
+void SourceStage::run() {
+  std::vector<char> buffer(chunkBytes);
+  bool dropped = false;
+
+  while (!stopping.load(std::memory_order_relaxed)) {
+    pollfd p = {fd, POLLIN, 0};
+    int ready = poll(&p, 1, SOURCE_POLL_MS);
+    if (ready < 0 && errno != EINTR) {
+      lastError = std::string("poll failed: ") + strerror(errno);
+      break;
+    }
+    if (ready <= 0) continue;
+
+    ssize_t n = read(fd, buffer.data(), buffer.size());
+    int64_t receivedNs = NowNs();
+    if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+    if (n < 0 && errno != EIO) {
+      lastError = std::string("Read failed: ") + strerror(errno);
+      break;
+    }
+    if (n <= 0) break;  // End of file, or the port went away (EIO)
+
+    BatchPtr batch = std::make_shared<PipelineBatch>();
+    batch->text.assign(buffer.data(), static_cast<size_t>(n));
+    batch->receivedNs = receivedNs;
+    batch->gap = dropped;
+    bytes.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+    countProcessed(0, NowNs() - receivedNs);
+    dropped = !send(batch);
+  }
+}
+
+// ============================================================================
+// DECODE
+// ============================================================================
+size_t DecodeStage::process(BatchPtr& batch) {
+  const std::string& text = batch->text;
+  size_t start = 0;
+
+  // After a drop the partial line and the start of this chunk do not
+  // belong together: resume at the next line
+  if (batch->gap) {
+    if (!partial.empty()) skipped.fetch_add(1, std::memory_order_relaxed);
+    partial.clear();
+    start = text.find('\n');
+    start = start == std::string::npos ? text.size() : start + 1;
+  }
+
+  size_t before = pending ? pending->samples.size() : 0;
+  size_t decoded = 0;
+  size_t newline;
+  while ((newline = text.find('\n', start)) != std::string::npos) {
+    if (!partial.empty()) {
+      partial.append(text, start, newline - start);
+      addLine(partial.c_str(), partialNs);
+      partial.clear();
+    } else {
+      addLine(text.c_str() + start, batch->receivedNs);  // Ends at the '\n'
+    }
+    start = newline + 1;
+
+    if (pending && pending->samples.size() >= batchSamples) {
+      decoded += pending->samples.size() - before;
+      before = 0;
+      flush();
+    }
+  }
+  if (start < text.size()) {
+    if (partial.empty()) partialNs = batch->receivedNs;
+    partial.append(text, start, std::string::npos);
+  }
+  if (pending) decoded += pending->samples.size() - before;
+
+  // Nothing more waiting: send what there is now rather than wait to fill
+  if (input->queue.size() == 0) flush();
+  return decoded;
+}
+
+void DecodeStage::finish() {
+  if (!partial.empty()) addLine(partial.c_str(), partialNs);  // Last line, no newline
+  partial.clear();
+  flush();
+}
+
+void DecodeStage::addLine(const char* p, int64_t receivedNs) {
+  if (!pending) {
+    pending = std::make_shared<PipelineBatch>();
+    pending->samples.reserve(batchSamples);
+  }
+  PipelineSample s;
+  if (parseLine(p, receivedNs, s)) pending->samples.push_back(s);
+  else skipped.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool DecodeStage::parseLine(const char* p, int64_t receivedNs, PipelineSample& s) const {
+  char* end;
+  s.hostNs = receivedNs;
+  s.timestamp = 0;
+  if (strncmp(p, "POS,", 4) == 0) {
+    s.timestamp = strtoll(p + 4, &end, 10);
+    if (end == p + 4) return false;
+  } else {
+    s.hostNs = strtoll(p, &end, 10);  // ccm_sync: host_ns first
+    if (end == p) return false;
+  }
+  p = end;
+
+  for (int i = 0; i < 3 + axes; i++) {
+    if (*p != ',') return false;
+    p++;
+    double value = strtod(p, &end);
+    if (end == p) return false;
+    if (i < 3) s.xyz[i] = value;
+    else s.angles[i - 3] = value;
+    p = end;
+  }
+  return *p == ',' || *p == '\n' || *p == '\r' || *p == '\0';
+}
+
+void DecodeStage::flush() {
+  if (!pending || pending->samples.empty()) return;
+  send(pending);
+  pending.reset();
+}
+
+// ============================================================================
+// FUNCTION
+// ============================================================================
+size_t FunctionStage::process(BatchPtr& batch) {
+  size_t count = batch->samples.size();
+  function(*batch);
+  if (!outputs.empty() && !batch->samples.empty()) send(batch);
+  return count;
+}
+
+// ============================================================================
+// CPU LIST
+// ============================================================================
+bool Pipeline_ParseCpuList(const char* text, std::vector<int>& cpus) {
+  cpus.clear();
+  const char* p = text;
+  for (;;) {
+    char* end;
+    long first = strtol(p, &end, 10);
+    if (end == p || first < 0) return false;
+    long last = first;
+    p = end;
+    if (*p == '-') {
+      p++;
+      last = strtol(p, &end, 10);
+      if (end == p || last < first) return false;
+      p = end;
+    }
+    for (long cpu = first; cpu <= last; cpu++) cpus.push_back(static_cast<int>(cpu));
+    if (*p == '\0') return true;
+    if (*p != ',') return false;
+    p++;
+  }
+}
@@ -0,0 +1,245 @@
+/*
+ * ============================================================================
+ * PIPELINE - HEADER FILE
+ * ============================================================================
+ *
+ * Multi-stage host processing: each stage runs on its own thread (pinned
+ * to a core if asked) and hands batches of samples to the next one through
+ * a bounded lock-free queue (spsc_queue.h).
+ *
+ *   source -> decode -> [transform stages] -> sinks (storage, fitting, ...)
+ *
+ * - SourceStage reads the port or file in chunks, DecodeStage splits the
+ *   text into samples, FunctionStage runs any per-batch function: the
+ *   transforms (kinematics, filtering, compensation) and the sinks
+ * - A stage with several outputs (fan-out) hands every one the same
+ *   batch; from there on the batch is read-only
+ * - Batches are handed over whole, so the queue cost is per batch, not
+ *   per sample. Decode sends what it has as soon as its input runs dry, so
+ *   batching never adds latency when the pipeline keeps up
+ *
+ * BACKPRESSURE:
+ * Every link has a capacity (in batches) and a policy for when it is full:
+ * - LINK_BLOCK: the producer waits for room (lossless; a slow stage slows
+ *   everything upstream of it)
+ * - LINK_DROP: the batch is dropped and counted (the producer never waits)
+ * The source's link from a live port is LINK_DROP, so acquisition never
+ * waits on anything: a slow disk first fills the queues behind it, and
+ * only when all of them are full are samples dropped, counted, at the
+ * source instead of being lost unseen in the serial driver's buffer.
+ *
+ * METRICS:
+ * Per stage: batches and samples processed, and where its thread's time
+ * went - busy (processing), starved (waiting for input) and blocked
+ * (waiting for room downstream). Per link: depth, largest depth, batches
+ * and samples dropped. All counters are relaxed atomics, read by any
+ * thread while the pipeline runs.
+ *
+ * SHUTDOWN:
+ * The source closes its outputs on end of file or stop(); every stage
+ * drains its input, then closes its own outputs, so join() returns once
+ * every sample has gone all the way through.
+ *
+ * ============================================================================
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.h"
+
+static const int PIPELINE_MAX_AXES = 8;
+
+// ============================================================================
+// DATA
+// ============================================================================
+struct PipelineSample {
+  int64_t hostNs;                     // Host time the line was read
+  int64_t timestamp;                  // Device timestamp (POS lines), else 0
+  double xyz[3];                      // mm
+  double angles[PIPELINE_MAX_AXES];   // Degrees
+};
+
+struct PipelineBatch {
+  std::string text;                     // Raw input (source -> decode)
+  int64_t receivedNs = 0;               // When 'text' was read
+  bool gap = false;                     // Input before 'text' was dropped
+  std::vector<PipelineSample> samples;  // Decoded samples
+};
+
+typedef std::shared_ptr<PipelineBatch> BatchPtr;
+
+// ============================================================================
+// LINKS
+// ============================================================================
+enum LinkPolicy {
+  LINK_BLOCK = 0,  // Producer waits for room
+  LINK_DROP  = 1   // Producer drops the batch
+};
+
+struct PipelineLink {
+  PipelineLink(const std::string& linkName, size_t capacity, LinkPolicy linkPolicy)
+      : name(linkName), queue(capacity), policy(linkPolicy) {}
+
+  std::string name;
+  SpscQueue<BatchPtr> queue;
+  LinkPolicy policy;
+  std::atomic<bool> closed{false};  // Producer is done
+
+  std::atomic<uint64_t> batches{0};         // Handed over
+  std::atomic<uint64_t> droppedBatches{0};
+  std::atomic<uint64_t> droppedSamples{0};
+  std::atomic<uint64_t> droppedBytes{0};    // Raw input (source links)
+  std::atomic<size_t> maxDepth{0};          // Largest depth seen
+  std::atomic<size_t> windowMaxDepth{0};    // Same, reset by whoever reports it
+};
+
+// ============================================================================
+// STAGES
+// ============================================================================
+struct StageCounters {
+  uint64_t batches = 0;    // Processed
+  uint64_t samples = 0;
+  int64_t busyNs = 0;      // Processing
+  int64_t starvedNs = 0;   // Waiting for input
+  int64_t blockedNs = 0;   // Waiting for room in an output
+  uint64_t stalls = 0;     // Pushes that had to wait
+};
+
+class PipelineStage {
+public:
+  explicit PipelineStage(const std::string& stageName) : stageName(stageName) {}
+  virtual ~PipelineStage();
+
+  PipelineStage(const PipelineStage&) = delete;
+  PipelineStage& operator=(const PipelineStage&) = delete;
+
+  // Wiring, before start(). Sources have no input, sinks no outputs.
+  void setInput(PipelineLink* link) { input = link; }
+  void addOutput(PipelineLink* link) { outputs.push_back(link); }
+
+  // Start the thread, pinned to 'cpu' if >= 0. Returns false if the
+  // thread runs but could not be pinned.
+  bool start(int cpu = -1);
+  void join();
+
+  const std::string& name() const { return stageName; }
+  PipelineLink* inputLink() const { return input; }
+  bool finished() const { return done.load(std::memory_order_acquire); }
+  StageCounters counters() const;
+
+protected:
+  // Thread body. The default pops batches until the input is drained,
+  // calling process() for each and finish() at the end. The outputs are
+  // closed when it returns.
+  virtual void run();
+  // Returns the number of samples handled, for the metrics
+  virtual size_t process(BatchPtr& batch) = 0;
+  virtual void finish() {}
+
+  // Wait for the next batch; false once the input is closed and empty
+  bool receive(BatchPtr& batch);
+  // Hand a batch to every output, by each link's policy. Returns false if
+  // any output dropped it.
+  bool send(BatchPtr& batch);
+
+  void countProcessed(size_t samples, int64_t busyNs);
+
+  PipelineLink* input = nullptr;
+  std::vector<PipelineLink*> outputs;
+
+private:
+  void closeOutputs();
+
+  std::string stageName;
+  std::thread thread;
+  std::atomic<bool> done{false};  // Thread body returned
+
+  std::atomic<uint64_t> batches{0};
+  std::atomic<uint64_t> samples{0};
+  std::atomic<int64_t> busyNs{0};
+  std::atomic<int64_t> starvedNs{0};
+  std::atomic<int64_t> blockedNs{0};
+  std::atomic<uint64_t> stalls{0};
+};
+
+// Reads a descriptor (serial port, pipe or file) in chunks until end of
+// file or stop(). A live descriptor is polled so stop() is seen promptly.
+class SourceStage : public PipelineStage {
+public:
+  SourceStage(const std::string& stageName, int fd, size_t chunkBytes = 1 << 16)
+      : PipelineStage(stageName), fd(fd), chunkBytes(chunkBytes) {}
+
+  void stop() { stopping.store(true, std::memory_order_relaxed); }
+  uint64_t bytesRead() const { return bytes.load(std::memory_order_relaxed); }
+  const std::string& error() const { return lastError; }  // After join()
+
+protected:
+  void run() override;
+  size_t process(BatchPtr&) override { return 0; }
+
+private:
+  int fd;
+  size_t chunkBytes;
+  std::atomic<bool> stopping{false};
+  std::atomic<uint64_t> bytes{0};
+  std::string lastError;
+};
+
+// Splits text into samples: "POS,timestamp,x,y,z,theta1..N" (firmware) or
+// "host_ns,x,y,z,theta1..N" (ccm_sync). Other lines are counted and
+// dropped. Sends at most 'batchSamples' per batch.
+class DecodeStage : public PipelineStage {
+public:
+  DecodeStage(const std::string& stageName, int axes, size_t batchSamples)
+      : PipelineStage(stageName), axes(axes), batchSamples(batchSamples) {}
+
+  uint64_t skippedLines() const { return skipped.load(std::memory_order_relaxed); }
+
+protected:
+  size_t process(BatchPtr& batch) override;
+  void finish() override;
+
+private:
+  bool parseLine(const char* p, int64_t receivedNs, PipelineSample& s) const;
+  void addLine(const char* p, int64_t receivedNs);
+  void flush();
+
+  int axes;
+  size_t batchSamples;
+  std::string partial;  // Line split across reads
+  int64_t partialNs = 0;
+  BatchPtr pending;
+  std::atomic<uint64_t> skipped{0};
+};
+
+// Runs a function on every batch, then passes it on (if it has outputs).
+// The function may change the samples, or remove some, unless the batch
+// came through a fan-out.
+class FunctionStage : public PipelineStage {
+public:
+  typedef std::function<void(PipelineBatch&)> Function;
+
+  FunctionStage(const std::string& stageName, Function function)
+      : PipelineStage(stageName), function(function) {}
+
+protected:
+  size_t process(BatchPtr& batch) override;
+
+private:
+  Function function;
+};
+
+// Parse a CPU list for --pin: "0,2,3" or "1-3". False on anything else.
+bool Pipeline_ParseCpuList(const char* text, std::vector<int>& cpus);
+
+#endif  // PIPELINE_H
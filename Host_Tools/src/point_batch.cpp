@@ -0,0 +1,53 @@
+/*
+ * ============================================================================
+ * POINT BATCH - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "point_batch.h"
+
+// ============================================================================
+// TYPE NAME TABLE
+// ============================================================================
+static const char* const typeNames[POINT_TYPE_COUNT] = {
+  "OTHER", "BOUNDARY", "HOLE_CENTER", "LIVE", "CIRCLE", "PLANE", "LINE"
+};
+
+PointType PointType_FromName(std::string_view name) {
+  for (int i = 1; i < POINT_TYPE_COUNT; i++) {
+    if (name == typeNames[i]) return static_cast<PointType>(i);
+  }
+  return POINT_TYPE_OTHER;
+}
+
+const char* PointType_Name(uint8_t type) {
+  return type < POINT_TYPE_COUNT ? typeNames[type] : typeNames[0];
+}
+
+// ============================================================================
+// BATCH STORAGE
+// ============================================================================
+PointBatch::PointBatch(size_t capacity)
+    : number(capacity), type(capacity), x(capacity), y(capacity), z(capacity),
+      timestamp(capacity), geometryStart(capacity + 1, 0) {
+  geometryText.reserve(capacity * 4);
+}
+
+void PointBatch::clear() {
+  count = 0;
+  geometryText.clear();
+  geometryStart[0] = 0;
+}
+
+void PointBatch::push(uint64_t num, uint8_t pointType, double px, double py,
+                      double pz, std::string_view geometryId, int64_t time) {
+  size_t i = count++;
+  number[i] = num;
+  type[i] = pointType;
+  x[i] = px;
+  y[i] = py;
+  z[i] = pz;
+  timestamp[i] = time;
+  geometryText.append(geometryId);
+  geometryStart[i + 1] = static_cast<uint32_t>(geometryText.size());
+}
@@ -0,0 +1,82 @@
+/*
+ * ============================================================================
+ * POINT BATCH - HEADER FILE
+ * ============================================================================
+ *
+ * Fixed-capacity structure-of-arrays block of captured points.
+ *
+ * Every host tool moves points around in batches instead of one object per
+ * point (the way CSVExporter does in the app). A batch is allocated once and
+ * reused, so memory stays constant no matter how long the session is.
+ *
+ * POINT TYPES:
+ * - The app stores the point type as a string (BOUNDARY, HOLE_CENTER, ...)
+ * - Here it is a one-byte code so it can be written straight into binary
+ *   formats such as PLY
+ *
+ * ============================================================================
+ */
+
+#ifndef POINT_BATCH_H
+#define POINT_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ============================================================================
+// POINT TYPE CODES
+// ============================================================================
+// Keep in sync with the types used by renderer.js / csv-exporter.js
+enum PointType : uint8_t {
+  POINT_TYPE_OTHER       = 0,
+  POINT_TYPE_BOUNDARY    = 1,
+  POINT_TYPE_HOLE_CENTER = 2,
+  POINT_TYPE_LIVE        = 3,
+  POINT_TYPE_CIRCLE      = 4,
+  POINT_TYPE_PLANE       = 5,
+  POINT_TYPE_LINE        = 6,
+  POINT_TYPE_COUNT
+};
+
+// Convert between app type strings and type codes
+PointType PointType_FromName(std::string_view name);
+const char* PointType_Name(uint8_t type);
+
+// ============================================================================
+// POINT BATCH STRUCTURE
+// ============================================================================
+struct PointBatch {
+  std::vector<uint64_t> number;     // 1-based point number
+  std::vector<uint8_t>  type;       // PointType code
+  std::vector<double>   x;          // X coordinate (mm unless converted)
+  std::vector<double>   y;          // Y coordinate
+  std::vector<double>   z;          // Z coordinate
+  std::vector<int64_t>  timestamp;  // Milliseconds (Date.now() in the app)
+
+  // Geometry IDs are short strings; keep them in one arena per batch
+  std::string           geometryText;
+  std::vector<uint32_t> geometryStart;  // size() + 1 offsets into geometryText
+
+  size_t count = 0;
+
+  explicit PointBatch(size_t capacity = 65536);
+
+  size_t capacity() const { return x.size(); }
+  bool full() const { return count == capacity(); }
+
+  void clear();
+
+  // Append one point (caller must check full() first)
+  void push(uint64_t num, uint8_t pointType, double px, double py, double pz,
+            std::string_view geometryId, int64_t time);
+
+  std::string_view geometryId(size_t i) const {
+    return std::string_view(geometryText).substr(
+        geometryStart[i], geometryStart[i + 1] - geometryStart[i]);
+  }
+};
+
+#endif // POINT_BATCH_H
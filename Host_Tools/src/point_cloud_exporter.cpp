@@ -0,0 +1,252 @@
+/*
+ * ============================================================================
+ * POINT CLOUD EXPORTER - IMPLEMENTATION FILE
+ * ============================================================================
+ *
+ * All formatting goes straight into the writer's block via reserve()/commit();
+ * numbers are printed with std::to_chars (no locale, no printf parsing).
+ *
+ * ============================================================================
+ */
+
+#include "point_cloud_exporter.h"
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+// Worst case for one fixed-notation double (1e308 with decimals)
+#define MAX_NUMBER_CHARS 340
+
+// ============================================================================
+// FORMAT NAMES
+// ============================================================================
+bool ExportFormat_FromName(const std::string& name, ExportFormat& format) {
+  if (name == "xyz") format = EXPORT_XYZ;
+  else if (name == "ply") format = EXPORT_PLY;
+  else if (name == "csv") format = EXPORT_CSV;
+  else return false;
+  return true;
+}
+
+// ============================================================================
+// UNIT CONVERSION
+// ============================================================================
+// Plain loops over contiguous arrays - the compiler vectorizes these
+void Units_MmToInches(double* values, size_t count) {
+  const double scale = 1.0 / 25.4;
+  for (size_t i = 0; i < count; i++) values[i] *= scale;
+}
+
+void Units_InchesToMm(double* values, size_t count) {
+  for (size_t i = 0; i < count; i++) values[i] *= 25.4;
+}
+
+void Units_MmToInches(PointBatch& batch) {
+  Units_MmToInches(batch.x.data(), batch.count);
+  Units_MmToInches(batch.y.data(), batch.count);
+  Units_MmToInches(batch.z.data(), batch.count);
+}
+
+// ============================================================================
+// FORMATTING HELPERS
+// ============================================================================
+static inline char* appendFixed(char* p, double value, int precision) {
+  return std::to_chars(p, p + MAX_NUMBER_CHARS, value, std::chars_format::fixed, precision).ptr;
+}
+
+template <typename T>
+static inline char* appendInt(char* p, T value) {
+  return std::to_chars(p, p + 24, value).ptr;
+}
+
+template <typename T>
+static inline char* appendLE(char* p, T value) {
+  memcpy(p, &value, sizeof(T));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  for (size_t i = 0; i < sizeof(T) / 2; i++) {
+    char tmp = p[i];
+    p[i] = p[sizeof(T) - 1 - i];
+    p[sizeof(T) - 1 - i] = tmp;
+  }
+#endif
+  return p + sizeof(T);
+}
+
+// ============================================================================
+// EXPORTER
+// ============================================================================
+PointCloudExporter::PointCloudExporter(BufferedWriter& out, const ExportOptions& options)
+    : writer(out), opts(options) {}
+
+bool PointCloudExporter::begin() {
+  written = 0;
+
+  switch (opts.format) {
+    case EXPORT_PLY:
+      if (!writer.seekable() && !hasExpectedCount) {
+        lastError = "PLY to a non-seekable output needs the point count up front";
+        return false;
+      }
+      writePlyHeader();
+      break;
+
+    case EXPORT_CSV: {
+      // The app's header, units included, so the file reads back as a session
+      static const char mm[] = "Point,Type,X (mm),Y (mm),Z (mm),GeometryID,Timestamp\n";
+      static const char inches[] = "Point,Type,X (in),Y (in),Z (in),GeometryID,Timestamp\n";
+      if (opts.units == UNITS_INCHES) writer.write(inches, sizeof(inches) - 1);
+      else writer.write(mm, sizeof(mm) - 1);
+      break;
+    }
+
+    case EXPORT_XYZ:
+      break;
+  }
+  return true;
+}
+
+void PointCloudExporter::writeBatch(PointBatch& batch) {
+  if (batch.count == 0) return;
+  if (opts.units == UNITS_INCHES) Units_MmToInches(batch);
+
+  switch (opts.format) {
+    case EXPORT_XYZ: writeXyz(batch); break;
+    case EXPORT_PLY: writePly(batch); break;
+    case EXPORT_CSV: writeCsv(batch); break;
+  }
+  written += batch.count;
+}
+
+bool PointCloudExporter::finish() {
+  if (opts.format != EXPORT_PLY) return true;
+
+  if (hasExpectedCount) {
+    if (written != expectedCount) {
+      lastError = "PLY header announced " + std::to_string(expectedCount) +
+                  " points but " + std::to_string(written) + " were written";
+      return false;
+    }
+    return true;
+  }
+
+  // Output must be closed before the header can be patched
+  if (!writer.close()) {
+    lastError = writer.error();
+    return false;
+  }
+
+  char count[16];
+  snprintf(count, sizeof(count), "%010llu", static_cast<unsigned long long>(written));
+  if (!writer.patch(vertexCountOffset, count, 10)) {
+    lastError = writer.error();
+    return false;
+  }
+  return true;
+}
+
+// ============================================================================
+// PLY
+// ============================================================================
+void PointCloudExporter::writePlyHeader() {
+  std::string header;
+  header += "ply\n";
+  header += "format binary_little_endian 1.0\n";
+  header += "comment CCM Digitizing Arm point cloud\n";
+  header += opts.units == UNITS_INCHES ? "comment units inches\n" : "comment units mm\n";
+  if (opts.includeType) {
+    header += "comment type";
+    for (int i = 0; i < POINT_TYPE_COUNT; i++) {
+      header += " " + std::to_string(i) + "=" + PointType_Name(i);
+    }
+    header += "\n";
+  }
+
+  header += "element vertex ";
+  vertexCountOffset = writer.bytesWritten() + header.size();
+  char count[16];
+  snprintf(count, sizeof(count), "%010llu",
+           static_cast<unsigned long long>(hasExpectedCount ? expectedCount : 0));
+  header += count;
+  header += "\n";
+
+  header += "property float x\n";
+  header += "property float y\n";
+  header += "property float z\n";
+  if (opts.includeTimestamp) header += "property double timestamp\n";
+  if (opts.includeType) header += "property uchar type\n";
+  header += "end_header\n";
+
+  writer.write(header.data(), header.size());
+}
+
+void PointCloudExporter::writePly(const PointBatch& batch) {
+  size_t stride = 3 * sizeof(float) + (opts.includeTimestamp ? sizeof(double) : 0) +
+                  (opts.includeType ? 1 : 0);
+
+  char* p = writer.reserve(stride * batch.count);
+
+  if (!opts.includeTimestamp && !opts.includeType) {
+    for (size_t i = 0; i < batch.count; i++) {
+      p = appendLE(p, static_cast<float>(batch.x[i]));
+      p = appendLE(p, static_cast<float>(batch.y[i]));
+      p = appendLE(p, static_cast<float>(batch.z[i]));
+    }
+  } else {
+    for (size_t i = 0; i < batch.count; i++) {
+      p = appendLE(p, static_cast<float>(batch.x[i]));
+      p = appendLE(p, static_cast<float>(batch.y[i]));
+      p = appendLE(p, static_cast<float>(batch.z[i]));
+      if (opts.includeTimestamp) p = appendLE(p, static_cast<double>(batch.timestamp[i]));
+      if (opts.includeType) *p++ = static_cast<char>(batch.type[i]);
+    }
+  }
+
+  writer.commit(p);
+}
+
+// ============================================================================
+// XYZ
+// ============================================================================
+void PointCloudExporter::writeXyz(const PointBatch& batch) {
+  for (size_t i = 0; i < batch.count; i++) {
+    char* p = writer.reserve(3 * MAX_NUMBER_CHARS + 3);
+    p = appendFixed(p, batch.x[i], opts.precision);
+    *p++ = ' ';
+    p = appendFixed(p, batch.y[i], opts.precision);
+    *p++ = ' ';
+    p = appendFixed(p, batch.z[i], opts.precision);
+    *p++ = '\n';
+    writer.commit(p);
+  }
+}
+
+// ============================================================================
+// CSV
+// ============================================================================
+void PointCloudExporter::writeCsv(const PointBatch& batch) {
+  for (size_t i = 0; i < batch.count; i++) {
+    std::string_view geometryId = batch.geometryId(i);
+    const char* typeName = PointType_Name(batch.type[i]);
+    size_t typeLength = strlen(typeName);
+
+    char* p = writer.reserve(3 * MAX_NUMBER_CHARS + 64 + typeLength + geometryId.size());
+    p = appendInt(p, batch.number[i]);
+    *p++ = ',';
+    memcpy(p, typeName, typeLength);
+    p += typeLength;
+    *p++ = ',';
+    p = appendFixed(p, batch.x[i], opts.precision);
+    *p++ = ',';
+    p = appendFixed(p, batch.y[i], opts.precision);
+    *p++ = ',';
+    p = appendFixed(p, batch.z[i], opts.precision);
+    *p++ = ',';
+    memcpy(p, geometryId.data(), geometryId.size());
+    p += geometryId.size();
+    *p++ = ',';
+    p = appendInt(p, batch.timestamp[i]);
+    *p++ = '\n';
+    writer.commit(p);
+  }
+}
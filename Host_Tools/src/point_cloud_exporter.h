@@ -0,0 +1,95 @@
+/*
+ * ============================================================================
+ * POINT CLOUD EXPORTER - HEADER FILE
+ * ============================================================================
+ *
+ * Streams PointBatch blocks into point-cloud file formats for CAD and
+ * inspection tools:
+ *
+ * - XYZ : ASCII "x y z" per line
+ * - PLY : binary_little_endian 1.0, float x/y/z with optional
+ *         double timestamp (ms) and uchar type attributes
+ * - CSV : Point,Type,X (mm),Y (mm),Z (mm),GeometryID,Timestamp (the app's
+ *         point table, units in the header, without the geometry results)
+ *
+ * The PLY vertex count is not known until the end of the stream, so the
+ * header is written with a fixed-width placeholder that is patched in
+ * finish(). When the output is not seekable (stdout, a pipe) the count
+ * must be supplied up front with setExpectedCount().
+ *
+ * ============================================================================
+ */
+
+#ifndef POINT_CLOUD_EXPORTER_H
+#define POINT_CLOUD_EXPORTER_H
+
+#include <cstdint>
+#include <string>
+
+#include "buffered_writer.h"
+#include "point_batch.h"
+
+enum ExportFormat {
+  EXPORT_XYZ,
+  EXPORT_PLY,
+  EXPORT_CSV
+};
+
+enum ExportUnits {
+  UNITS_MM,
+  UNITS_INCHES
+};
+
+struct ExportOptions {
+  ExportFormat format = EXPORT_PLY;
+  ExportUnits units = UNITS_MM;
+  bool includeTimestamp = false;  // PLY only (XYZ has no attributes, CSV always has it)
+  bool includeType = false;       // PLY only
+  int precision = 3;              // decimal places for ASCII formats
+};
+
+// Parse "xyz" / "ply" / "csv"; returns false if unknown
+bool ExportFormat_FromName(const std::string& name, ExportFormat& format);
+
+// ============================================================================
+// UNIT CONVERSION (bulk versions of CSVExporter.mmToInches/inchesToMm)
+// ============================================================================
+void Units_MmToInches(double* values, size_t count);
+void Units_InchesToMm(double* values, size_t count);
+void Units_MmToInches(PointBatch& batch);
+
+// ============================================================================
+// EXPORTER
+// ============================================================================
+class PointCloudExporter {
+public:
+  PointCloudExporter(BufferedWriter& out, const ExportOptions& options);
+
+  // Needed for PLY output to a non-seekable stream
+  void setExpectedCount(uint64_t count) { expectedCount = count; hasExpectedCount = true; }
+
+  bool begin();
+  void writeBatch(PointBatch& batch);  // converts units in place
+  bool finish();
+
+  uint64_t pointsWritten() const { return written; }
+  const std::string& error() const { return lastError; }
+
+private:
+  void writePlyHeader();
+  void writeXyz(const PointBatch& batch);
+  void writePly(const PointBatch& batch);
+  void writeCsv(const PointBatch& batch);
+
+  BufferedWriter& writer;
+  ExportOptions opts;
+
+  uint64_t written = 0;
+  uint64_t expectedCount = 0;
+  bool hasExpectedCount = false;
+  uint64_t vertexCountOffset = 0;  // file offset of the PLY count placeholder
+
+  std::string lastError;
+};
+
+#endif // POINT_CLOUD_EXPORTER_H
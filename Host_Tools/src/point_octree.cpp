@@ -0,0 +1,243 @@
+/*
+ * ============================================================================
+ * POINT OCTREE - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "point_octree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <utility>
+
+static const uint32_t EMPTY_BLOCK = 0xFFFFFFFFu;
+
+// Neighbouring blocks differ in the low bits; spread them over the table
+static inline size_t BlockHash(uint32_t block) {
+  uint32_t h = block * 0x9E3779B1u;
+  return h ^ (h >> 15);
+}
+
+PointOctree::PointOctree(const float center[3], float halfSize, float minSpacing)
+    : rootHalf(halfSize) {
+  for (int k = 0; k < 3; k++) rootCenter[k] = center[k];
+  int depth = 0;
+  float spacing = 2 * halfSize / GRID;
+  while (spacing > minSpacing && depth < MAX_DEPTH - 1) {
+    spacing /= 2;
+    depth++;
+  }
+  maxDepth = static_cast<uint8_t>(depth);
+  addNode(rootCenter, rootHalf, 0);
+}
+
+uint32_t PointOctree::addNode(const float center[3], float half, uint8_t depth) {
+  nodes.emplace_back();
+  Node& node = nodes.back();
+  for (int k = 0; k < 3; k++) node.center[k] = center[k];
+  node.half = half;
+  node.depth = depth;
+  std::fill(node.children, node.children + 8, -1);
+  node.blocks = 0;
+  return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+void PointOctree::clear() {
+  nodes.clear();
+  insertedCount = 0;
+  outsideCount = 0;
+  storedCount = 0;
+  pathLength = 0;
+  addNode(rootCenter, rootHalf, 0);
+}
+
+void PointOctree::insert(const float* positions, const uint32_t* colors, size_t count) {
+  for (size_t i = 0; i < count; i++) insertOne(positions + 3 * i, colors[i]);
+}
+
+// ============================================================================
+// INSERT (one node per level until a free cell)
+// ============================================================================
+// Mark a cell occupied; false if it already was. Open addressing over
+// blocks, kept at most half full.
+bool PointOctree::claimCell(Node& node, const int cell[3]) {
+  const int blocksPerEdge = GRID / 4;
+  uint32_t block = static_cast<uint32_t>(((cell[2] >> 2) * blocksPerEdge + (cell[1] >> 2)) *
+                                             blocksPerEdge + (cell[0] >> 2));
+  uint64_t bit = 1ULL << (((cell[2] & 3) * 4 + (cell[1] & 3)) * 4 + (cell[0] & 3));
+
+  size_t mask = node.blockKeys.size() - 1;
+  size_t slot = BlockHash(block) & mask;
+  if (!node.blockKeys.empty()) {
+    while (node.blockKeys[slot] != EMPTY_BLOCK) {
+      if (node.blockKeys[slot] == block) {
+        if (node.blockBits[slot] & bit) return false;
+        node.blockBits[slot] |= bit;
+        return true;
+      }
+      slot = (slot + 1) & mask;
+    }
+  }
+
+  // New block
+  if ((node.blocks + 1) * 2 > node.blockKeys.size()) {
+    std::vector<uint32_t> oldKeys;
+    std::vector<uint64_t> oldBits;
+    oldKeys.swap(node.blockKeys);
+    oldBits.swap(node.blockBits);
+    size_t size = std::max<size_t>(8, oldKeys.size() * 2);
+    node.blockKeys.assign(size, EMPTY_BLOCK);
+    node.blockBits.assign(size, 0);
+    mask = size - 1;
+    for (size_t i = 0; i < oldKeys.size(); i++) {
+      if (oldKeys[i] == EMPTY_BLOCK) continue;
+      size_t to = BlockHash(oldKeys[i]) & mask;
+      while (node.blockKeys[to] != EMPTY_BLOCK) to = (to + 1) & mask;
+      node.blockKeys[to] = oldKeys[i];
+      node.blockBits[to] = oldBits[i];
+    }
+    slot = BlockHash(block) & mask;
+    while (node.blockKeys[slot] != EMPTY_BLOCK) slot = (slot + 1) & mask;
+  }
+  node.blockKeys[slot] = block;
+  node.blockBits[slot] = bit;
+  node.blocks++;
+  return true;
+}
+
+void PointOctree::insertOne(const float* p, uint32_t color) {
+  insertedCount++;
+  for (int k = 0; k < 3; k++) {
+    // Also rejects NaN
+    if (!(std::fabs(p[k] - rootCenter[k]) <= rootHalf)) {
+      outsideCount++;
+      return;
+    }
+  }
+
+  uint32_t index = 0;
+  for (;;) {
+    Node& node = nodes[index];
+    if (node.depth == maxDepth) {
+      pathLength = node.depth;
+      break;
+    }
+
+    int cell[3];
+    float scale = GRID / (2 * node.half);
+    for (int k = 0; k < 3; k++) {
+      int c = static_cast<int>((p[k] - (node.center[k] - node.half)) * scale);
+      cell[k] = std::min(std::max(c, 0), GRID - 1);
+    }
+    uint32_t key = (static_cast<uint32_t>(cell[2]) * GRID + cell[1]) * GRID + cell[0];
+    int level = node.depth;
+    bool known = level < pathLength && pathNode[level] == index && pathCell[level] == key;
+    bool claimed = !known && claimCell(node, cell);
+    pathNode[level] = index;
+    pathCell[level] = key;
+    if (claimed) {
+      pathLength = level + 1;
+      break;
+    }
+
+    // Cell taken: on to the child octant under the point
+    int octant = (p[0] >= node.center[0] ? 1 : 0) | (p[1] >= node.center[1] ? 2 : 0) |
+                 (p[2] >= node.center[2] ? 4 : 0);
+    if (node.children[octant] < 0) {
+      float half = node.half / 2;
+      float center[3] = {node.center[0] + ((octant & 1) ? half : -half),
+                         node.center[1] + ((octant & 2) ? half : -half),
+                         node.center[2] + ((octant & 4) ? half : -half)};
+      uint8_t depth = static_cast<uint8_t>(node.depth + 1);
+      uint32_t child = addNode(center, half, depth);  // May move 'node'
+      nodes[index].children[octant] = static_cast<int32_t>(child);
+    }
+    index = static_cast<uint32_t>(nodes[index].children[octant]);
+  }
+
+  Node& node = nodes[index];
+  node.positions.insert(node.positions.end(), p, p + 3);
+  node.colors.push_back(color);
+  storedCount++;
+}
+
+// ============================================================================
+// SELECTION
+// ============================================================================
+uint64_t PointOctree::select(const OctreeCamera& camera, float errorPixels, uint64_t pointBudget,
+                             std::vector<uint32_t>& selected) const {
+  selected.clear();
+
+  // Frustum planes (a, b, c, d) from the rows of the view-projection
+  // matrix; inside is a*x + b*y + c*z + d >= 0
+  const float* m = camera.viewProjection;
+  float planes[6][4];
+  for (int p = 0; p < 6; p++) {
+    int row = p / 2;
+    float sign = (p % 2 == 0) ? 1.0f : -1.0f;
+    for (int col = 0; col < 4; col++) {
+      planes[p][col] = m[col * 4 + 3] + sign * m[col * 4 + row];
+    }
+  }
+
+  auto visible = [&](const Node& node) {
+    for (int p = 0; p < 6; p++) {
+      const float* q = planes[p];
+      float distance = q[0] * node.center[0] + q[1] * node.center[1] + q[2] * node.center[2] + q[3];
+      float reach = node.half * (std::fabs(q[0]) + std::fabs(q[1]) + std::fabs(q[2]));
+      if (distance < -reach) return false;
+    }
+    return true;
+  };
+
+  // Node spacing on screen (pixels); a cube the eye is in is infinitely close
+  auto projected = [&](const Node& node) {
+    float dx = node.center[0] - camera.eye[0];
+    float dy = node.center[1] - camera.eye[1];
+    float dz = node.center[2] - camera.eye[2];
+    float distance = std::sqrt(dx * dx + dy * dy + dz * dz) - node.half * 1.7320508f;
+    float spacing = node.half * 2 / GRID;
+    if (distance <= spacing) return 1e30f;
+    return spacing / distance * camera.projectionScale;
+  };
+
+  std::priority_queue<std::pair<float, uint32_t>> queue;
+  if (visible(nodes[0])) queue.push({1e30f, 0});
+
+  uint64_t points = 0;
+  while (!queue.empty()) {
+    uint32_t index = queue.top().second;
+    queue.pop();
+
+    const Node& node = nodes[index];
+    size_t count = node.colors.size();
+    if (points + count > pointBudget) break;
+    points += count;
+    if (count > 0) selected.push_back(index);
+
+    if (projected(node) <= errorPixels) continue;
+    for (int c = 0; c < 8; c++) {
+      if (node.children[c] < 0) continue;
+      const Node& child = nodes[node.children[c]];
+      if (visible(child)) queue.push({projected(child), static_cast<uint32_t>(node.children[c])});
+    }
+  }
+  return points;
+}
+
+OctreeStats PointOctree::stats() const {
+  OctreeStats s;
+  s.inserted = insertedCount;
+  s.outside = outsideCount;
+  s.stored = storedCount;
+  s.nodes = nodes.size();
+  s.bytes = nodes.capacity() * sizeof(Node);
+  for (const Node& node : nodes) {
+    s.bytes += node.positions.capacity() * sizeof(float) +
+               node.colors.capacity() * sizeof(uint32_t) +
+               node.blockKeys.capacity() * sizeof(uint32_t) +
+               node.blockBits.capacity() * sizeof(uint64_t);
+  }
+  return s;
+}
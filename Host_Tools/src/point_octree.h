@@ -0,0 +1,132 @@
+/*
+ * ============================================================================
+ * POINT OCTREE - HEADER FILE
+ * ============================================================================
+ *
+ * Level-of-detail point cloud for the 3D viewer: an octree that takes
+ * points one batch at a time while a scan is running and answers "which
+ * points does this camera need".
+ *
+ * Every node keeps a decimated subset of the points in its cube, at most
+ * one per cell of a GRID^3 grid over the cube (a surface scan fills about
+ * GRID^2 cells, so a node is one draw call of up to some 10^4 points). A new point goes to the
+ * first node, from the root down, whose cell under it is still empty, so
+ * the root holds a coarse sample of the whole cloud and each level adds
+ * detail at twice the resolution of the one above. No point is stored
+ * twice: drawing a node and its ancestors draws every point of that region
+ * down to the node's spacing. Inserting touches one node per level and
+ * never moves a point already stored, so a node only ever grows and the
+ * viewer uploads only what was appended since it last looked.
+ *
+ * SELECTION:
+ * Nodes are visited coarse to fine, largest on screen first. A node is
+ * drawn when its cube is in the view frustum; its children are visited
+ * when its point spacing, projected to the screen, is larger than the
+ * allowed error in pixels. Selection stops at the point budget, so close
+ * to the camera the cloud is at full resolution and far from it a node
+ * stands for its whole region.
+ *
+ * The root cube is fixed when the tree is created (the arm's workspace);
+ * points outside it are counted and left out. Below the depth where the
+ * spacing reaches minSpacing, nodes keep every point.
+ *
+ * Positions are float (mm), colors packed RGBA (R in the low byte), laid
+ * out so a node's arrays can be handed to WebGL as vertex buffers as is.
+ *
+ * ============================================================================
+ */
+
+#ifndef POINT_OCTREE_H
+#define POINT_OCTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Camera for selection. viewProjection is column-major (OpenGL / three.js
+// order), clip z in -w..w. projectionScale converts a size over a distance
+// into pixels: screen height / (2 tan(vertical fov / 2)).
+struct OctreeCamera {
+  float viewProjection[16];
+  float eye[3];
+  float projectionScale;
+};
+
+struct OctreeStats {
+  uint64_t inserted = 0;  // Points offered
+  uint64_t outside = 0;   // Left out: outside the root cube
+  uint64_t stored = 0;
+  size_t nodes = 0;
+  size_t bytes = 0;       // Node arrays and occupied cells
+};
+
+class PointOctree {
+public:
+  static const int GRID = 128;  // Cells per node edge
+
+  // Cube of half size 'halfSize' (mm) around 'center'. Levels are added
+  // until a node's cell is smaller than minSpacing (mm).
+  PointOctree(const float center[3], float halfSize, float minSpacing);
+
+  // Add 'count' points (xyz interleaved) with their colors
+  void insert(const float* positions, const uint32_t* colors, size_t count);
+
+  // Remove every point
+  void clear();
+
+  // Nodes to draw, coarse first. Returns the number of points they hold.
+  uint64_t select(const OctreeCamera& camera, float errorPixels, uint64_t pointBudget,
+                  std::vector<uint32_t>& nodes) const;
+
+  // Node contents (ids from select(); 0 is the root)
+  size_t nodeCount() const { return nodes.size(); }
+  size_t pointCount(uint32_t node) const { return nodes[node].colors.size(); }
+  const float* positions(uint32_t node) const { return nodes[node].positions.data(); }
+  const uint32_t* colors(uint32_t node) const { return nodes[node].colors.data(); }
+  const float* center(uint32_t node) const { return nodes[node].center; }
+  float halfSize(uint32_t node) const { return nodes[node].half; }
+
+  uint64_t stored() const { return storedCount; }
+  uint64_t outside() const { return outsideCount; }
+
+  // Walks every node for the memory figure
+  OctreeStats stats() const;
+
+private:
+  struct Node {
+    float center[3];
+    float half;
+    int32_t children[8];
+    uint8_t depth;
+    std::vector<float> positions;
+    std::vector<uint32_t> colors;
+    // Occupied cells, unused at the deepest level: a hash table of 4x4x4
+    // blocks, each with a 64-bit mask, so a stroke keeps hitting one entry
+    std::vector<uint32_t> blockKeys;
+    std::vector<uint64_t> blockBits;
+    uint32_t blocks;
+  };
+
+  uint32_t addNode(const float center[3], float half, uint8_t depth);
+  void insertOne(const float* p, uint32_t color);
+  static bool claimCell(Node& node, const int cell[3]);
+
+  float rootCenter[3];
+  float rootHalf;
+  uint8_t maxDepth;
+
+  std::vector<Node> nodes;
+
+  // Cells the last point found taken, per level: a stroke of the probe
+  // crosses the same coarse cells point after point
+  static const int MAX_DEPTH = 24;
+  uint32_t pathNode[MAX_DEPTH];
+  uint32_t pathCell[MAX_DEPTH];
+  int pathLength = 0;
+
+  uint64_t insertedCount = 0;
+  uint64_t outsideCount = 0;
+  uint64_t storedCount = 0;
+};
+
+#endif  // POINT_OCTREE_H
@@ -0,0 +1,65 @@
+/*
+ * ============================================================================
+ * RIGID TRANSFORM - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "rigid_transform.h"
+
+#include <cmath>
+#include <cstdlib>
+
+RigidTransform::RigidTransform() {
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) r[i][j] = (i == j) ? 1.0 : 0.0;
+    t[i] = 0.0;
+  }
+}
+
+RigidTransform RigidTransform::fromEulerDeg(double tx, double ty, double tz,
+                                            double rxDeg, double ryDeg, double rzDeg) {
+  const double degToRad = M_PI / 180.0;
+  double cx = cos(rxDeg * degToRad), sx = sin(rxDeg * degToRad);
+  double cy = cos(ryDeg * degToRad), sy = sin(ryDeg * degToRad);
+  double cz = cos(rzDeg * degToRad), sz = sin(rzDeg * degToRad);
+
+  // R = Rz * Ry * Rx
+  RigidTransform m;
+  m.r[0][0] = cz * cy;
+  m.r[0][1] = cz * sy * sx - sz * cx;
+  m.r[0][2] = cz * sy * cx + sz * sx;
+  m.r[1][0] = sz * cy;
+  m.r[1][1] = sz * sy * sx + cz * cx;
+  m.r[1][2] = sz * sy * cx - cz * sx;
+  m.r[2][0] = -sy;
+  m.r[2][1] = cy * sx;
+  m.r[2][2] = cy * cx;
+  m.t[0] = tx;
+  m.t[1] = ty;
+  m.t[2] = tz;
+  return m;
+}
+
+bool RigidTransform::parse(const std::string& text, RigidTransform& out) {
+  double v[6];
+  const char* p = text.c_str();
+  for (int i = 0; i < 6; i++) {
+    while (*p == ' ' || *p == '\t' || *p == ',') p++;
+    char* end;
+    v[i] = strtod(p, &end);
+    if (end == p) return false;
+    p = end;
+  }
+  while (*p == ' ' || *p == '\t' || *p == ',') p++;
+  if (*p != '\0') return false;
+
+  out = fromEulerDeg(v[0], v[1], v[2], v[3], v[4], v[5]);
+  return true;
+}
+
+void RigidTransform::apply(const double in[3], double out[3]) const {
+  double x = in[0], y = in[1], z = in[2];
+  for (int i = 0; i < 3; i++) {
+    out[i] = r[i][0] * x + r[i][1] * y + r[i][2] * z + t[i];
+  }
+}
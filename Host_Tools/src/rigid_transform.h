@@ -0,0 +1,45 @@
+/*
+ * ============================================================================
+ * RIGID TRANSFORM - HEADER FILE
+ * ============================================================================
+ *
+ * Rotation + translation from one arm's base frame to a shared fixture
+ * frame:
+ *
+ *   p_fixture = R * p_arm + t
+ *
+ * R is built from three rotations about the FIXED fixture axes, applied in
+ * the order X, then Y, then Z (R = Rz * Ry * Rx), angles in degrees; t is
+ * in millimeters (the arm's units). An arm whose base sits 1200 mm along X
+ * and faces back towards the origin is "1200 0 0 0 0 180".
+ *
+ * ============================================================================
+ */
+
+#ifndef RIGID_TRANSFORM_H
+#define RIGID_TRANSFORM_H
+
+#include <string>
+
+class RigidTransform {
+public:
+  // Identity
+  RigidTransform();
+
+  // From a translation (mm) and X / Y / Z rotations (degrees)
+  static RigidTransform fromEulerDeg(double tx, double ty, double tz,
+                                     double rxDeg, double ryDeg, double rzDeg);
+
+  // Parse "tx ty tz rx ry rz" (whitespace or comma separated).
+  // Returns false if the text does not hold exactly six numbers.
+  static bool parse(const std::string& text, RigidTransform& out);
+
+  // out = R * in + t (in and out may be the same array)
+  void apply(const double in[3], double out[3]) const;
+
+private:
+  double r[3][3];
+  double t[3];
+};
+
+#endif  // RIGID_TRANSFORM_H
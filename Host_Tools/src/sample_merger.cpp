@@ -0,0 +1,81 @@
+/*
+ * ============================================================================
+ * SAMPLE MERGER - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "sample_merger.h"
+
+#include <limits>
+#include <utility>
+
+SampleMerger::SampleMerger(size_t sources, int64_t maxDelayNs)
+    : maxDelay(maxDelayNs),
+      newest(sources, 0),
+      seen(sources, false),
+      done(sources, false),
+      recovering(sources, false),
+      lateCounts(sources, 0) {}
+
+bool SampleMerger::push(ArmSample&& sample) {
+  size_t source = sample.arm;
+  if (released && sample.hostNs < lastReleasedNs) {
+    lateCounts[source]++;
+    return false;
+  }
+  if (!seen[source] || sample.hostNs > newest[source]) newest[source] = sample.hostNs;
+  seen[source] = true;
+  heap.push(std::move(sample));
+  return true;
+}
+
+void SampleMerger::setSourceDone(size_t source) {
+  done[source] = true;
+  recovering[source] = false;
+}
+
+void SampleMerger::setRecovering(size_t source, bool isRecovering) {
+  recovering[source] = isRecovering && !done[source];
+}
+
+int64_t SampleMerger::releaseDelay() const {
+  for (bool r : recovering) {
+    if (r) return maxDelay + recoveryDelay;
+  }
+  return maxDelay;
+}
+
+// Every connected source has delivered up to here; sources that have not
+// sent anything yet (or are idle) are covered by the maxDelay bound instead
+int64_t SampleMerger::watermark() const {
+  int64_t mark = std::numeric_limits<int64_t>::max();
+  bool any = false;
+  for (size_t i = 0; i < newest.size(); i++) {
+    if (done[i] || !seen[i]) continue;
+    if (newest[i] < mark) mark = newest[i];
+    any = true;
+  }
+  return any ? mark : std::numeric_limits<int64_t>::min();
+}
+
+bool SampleMerger::pop(int64_t nowNs, ArmSample& out) {
+  if (heap.empty()) return false;
+  int64_t oldest = heap.top().hostNs;
+  if (oldest > watermark() && oldest > nowNs - releaseDelay()) return false;
+  return popAny(out);
+}
+
+bool SampleMerger::popAny(ArmSample& out) {
+  if (heap.empty()) return false;
+  // priority_queue::top() is const; the element is discarded right after
+  out = std::move(const_cast<ArmSample&>(heap.top()));
+  heap.pop();
+  released = true;
+  lastReleasedNs = out.hostNs;
+  return true;
+}
+
+int64_t SampleMerger::nextDeadlineNs() const {
+  if (heap.empty()) return std::numeric_limits<int64_t>::max();
+  return heap.top().hostNs + releaseDelay();
+}
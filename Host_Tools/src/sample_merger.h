@@ -0,0 +1,94 @@
+/*
+ * ============================================================================
+ * SAMPLE MERGER - HEADER FILE
+ * ============================================================================
+ *
+ * Merges the sample streams of several arms into one stream ordered by
+ * sample time (host clock, see arm_connection.h).
+ *
+ * Each arm's samples arrive in order, but arms have different link
+ * latencies, so a sample can only be released once no arm can still send
+ * an earlier one. A sample at time T is released when:
+ * - every arm that is still connected has already delivered a sample at
+ *   or after T, or
+ * - T is more than maxDelay in the past (an arm that is idle, or slower
+ *   than maxDelay, does not hold everyone back for longer than that)
+ *
+ * An arm that is recovering lost frames (sequenced streaming, see
+ * frame_tracker.h) delivers them late, together with everything it held
+ * back behind them. While any arm is recovering, maxDelay is extended by
+ * the recovery delay (the RESEND retry budget), so recovered frames are
+ * merged instead of arriving LATE.
+ *
+ * A sample that arrives after a later one has already been released is
+ * LATE: it is dropped and counted, so the output is always in order.
+ * Late samples mean maxDelay is shorter than an arm's link latency.
+ *
+ * ============================================================================
+ */
+
+#ifndef SAMPLE_MERGER_H
+#define SAMPLE_MERGER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+#include "arm_connection.h"
+
+class SampleMerger {
+public:
+  SampleMerger(size_t sources, int64_t maxDelayNs);
+
+  // Add a sample from source sample.arm. Returns false if it was late.
+  bool push(ArmSample&& sample);
+
+  // A source that disconnected no longer holds back the others
+  void setSourceDone(size_t source);
+
+  // A source is recovering lost frames: hold everyone back for up to
+  // maxDelay + recoveryDelayNs instead of maxDelay
+  void setRecoveryDelay(int64_t recoveryDelayNs) { recoveryDelay = recoveryDelayNs; }
+  void setRecovering(size_t source, bool isRecovering);
+
+  // Next sample that can be released as of nowNs (host clock)
+  bool pop(int64_t nowNs, ArmSample& out);
+
+  // Release the oldest held sample regardless of the other sources
+  // (shutdown). Returns false when empty.
+  bool popAny(ArmSample& out);
+
+  // Host time at which the oldest held sample is released at the latest
+  // (INT64_MAX if none is held)
+  int64_t nextDeadlineNs() const;
+
+  size_t held() const { return heap.size(); }
+  uint64_t late(size_t source) const { return lateCounts[source]; }
+  int64_t maxDelayNs() const { return maxDelay; }
+
+private:
+  struct Later {
+    bool operator()(const ArmSample& a, const ArmSample& b) const {
+      if (a.hostNs != b.hostNs) return a.hostNs > b.hostNs;
+      return a.arm > b.arm;
+    }
+  };
+
+  int64_t watermark() const;
+  int64_t releaseDelay() const;
+
+  int64_t maxDelay;
+  int64_t recoveryDelay = 0;
+  std::priority_queue<ArmSample, std::vector<ArmSample>, Later> heap;
+
+  std::vector<int64_t> newest;       // Newest sample time per source
+  std::vector<bool> seen;            // Source has delivered a sample
+  std::vector<bool> done;            // Source disconnected
+  std::vector<bool> recovering;      // Source is recovering lost frames
+  std::vector<uint64_t> lateCounts;
+  bool released = false;
+  int64_t lastReleasedNs = 0;
+};
+
+#endif  // SAMPLE_MERGER_H
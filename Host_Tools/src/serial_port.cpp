@@ -0,0 +1,191 @@
+/*
+ * ============================================================================
+ * SERIAL PORT - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "serial_port.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+int64_t HostClock_NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ============================================================================
+// BAUD RATES
+// ============================================================================
+static bool BaudToSpeed(int baud, speed_t& speed) {
+  switch (baud) {
+    case 9600: speed = B9600; return true;
+    case 19200: speed = B19200; return true;
+    case 38400: speed = B38400; return true;
+    case 57600: speed = B57600; return true;
+    case 115200: speed = B115200; return true;
+    case 230400: speed = B230400; return true;
+#ifdef B460800
+    case 460800: speed = B460800; return true;
+#endif
+#ifdef B500000
+    case 500000: speed = B500000; return true;
+#endif
+#ifdef B1000000
+    case 1000000: speed = B1000000; return true;
+#endif
+#ifdef B2000000
+    case 2000000: speed = B2000000; return true;
+#endif
+    default: return false;
+  }
+}
+
+// ============================================================================
+// OPEN / CLOSE
+// ============================================================================
+SerialPort::~SerialPort() {
+  close();
+}
+
+bool SerialPort::open(const std::string& path, int baud) {
+  close();
+
+  speed_t speed;
+  if (!BaudToSpeed(baud, speed)) {
+    lastError = "Unsupported baud rate: " + std::to_string(baud);
+    return false;
+  }
+
+  fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (fd < 0) {
+    lastError = "Cannot open " + path + ": " + strerror(errno);
+    return false;
+  }
+
+  termios tty;
+  if (tcgetattr(fd, &tty) == 0) {
+    cfmakeraw(&tty);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cflag &= ~CSTOPB;
+#ifdef CRTSCTS
+    tty.c_cflag &= ~CRTSCTS;
+#endif
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;
+    cfsetispeed(&tty, speed);
+    cfsetospeed(&tty, speed);
+    if (tcsetattr(fd, TCSANOW, &tty) != 0) {
+      lastError = "Cannot configure " + path + ": " + strerror(errno);
+      close();
+      return false;
+    }
+  }
+  // (tcgetattr fails on plain files and some pipes - used as-is)
+
+  rxBuffer.clear();
+  scanned = 0;
+  return true;
+}
+
+void SerialPort::close() {
+  if (fd >= 0) ::close(fd);
+  fd = -1;
+}
+
+// ============================================================================
+// WRITE
+// ============================================================================
+bool SerialPort::writeLine(const std::string& line) {
+  std::string out = line + "\n";
+  size_t done = 0;
+  while (done < out.size()) {
+    ssize_t n = ::write(fd, out.data() + done, out.size() - done);
+    if (n < 0) {
+      if (errno == EINTR || errno == EAGAIN) continue;
+      lastError = std::string("Write failed: ") + strerror(errno);
+      return false;
+    }
+    done += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// ============================================================================
+// READ
+// ============================================================================
+bool SerialPort::takeLine(std::string& line) {
+  size_t end = rxBuffer.find('\n', scanned);
+  if (end == std::string::npos) {
+    scanned = rxBuffer.size();
+    return false;
+  }
+
+  size_t length = end;
+  if (length > 0 && rxBuffer[length - 1] == '\r') length--;
+  line.assign(rxBuffer, 0, length);
+  rxBuffer.erase(0, end + 1);
+  scanned = 0;
+  return true;
+}
+
+bool SerialPort::readLine(std::string& line, int64_t& receivedNs, int timeoutMs) {
+  int64_t deadline = timeoutMs < 0 ? -1 : HostClock_NowNs() + timeoutMs * 1000000LL;
+
+  while (true) {
+    // Lines already buffered arrived with the newest read
+    if (takeLine(line)) {
+      receivedNs = lineTimeNs;
+      return true;
+    }
+
+    int waitMs = -1;
+    if (deadline >= 0) {
+      int64_t remaining = deadline - HostClock_NowNs();
+      if (remaining <= 0) return false;
+      waitMs = static_cast<int>((remaining + 999999) / 1000000);
+    }
+
+    pollfd pfd = {fd, POLLIN, 0};
+    int ready = poll(&pfd, 1, waitMs);
+    if (ready < 0) {
+      if (errno == EINTR) continue;
+      lastError = std::string("Poll failed: ") + strerror(errno);
+      return false;
+    }
+    if (ready == 0) return false;
+
+    if (!readAvailable()) return false;
+  }
+}
+
+bool SerialPort::readAvailable() {
+  char chunk[4096];
+  ssize_t n = ::read(fd, chunk, sizeof(chunk));
+  int64_t now = HostClock_NowNs();
+  if (n < 0 && (errno == EINTR || errno == EAGAIN)) return true;
+  if (n < 0 && errno != EIO) {
+    lastError = std::string("Read failed: ") + strerror(errno);
+    return false;
+  }
+  if (n <= 0) {
+    // EOF, or EIO from a pseudo-terminal whose other end went away
+    lastError = "Port closed";
+    return false;
+  }
+  rxBuffer.append(chunk, static_cast<size_t>(n));
+  lineTimeNs = now;
+  return true;
+}
+
+bool SerialPort::nextLine(std::string& line, int64_t& receivedNs) {
+  if (!takeLine(line)) return false;
+  receivedNs = lineTimeNs;
+  return true;
+}
@@ -0,0 +1,65 @@
+/*
+ * ============================================================================
+ * SERIAL PORT - HEADER FILE
+ * ============================================================================
+ *
+ * Line-oriented access to the arm's USB serial port (or a pseudo-terminal)
+ * for host tools. POSIX termios, raw 8N1, no flow control.
+ *
+ * Every received line is stamped with the host monotonic clock
+ * (steady_clock, nanoseconds) at the read() that completed it - the
+ * receive time used by the clock model.
+ *
+ * ============================================================================
+ */
+
+#ifndef SERIAL_PORT_H
+#define SERIAL_PORT_H
+
+#include <cstdint>
+#include <string>
+
+// Host monotonic time in nanoseconds (std::chrono::steady_clock)
+int64_t HostClock_NowNs();
+
+class SerialPort {
+public:
+  SerialPort() = default;
+  ~SerialPort();
+
+  SerialPort(const SerialPort&) = delete;
+  SerialPort& operator=(const SerialPort&) = delete;
+
+  // Open and configure the port. Returns false and sets error().
+  bool open(const std::string& path, int baud = 115200);
+  void close();
+  bool isOpen() const { return fd >= 0; }
+  int descriptor() const { return fd; }
+
+  // Send a command; a '\n' is appended. Blocks until written.
+  bool writeLine(const std::string& line);
+
+  // Next complete line without its line ending. Waits up to timeoutMs
+  // (-1 = forever). Returns false on timeout, end of file or error.
+  bool readLine(std::string& line, int64_t& receivedNs, int timeoutMs);
+
+  // Event-loop use (epoll / poll on descriptor()): read once, without
+  // waiting, whatever has arrived. Returns false on end of file or error.
+  bool readAvailable();
+
+  // Next complete line already read, with its receive time. Never reads.
+  bool nextLine(std::string& line, int64_t& receivedNs);
+
+  const std::string& error() const { return lastError; }
+
+private:
+  bool takeLine(std::string& line);
+
+  int fd = -1;
+  std::string rxBuffer;
+  size_t scanned = 0;      // rxBuffer bytes already searched for '\n'
+  int64_t lineTimeNs = 0;  // receive time of the newest data
+  std::string lastError;
+};
+
+#endif // SERIAL_PORT_H
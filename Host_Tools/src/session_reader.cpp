@@ -0,0 +1,205 @@
+/*
+ * ============================================================================
+ * SESSION READER - IMPLEMENTATION FILE
+ * ============================================================================
+ *
+ * Parsing uses std::from_chars directly on the read buffer - no per-line
+ * std::string, no locale, no allocation once the reader is running.
+ *
+ * ============================================================================
+ */
+
+#include "session_reader.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <initializer_list>
+#include <string_view>
+
+// ============================================================================
+// CONSTRUCTION
+// ============================================================================
+SessionReader::SessionReader(size_t chunkBytes) : buffer(chunkBytes) {}
+
+SessionReader::~SessionReader() {
+  close();
+}
+
+bool SessionReader::open(const std::string& path, SessionUnits units) {
+  close();
+  lastError.clear();
+
+  if (path == "-") {
+    file = stdin;
+    ownsFile = false;
+  } else {
+    file = fopen(path.c_str(), "rb");
+    ownsFile = true;
+  }
+
+  if (file == nullptr) {
+    lastError = "Cannot open " + path + ": " + strerror(errno);
+    return false;
+  }
+
+  finished = false;
+  headerSeen = false;
+  givenUnits = units;
+  fileUnits = units == SESSION_UNITS_UNKNOWN ? SESSION_UNITS_MM : units;
+  head = tail = 0;
+  badLines = 0;
+  return true;
+}
+
+void SessionReader::close() {
+  if (file != nullptr && ownsFile) fclose(file);
+  file = nullptr;
+}
+
+// ============================================================================
+// BUFFER MANAGEMENT
+// ============================================================================
+// Moves the unparsed remainder to the front and tops the buffer up.
+// Returns false at end of file with nothing new read.
+bool SessionReader::fillBuffer() {
+  if (head > 0) {
+    memmove(buffer.data(), buffer.data() + head, tail - head);
+    tail -= head;
+    head = 0;
+  }
+
+  // A single line longer than the whole buffer: grow once
+  if (tail == buffer.size()) buffer.resize(buffer.size() * 2);
+
+  size_t got = fread(buffer.data() + tail, 1, buffer.size() - tail, file);
+  tail += got;
+  return got > 0;
+}
+
+// ============================================================================
+// READ BATCH
+// ============================================================================
+bool SessionReader::readBatch(PointBatch& batch) {
+  batch.clear();
+  if (file == nullptr || finished) return false;
+
+  bool eof = false;
+  while (!batch.full()) {
+    const char* start = buffer.data() + head;
+    const char* end = buffer.data() + tail;
+    const char* newline = static_cast<const char*>(memchr(start, '\n', end - start));
+
+    if (newline == nullptr) {
+      if (!eof) {
+        if (!fillBuffer()) eof = true;
+        continue;
+      }
+      if (head == tail) {
+        finished = true;
+        break;
+      }
+      // Last line without a terminator
+      newline = end;
+    }
+
+    const char* lineEnd = newline;
+    if (lineEnd > start && lineEnd[-1] == '\r') lineEnd--;
+    head = (newline == end) ? tail : static_cast<size_t>(newline - buffer.data()) + 1;
+
+    if (!parseLine(start, lineEnd, batch)) {
+      finished = true;
+      break;
+    }
+  }
+
+  if (fileUnits == SESSION_UNITS_INCHES) {
+    for (std::vector<double>* axis : {&batch.x, &batch.y, &batch.z}) {
+      double* v = axis->data();
+      for (size_t i = 0; i < batch.count; i++) v[i] *= 25.4;
+    }
+  }
+  return batch.count > 0;
+}
+
+// ============================================================================
+// PARSE LINE
+// ============================================================================
+// Returns false when the point section has ended.
+bool SessionReader::parseLine(const char* begin, const char* end, PointBatch& batch) {
+  std::string_view line(begin, end - begin);
+
+  if (line.empty()) return true;
+  if (line.rfind("Geometry Calculations", 0) == 0) return false;
+  if (!headerSeen) {
+    headerSeen = true;
+    if (line.rfind("Point,", 0) == 0) return parseHeader(line);
+  }
+
+  // Split into the 7 expected fields
+  std::string_view fields[7];
+  int count = 0;
+  size_t pos = 0;
+  while (count < 7) {
+    size_t comma = line.find(',', pos);
+    fields[count++] = line.substr(pos, comma == std::string_view::npos ? comma : comma - pos);
+    if (comma == std::string_view::npos) break;
+    pos = comma + 1;
+  }
+
+  if (count < 5) {
+    badLines++;
+    return true;
+  }
+
+  uint64_t number = 0;
+  double x = 0, y = 0, z = 0;
+  int64_t timestamp = 0;
+
+  auto toNumber = [](std::string_view f, auto& out) {
+    auto result = std::from_chars(f.data(), f.data() + f.size(), out);
+    return result.ec == std::errc();
+  };
+
+  if (!toNumber(fields[2], x) || !toNumber(fields[3], y) || !toNumber(fields[4], z)) {
+    badLines++;
+    return true;
+  }
+  if (!toNumber(fields[0], number)) number = 0;
+  if (count > 6 && !fields[6].empty()) toNumber(fields[6], timestamp);
+
+  batch.push(number, PointType_FromName(fields[1]), x, y, z,
+             count > 5 ? fields[5] : std::string_view(), timestamp);
+  return true;
+}
+
+// "X (mm)" / "X (in)" in the third column; a plain "X" leaves the units
+// given to open(). Returns false (and stops reading) on anything else.
+bool SessionReader::parseHeader(std::string_view line) {
+  size_t x = 0;
+  for (int comma = 0; comma < 2 && x != std::string_view::npos; comma++) {
+    x = line.find(',', x);
+    if (x != std::string_view::npos) x++;
+  }
+  if (x == std::string_view::npos) return true;
+  std::string_view column = line.substr(x, line.find(',', x) - x);
+  if (column == "X") return true;
+
+  SessionUnits header;
+  if (column == "X (mm)") {
+    header = SESSION_UNITS_MM;
+  } else if (column == "X (in)") {
+    header = SESSION_UNITS_INCHES;
+  } else {
+    lastError = "Unknown units in the session header: " + std::string(column);
+    return false;
+  }
+  if (givenUnits != SESSION_UNITS_UNKNOWN && givenUnits != header) {
+    lastError = std::string("Session header says ") +
+                (header == SESSION_UNITS_MM ? "mm" : "inches") + ", but " +
+                (givenUnits == SESSION_UNITS_MM ? "mm" : "inches") + " were given";
+    return false;
+  }
+  fileUnits = header;
+  return true;
+}
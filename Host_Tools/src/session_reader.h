@@ -0,0 +1,86 @@
+/*
+ * ============================================================================
+ * SESSION READER - HEADER FILE
+ * ============================================================================
+ *
+ * Streams points out of a session CSV written by the desktop app
+ * (CSVExporter.generateCSV):
+ *
+ *   Point,Type,X (mm),Y (mm),Z (mm),GeometryID,Timestamp
+ *   1,BOUNDARY,12.345,67.890,-1.234,,1732100000000
+ *   ...
+ *   <blank line>
+ *   Geometry Calculations        <- reading stops here
+ *
+ * The file is read in large chunks and parsed in place, so only one chunk
+ * and one PointBatch are ever held in memory.
+ *
+ * UNITS:
+ * Points always come out in mm. The app names the unit in the header
+ * ("X (mm)" or "X (in)"); inch sessions are converted. Older sessions have
+ * a plain "X" header and no way to tell: they are read in the units given
+ * to open() (mm unless told otherwise). A header unit that is not mm or
+ * in, or one that contradicts the units given to open(), is an error.
+ *
+ * ============================================================================
+ */
+
+#ifndef SESSION_READER_H
+#define SESSION_READER_H
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "point_batch.h"
+
+enum SessionUnits {
+  SESSION_UNITS_UNKNOWN = 0,  // From the header; mm for an older file
+  SESSION_UNITS_MM      = 1,
+  SESSION_UNITS_INCHES  = 2
+};
+
+class SessionReader {
+public:
+  explicit SessionReader(size_t chunkBytes = 1 << 20);
+  ~SessionReader();
+
+  SessionReader(const SessionReader&) = delete;
+  SessionReader& operator=(const SessionReader&) = delete;
+
+  // Open a session CSV ("-" reads stdin). Returns false and sets error().
+  // 'units' is what the file is known to be in (see UNITS above).
+  bool open(const std::string& path, SessionUnits units = SESSION_UNITS_UNKNOWN);
+  void close();
+
+  // Fill the batch with up to batch.capacity() points (mm).
+  // Returns false once the point section is exhausted, or on an error.
+  bool readBatch(PointBatch& batch);
+
+  // Units the file turned out to be in, once the header has been read
+  SessionUnits units() const { return fileUnits; }
+  const std::string& error() const { return lastError; }
+  size_t skippedLines() const { return badLines; }
+
+private:
+  bool fillBuffer();
+  bool parseLine(const char* begin, const char* end, PointBatch& batch);
+  bool parseHeader(std::string_view line);
+
+  FILE* file = nullptr;
+  bool ownsFile = false;
+  bool finished = false;
+  bool headerSeen = false;
+  SessionUnits givenUnits = SESSION_UNITS_UNKNOWN;
+  SessionUnits fileUnits = SESSION_UNITS_UNKNOWN;
+
+  std::vector<char> buffer;
+  size_t head = 0;  // first unparsed byte
+  size_t tail = 0;  // one past last valid byte
+
+  size_t badLines = 0;
+  std::string lastError;
+};
+
+#endif // SESSION_READER_H
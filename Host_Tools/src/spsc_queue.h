@@ -0,0 +1,87 @@
+/*
+ * ============================================================================
+ * SPSC QUEUE - HEADER FILE
+ * ============================================================================
+ *
+ * Bounded lock-free queue between exactly one producer thread and one
+ * consumer thread.
+ *
+ * A power-of-two ring of slots with two counters: the producer owns 'tail',
+ * the consumer owns 'head', and each only reads the other's. An item is
+ * written before tail is published (release) and read after tail is seen
+ * (acquire), and the same the other way round for freeing a slot, so no
+ * lock and no compare-and-swap is needed. The counters sit on their own
+ * cache lines, and each side keeps a cached copy of the other's counter so
+ * it only touches the shared line when the queue looks full or empty.
+ *
+ * tryPush() / tryPop() never wait; what to do when the queue is full or
+ * empty (wait, drop, do something else) is up to the caller.
+ *
+ * ============================================================================
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class SpscQueue {
+public:
+  // capacity is rounded up to a power of two
+  explicit SpscQueue(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size *= 2;
+    slots.resize(size);
+    mask = size - 1;
+  }
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // Producer only. Returns false (item untouched) when full.
+  bool tryPush(T& item) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - headCache == slots.size()) {
+      headCache = head.load(std::memory_order_acquire);
+      if (t - headCache == slots.size()) return false;
+    }
+    slots[t & mask] = std::move(item);
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only. Returns false when empty.
+  bool tryPop(T& item) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tailCache) {
+      tailCache = tail.load(std::memory_order_acquire);
+      if (h == tailCache) return false;
+    }
+    item = std::move(slots[h & mask]);
+    slots[h & mask] = T();  // Release what the slot held now, not on reuse
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Either side (approximate while the other side is running)
+  size_t size() const {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+  }
+  size_t capacity() const { return slots.size(); }
+
+private:
+  std::vector<T> slots;
+  size_t mask;
+
+  alignas(64) std::atomic<size_t> head{0};  // Next slot to read (consumer)
+  size_t tailCache = 0;                     // Consumer's copy of tail
+  alignas(64) std::atomic<size_t> tail{0};  // Next slot to write (producer)
+  size_t headCache = 0;                     // Producer's copy of head
+  char padding[64 - sizeof(size_t)];
+};
+
+#endif  // SPSC_QUEUE_H
@@ -0,0 +1,243 @@
+/*
+ * ============================================================================
+ * UNCERTAINTY - IMPLEMENTATION FILE
+ * ============================================================================
+ */
+
+#include "uncertainty.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+static const double DEG_TO_RAD = M_PI / 180.0;
+
+bool ArmModel_ParseJoints(const std::string& text, ArmModel& model) {
+  std::string spaced(text);
+  std::replace(spaced.begin(), spaced.end(), ',', ' ');
+  std::istringstream fields(spaced);
+
+  std::string name;
+  int axes = 0;
+  while (fields >> name) {
+    if (axes == UNCERTAINTY_MAX_AXES) return false;
+    if (name == "yaw") model.jointTypes[axes] = JOINT_TYPE_YAW;
+    else if (name == "pitch") model.jointTypes[axes] = JOINT_TYPE_PITCH;
+    else if (name == "roll") model.jointTypes[axes] = JOINT_TYPE_ROLL;
+    else return false;
+    axes++;
+  }
+  if (axes == 0) return false;
+  model.axes = axes;
+  return true;
+}
+
+bool ArmModel_ParseNumbers(const std::string& text, double* out, int count) {
+  const char* p = text.c_str();
+  for (int i = 0; i < count; i++) {
+    while (*p == ' ' || *p == '\t' || *p == ',') p++;
+    char* end;
+    out[i] = strtod(p, &end);
+    if (end == p) return false;
+    p = end;
+  }
+  while (*p == ' ' || *p == '\t' || *p == ',') p++;
+  return *p == '\0';
+}
+
+void PointCovariance::resize(size_t count) {
+  xx.resize(count);
+  xy.resize(count);
+  xz.resize(count);
+  yy.resize(count);
+  yz.resize(count);
+  zz.resize(count);
+}
+
+double PointCovariance::rms(size_t i) const {
+  return std::sqrt((xx[i] + yy[i] + zz[i]) / 3.0);
+}
+
+UncertaintyEngine::UncertaintyEngine(const ArmModel& model, const UncertaintyInputs& inputs)
+    : arm(model) {
+  double step = 2 * M_PI / static_cast<double>(std::max(1L, inputs.countsPerRevolution));
+  double extra = inputs.jointSigmaDeg * DEG_TO_RAD;
+  jointVariance = step * step / 12.0 + extra * extra;
+  linkVariance = inputs.linkSigmaMm * inputs.linkSigmaMm;
+  toolVariance = inputs.toolSigmaMm * inputs.toolSigmaMm;
+}
+
+// ============================================================================
+// FORWARD MODEL (one point, as Kinematics_Calculate)
+// ============================================================================
+void UncertaintyEngine::position(const double* anglesDeg, double out[3]) const {
+  double ax[3] = {1, 0, 0}, ay[3] = {0, 1, 0}, az[3] = {0, 0, 1};
+  double p[3] = {0, 0, 0}, tool[3] = {0, 0, 0};
+
+  auto rotate = [](double* a, double* b, double c, double s) {
+    for (int k = 0; k < 3; k++) {
+      double ak = a[k];
+      a[k] = c * ak + s * b[k];
+      b[k] = c * b[k] - s * ak;
+    }
+  };
+
+  for (int i = 0; i < arm.axes; i++) {
+    double theta = anglesDeg[i] * DEG_TO_RAD;
+    double c = cos(theta), s = sin(theta);
+    switch (arm.jointTypes[i]) {
+      case JOINT_TYPE_YAW:   rotate(ax, ay, c, s); break;
+      case JOINT_TYPE_PITCH: rotate(ax, az, c, s); break;
+      case JOINT_TYPE_ROLL:  rotate(ay, az, c, s); break;
+    }
+    if (i > 0) {
+      for (int k = 0; k < 3; k++) p[k] += arm.linkLengths[i - 1] * ax[k];
+    } else {
+      for (int k = 0; k < 3; k++) {
+        tool[k] = arm.toolOffset[0] * ax[k] + arm.toolOffset[1] * ay[k] + arm.toolOffset[2] * az[k];
+      }
+    }
+  }
+  for (int k = 0; k < 3; k++) out[k] = p[k] + arm.linkLengths[arm.axes - 1] * ax[k] + tool[k];
+}
+
+// ============================================================================
+// PROPAGATION (blocks of points)
+// ============================================================================
+void UncertaintyEngine::propagate(const double* anglesDeg, size_t stride, size_t count,
+                                  PointCovariance& out, size_t offset) const {
+  if (out.size() < offset + count) out.resize(offset + count);
+  for (size_t start = 0; start < count; start += BLOCK_POINTS) {
+    size_t n = std::min(BLOCK_POINTS, count - start);
+    propagateBlock(anglesDeg + start, stride, n, out, offset + start);
+  }
+}
+
+void UncertaintyEngine::propagateBlock(const double* anglesDeg, size_t stride, size_t n,
+                                       PointCovariance& out, size_t offset) const {
+  const size_t B = BLOCK_POINTS;
+  const int axes = arm.axes;
+
+  // Current frame (X, Y, Z directions) and chain position, per point
+  double frame[3][3][B];
+  double p[3][B];
+  double tool[3][B];
+  double cs[2][B];
+  // Per joint: its position, its rotation axis, and the frame's X after it
+  double origin[UNCERTAINTY_MAX_AXES][3][B];
+  double spin[UNCERTAINTY_MAX_AXES][3][B];
+  double xAfter[UNCERTAINTY_MAX_AXES][3][B];
+
+  for (int a = 0; a < 3; a++) {
+    for (int k = 0; k < 3; k++) {
+      for (size_t b = 0; b < n; b++) frame[a][k][b] = (a == k) ? 1.0 : 0.0;
+    }
+    for (size_t b = 0; b < n; b++) p[a][b] = 0;
+  }
+
+  // --------------------------------------------------------------------------
+  // Walk the chain
+  // --------------------------------------------------------------------------
+  for (int i = 0; i < axes; i++) {
+    const double* theta = anglesDeg + i * stride;
+    for (size_t b = 0; b < n; b++) {
+      double radians = theta[b] * DEG_TO_RAD;
+      cs[0][b] = cos(radians);
+      cs[1][b] = sin(radians);
+    }
+
+    // Rotate axes (first, second) into each other; the third is the
+    // rotation axis, with the sign that makes the rotation positive
+    int first, second, axis;
+    double sign;
+    switch (arm.jointTypes[i]) {
+      case JOINT_TYPE_PITCH: first = 0; second = 2; axis = 1; sign = -1; break;
+      case JOINT_TYPE_ROLL:  first = 1; second = 2; axis = 0; sign = 1; break;
+      default:               first = 0; second = 1; axis = 2; sign = 1; break;
+    }
+    for (int k = 0; k < 3; k++) {
+      double* fa = frame[first][k];
+      double* fb = frame[second][k];
+      for (size_t b = 0; b < n; b++) {
+        double ak = fa[b];
+        fa[b] = cs[0][b] * ak + cs[1][b] * fb[b];
+        fb[b] = cs[0][b] * fb[b] - cs[1][b] * ak;
+      }
+      const double* fr = frame[axis][k];
+      for (size_t b = 0; b < n; b++) {
+        spin[i][k][b] = sign * fr[b];
+        origin[i][k][b] = p[k][b];
+        xAfter[i][k][b] = frame[0][k][b];
+      }
+    }
+
+    if (i > 0) {
+      double length = arm.linkLengths[i - 1];
+      for (int k = 0; k < 3; k++) {
+        for (size_t b = 0; b < n; b++) p[k][b] += length * frame[0][k][b];
+      }
+    } else {
+      for (int k = 0; k < 3; k++) {
+        for (size_t b = 0; b < n; b++) {
+          tool[k][b] = arm.toolOffset[0] * frame[0][k][b] + arm.toolOffset[1] * frame[1][k][b] +
+                       arm.toolOffset[2] * frame[2][k][b];
+        }
+      }
+    }
+  }
+  double last = arm.linkLengths[axes - 1];
+  for (int k = 0; k < 3; k++) {
+    for (size_t b = 0; b < n; b++) p[k][b] += last * frame[0][k][b];
+  }
+
+  // --------------------------------------------------------------------------
+  // Accumulate sigma^2 * j * j^T
+  // --------------------------------------------------------------------------
+  double* xx = out.xx.data() + offset;
+  double* xy = out.xy.data() + offset;
+  double* xz = out.xz.data() + offset;
+  double* yy = out.yy.data() + offset;
+  double* yz = out.yz.data() + offset;
+  double* zz = out.zz.data() + offset;
+
+  // Tool offset: R * sigma^2 I * R^T = sigma^2 I
+  for (size_t b = 0; b < n; b++) {
+    xx[b] = yy[b] = zz[b] = toolVariance;
+    xy[b] = xz[b] = yz[b] = 0;
+  }
+
+  for (int i = 0; i < axes; i++) {
+    bool withTool = (i == 0);
+    for (size_t b = 0; b < n; b++) {
+      double rx = p[0][b] - origin[i][0][b] + (withTool ? tool[0][b] : 0);
+      double ry = p[1][b] - origin[i][1][b] + (withTool ? tool[1][b] : 0);
+      double rz = p[2][b] - origin[i][2][b] + (withTool ? tool[2][b] : 0);
+      double wx = spin[i][0][b], wy = spin[i][1][b], wz = spin[i][2][b];
+      double jx = wy * rz - wz * ry;
+      double jy = wz * rx - wx * rz;
+      double jz = wx * ry - wy * rx;
+      xx[b] += jointVariance * jx * jx;
+      xy[b] += jointVariance * jx * jy;
+      xz[b] += jointVariance * jx * jz;
+      yy[b] += jointVariance * jy * jy;
+      yz[b] += jointVariance * jy * jz;
+      zz[b] += jointVariance * jz * jz;
+    }
+  }
+
+  if (linkVariance > 0) {
+    for (int link = 0; link < axes; link++) {
+      const double (*d)[B] = xAfter[std::min(link + 1, axes - 1)];
+      for (size_t b = 0; b < n; b++) {
+        xx[b] += linkVariance * d[0][b] * d[0][b];
+        xy[b] += linkVariance * d[0][b] * d[1][b];
+        xz[b] += linkVariance * d[0][b] * d[2][b];
+        yy[b] += linkVariance * d[1][b] * d[1][b];
+        yz[b] += linkVariance * d[1][b] * d[2][b];
+        zz[b] += linkVariance * d[2][b] * d[2][b];
+      }
+    }
+  }
+}
@@ -0,0 +1,114 @@
+/*
+ * ============================================================================
+ * UNCERTAINTY - HEADER FILE
+ * ============================================================================
+ *
+ * Per-point measurement uncertainty: the 3x3 covariance of the tip position
+ * from the joint angles, propagated through the firmware's forward model
+ * (Kinematics_Calculate, double precision here).
+ *
+ *   C = sum over inputs k of sigma_k^2 * j_k * j_k^T
+ *
+ * j_k is the Jacobian column of input k, taken analytically:
+ *
+ * - Joint i:       w_i x (p - o_i), with w_i the joint's rotation axis and
+ *                  o_i its position in base coordinates (p includes the
+ *                  tool offset only for joint 1, the only joint it turns
+ *                  with)
+ * - Link k:        the X direction of the frame that link runs along
+ * - Tool offset:   the X, Y, Z directions of the frame after joint 1
+ *
+ * Inputs are independent, so their covariances are diagonal:
+ * - Encoder quantization: one count is 2 pi / COUNTS_PER_REVOLUTION rad,
+ *   uniformly distributed, sigma = step / sqrt(12); plus any extra joint
+ *   sigma (backlash, shaft play)
+ * - Link-length and tool-offset tolerances, as 1-sigma in mm
+ *
+ * Points are processed in blocks of BLOCK_POINTS, each step of the chain
+ * a loop over the whole block on structure-of-arrays scratch, so the
+ * compiler can vectorize everything except sin / cos.
+ *
+ * ============================================================================
+ */
+
+#ifndef UNCERTAINTY_H
+#define UNCERTAINTY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+static const int UNCERTAINTY_MAX_AXES = 8;
+
+// Same codes as JOINT_YAW / JOINT_PITCH / JOINT_ROLL in kinematics.h
+enum JointType : uint8_t {
+  JOINT_TYPE_YAW   = 0,
+  JOINT_TYPE_PITCH = 1,
+  JOINT_TYPE_ROLL  = 2
+};
+
+// The firmware's kinematic model (config.h and any SETDIM / SETTOOL)
+struct ArmModel {
+  int axes = 4;
+  uint8_t jointTypes[UNCERTAINTY_MAX_AXES] = {JOINT_TYPE_YAW, JOINT_TYPE_PITCH,
+                                              JOINT_TYPE_PITCH, JOINT_TYPE_PITCH};
+  double linkLengths[UNCERTAINTY_MAX_AXES] = {254.0, 254.0, 254.0, 35.0};
+  double toolOffset[3] = {0, 0, 0};
+};
+
+// Parse "yaw pitch pitch pitch" (sets axes) or link lengths / tool offset
+// (whitespace or comma separated). Return false on anything else.
+bool ArmModel_ParseJoints(const std::string& text, ArmModel& model);
+bool ArmModel_ParseNumbers(const std::string& text, double* out, int count);
+
+struct UncertaintyInputs {
+  long countsPerRevolution = 2400;  // COUNTS_PER_REVOLUTION
+  double jointSigmaDeg = 0;         // Extra per joint, on top of quantization
+  double linkSigmaMm = 0;           // Per link length
+  double toolSigmaMm = 0;           // Per tool offset component
+};
+
+// Six unique covariance entries per point (mm^2), one array each
+struct PointCovariance {
+  std::vector<double> xx, xy, xz, yy, yz, zz;
+
+  void resize(size_t count);
+  size_t size() const { return xx.size(); }
+
+  // Variance along a unit direction: d^T C d
+  double along(size_t i, const double d[3]) const {
+    return d[0] * d[0] * xx[i] + d[1] * d[1] * yy[i] + d[2] * d[2] * zz[i] +
+           2 * (d[0] * d[1] * xy[i] + d[0] * d[2] * xz[i] + d[1] * d[2] * yz[i]);
+  }
+
+  // RMS of the three standard deviations (mm)
+  double rms(size_t i) const;
+};
+
+class UncertaintyEngine {
+public:
+  static const size_t BLOCK_POINTS = 64;
+
+  UncertaintyEngine(const ArmModel& model, const UncertaintyInputs& inputs);
+
+  // Covariance of 'count' points into out[offset ...]. Angles are in
+  // degrees, as sent in POS lines: anglesDeg[axis * stride + i].
+  void propagate(const double* anglesDeg, size_t stride, size_t count, PointCovariance& out,
+                 size_t offset = 0) const;
+
+  // Tip position from the model (no origin offset), for checking the
+  // model against the firmware's x,y,z
+  void position(const double* anglesDeg, double out[3]) const;
+
+private:
+  void propagateBlock(const double* anglesDeg, size_t stride, size_t count,
+                      PointCovariance& out, size_t offset) const;
+
+  ArmModel arm;
+  double jointVariance;     // rad^2
+  double linkVariance;      // mm^2
+  double toolVariance;      // mm^2
+};
+
+#endif  // UNCERTAINTY_H
@@ -0,0 +1,160 @@
+/*
+ * ============================================================================
+ * CHECK_ENCODER_BACKENDS - Encoder backends against the host HAL
+ * ============================================================================
+ *
+ * Drives the firmware's encoder backend (encoder*.cpp, built for the host
+ * with the HAL) through quadrature edges on the pins or the SPI mocks, and
+ * checks the counts it reports:
+ *
+ * - ISR       Every axis counts edges both ways, including axes on pin
+ *               change interrupt pins
+ * - LS7366R   A counter moved down through zero reads as a negative count
+ *               (two's complement 32-bit), and back up again
+ * - SSI, BiSS A joint moved through the encoder's 0/max point keeps a
+ *               continuous count in both directions
+ * - BiSS      An encoder that fails every read at power-up is seeded by its
+ *               first good reading later, not unwrapped from 0
+ *
+ * The backend is chosen at compile time, so build once per backend. Exit
+ * status is 0 when every check passes, 1 otherwise.
+ *
+ * ============================================================================
+ */
+
+#include <stdio.h>
+
+#include "encoder.h"
+#include "hal_control.h"
+#include "mock_spi_devices.h"
+
+static int failures = 0;
+
+static long ReadCount(uint8_t axis) {
+  long counts[NUM_AXES];
+  Encoder_GetCounts(counts);
+  return counts[axis];
+}
+
+static void Expect(const char* what, long got, long expected) {
+  if (got == expected) return;
+  fprintf(stderr, "FAIL,%s: got %ld, expected %ld\n", what, got, expected);
+  failures++;
+}
+
+#if ENCODER_BACKEND == ENCODER_BACKEND_ISR
+
+static const uint8_t pinsA[] = ENCODER_PINS_A;
+static const uint8_t pinsB[] = ENCODER_PINS_B;
+
+// A/B levels by count modulo 4, counting up (as in ccm_armsim)
+static const uint8_t QUAD_A[4] = { HIGH, HIGH, LOW, LOW };
+static const uint8_t QUAD_B[4] = { HIGH, LOW, LOW, HIGH };
+
+static void MoveTo(uint8_t axis, long from, long to) {
+  for (long count = from; count != to;) {
+    count += to > from ? 1 : -1;
+    int state = (int)(((count % 4) + 4) % 4);
+    Hal_SetPin(pinsA[axis], QUAD_A[state]);
+    Hal_SetPin(pinsB[axis], QUAD_B[state]);
+  }
+}
+
+static void CheckBackend() {
+  Encoder_Init();
+
+  char what[32];
+  for (uint8_t i = 0; i < NUM_AXES; i++) {
+    MoveTo(i, 0, 10 + i);
+    snprintf(what, sizeof(what), "axis %d forward", i + 1);
+    Expect(what, ReadCount(i), 10 + i);
+    MoveTo(i, 10 + i, -25);
+    snprintf(what, sizeof(what), "axis %d back", i + 1);
+    Expect(what, ReadCount(i), -25);
+  }
+}
+
+#elif ENCODER_BACKEND == ENCODER_BACKEND_LS7366R
+
+static const uint8_t csPins[] = ENCODER_SPI_CS_PINS;
+
+static void CheckBackend() {
+  static MockLS7366R counters[NUM_AXES];
+  for (int i = 0; i < NUM_AXES; i++) Hal_AttachSpiDevice(csPins[i], &counters[i]);
+  Encoder_Init();
+
+  Expect("start", ReadCount(0), 0);
+  counters[0].addCounts(3);
+  Expect("up", ReadCount(0), 3);
+  counters[0].addCounts(-10);  // Through zero
+  Expect("down through zero", ReadCount(0), -7);
+  counters[0].addCounts(-100000);
+  Expect("far below zero", ReadCount(0), -100007);
+  counters[0].addCounts(100017);
+  Expect("back up through zero", ReadCount(0), 10);
+  Expect("other axis", ReadCount(1), 0);
+}
+
+#else  // SSI / BiSS
+
+static const uint8_t csPins[] = ENCODER_SPI_CS_PINS;
+static const long TURN = 1L << ENCODER_ABS_BITS;
+
+#if ENCODER_BACKEND == ENCODER_BACKEND_BISS
+typedef MockBissEncoder MockAbsolute;
+static MockAbsolute* NewEncoder() { return new MockBissEncoder(ENCODER_ABS_BITS); }
+#else
+typedef MockSsiEncoder MockAbsolute;
+static MockAbsolute* NewEncoder() { return new MockSsiEncoder(ENCODER_ABS_BITS, ENCODER_SSI_GRAY_CODE); }
+#endif
+
+// Move in steps well under half a turn, as a joint does between reads
+static void MoveTo(MockAbsolute* encoder, uint8_t axis, long from, long to) {
+  long step = to > from ? TURN / 8 : -TURN / 8;
+  for (long at = from; at != to;) {
+    at = (to - at) / step > 0 ? at + step : to;
+    encoder->position = (uint32_t)(((at % TURN) + TURN) % TURN);
+    ReadCount(axis);
+  }
+}
+
+static void CheckBackend() {
+  MockAbsolute* encoders[NUM_AXES];
+  for (int i = 0; i < NUM_AXES; i++) {
+    encoders[i] = NewEncoder();
+    Hal_AttachSpiDevice(csPins[i], encoders[i]);
+  }
+
+  // Powered up just below the 0/max point: the reading is the position
+  encoders[0]->position = TURN - 3;
+  Encoder_Init();
+  Expect("power-up position", ReadCount(0), TURN - 3);
+
+  MoveTo(encoders[0], 0, TURN - 3, TURN + 5);
+  Expect("forward through 0/max", ReadCount(0), TURN + 5);
+  MoveTo(encoders[0], 0, TURN + 5, -TURN / 2);
+  Expect("back through 0/max twice", ReadCount(0), -TURN / 2);
+  MoveTo(encoders[0], 0, -TURN / 2, 2 * TURN + 1);
+  Expect("forward two turns", ReadCount(0), 2 * TURN + 1);
+
+#if ENCODER_BACKEND == ENCODER_BACKEND_BISS
+  // No good frame at power-up: the axis must not be unwrapped from 0
+  encoders[1]->position = TURN - 3;
+  encoders[1]->corruptCrc = true;
+  unsigned long errorsBefore = Encoder_GetReadErrors();
+  Encoder_Init();
+  Expect("power-up read errors counted", Encoder_GetReadErrors() > errorsBefore, 1);
+  encoders[1]->corruptCrc = false;
+  Expect("seeded by first good read", ReadCount(1), TURN - 3);
+  MoveTo(encoders[1], 1, TURN - 3, TURN + 2);
+  Expect("unseeded axis through 0/max", ReadCount(1), TURN + 2);
+#endif
+}
+
+#endif
+
+int main() {
+  CheckBackend();
+  printf("%s,%s\n", Encoder_GetBackendName(), failures == 0 ? "PASS" : "FAIL");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+/*
+ * ============================================================================
+ * CHECK_GEOMETRY_FIT - Plane and line fits on exact data
+ * ============================================================================
+ *
+ * Points that lie exactly on a plane or a line must be fitted exactly by
+ * Geometry_FitPlane / Geometry_FitLine (src/geometry_fit.h), weighted or
+ * not:
+ *
+ * - Planar points (flat z = 5, and a tilted plane): normal within 1e-9 of
+ *   the true one (either sign), residual below 1e-9 mm
+ * - Collinear points: line direction within 1e-9, residual below 1e-9 mm,
+ *   and the plane fit refuses them
+ * - Coincident points: both fits refuse them
+ *
+ * Exit status is 0 when every check passes, 1 otherwise.
+ *
+ * ============================================================================
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "../src/geometry_fit.h"
+
+static const double TOLERANCE = 1e-9;
+
+static int failures = 0;
+
+static void Expect(const char* what, bool ok) {
+  if (ok) return;
+  fprintf(stderr, "FAIL,%s\n", what);
+  failures++;
+}
+
+// |a . b| for unit vectors: 1 when parallel either way round
+static bool Parallel(const double a[3], const double b[3]) {
+  double dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  return std::fabs(std::fabs(dot) - 1) < TOLERANCE;
+}
+
+struct Points {
+  std::vector<double> x, y, z, w;
+
+  void add(double px, double py, double pz) {
+    x.push_back(px);
+    y.push_back(py);
+    z.push_back(pz);
+    w.push_back(0.5 + (x.size() % 7) * 0.25);  // Uneven weights
+  }
+  size_t size() const { return x.size(); }
+};
+
+static void CheckPlane(const char* name, const Points& p, const double normal[3]) {
+  const double* weightings[] = {nullptr, p.w.data()};
+  for (const double* weights : weightings) {
+    PlaneFit fit;
+    bool ok = Geometry_FitPlane(p.x.data(), p.y.data(), p.z.data(), p.size(), fit, weights);
+    Expect(name, ok && Parallel(fit.normal, normal) && fit.residual < TOLERANCE);
+    if (failures > 0 && ok) {
+      fprintf(stderr, "INFO,%s: normal %.12f %.12f %.12f, residual %.3g mm\n", name,
+              fit.normal[0], fit.normal[1], fit.normal[2], fit.residual);
+    }
+  }
+}
+
+int main() {
+  // Flat z = 5 over a skewed patch
+  {
+    Points p;
+    for (int i = 0; i < 40; i++) p.add(100 + 7.3 * (i % 8) + 0.9 * i, -40 + 3.1 * (i / 8), 5);
+    double normal[3] = {0, 0, 1};
+    CheckPlane("flat z=5", p, normal);
+  }
+
+  // Tilted plane through (10, 20, 30), normal (1, -2, 2) / 3
+  {
+    Points p;
+    double n[3] = {1.0 / 3, -2.0 / 3, 2.0 / 3};
+    double u[3] = {2.0 / 3, 2.0 / 3, 1.0 / 3};   // In the plane
+    double v[3] = {-2.0 / 3, 1.0 / 3, 2.0 / 3};  // In the plane
+    for (int i = 0; i < 50; i++) {
+      double a = 13.0 * std::sin(i * 0.7), b = 9.0 * std::cos(i * 1.3) + i * 0.2;
+      p.add(10 + a * u[0] + b * v[0], 20 + a * u[1] + b * v[1], 30 + a * u[2] + b * v[2]);
+    }
+    CheckPlane("tilted", p, n);
+  }
+
+  // Collinear: along (3, 4, 12) / 13 from (-5, 7, 2)
+  {
+    Points p;
+    double d[3] = {3.0 / 13, 4.0 / 13, 12.0 / 13};
+    for (int i = 0; i < 30; i++) {
+      double t = -60 + 4.1 * i + (i % 3) * 0.7;
+      p.add(-5 + t * d[0], 7 + t * d[1], 2 + t * d[2]);
+    }
+    const double* weightings[] = {nullptr, p.w.data()};
+    for (const double* weights : weightings) {
+      LineFit line;
+      bool ok = Geometry_FitLine(p.x.data(), p.y.data(), p.z.data(), p.size(), line, weights);
+      Expect("line through collinear points",
+             ok && Parallel(line.direction, d) && line.residual < TOLERANCE);
+
+      PlaneFit plane;
+      Expect("plane refuses collinear points",
+             !Geometry_FitPlane(p.x.data(), p.y.data(), p.z.data(), p.size(), plane, weights));
+    }
+  }
+
+  // Coincident
+  {
+    Points p;
+    for (int i = 0; i < 5; i++) p.add(1, 2, 3);
+    PlaneFit plane;
+    LineFit line;
+    Expect("plane refuses coincident points",
+           !Geometry_FitPlane(p.x.data(), p.y.data(), p.z.data(), p.size(), plane));
+    Expect("line refuses coincident points",
+           !Geometry_FitLine(p.x.data(), p.y.data(), p.z.data(), p.size(), line));
+  }
+
+  printf("geometry_fit,%s\n", failures == 0 ? "PASS" : "FAIL");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+/*
+ * ============================================================================
+ * CHECK_LINE_RING - Byte stream of a ring reader stays line-aligned
+ * ============================================================================
+ *
+ * Plays a socket that takes only a few bytes per write against
+ * RingReader (src/line_ring.h) and checks what it received:
+ *
+ * - A private line queued while a ring line is half sent comes after
+ *   that line, not inside it
+ * - The same when the reader is then lapped, so the rest of the line
+ *   comes from the reader's private copy
+ * - Every line arrives whole, in order, and the counters add up
+ *
+ * Exit status is 0 when every check passes, 1 otherwise.
+ *
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../src/line_ring.h"
+
+static int failures = 0;
+
+static void Expect(const char* what, bool ok) {
+  if (ok) return;
+  fprintf(stderr, "FAIL,%s\n", what);
+  failures++;
+}
+
+static void Push(LineRing& ring, std::vector<RingReader*> readers, const std::string& line) {
+  for (RingReader* r : readers) r->beforeOverwrite();
+  ring.push(line.data(), line.size(), false);
+}
+
+// One write of at most 'limit' bytes, as a socket with a full buffer takes it
+static void Write(RingReader& reader, size_t limit, std::string& received) {
+  struct iovec iov[16];
+  int n = reader.gather(iov, 16);
+  size_t taken = 0;
+  for (int i = 0; i < n && taken < limit; i++) {
+    size_t take = std::min(limit - taken, iov[i].iov_len);
+    received.append(static_cast<const char*>(iov[i].iov_base), take);
+    taken += take;
+  }
+  reader.consumed(taken);
+}
+
+static void Drain(RingReader& reader, std::string& received) {
+  while (reader.pending()) Write(reader, 1 << 20, received);
+}
+
+static std::vector<std::string> Lines(const std::string& text) {
+  std::vector<std::string> lines;
+  size_t start = 0, newline;
+  while ((newline = text.find('\n', start)) != std::string::npos) {
+    lines.push_back(text.substr(start, newline - start));
+    start = newline + 1;
+  }
+  if (start < text.size()) lines.push_back(text.substr(start) + " (no newline)");
+  return lines;
+}
+
+// Every line is a ring line "L<n>" with n increasing, or the reply
+static bool Aligned(const std::vector<std::string>& lines, const char* reply) {
+  long last = -1;
+  for (const std::string& line : lines) {
+    if (line == reply) continue;
+    if (line.size() < 2 || line[0] != 'L') return false;
+    long n = strtol(line.c_str() + 1, nullptr, 10);
+    if (n <= last) return false;
+    last = n;
+  }
+  return true;
+}
+
+static std::string RingLine(int n) {
+  return "L" + std::to_string(n) + ",POS,12.345,67.890,-1.234";
+}
+
+int main() {
+  // Private line while a ring line is half sent
+  {
+    LineRing ring(16);
+    RingReader reader(ring);
+    std::string received;
+    for (int i = 0; i < 4; i++) Push(ring, {&reader}, RingLine(i));
+
+    Write(reader, 5, received);  // "L0,PO"
+    reader.sendPrivate("ACK,BRIDGE");
+    Drain(reader, received);
+
+    std::vector<std::string> lines = Lines(received);
+    Expect("short write: five lines", lines.size() == 5);
+    Expect("short write: line-aligned", Aligned(lines, "ACK,BRIDGE"));
+    Expect("short write: reply after the half-sent line",
+           lines.size() == 5 && lines[0] == RingLine(0) && lines[1] == "ACK,BRIDGE");
+    Expect("short write: counted", reader.stats().sent == 4 && reader.stats().dropped == 0);
+  }
+
+  // Same, then lapped: the rest of the line comes from the private copy
+  {
+    LineRing ring(8);
+    RingReader reader(ring);
+    std::string received;
+    for (int i = 0; i < 4; i++) Push(ring, {&reader}, RingLine(i));
+
+    Write(reader, 3, received);  // "L0,"
+    reader.sendPrivate("ACK,BRIDGE");
+    for (int i = 4; i < 40; i++) Push(ring, {&reader}, RingLine(i));
+    Drain(reader, received);
+
+    std::vector<std::string> lines = Lines(received);
+    Expect("lapped: line-aligned", Aligned(lines, "ACK,BRIDGE"));
+    Expect("lapped: half-sent line finished first",
+           lines.size() >= 2 && lines[0] == RingLine(0) && lines[1] == "ACK,BRIDGE");
+    Expect("lapped: every line counted",
+           reader.stats().sent + reader.stats().dropped + reader.stats().decimated == 40);
+  }
+
+  // Many one-byte-at-a-time writes with replies queued throughout
+  {
+    LineRing ring(64);
+    RingReader reader(ring);
+    std::string received;
+    for (int i = 0; i < 20; i++) {
+      Push(ring, {&reader}, RingLine(i));
+      if (i % 3 == 0) reader.sendPrivate("ACK,BRIDGE");
+      for (int k = 0; k < 7; k++) Write(reader, 1, received);
+    }
+    Drain(reader, received);
+
+    std::vector<std::string> lines = Lines(received);
+    Expect("trickle: line-aligned", Aligned(lines, "ACK,BRIDGE"));
+    Expect("trickle: every line", lines.size() == 20 + 7);
+  }
+
+  printf("line_ring,%s\n", failures == 0 ? "PASS" : "FAIL");
+  return failures == 0 ? 0 : 1;
+}
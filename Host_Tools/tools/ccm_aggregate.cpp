@@ -0,0 +1,501 @@
+/*
+ * ============================================================================
+ * CCM_AGGREGATE - Multi-arm aggregator daemon
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_aggregate [options] <arm list>
+ *
+ * Options:
+ *   --baud N             Serial baud rate (default: 115200)
+ *   --seconds S          Stop after S seconds (default: 0 = until SIGINT / SIGTERM)
+ *   --merge-delay-ms N   Longest wait for a slow arm before releasing (default: 50);
+ *                        with --sequenced also the wait before repeating a RESEND
+ *   --probes N           SYNC exchanges per arm before streaming (default: 8)
+ *   --sync-interval-ms N SYNC period per arm while streaming (default: 250)
+ *   --metrics-s S        Metrics period on stderr (default: 5, 0 = only at exit)
+ *   --sequenced          Lossless sequenced streaming (SETSEQ ON, see ccm_record)
+ *   --output FILE        Write the merged stream to FILE (default: stdout)
+ *   --no-wait            Do not wait for startup banners (ports already open)
+ *
+ * Arm list: a text file with one arm per line ('#' starts a comment):
+ *
+ *   name  port          [tx ty tz rx ry rz]   [map=FILE]
+ *   left  /dev/ttyACM0  0    0 0  0 0 0      map=left.map
+ *   right /dev/ttyACM1  1200 0 0  0 0 180
+ *
+ * The optional six numbers place the arm's base frame in the fixture frame
+ * (translation in mm, then rotations about fixture X, Y, Z in degrees; see
+ * rigid_transform.h). Without them the arm frame is the fixture frame.
+ * map= names the arm's volumetric error map (ccm_errormap), applied to
+ * its samples in its own base frame before they are moved.
+ *
+ * Every arm is synchronized (microsecond timestamps, SYNC exchanges, as
+ * ccm_sync) and started. All ports are then served by one epoll loop on
+ * one thread. Samples are moved into the fixture frame and merged by
+ * sample time, and written as:
+ *
+ *   host_ns,arm,x,y,z,theta1,...,thetaN
+ *
+ * host_ns is the sample time on the host monotonic clock. Per-arm metrics
+ * (sample rate, link latency, merge lag, late samples, clock offset and
+ * drift) and the daemon's CPU use are reported on stderr as INFO lines.
+ * An arm whose port goes away is reported and dropped; the others carry
+ * on.
+ *
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#include "../src/arm_connection.h"
+#include "../src/rigid_transform.h"
+#include "../src/sample_merger.h"
+#include "../src/serial_port.h"
+
+// Merged output is flushed at least this often
+static const int64_t OUTPUT_FLUSH_NS = 20000000;
+static const size_t OUTPUT_FLUSH_BYTES = 64 * 1024;
+
+// Shortest wait before repeating a RESEND (about a round trip at 115200
+// baud with the device's transmit queue full)
+static const int MIN_RESEND_RETRY_MS = 30;
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_aggregate [options] <arm list>\n"
+          "  --baud N             Serial baud rate (default: 115200)\n"
+          "  --seconds S          Stop after S seconds (default: 0 = until signal)\n"
+          "  --merge-delay-ms N   Longest wait for a slow arm (default: 50),\n"
+          "                       with --sequenced also the RESEND retry\n"
+          "  --probes N           SYNC exchanges per arm before streaming (default: 8)\n"
+          "  --sync-interval-ms N SYNC period per arm while streaming (default: 250)\n"
+          "  --metrics-s S        Metrics period on stderr (default: 5, 0 = at exit)\n"
+          "  --sequenced          Lossless sequenced streaming (SETSEQ ON)\n"
+          "  --output FILE        Merged stream to FILE (default: stdout)\n"
+          "  --no-wait            Do not wait for startup banners\n"
+          "Arm list lines: name port [tx ty tz rx ry rz] [map=FILE]\n");
+}
+
+// ============================================================================
+// ARM LIST
+// ============================================================================
+struct ArmConfig {
+  std::string name;
+  std::string port;
+  RigidTransform toFixture;
+  std::string mapPath;
+};
+
+static bool readArmList(const char* path, std::vector<ArmConfig>& arms) {
+  std::ifstream in(path);
+  if (!in) {
+    fprintf(stderr, "ERROR,Cannot open %s\n", path);
+    return false;
+  }
+
+  std::string text;
+  int lineNumber = 0;
+  while (std::getline(in, text)) {
+    lineNumber++;
+    size_t hash = text.find('#');
+    if (hash != std::string::npos) text.erase(hash);
+
+    std::istringstream fields(text);
+    ArmConfig arm;
+    if (!(fields >> arm.name)) continue;  // Blank line
+    if (!(fields >> arm.port)) {
+      fprintf(stderr, "ERROR,%s:%d: missing port\n", path, lineNumber);
+      return false;
+    }
+    std::string rest;
+    std::getline(fields, rest);
+    size_t mapAt = rest.find("map=");
+    if (mapAt != std::string::npos) {
+      std::istringstream(rest.substr(mapAt + 4)) >> arm.mapPath;
+      rest.erase(mapAt);
+      if (arm.mapPath.empty()) {
+        fprintf(stderr, "ERROR,%s:%d: map= needs a file\n", path, lineNumber);
+        return false;
+      }
+    }
+    if (rest.find_first_not_of(" \t\r") != std::string::npos &&
+        !RigidTransform::parse(rest, arm.toFixture)) {
+      fprintf(stderr, "ERROR,%s:%d: transform must be six numbers: tx ty tz rx ry rz\n",
+              path, lineNumber);
+      return false;
+    }
+    for (const ArmConfig& other : arms) {
+      if (other.name == arm.name) {
+        fprintf(stderr, "ERROR,%s:%d: duplicate arm name %s\n", path, lineNumber,
+                arm.name.c_str());
+        return false;
+      }
+    }
+    arms.push_back(arm);
+  }
+
+  if (arms.empty()) {
+    fprintf(stderr, "ERROR,No arms in %s\n", path);
+    return false;
+  }
+  return true;
+}
+
+// ============================================================================
+// METRICS
+// ============================================================================
+struct ArmWindow {
+  uint64_t samples = 0;       // Counters at the start of the window
+  uint64_t released = 0;      // Released in this window
+  double lagSumMs = 0;        // Merge lag: release time - sample time
+  double lagMaxMs = 0;
+  bool up = true;             // Port still open
+};
+
+static double CpuSeconds() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// One INFO line per arm over a window (periodic, or the whole run at exit)
+static void printMetrics(const std::vector<std::unique_ptr<ArmConnection>>& arms,
+                         std::vector<ArmWindow>& windows, const SampleMerger& merger,
+                         double seconds, double cpuSeconds) {
+  uint64_t totalReleased = 0;
+  for (size_t i = 0; i < arms.size(); i++) {
+    const ArmConnection& arm = *arms[i];
+    ArmWindow& w = windows[i];
+    const ClockSyncMetrics& clock = arm.clockMetrics();
+    uint64_t samples = arm.counters().samples;
+
+    fprintf(stderr,
+            "INFO,Arm %s: %s, %.1f samples/s, latency mean %.0f us max %.0f us, "
+            "merge lag mean %.1f ms max %.1f ms, %llu late, %llu unsynced, "
+            "offset %.1f us, drift %.2f ppm\n",
+            arm.name().c_str(), w.up ? "up" : "DOWN", (samples - w.samples) / seconds,
+            clock.latencyMeanUs, clock.latencyMaxUs,
+            w.released > 0 ? w.lagSumMs / w.released : 0.0, w.lagMaxMs,
+            static_cast<unsigned long long>(merger.late(i)),
+            static_cast<unsigned long long>(arm.counters().unsynced), clock.offsetUs,
+            clock.driftPpm);
+    if (arm.frameStats().missed > 0) {
+      const FrameTrackerStats& f = arm.frameStats();
+      fprintf(stderr, "INFO,Arm %s frames: %llu missed, %llu recovered, %llu lost\n",
+              arm.name().c_str(), static_cast<unsigned long long>(f.missed),
+              static_cast<unsigned long long>(f.recovered),
+              static_cast<unsigned long long>(f.lost));
+    }
+    if (arm.compensation().outside() > 0) {
+      fprintf(stderr, "INFO,Arm %s: %llu samples outside its error map\n", arm.name().c_str(),
+              static_cast<unsigned long long>(arm.compensation().outside()));
+    }
+
+    totalReleased += w.released;
+    w.samples = samples;
+    w.released = 0;
+    w.lagSumMs = 0;
+    w.lagMaxMs = 0;
+  }
+  fprintf(stderr, "INFO,Total: %.1f samples/s merged, %zu held, CPU %.1f%%\n",
+          totalReleased / seconds, merger.held(), 100.0 * cpuSeconds / seconds);
+}
+
+// ============================================================================
+// OUTPUT
+// ============================================================================
+class MergedOutput {
+public:
+  explicit MergedOutput(FILE* f) : file(f) { buffer.reserve(OUTPUT_FLUSH_BYTES * 2); }
+
+  void write(const ArmSample& s, const std::string& armName) {
+    char head[128];
+    int n = snprintf(head, sizeof(head), "%lld,%s,%.3f,%.3f,%.3f",
+                     static_cast<long long>(s.hostNs), armName.c_str(), s.xyz[0], s.xyz[1],
+                     s.xyz[2]);
+    buffer.append(head, static_cast<size_t>(std::min<int>(n, sizeof(head) - 1)));
+    if (!s.joints.empty()) {
+      buffer += ',';
+      buffer += s.joints;
+    }
+    buffer += '\n';
+  }
+
+  void flushIfDue(int64_t nowNs) {
+    if (buffer.size() >= OUTPUT_FLUSH_BYTES || (!buffer.empty() && nowNs - lastFlushNs >= OUTPUT_FLUSH_NS)) {
+      flush(nowNs);
+    }
+  }
+
+  void flush(int64_t nowNs) {
+    if (!buffer.empty()) {
+      fwrite(buffer.data(), 1, buffer.size(), file);
+      fflush(file);
+      buffer.clear();
+    }
+    lastFlushNs = nowNs;
+  }
+
+  int64_t nextFlushNs() const {
+    return buffer.empty() ? INT64_MAX : lastFlushNs + OUTPUT_FLUSH_NS;
+  }
+
+private:
+  FILE* file;
+  std::string buffer;
+  int64_t lastFlushNs = 0;
+};
+
+int main(int argc, char** argv) {
+  int baud = 115200;
+  double runSeconds = 0;
+  int mergeDelayMs = 50;
+  int probes = 8;
+  int syncIntervalMs = 250;
+  double metricsSeconds = 5;
+  bool sequenced = false;
+  bool waitForBanner = true;
+  const char* outputPath = nullptr;
+  const char* listPath = nullptr;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--baud") == 0 && hasValue) {
+      baud = atoi(argv[++i]);
+    } else if (strcmp(arg, "--seconds") == 0 && hasValue) {
+      runSeconds = atof(argv[++i]);
+    } else if (strcmp(arg, "--merge-delay-ms") == 0 && hasValue) {
+      mergeDelayMs = atoi(argv[++i]);
+    } else if (strcmp(arg, "--probes") == 0 && hasValue) {
+      probes = atoi(argv[++i]);
+    } else if (strcmp(arg, "--sync-interval-ms") == 0 && hasValue) {
+      syncIntervalMs = atoi(argv[++i]);
+    } else if (strcmp(arg, "--metrics-s") == 0 && hasValue) {
+      metricsSeconds = atof(argv[++i]);
+    } else if (strcmp(arg, "--sequenced") == 0) {
+      sequenced = true;
+    } else if (strcmp(arg, "--output") == 0 && hasValue) {
+      outputPath = argv[++i];
+    } else if (strcmp(arg, "--no-wait") == 0) {
+      waitForBanner = false;
+    } else if (arg[0] == '-' && arg[1] != '\0') {
+      printUsage();
+      return 1;
+    } else if (listPath == nullptr) {
+      listPath = arg;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (listPath == nullptr || mergeDelayMs < 0 || probes < 1 || syncIntervalMs < 1 ||
+      runSeconds < 0 || metricsSeconds < 0) {
+    printUsage();
+    return 1;
+  }
+
+  std::vector<ArmConfig> configs;
+  if (!readArmList(listPath, configs)) return 1;
+
+  FILE* output = stdout;
+  if (outputPath != nullptr) {
+    output = fopen(outputPath, "w");
+    if (output == nullptr) {
+      fprintf(stderr, "ERROR,Cannot create %s: %s\n", outputPath, strerror(errno));
+      return 1;
+    }
+  }
+
+  // --------------------------------------------------------------------------
+  // Open every port first (each open resets its Arduino, so they all boot
+  // in parallel), then synchronize and start them one by one
+  // --------------------------------------------------------------------------
+  std::vector<std::unique_ptr<ArmConnection>> arms;
+  for (size_t i = 0; i < configs.size(); i++) {
+    arms.emplace_back(new ArmConnection(i, configs[i].name, configs[i].port, configs[i].toFixture));
+    if ((!configs[i].mapPath.empty() && !arms.back()->loadCompensation(configs[i].mapPath)) ||
+        !arms.back()->open(baud)) {
+      fprintf(stderr, "ERROR,Arm %s: %s\n", configs[i].name.c_str(), arms.back()->error().c_str());
+      return 1;
+    }
+  }
+  for (auto& arm : arms) {
+    arm->setSyncInterval(syncIntervalMs * 1000000LL);
+    if (!arm->prepare(waitForBanner, probes, sequenced)) {
+      fprintf(stderr, "ERROR,Arm %s: %s\n", arm->name().c_str(), arm->error().c_str());
+      return 1;
+    }
+    const ClockSyncMetrics& m = arm->clockMetrics();
+    fprintf(stderr, "INFO,Arm %s on %s: synchronized, offset %.1f us, rtt min %.1f us\n",
+            arm->name().c_str(), arm->path().c_str(), m.offsetUs, m.minRttUs);
+  }
+
+  // --------------------------------------------------------------------------
+  // Event loop setup: one epoll set for every port and the stop signals
+  // --------------------------------------------------------------------------
+  sigset_t stopSignals;
+  sigemptyset(&stopSignals);
+  sigaddset(&stopSignals, SIGINT);
+  sigaddset(&stopSignals, SIGTERM);
+  sigprocmask(SIG_BLOCK, &stopSignals, nullptr);
+  int signalFd = signalfd(-1, &stopSignals, SFD_CLOEXEC);
+
+  int epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd < 0 || signalFd < 0) {
+    fprintf(stderr, "ERROR,Cannot set up the event loop: %s\n", strerror(errno));
+    return 1;
+  }
+  const uint64_t SIGNAL_TAG = UINT64_MAX;
+  epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.u64 = SIGNAL_TAG;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &ev);
+  for (auto& arm : arms) {
+    ev.data.u64 = arm->index();
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, arm->descriptor(), &ev);
+  }
+
+  for (auto& arm : arms) {
+    if (!arm->start()) {
+      fprintf(stderr, "ERROR,Arm %s: %s\n", arm->name().c_str(), arm->error().c_str());
+      return 1;
+    }
+  }
+
+  // Sequenced: a RESEND is repeated after the merge delay, and an arm
+  // recovering lost frames holds the merge back for its whole retry budget
+  // on top, so recovered frames are merged rather than counted late
+  SampleMerger merger(arms.size(), mergeDelayMs * 1000000LL);
+  if (sequenced) {
+    int64_t recoveryNs = 0;
+    for (auto& arm : arms) {
+      arm->setResendRetry(std::max(mergeDelayMs, MIN_RESEND_RETRY_MS) * 1000000LL);
+      recoveryNs = std::max(recoveryNs, arm->recoveryBudgetNs());
+    }
+    merger.setRecoveryDelay(recoveryNs);
+  }
+  MergedOutput out(output);
+  std::vector<ArmWindow> windows(arms.size());  // Since the last metrics report
+  std::vector<ArmWindow> totals(arms.size());   // Whole run
+  std::vector<ArmSample> batch;
+  size_t armsUp = arms.size();
+
+  int64_t startNs = HostClock_NowNs();
+  int64_t endNs = runSeconds > 0 ? startNs + static_cast<int64_t>(runSeconds * 1e9) : INT64_MAX;
+  int64_t metricsPeriodNs = static_cast<int64_t>(metricsSeconds * 1e9);
+  int64_t nextMetricsNs = metricsPeriodNs > 0 ? startNs + metricsPeriodNs : INT64_MAX;
+  int64_t windowStartNs = startNs;
+  double startCpu = CpuSeconds();
+  double windowCpu = startCpu;
+  bool stopping = false;
+
+  auto release = [&](ArmSample& s, int64_t nowNs) {
+    double lagMs = (nowNs - s.hostNs) / 1e6;
+    for (ArmWindow* w : {&windows[s.arm], &totals[s.arm]}) {
+      w->released++;
+      w->lagSumMs += lagMs;
+      if (lagMs > w->lagMaxMs) w->lagMaxMs = lagMs;
+    }
+    out.write(s, arms[s.arm]->name());
+  };
+
+  // --------------------------------------------------------------------------
+  // Event loop
+  // --------------------------------------------------------------------------
+  epoll_event events[64];
+  ArmSample sample;
+  while (!stopping && armsUp > 0) {
+    int64_t now = HostClock_NowNs();
+
+    int64_t wakeNs = std::min({endNs, nextMetricsNs, merger.nextDeadlineNs(), out.nextFlushNs()});
+    for (auto& arm : arms) {
+      if (windows[arm->index()].up) wakeNs = std::min(wakeNs, arm->nextTimerNs());
+    }
+    int timeoutMs = wakeNs <= now ? 0 : static_cast<int>(std::min<int64_t>((wakeNs - now + 999999) / 1000000, 1000));
+
+    int n = epoll_wait(epollFd, events, 64, timeoutMs);
+    if (n < 0 && errno != EINTR) {
+      fprintf(stderr, "ERROR,epoll_wait: %s\n", strerror(errno));
+      break;
+    }
+
+    for (int i = 0; i < n; i++) {
+      if (events[i].data.u64 == SIGNAL_TAG) {
+        stopping = true;
+        continue;
+      }
+      ArmConnection& arm = *arms[events[i].data.u64];
+      batch.clear();
+      bool open = arm.onReadable(batch);
+      for (ArmSample& s : batch) merger.push(std::move(s));
+      merger.setRecovering(arm.index(), arm.recovering());
+      if (!open) {
+        fprintf(stderr, "ERROR,Arm %s: %s - dropped\n", arm.name().c_str(), arm.error().c_str());
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, arm.descriptor(), nullptr);
+        windows[arm.index()].up = false;
+        totals[arm.index()].up = false;
+        merger.setSourceDone(arm.index());
+        armsUp--;
+      }
+    }
+
+    now = HostClock_NowNs();
+    for (auto& arm : arms) {
+      if (windows[arm->index()].up && now >= arm->nextTimerNs()) {
+        arm->onTimer(now);
+        merger.setRecovering(arm->index(), arm->recovering());
+      }
+    }
+    while (merger.pop(now, sample)) release(sample, now);
+    out.flushIfDue(now);
+
+    if (now >= nextMetricsNs) {
+      double cpu = CpuSeconds();
+      printMetrics(arms, windows, merger, (now - windowStartNs) / 1e9, cpu - windowCpu);
+      windowStartNs = now;
+      windowCpu = cpu;
+      nextMetricsNs = now + metricsPeriodNs;
+    }
+    if (now >= endNs) stopping = true;
+  }
+
+  // --------------------------------------------------------------------------
+  // Shutdown: stop the arms and release everything still held
+  // --------------------------------------------------------------------------
+  for (auto& arm : arms) {
+    if (windows[arm->index()].up) arm->stop();
+  }
+  int64_t now = HostClock_NowNs();
+  while (merger.popAny(sample)) release(sample, now);
+  out.flush(now);
+  if (output != stdout) fclose(output);
+
+  fprintf(stderr, "INFO,Run summary:\n");
+  printMetrics(arms, totals, merger, std::max(1e-3, (now - startNs) / 1e9), CpuSeconds() - startCpu);
+  close(epollFd);
+  close(signalFd);
+  return armsUp == arms.size() ? 0 : 2;
+}
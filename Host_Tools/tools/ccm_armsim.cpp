@@ -0,0 +1,465 @@
+/*
+ * ============================================================================
+ * CCM_ARMSIM - Simulated arm running the real firmware on a pseudo-terminal
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_armsim [options]
+ *
+ * Options:
+ *   --rate HZ            Streaming rate, 1 - 10000 (default: the firmware's
+ *                        UPDATE_INTERVAL_MS)
+ *   --seconds S          Stop after S seconds (default: 0 = until SIGINT / SIGTERM)
+ *   --init "CMD;CMD"     Commands to run at startup, e.g. "SETTS US;START"
+ *   --link PATH          Also make PATH a symlink to the pseudo-terminal
+ *   --seed N             Trajectory and noise seed (default: 1)
+ *   --speed DEG_S        Peak joint speed of a normal move (default: 90)
+ *   --burst-fraction F   Share of moves that are fast flicks (default: 0.1)
+ *   --noise-counts C     Encoder noise, standard deviation in counts (default: 0.3)
+ *   --glitches-per-s R   Encoder glitches per second (default: 0)
+ *   --glitch-counts N    Size of a count glitch (default: 40)
+ *   --chunk-ms N         Deliver output in chunks every N ms, like a USB
+ *                        serial adapter's latency timer (default: 0 = at once)
+ *   --step-us N          Simulation step (default: 20)
+ *
+ * The firmware sketch and modules in Hardware_Firmware/Arduino are compiled
+ * against the host HAL (hal/) and run in real time. Every line on the
+ * pseudo-terminal comes from the firmware's own protocol, kinematics,
+ * filter, sequenced-frame and burst code. Any command it accepts works,
+ * and so does every output format: POS in ms or us, VEL, motion streaming,
+ * SPOS with RESEND, BURST dumps. The pseudo-terminal's path is printed on
+ * stdout.
+ *
+ * The encoders are driven through the backend the firmware is built with
+ * (-DENCODER_BACKEND=..., default ISR):
+ *   ISR      quadrature edges on the A/B pins, with interpolated edge times
+ *   LS7366R  MockLS7366R counters
+ *   SSI/BISS MockSsiEncoder / MockBissEncoder positions
+ * following a seeded hand-guided trajectory (joint_trajectory.h) plus noise.
+ * A glitch is a spike of --glitch-counts on one axis for 300 us; with BiSS
+ * it is a frame with a bad CRC instead. With SSI / BiSS a SETPPR matching
+ * ENCODER_ABS_BITS is sent first if config.h still has incremental
+ * settings.
+ *
+ * The streaming rate is applied by retuning the firmware's KIN task. The
+ * link is not throttled to a baud rate: this is for load-testing the PC
+ * side (a real 115200 baud link carries about 190 POS lines/s).
+ * Arduino-style auto-reset on open is not modelled. Tools that wait for
+ * the startup banner need --no-wait.
+ *
+ * ============================================================================
+ */
+
+#include "config.h"
+#include "encoder.h"
+#include "motion_trigger.h"
+#include "scheduler.h"
+
+#include "hal_control.h"
+#include "mock_spi_devices.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include <fcntl.h>
+#include <pty.h>
+#include <sys/prctl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/joint_trajectory.h"
+
+// The sketch (CCM_Digitizing_Arm_Arduino.ino)
+void setup();
+void loop();
+
+// Scheduler passes per simulation step: enough for every task that is due
+static const int LOOP_CALLS_PER_STEP = 16;
+static const uint64_t GLITCH_DURATION_US = 300;
+static const uint64_t NOISE_HOLD_US = 1000;
+static const size_t MAX_PENDING_OUTPUT = 4 * 1024 * 1024;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onStopSignal(int) {
+  stopRequested = 1;
+}
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_armsim [options]\n"
+          "  --rate HZ            Streaming rate, 1-10000 (default: firmware's)\n"
+          "  --seconds S          Stop after S seconds (default: 0 = until signal)\n"
+          "  --init \"CMD;CMD\"     Commands to run at startup\n"
+          "  --link PATH          Symlink PATH to the pseudo-terminal\n"
+          "  --seed N             Trajectory and noise seed (default: 1)\n"
+          "  --speed DEG_S        Peak joint speed (default: 90)\n"
+          "  --burst-fraction F   Share of fast flick moves (default: 0.1)\n"
+          "  --noise-counts C     Encoder noise in counts (default: 0.3)\n"
+          "  --glitches-per-s R   Encoder glitches per second (default: 0)\n"
+          "  --glitch-counts N    Size of a count glitch (default: 40)\n"
+          "  --chunk-ms N         Deliver output every N ms (default: 0)\n"
+          "  --step-us N          Simulation step (default: 20)\n");
+}
+
+// ============================================================================
+// ENCODERS (one implementation per firmware backend)
+// ============================================================================
+#if ENCODER_BACKEND == ENCODER_BACKEND_ISR
+
+static const double COUNTS_PER_DEGREE = COUNTS_PER_REVOLUTION / 360.0;
+static const uint8_t pinsA[] = ENCODER_PINS_A;
+static const uint8_t pinsB[] = ENCODER_PINS_B;
+
+// A/B levels by count modulo 4, counting up through the sequence as the
+// firmware's ISRs decode it. Count 0 = both high (the pull-up idle state).
+static const uint8_t QUAD_A[4] = { HIGH, HIGH, LOW, LOW };
+static const uint8_t QUAD_B[4] = { HIGH, LOW, LOW, HIGH };
+
+static void Encoders_Init() {}
+
+// One edge per count, spread evenly over the step so edge times (and the
+// firmware's edge-timing velocity) look like real motion
+static void Encoders_Move(int axis, long from, long to, uint64_t fromUs, uint64_t toUs) {
+  long steps = labs(to - from);
+  int dir = to > from ? 1 : -1;
+  for (long i = 1; i <= steps; i++) {
+    long count = from + dir * i;
+    int state = static_cast<int>(((count % 4) + 4) % 4);
+    Hal_SetMicros(fromUs + (toUs - fromUs) * i / steps);
+    Hal_SetPin(pinsA[axis], QUAD_A[state]);
+    Hal_SetPin(pinsB[axis], QUAD_B[state]);
+  }
+}
+
+static void Encoders_SetFault(int, bool) {}
+
+#elif ENCODER_BACKEND == ENCODER_BACKEND_LS7366R
+
+static const double COUNTS_PER_DEGREE = COUNTS_PER_REVOLUTION / 360.0;
+static const uint8_t csPins[] = ENCODER_SPI_CS_PINS;
+static MockLS7366R counters[NUM_AXES];
+
+static void Encoders_Init() {
+  for (int i = 0; i < NUM_AXES; i++) Hal_AttachSpiDevice(csPins[i], &counters[i]);
+}
+
+static void Encoders_Move(int axis, long from, long to, uint64_t, uint64_t) {
+  counters[axis].addCounts(static_cast<int32_t>(to - from));
+}
+
+static void Encoders_SetFault(int, bool) {}
+
+#else  // SSI / BiSS
+
+static const double COUNTS_PER_DEGREE = (1L << ENCODER_ABS_BITS) / 360.0;
+static const uint8_t csPins[] = ENCODER_SPI_CS_PINS;
+#if ENCODER_BACKEND == ENCODER_BACKEND_BISS
+static MockBissEncoder* absEncoders[NUM_AXES];
+#else
+static MockSsiEncoder* absEncoders[NUM_AXES];
+#endif
+
+static void Encoders_Init() {
+  for (int i = 0; i < NUM_AXES; i++) {
+#if ENCODER_BACKEND == ENCODER_BACKEND_BISS
+    absEncoders[i] = new MockBissEncoder(ENCODER_ABS_BITS);
+#else
+    absEncoders[i] = new MockSsiEncoder(ENCODER_ABS_BITS, ENCODER_SSI_GRAY_CODE);
+#endif
+    Hal_AttachSpiDevice(csPins[i], absEncoders[i]);
+  }
+}
+
+static void Encoders_Move(int axis, long, long to, uint64_t, uint64_t) {
+  long turn = 1L << ENCODER_ABS_BITS;
+  absEncoders[axis]->position = static_cast<uint32_t>(((to % turn) + turn) % turn);
+}
+
+#if ENCODER_BACKEND == ENCODER_BACKEND_BISS
+#define GLITCH_IS_CRC_ERROR 1
+static void Encoders_SetFault(int axis, bool on) {
+  absEncoders[axis]->corruptCrc = on;
+}
+#else
+static void Encoders_SetFault(int, bool) {}
+#endif
+
+#endif
+
+#ifndef GLITCH_IS_CRC_ERROR
+#define GLITCH_IS_CRC_ERROR 0
+#endif
+
+// ============================================================================
+// SCHEDULER
+// ============================================================================
+static int FindTask(const char* name) {
+  for (uint8_t i = 0; i < Scheduler_GetTaskCount(); i++) {
+    if (strcmp(Scheduler_GetTask(i)->name, name) == 0) return i;
+  }
+  return -1;
+}
+
+// ============================================================================
+// PSEUDO-TERMINAL
+// ============================================================================
+static bool OpenPty(int& master, int& slave, std::string& name) {
+  char path[128];
+  termios tty;
+  memset(&tty, 0, sizeof(tty));
+  cfmakeraw(&tty);  // No echo, no line editing: a plain byte pipe
+  if (openpty(&master, &slave, path, &tty, nullptr) != 0) return false;
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+  name = path;
+  return true;
+}
+
+int main(int argc, char** argv) {
+  double rateHz = 0;
+  double runSeconds = 0;
+  std::string initCommands;
+  const char* linkPath = nullptr;
+  TrajectoryConfig trajectory;
+  trajectory.axes = NUM_AXES;
+  double noiseCounts = 0.3;
+  double glitchesPerSecond = 0;
+  long glitchCounts = 40;
+  int chunkMs = 0;
+  int stepUs = 20;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--rate") == 0 && hasValue) {
+      rateHz = atof(argv[++i]);
+    } else if (strcmp(arg, "--seconds") == 0 && hasValue) {
+      runSeconds = atof(argv[++i]);
+    } else if (strcmp(arg, "--init") == 0 && hasValue) {
+      initCommands = argv[++i];
+    } else if (strcmp(arg, "--link") == 0 && hasValue) {
+      linkPath = argv[++i];
+    } else if (strcmp(arg, "--seed") == 0 && hasValue) {
+      trajectory.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    } else if (strcmp(arg, "--speed") == 0 && hasValue) {
+      trajectory.maxSpeedDegS = atof(argv[++i]);
+    } else if (strcmp(arg, "--burst-fraction") == 0 && hasValue) {
+      trajectory.burstFraction = atof(argv[++i]);
+    } else if (strcmp(arg, "--noise-counts") == 0 && hasValue) {
+      noiseCounts = atof(argv[++i]);
+    } else if (strcmp(arg, "--glitches-per-s") == 0 && hasValue) {
+      glitchesPerSecond = atof(argv[++i]);
+    } else if (strcmp(arg, "--glitch-counts") == 0 && hasValue) {
+      glitchCounts = atol(argv[++i]);
+    } else if (strcmp(arg, "--chunk-ms") == 0 && hasValue) {
+      chunkMs = atoi(argv[++i]);
+    } else if (strcmp(arg, "--step-us") == 0 && hasValue) {
+      stepUs = atoi(argv[++i]);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (rateHz < 0 || rateHz > 10000 || runSeconds < 0 || trajectory.maxSpeedDegS <= 0 ||
+      trajectory.burstFraction < 0 || trajectory.burstFraction > 1 || noiseCounts < 0 ||
+      glitchesPerSecond < 0 || chunkMs < 0 || stepUs < 1) {
+    printUsage();
+    return 1;
+  }
+
+  int master, slave;
+  std::string ptyName;
+  if (!OpenPty(master, slave, ptyName)) {
+    fprintf(stderr, "ERROR,Cannot open a pseudo-terminal: %s\n", strerror(errno));
+    return 1;
+  }
+  if (linkPath != nullptr) {
+    unlink(linkPath);
+    if (symlink(ptyName.c_str(), linkPath) != 0) {
+      fprintf(stderr, "ERROR,Cannot create %s: %s\n", linkPath, strerror(errno));
+      return 1;
+    }
+  }
+  printf("%s\n", ptyName.c_str());
+  fflush(stdout);
+
+  signal(SIGINT, onStopSignal);
+  signal(SIGTERM, onStopSignal);
+  prctl(PR_SET_TIMERSLACK, 1UL);  // Short sleeps really are short
+
+  // --------------------------------------------------------------------------
+  // Boot the firmware
+  // --------------------------------------------------------------------------
+  Encoders_Init();
+  // Serial.availableForWrite() stays at an empty 63-byte buffer, so the
+  // firmware drains as fast as it likes (no baud limit, see header) and its
+  // SYNC tx stamps see no queued bytes
+  setup();
+
+  int kinTask = FindTask("KIN");
+  unsigned long streamPeriodUs = rateHz > 0 ? static_cast<unsigned long>(1e6 / rateHz + 0.5) : 0;
+
+#if ENCODER_BACKEND == ENCODER_BACKEND_SSI || ENCODER_BACKEND == ENCODER_BACKEND_BISS
+  // config.h keeps incremental-encoder settings unless edited; match the
+  // firmware's resolution to the simulated absolute encoders
+  if ((1L << ENCODER_ABS_BITS) != COUNTS_PER_REVOLUTION) {
+    std::string ppr = "SETPPR " + std::to_string((1L << ENCODER_ABS_BITS) / ENCODER_MULTIPLIER);
+    initCommands = initCommands.empty() ? ppr : ppr + ";" + initCommands;
+  }
+#endif
+
+  // Commands are queued in the order given and run by the firmware's own
+  // RX task, with replies on the pseudo-terminal like any others
+  for (size_t start = 0; start < initCommands.size();) {
+    size_t end = initCommands.find(';', start);
+    if (end == std::string::npos) end = initCommands.size();
+    std::string command = initCommands.substr(start, end - start) + "\n";
+    Hal_SerialInject(command.c_str());
+    start = end + 1;
+  }
+
+  JointTrajectory motion(trajectory);
+  std::mt19937 noiseRng(trajectory.seed ^ 0x9e3779b9U);
+  std::normal_distribution<double> noise(0.0, noiseCounts > 0 ? noiseCounts : 1.0);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::uniform_int_distribution<int> pickAxis(0, NUM_AXES - 1);
+
+  long counts[NUM_AXES] = {};
+  double noiseValue[NUM_AXES] = {};
+  uint64_t nextNoiseUs = 0;
+  int glitchAxis = -1;
+  uint64_t glitchEndUs = 0;
+  uint64_t glitches = 0;
+
+  std::string pending;
+  uint64_t bytesOut = 0, bytesDiscarded = 0, linesOut = 0;
+  uint64_t lastChunkUs = 0;
+
+  // --------------------------------------------------------------------------
+  // Real-time loop: firmware time = boot time + wall time since then
+  // --------------------------------------------------------------------------
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point wallStart = Clock::now();
+  uint64_t bootUs = Hal_GetMicros64();
+  uint64_t lastUs = bootUs;
+  timespec nextWake;
+  clock_gettime(CLOCK_MONOTONIC, &nextWake);
+
+  while (!stopRequested) {
+    double elapsed = std::chrono::duration<double>(Clock::now() - wallStart).count();
+    if (runSeconds > 0 && elapsed >= runSeconds) break;
+    uint64_t nowUs = bootUs + static_cast<uint64_t>(elapsed * 1e6);
+
+    // Encoders: trajectory + held noise + glitch
+    if (nowUs >= nextNoiseUs) {
+      for (int i = 0; i < NUM_AXES; i++) noiseValue[i] = noiseCounts > 0 ? noise(noiseRng) : 0.0;
+      nextNoiseUs = nowUs + NOISE_HOLD_US;
+      if (glitchAxis < 0 && glitchesPerSecond > 0 &&
+          unit(noiseRng) < glitchesPerSecond * NOISE_HOLD_US / 1e6) {
+        glitchAxis = pickAxis(noiseRng);
+        glitchEndUs = nowUs + GLITCH_DURATION_US;
+        glitches++;
+        Encoders_SetFault(glitchAxis, true);
+      }
+    }
+    if (glitchAxis >= 0 && nowUs >= glitchEndUs) {
+      Encoders_SetFault(glitchAxis, false);
+      glitchAxis = -1;
+    }
+
+    double angles[NUM_AXES];
+    motion.anglesAt(elapsed, angles);
+    for (int i = 0; i < NUM_AXES; i++) {
+      long target = lround(angles[i] * COUNTS_PER_DEGREE + noiseValue[i]);
+      if (i == glitchAxis && !GLITCH_IS_CRC_ERROR) target += glitchCounts;
+      if (target != counts[i]) {
+        Encoders_Move(i, counts[i], target, lastUs, nowUs);
+        counts[i] = target;
+      }
+    }
+    Hal_SetMicros(nowUs);
+    lastUs = nowUs;
+
+    // Commands from the host
+    char input[512];
+    ssize_t n;
+    while ((n = read(master, input, sizeof(input))) > 0) Hal_SerialInject(input, n);
+
+    // Run the firmware
+    for (int i = 0; i < LOOP_CALLS_PER_STEP; i++) {
+      // SETSTREAM TIME restores the firmware's own period
+      if (streamPeriodUs > 0 && kinTask >= 0 && !MotionTrigger_IsEnabled() &&
+          Scheduler_GetTask(kinTask)->periodUs != streamPeriodUs) {
+        Scheduler_SetPeriod(kinTask, streamPeriodUs);
+      }
+      loop();
+    }
+
+    // Output to the pseudo-terminal
+    std::string out = Hal_SerialTake();
+    linesOut += std::count(out.begin(), out.end(), '\n');
+    pending += out;
+    if (pending.size() > MAX_PENDING_OUTPUT) {
+      // Nobody is reading: drop the oldest output
+      size_t excess = pending.size() - MAX_PENDING_OUTPUT;
+      pending.erase(0, excess);
+      bytesDiscarded += excess;
+    }
+    if (!pending.empty() && (chunkMs == 0 || nowUs - lastChunkUs >= chunkMs * 1000ULL)) {
+      ssize_t written = write(master, pending.data(), pending.size());
+      if (written > 0) {
+        pending.erase(0, static_cast<size_t>(written));
+        bytesOut += static_cast<uint64_t>(written);
+      }
+      lastChunkUs = nowUs;
+    }
+
+    // Next step on a fixed grid (no sleep when behind)
+    nextWake.tv_nsec += stepUs * 1000L;
+    while (nextWake.tv_nsec >= 1000000000L) {
+      nextWake.tv_nsec -= 1000000000L;
+      nextWake.tv_sec++;
+    }
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (now.tv_sec > nextWake.tv_sec ||
+        (now.tv_sec == nextWake.tv_sec && now.tv_nsec > nextWake.tv_nsec)) {
+      nextWake = now;
+    } else {
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &nextWake, nullptr);
+    }
+  }
+
+  // --------------------------------------------------------------------------
+  // Summary
+  // --------------------------------------------------------------------------
+  double seconds = std::max(1e-3, std::chrono::duration<double>(Clock::now() - wallStart).count());
+  unsigned long kinMisses = kinTask >= 0 ? Scheduler_GetTask(kinTask)->misses : 0;
+  fprintf(stderr,
+          "INFO,Simulated %.1f s: %.1f lines/s, %.1f KB/s, %llu moves (%llu bursts), "
+          "%llu glitches, %lu stream periods missed, %llu bytes discarded unread\n",
+          seconds, linesOut / seconds, bytesOut / seconds / 1024,
+          static_cast<unsigned long long>(motion.moves()),
+          static_cast<unsigned long long>(motion.bursts()),
+          static_cast<unsigned long long>(glitches), kinMisses,
+          static_cast<unsigned long long>(bytesDiscarded));
+
+  if (linkPath != nullptr) unlink(linkPath);
+  close(master);
+  close(slave);
+  return 0;
+}
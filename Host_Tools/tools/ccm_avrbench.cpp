@@ -0,0 +1,920 @@
+/*
+ * ============================================================================
+ * CCM_AVRBENCH - Cycle-exact firmware benchmark on a simulated ATmega2560
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_avrbench [options] <firmware.elf>
+ *
+ * Options:
+ *   --script FILE      Stimulus script (default: the built-in one below)
+ *   --probe NAME       Also time function NAME (repeatable)
+ *   --uart-log FILE    Save everything the firmware sent
+ *   --baseline FILE    Compare with an earlier report; exit 3 on a regression
+ *   --tolerance PCT    Allowed increase over the baseline (default: 5)
+ *
+ * Runs the real Mega 2560 build of the sketch (arduino-cli, see README)
+ * instruction by instruction under simavr at 16 MHz. Quadrature edges are
+ * driven onto the encoder pins from config.h (ENCODER_PINS_A/B), commands
+ * are typed into USART0 at the configured baud rate and the firmware's
+ * output is read back from it. Host-native timings (ccm_armsim,
+ * ccm_bench) cannot show what the AVR pays for soft-float sin/cos, float
+ * printing or digitalRead() in the encoder ISRs; this does, to the cycle.
+ *
+ * SCRIPT, one event per line ("#" starts a comment):
+ *   <ms> CMD <text>            Type a command (line ending added)
+ *   <ms> VEL <axis|*> <cps>    Drive axis 1..NUM_AXES (or all) at cps
+ *                              counts/s, negative = backwards, 0 = stop
+ *   <ms> END                   Stop the run
+ * Default: START at 500 ms, all axes at 2000 counts/s from 600 ms, END at
+ * 3000 ms.
+ *
+ * MEASUREMENTS (from the ELF symbol table, C++ names demangled):
+ * - isr       every interrupt vector that ran: from the vector to the
+ *             instruction after reti
+ * - latency   per encoder interrupt: from the pin edge to the vector
+ *             (includes the instruction being finished and the hardware
+ *             entry, and any wait behind another interrupt)
+ * - task      scheduler tasks (Task_*), the loop phases
+ * - function  selected firmware functions (Kinematics_Calculate,
+ *             Serial_SendPositionData, ...) and any --probe
+ * - phase     where the cycles went: tasks, interrupts, idle (sleeping)
+ *             and the scheduler itself (everything else)
+ * - sample    per POS / SPOS line emitted: KIN + FRAMES + TX task cycles
+ *             plus the USART0 data-register-empty interrupt that sends
+ *             the bytes
+ * - edges     per axis: count = edges driven, total = edges lost (net
+ *             edges driven minus the change of encoders.count)
+ * Task and function times exclude interrupts that hit them. A function
+ * the compiler inlined (LTO) has no symbol and is reported as not found.
+ *
+ * REPORT (stdout, CSV):
+ *   kind,name,count,min,mean,max,total,share_percent
+ * Values are CPU cycles (62.5 ns each); share = total / run cycles.
+ *
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <cxxabi.h>
+#include <fcntl.h>
+#include <gelf.h>
+#include <libelf.h>
+#include <unistd.h>
+
+extern "C" {
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_uart.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_cycle_timers.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_irq.h>
+}
+
+#include "config.h"
+
+static const uint32_t CPU_HZ = 16000000;
+static const uint32_t SRAM_OFFSET = 0x800000;  // Data addresses in the ELF
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_avrbench [options] <firmware.elf>\n"
+          "  --script FILE      Stimulus script (default: built in)\n"
+          "  --probe NAME       Also time function NAME (repeatable)\n"
+          "  --uart-log FILE    Save the firmware's serial output\n"
+          "  --baseline FILE    Compare with an earlier report (exit 3 on regression)\n"
+          "  --tolerance PCT    Allowed increase over the baseline (default: 5)\n");
+}
+
+static const char* DEFAULT_SCRIPT =
+    "500 CMD START\n"
+    "600 VEL * 2000\n"
+    "3000 END\n";
+
+static const char* TASK_FUNCTIONS[] = {
+    "Task_Sample", "Task_ReceiveCommands", "Task_Kinematics", "Task_Frames",
+    "Task_Transmit", "Task_Burst", "Task_Housekeeping"};
+
+static const char* DEFAULT_PROBES[] = {
+    "Encoder_GetSnapshot", "Velocity_Sample", "JointFilter_SampleCounts", "Encoder_Update",
+    "Kinematics_Calculate", "Serial_StreamPositionData", "Serial_SendPositionData",
+    "Serial_SendVelocityData", "FrameHistory_Transmit", "Serial_CheckForCommands"};
+
+// Tasks whose cycles make up an emitted sample
+static const char* SAMPLE_TASKS[] = {"Task_Kinematics", "Task_Frames", "Task_Transmit"};
+
+// ============================================================================
+// MEGA 2560 PINS AND VECTORS
+// ============================================================================
+struct PinPort {
+  char port;
+  uint8_t bit;
+};
+
+// Arduino digital pin -> port and bit (pins_arduino.h, "mega" variant)
+static const PinPort MEGA_PINS[] = {
+    {'E', 0}, {'E', 1}, {'E', 4}, {'E', 5}, {'G', 5}, {'E', 3}, {'H', 3}, {'H', 4},  //  0-7
+    {'H', 5}, {'H', 6}, {'B', 4}, {'B', 5}, {'B', 6}, {'B', 7}, {'J', 1}, {'J', 0},  //  8-15
+    {'H', 1}, {'H', 0}, {'D', 3}, {'D', 2}, {'D', 1}, {'D', 0}, {'A', 0}, {'A', 1},  // 16-23
+    {'A', 2}, {'A', 3}, {'A', 4}, {'A', 5}, {'A', 6}, {'A', 7}, {'C', 7}, {'C', 6},  // 24-31
+    {'C', 5}, {'C', 4}, {'C', 3}, {'C', 2}, {'C', 1}, {'C', 0}, {'D', 7}, {'G', 2},  // 32-39
+    {'G', 1}, {'G', 0}, {'L', 7}, {'L', 6}, {'L', 5}, {'L', 4}, {'L', 3}, {'L', 2},  // 40-47
+    {'L', 1}, {'L', 0}, {'B', 3}, {'B', 2}, {'B', 1}, {'B', 0},                      // 48-53
+    {'F', 0}, {'F', 1}, {'F', 2}, {'F', 3}, {'F', 4}, {'F', 5}, {'F', 6}, {'F', 7},  // A0-A7
+    {'K', 0}, {'K', 1}, {'K', 2}, {'K', 3}, {'K', 4}, {'K', 5}, {'K', 6}, {'K', 7}}; // A8-A15
+static const int MEGA_PIN_COUNT = sizeof(MEGA_PINS) / sizeof(MEGA_PINS[0]);
+
+// External interrupt vector of a pin (INT0 = vector 1 ... INT5 = 6), 0 = none
+static int ExternalInterruptVector(int pin) {
+  switch (pin) {
+    case 21: return 1;  // INT0
+    case 20: return 2;  // INT1
+    case 19: return 3;  // INT2
+    case 18: return 4;  // INT3
+    case 2:  return 5;  // INT4
+    case 3:  return 6;  // INT5
+    default: return 0;
+  }
+}
+
+// Pin change interrupt vector of a pin (PCINT0 = vector 9 ... PCINT2 = 11),
+// 0 = none
+static int PinChangeVector(int pin) {
+  if ((pin >= 10 && pin <= 13) || (pin >= 50 && pin <= 53)) return 9;  // PCINT0 (port B)
+  if (pin == 14 || pin == 15) return 10;                               // PCINT1 (port J)
+  if (pin >= 62 && pin <= 69) return 11;                               // PCINT2 (port K)
+  return 0;
+}
+
+// Vector that serves an encoder pin (the firmware uses the external
+// interrupt where there is one), 0 = none
+static int EncoderVector(int pin) {
+  int vector = ExternalInterruptVector(pin);
+  return vector != 0 ? vector : PinChangeVector(pin);
+}
+
+static std::string VectorName(int vector) {
+  static const char* NAMES[] = {
+      "RESET", "INT0", "INT1", "INT2", "INT3", "INT4", "INT5", "INT6", "INT7",
+      "PCINT0", "PCINT1", "PCINT2", "WDT", "TIMER2_COMPA", "TIMER2_COMPB", "TIMER2_OVF",
+      "TIMER1_CAPT", "TIMER1_COMPA", "TIMER1_COMPB", "TIMER1_COMPC", "TIMER1_OVF",
+      "TIMER0_COMPA", "TIMER0_COMPB", "TIMER0_OVF", "SPI_STC", "USART0_RX", "USART0_UDRE",
+      "USART0_TX", "ANALOG_COMP", "ADC", "EE_READY"};
+  if (vector >= 0 && vector < static_cast<int>(sizeof(NAMES) / sizeof(NAMES[0]))) {
+    return NAMES[vector];
+  }
+  return "vector_" + std::to_string(vector);
+}
+
+static const int VECTOR_USART0_UDRE = 26;
+static const int VECTOR_COUNT = 57;
+
+// ============================================================================
+// ELF SYMBOLS
+// ============================================================================
+struct Symbols {
+  std::map<std::string, uint32_t> functions;  // Plain name -> flash byte address
+  std::map<std::string, uint32_t> objects;    // Plain name -> SRAM address
+};
+
+// "_Z14Task_Kinematicsv.lto_priv.0" -> "Task_Kinematics"
+static std::string PlainName(const char* raw) {
+  std::string name = raw;
+  size_t dot = name.find('.');
+  if (dot != std::string::npos && dot > 0) name.resize(dot);
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+  if (status == 0 && demangled != nullptr) {
+    name = demangled;
+    free(demangled);
+    size_t paren = name.find('(');
+    if (paren != std::string::npos) name.resize(paren);
+  }
+  return name;
+}
+
+static bool LoadSymbols(const char* path, Symbols& out, std::string& error) {
+  if (elf_version(EV_CURRENT) == EV_NONE) {
+    error = "libelf initialization failed";
+    return false;
+  }
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    error = std::string("Cannot open ") + path + ": " + strerror(errno);
+    return false;
+  }
+  Elf* elf = elf_begin(fd, ELF_C_READ, nullptr);
+  Elf_Scn* section = nullptr;
+  while (elf != nullptr && (section = elf_nextscn(elf, section)) != nullptr) {
+    GElf_Shdr header;
+    if (gelf_getshdr(section, &header) == nullptr || header.sh_type != SHT_SYMTAB) continue;
+    Elf_Data* data = elf_getdata(section, nullptr);
+    size_t count = header.sh_entsize ? header.sh_size / header.sh_entsize : 0;
+    for (size_t i = 0; data != nullptr && i < count; i++) {
+      GElf_Sym symbol;
+      if (gelf_getsym(data, static_cast<int>(i), &symbol) == nullptr) continue;
+      const char* raw = elf_strptr(elf, header.sh_link, symbol.st_name);
+      if (raw == nullptr || raw[0] == '\0') continue;
+      int type = GELF_ST_TYPE(symbol.st_info);
+      if (type == STT_FUNC) {
+        out.functions.emplace(PlainName(raw), static_cast<uint32_t>(symbol.st_value));
+      } else if (type == STT_OBJECT && symbol.st_value >= SRAM_OFFSET) {
+        out.objects.emplace(PlainName(raw), static_cast<uint32_t>(symbol.st_value - SRAM_OFFSET));
+      }
+    }
+  }
+  if (elf != nullptr) elf_end(elf);
+  close(fd);
+  if (out.functions.empty()) {
+    error = std::string(path) + " has no symbol table (built without -g / stripped?)";
+    return false;
+  }
+  return true;
+}
+
+// ============================================================================
+// STATISTICS
+// ============================================================================
+struct CycleStats {
+  uint64_t count = 0;
+  uint64_t total = 0;
+  uint64_t min = UINT64_MAX;
+  uint64_t max = 0;
+
+  void add(uint64_t cycles) {
+    count++;
+    total += cycles;
+    min = std::min(min, cycles);
+    max = std::max(max, cycles);
+  }
+};
+
+// ============================================================================
+// SIMULATION STATE
+// ============================================================================
+struct AxisDrive {
+  int pinA = 0, pinB = 0;
+  avr_irq_t* irqA = nullptr;
+  avr_irq_t* irqB = nullptr;
+  bool a = false, b = false;
+  double countsPerSecond = 0;
+  uint64_t edges = 0;
+  int64_t net = 0;            // Forward minus backward edges
+  int32_t startCount = 0;     // encoders.count when driving started
+};
+
+struct ScriptEvent {
+  uint32_t ms;
+  std::string action;  // CMD, VEL, END
+  std::string text;    // Command
+  int axis = 0;        // VEL: 1..NUM_AXES, 0 = all
+  double cps = 0;
+};
+
+// A function or interrupt being executed
+struct Frame {
+  int kind;            // 0 = function, 1 = interrupt
+  int id;              // Probe index or vector
+  uint16_t entrySp;
+  uint64_t entryCycle;
+  uint64_t isrAtEntry; // Interrupt cycles so far, to exclude them
+};
+
+struct Bench {
+  avr_t* avr = nullptr;
+  std::vector<AxisDrive> axes;
+  uint32_t encodersAddress = 0;
+  bool haveEncoders = false;
+
+  // UART
+  avr_irq_t* uartIn = nullptr;
+  std::string typing;          // Bytes still to type
+  uint32_t byteCycles = 0;
+  std::string lineBuffer;
+  uint64_t sampleLines = 0;
+  FILE* uartLog = nullptr;
+
+  // Script
+  std::vector<ScriptEvent> script;
+  size_t nextEvent = 0;
+  bool ended = false;
+
+  // Profiling
+  std::vector<std::string> probeNames;  // Tasks first, then functions
+  size_t taskProbes = 0;
+  std::map<uint32_t, int> probeAt;      // Entry address -> probe index
+  std::vector<CycleStats> probeStats;
+  std::map<int, CycleStats> isrStats;
+  std::map<int, CycleStats> latencyStats;  // Per vector
+  std::map<int, std::string> vectorPins;   // Vector -> encoder pins ("62/63")
+  std::map<int, uint64_t> edgePending;     // Vector -> cycle of the unserviced edge
+  std::vector<Frame> frames;
+  uint64_t isrCycles = 0;
+  uint64_t idleCycles = 0;
+  uint32_t lastPc = UINT32_MAX;
+};
+
+static uint16_t StackPointer(avr_t* avr) {
+  return static_cast<uint16_t>(avr->data[R_SPL] | (avr->data[R_SPH] << 8));
+}
+
+static int32_t ReadEncoderCount(Bench& bench, int axis) {
+  uint32_t address = bench.encodersAddress + 4 * axis;  // EncoderState.count[]
+  const uint8_t* p = bench.avr->data + address;
+  return static_cast<int32_t>(p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24));
+}
+
+// ============================================================================
+// QUADRATURE EDGES
+// ============================================================================
+static void MarkEdge(Bench& bench, int pin) {
+  int vector = EncoderVector(pin);
+  if (vector == 0) return;
+  // A second edge before the first was serviced is lost on the hardware
+  // too (one flag per interrupt) - the edges row shows it. A pin change
+  // vector serves a bank of 8 pins; its latency is from the first edge.
+  if (bench.edgePending.find(vector) == bench.edgePending.end()) {
+    bench.edgePending[vector] = bench.avr->cycle;
+  }
+}
+
+// Forward (decoder counts up): toggle B when A == B, else A
+static void StepAxis(Bench& bench, AxisDrive& axis, bool forward) {
+  bool toggleB = (axis.a == axis.b) == forward;
+  if (toggleB) {
+    axis.b = !axis.b;
+    MarkEdge(bench, axis.pinB);
+    avr_raise_irq(axis.irqB, axis.b);
+  } else {
+    axis.a = !axis.a;
+    MarkEdge(bench, axis.pinA);
+    avr_raise_irq(axis.irqA, axis.a);
+  }
+  axis.edges++;
+  axis.net += forward ? 1 : -1;
+}
+
+struct AxisTimer {
+  Bench* bench;
+  size_t index;
+};
+
+static avr_cycle_count_t OnAxisTimer(avr_t* avr, avr_cycle_count_t when, void* param) {
+  AxisTimer* timer = static_cast<AxisTimer*>(param);
+  AxisDrive& axis = timer->bench->axes[timer->index];
+  if (axis.countsPerSecond == 0) return when + CPU_HZ / 1000;  // Idle: look again in 1 ms
+  StepAxis(*timer->bench, axis, axis.countsPerSecond > 0);
+  double period = CPU_HZ / std::fabs(axis.countsPerSecond);
+  (void)avr;
+  return when + std::max<avr_cycle_count_t>(1, static_cast<avr_cycle_count_t>(period + 0.5));
+}
+
+// ============================================================================
+// UART
+// ============================================================================
+static void OnUartByte(avr_irq_t*, uint32_t value, void* param) {
+  Bench& bench = *static_cast<Bench*>(param);
+  char c = static_cast<char>(value);
+  if (bench.uartLog != nullptr) fputc(c, bench.uartLog);
+  if (c == '\n') {
+    if (bench.lineBuffer.compare(0, 4, "POS,") == 0 || bench.lineBuffer.compare(0, 5, "SPOS,") == 0) {
+      bench.sampleLines++;
+    }
+    bench.lineBuffer.clear();
+  } else if (c != '\r' && bench.lineBuffer.size() < 256) {
+    bench.lineBuffer += c;
+  }
+}
+
+// One byte per character time, like a terminal at the configured baud rate
+static avr_cycle_count_t OnTypeTimer(avr_t*, avr_cycle_count_t when, void* param) {
+  Bench& bench = *static_cast<Bench*>(param);
+  if (!bench.typing.empty()) {
+    avr_raise_irq(bench.uartIn, static_cast<uint8_t>(bench.typing[0]));
+    bench.typing.erase(0, 1);
+  }
+  return when + bench.byteCycles;
+}
+
+// ============================================================================
+// SCRIPT
+// ============================================================================
+static bool ParseScript(const std::string& text, std::vector<ScriptEvent>& out, std::string& error) {
+  size_t start = 0;
+  int lineNumber = 0;
+  while (start < text.size()) {
+    size_t end = text.find('\n', start);
+    if (end == std::string::npos) end = text.size();
+    std::string line = text.substr(start, end - start);
+    start = end + 1;
+    lineNumber++;
+
+    size_t hash = line.find('#');
+    if (hash != std::string::npos) line.resize(hash);
+    char action[8] = {};
+    unsigned ms = 0;
+    int used = 0;
+    if (sscanf(line.c_str(), " %u %7s %n", &ms, action, &used) < 2) {
+      if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+      error = "script line " + std::to_string(lineNumber) + ": expected <ms> <action>";
+      return false;
+    }
+
+    ScriptEvent event;
+    event.ms = ms;
+    event.action = action;
+    std::string rest = line.substr(used);
+    while (!rest.empty() && (rest.back() == '\r' || rest.back() == ' ')) rest.pop_back();
+
+    if (event.action == "CMD") {
+      event.text = rest;
+    } else if (event.action == "VEL") {
+      char axis[8] = {};
+      if (sscanf(rest.c_str(), "%7s %lf", axis, &event.cps) != 2) {
+        error = "script line " + std::to_string(lineNumber) + ": VEL <axis|*> <counts/s>";
+        return false;
+      }
+      event.axis = strcmp(axis, "*") == 0 ? 0 : atoi(axis);
+      if (event.axis < 0 || event.axis > NUM_AXES) {
+        error = "script line " + std::to_string(lineNumber) + ": no axis " + axis;
+        return false;
+      }
+    } else if (event.action != "END") {
+      error = "script line " + std::to_string(lineNumber) + ": unknown action " + event.action;
+      return false;
+    }
+    out.push_back(event);
+  }
+  std::stable_sort(out.begin(), out.end(),
+                   [](const ScriptEvent& a, const ScriptEvent& b) { return a.ms < b.ms; });
+  if (out.empty() || out.back().action != "END") {
+    error = "script has no END";
+    return false;
+  }
+  return true;
+}
+
+static avr_cycle_count_t OnScriptTimer(avr_t* avr, avr_cycle_count_t when, void* param) {
+  Bench& bench = *static_cast<Bench*>(param);
+  uint64_t nowMs = avr->cycle / (CPU_HZ / 1000);
+  while (bench.nextEvent < bench.script.size() && bench.script[bench.nextEvent].ms <= nowMs) {
+    const ScriptEvent& event = bench.script[bench.nextEvent++];
+    if (event.action == "CMD") {
+      bench.typing += event.text + "\r\n";
+    } else if (event.action == "VEL") {
+      for (size_t i = 0; i < bench.axes.size(); i++) {
+        if (event.axis == 0 || event.axis == static_cast<int>(i) + 1) {
+          bench.axes[i].countsPerSecond = event.cps;
+        }
+      }
+    } else {
+      bench.ended = true;
+      return 0;
+    }
+  }
+  return when + CPU_HZ / 1000;
+}
+
+// ============================================================================
+// PROFILING - called after every instruction
+// ============================================================================
+static void FinishFrame(Bench& bench, const Frame& frame) {
+  uint64_t cycles = bench.avr->cycle - frame.entryCycle;
+  if (frame.kind == 1) {
+    bench.isrStats[frame.id].add(cycles);
+    bench.isrCycles += cycles;
+  } else {
+    uint64_t interrupted = bench.isrCycles - frame.isrAtEntry;
+    bench.probeStats[frame.id].add(cycles - std::min(cycles, interrupted));
+  }
+}
+
+static void Profile(Bench& bench) {
+  avr_t* avr = bench.avr;
+  uint32_t pc = avr->pc;
+  if (pc == bench.lastPc) return;  // Sleeping
+  bench.lastPc = pc;
+  uint16_t sp = StackPointer(avr);
+
+  // Returned (ret / reti popped the return address): the stack pointer is
+  // back above where it was on entry. A tail call shares its caller's
+  // entry, so both end together.
+  while (!bench.frames.empty() && sp > bench.frames.back().entrySp) {
+    FinishFrame(bench, bench.frames.back());
+    bench.frames.pop_back();
+  }
+
+  uint32_t vectorBytes = avr->vector_size;
+  if (pc > 0 && pc < VECTOR_COUNT * vectorBytes && pc % vectorBytes == 0) {
+    int vector = static_cast<int>(pc / vectorBytes);
+    bench.frames.push_back({1, vector, sp, avr->cycle, bench.isrCycles});
+    auto pending = bench.edgePending.find(vector);
+    if (pending != bench.edgePending.end()) {
+      bench.latencyStats[vector].add(avr->cycle - pending->second);
+      bench.edgePending.erase(pending);
+    }
+    return;
+  }
+
+  auto probe = bench.probeAt.find(pc);
+  if (probe != bench.probeAt.end()) {
+    bench.frames.push_back({0, probe->second, sp, avr->cycle, bench.isrCycles});
+  }
+}
+
+// ============================================================================
+// REPORT
+// ============================================================================
+struct ReportRow {
+  std::string kind, name;
+  uint64_t count = 0;
+  double min = 0, mean = 0, max = 0, total = 0;
+  bool timing = true;  // false: edges row (only count and total)
+};
+
+static void PrintRow(FILE* out, const ReportRow& row, uint64_t runCycles) {
+  if (!row.timing) {
+    fprintf(out, "%s,%s,%llu,,,,%.0f,\n", row.kind.c_str(), row.name.c_str(),
+            static_cast<unsigned long long>(row.count), row.total);
+    return;
+  }
+  fprintf(out, "%s,%s,%llu,%.0f,%.1f,%.0f,%.0f,%.3f\n", row.kind.c_str(), row.name.c_str(),
+          static_cast<unsigned long long>(row.count), row.min, row.mean, row.max, row.total,
+          runCycles ? 100.0 * row.total / runCycles : 0.0);
+}
+
+static ReportRow StatsRow(const std::string& kind, const std::string& name, const CycleStats& s) {
+  ReportRow row;
+  row.kind = kind;
+  row.name = name;
+  row.count = s.count;
+  row.min = s.count ? static_cast<double>(s.min) : 0;
+  row.mean = s.count ? static_cast<double>(s.total) / s.count : 0;
+  row.max = static_cast<double>(s.max);
+  row.total = static_cast<double>(s.total);
+  return row;
+}
+
+// Rows of an earlier report, by kind,name
+static bool LoadBaseline(const char* path, std::map<std::string, ReportRow>& out, std::string& error) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    error = std::string("Cannot open ") + path + ": " + strerror(errno);
+    return false;
+  }
+  char line[512];
+  while (fgets(line, sizeof(line), file)) {
+    char kind[32], name[200];
+    unsigned long long count;
+    double min, mean, max, total;
+    ReportRow row;
+    if (sscanf(line, "%31[^,],%199[^,],%llu,%lf,%lf,%lf,%lf", kind, name, &count, &min, &mean,
+               &max, &total) == 7) {
+      row.min = min;
+      row.mean = mean;
+      row.max = max;
+      row.total = total;
+    } else if (sscanf(line, "%31[^,],%199[^,],%llu,,,,%lf", kind, name, &count, &total) == 4) {
+      row.timing = false;
+      row.total = total;
+    } else {
+      continue;  // Header
+    }
+    row.kind = kind;
+    row.name = name;
+    row.count = count;
+    out[row.kind + "," + row.name] = row;
+  }
+  fclose(file);
+  return true;
+}
+
+// Returns the number of regressions (printed on stderr)
+static int CompareWithBaseline(const std::vector<ReportRow>& rows,
+                               const std::map<std::string, ReportRow>& baseline, double tolerance) {
+  // A few cycles of slack so tiny timings do not flap
+  const double SLACK_CYCLES = 8;
+  int regressions = 0;
+  for (const ReportRow& row : rows) {
+    if (row.kind == "phase") continue;  // Shares of a run, not costs
+    auto old = baseline.find(row.kind + "," + row.name);
+    if (old == baseline.end()) continue;
+
+    if (!row.timing) {
+      if (row.total > old->second.total) {
+        fprintf(stderr, "REGRESSION,%s,%s,lost,%.0f,%.0f\n", row.kind.c_str(), row.name.c_str(),
+                old->second.total, row.total);
+        regressions++;
+      }
+      continue;
+    }
+    if (row.count == 0 || old->second.count == 0) continue;
+    const char* fields[] = {"mean", "max"};
+    double before[] = {old->second.mean, old->second.max};
+    double now[] = {row.mean, row.max};
+    for (int i = 0; i < 2; i++) {
+      if (now[i] > before[i] * (1 + tolerance / 100) + SLACK_CYCLES) {
+        fprintf(stderr, "REGRESSION,%s,%s,%s,%.1f,%.1f\n", row.kind.c_str(), row.name.c_str(),
+                fields[i], before[i], now[i]);
+        regressions++;
+      }
+    }
+  }
+  return regressions;
+}
+
+static bool ReadFile(const char* path, std::string& out) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) return false;
+  char buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) out.append(buffer, n);
+  fclose(file);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  const char* scriptPath = nullptr;
+  const char* uartLogPath = nullptr;
+  const char* baselinePath = nullptr;
+  const char* elfPath = nullptr;
+  double tolerance = 5;
+  std::vector<std::string> extraProbes;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--script") == 0 && hasValue) {
+      scriptPath = argv[++i];
+    } else if (strcmp(arg, "--probe") == 0 && hasValue) {
+      extraProbes.push_back(argv[++i]);
+    } else if (strcmp(arg, "--uart-log") == 0 && hasValue) {
+      uartLogPath = argv[++i];
+    } else if (strcmp(arg, "--baseline") == 0 && hasValue) {
+      baselinePath = argv[++i];
+    } else if (strcmp(arg, "--tolerance") == 0 && hasValue) {
+      tolerance = atof(argv[++i]);
+    } else if (arg[0] == '-' || elfPath != nullptr) {
+      printUsage();
+      return 1;
+    } else {
+      elfPath = arg;
+    }
+  }
+
+  if (elfPath == nullptr || tolerance < 0) {
+    printUsage();
+    return 1;
+  }
+
+  Bench bench;
+  std::string error;
+
+  std::string scriptText = DEFAULT_SCRIPT;
+  if (scriptPath != nullptr) {
+    scriptText.clear();
+    if (!ReadFile(scriptPath, scriptText)) {
+      fprintf(stderr, "ERROR,Cannot read %s: %s\n", scriptPath, strerror(errno));
+      return 1;
+    }
+  }
+  if (!ParseScript(scriptText, bench.script, error)) {
+    fprintf(stderr, "ERROR,%s\n", error.c_str());
+    return 1;
+  }
+
+  std::map<std::string, ReportRow> baseline;
+  if (baselinePath != nullptr && !LoadBaseline(baselinePath, baseline, error)) {
+    fprintf(stderr, "ERROR,%s\n", error.c_str());
+    return 1;
+  }
+
+  // --------------------------------------------------------------------------
+  // Firmware and symbols
+  // --------------------------------------------------------------------------
+  Symbols symbols;
+  if (!LoadSymbols(elfPath, symbols, error)) {
+    fprintf(stderr, "ERROR,%s\n", error.c_str());
+    return 1;
+  }
+
+  elf_firmware_t firmware;
+  memset(&firmware, 0, sizeof(firmware));
+  if (elf_read_firmware(elfPath, &firmware) != 0) {
+    fprintf(stderr, "ERROR,Cannot load %s\n", elfPath);
+    return 1;
+  }
+  strcpy(firmware.mmcu, "atmega2560");
+  firmware.frequency = CPU_HZ;
+
+  bench.avr = avr_make_mcu_by_name("atmega2560");
+  if (bench.avr == nullptr || avr_init(bench.avr) != 0) {
+    fprintf(stderr, "ERROR,simavr has no atmega2560 core\n");
+    return 1;
+  }
+  avr_load_firmware(bench.avr, &firmware);
+  avr_t* avr = bench.avr;
+
+  for (const char* name : TASK_FUNCTIONS) bench.probeNames.push_back(name);
+  bench.taskProbes = bench.probeNames.size();
+  for (const char* name : DEFAULT_PROBES) bench.probeNames.push_back(name);
+  for (const std::string& name : extraProbes) bench.probeNames.push_back(name);
+  bench.probeStats.resize(bench.probeNames.size());
+  for (size_t i = 0; i < bench.probeNames.size(); i++) {
+    auto symbol = symbols.functions.find(bench.probeNames[i]);
+    if (symbol == symbols.functions.end()) {
+      fprintf(stderr, "INFO,%s not found (inlined?)\n", bench.probeNames[i].c_str());
+      continue;
+    }
+    bench.probeAt.emplace(symbol->second, static_cast<int>(i));
+  }
+
+  auto encoders = symbols.objects.find("encoders");
+  bench.haveEncoders = encoders != symbols.objects.end();
+  if (bench.haveEncoders) bench.encodersAddress = encoders->second;
+
+  // --------------------------------------------------------------------------
+  // Encoder pins
+  // --------------------------------------------------------------------------
+  const int pinsA[NUM_AXES] = ENCODER_PINS_A;
+  const int pinsB[NUM_AXES] = ENCODER_PINS_B;
+  bench.axes.resize(NUM_AXES);
+  for (int i = 0; i < NUM_AXES; i++) {
+    AxisDrive& axis = bench.axes[i];
+    axis.pinA = pinsA[i];
+    axis.pinB = pinsB[i];
+    if (axis.pinA >= MEGA_PIN_COUNT || axis.pinB >= MEGA_PIN_COUNT) {
+      fprintf(stderr, "ERROR,Axis %d: pin out of range\n", i + 1);
+      return 1;
+    }
+    const PinPort& a = MEGA_PINS[axis.pinA];
+    const PinPort& b = MEGA_PINS[axis.pinB];
+    axis.irqA = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(a.port), a.bit);
+    axis.irqB = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(b.port), b.bit);
+    avr_raise_irq(axis.irqA, 0);
+    avr_raise_irq(axis.irqB, 0);
+    for (int pin : {axis.pinA, axis.pinB}) {
+      int vector = EncoderVector(pin);
+      if (vector == 0) {
+        fprintf(stderr, "INFO,Axis %d: pin %d has no interrupt\n", i + 1, pin);
+        continue;
+      }
+      std::string& pins = bench.vectorPins[vector];
+      pins += (pins.empty() ? "" : "/") + std::to_string(pin);
+    }
+  }
+  std::vector<AxisTimer> axisTimers(NUM_AXES);
+  for (int i = 0; i < NUM_AXES; i++) {
+    axisTimers[i] = {&bench, static_cast<size_t>(i)};
+    avr_cycle_timer_register(avr, CPU_HZ / 1000, OnAxisTimer, &axisTimers[i]);
+  }
+
+  // --------------------------------------------------------------------------
+  // UART and script
+  // --------------------------------------------------------------------------
+  uint32_t uartFlags = 0;
+  avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &uartFlags);
+  uartFlags &= ~AVR_UART_FLAG_STDIO;
+  avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &uartFlags);
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT),
+                          OnUartByte, &bench);
+  bench.uartIn = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+  bench.byteCycles = static_cast<uint32_t>(CPU_HZ * 10ULL / SERIAL_BAUD_RATE);
+  avr_cycle_timer_register(avr, bench.byteCycles, OnTypeTimer, &bench);
+  avr_cycle_timer_register(avr, 1, OnScriptTimer, &bench);
+
+  if (uartLogPath != nullptr) {
+    bench.uartLog = fopen(uartLogPath, "w");
+    if (bench.uartLog == nullptr) {
+      fprintf(stderr, "ERROR,Cannot create %s: %s\n", uartLogPath, strerror(errno));
+      return 1;
+    }
+  }
+
+  // --------------------------------------------------------------------------
+  // Run
+  // --------------------------------------------------------------------------
+  bool countsRead = false;
+  int state = cpu_Running;
+  while (!bench.ended) {
+    uint64_t before = avr->cycle;
+    bool sleeping = avr->state == cpu_Sleeping;
+    state = avr_run(avr);
+    if (state == cpu_Done || state == cpu_Crashed) break;
+    if (sleeping) bench.idleCycles += avr->cycle - before;
+    Profile(bench);
+
+    // Reference counts once the firmware is up and before the axes move
+    if (!countsRead && bench.haveEncoders && bench.nextEvent > 0) {
+      for (int i = 0; i < NUM_AXES; i++) bench.axes[i].startCount = ReadEncoderCount(bench, i);
+      countsRead = true;
+    }
+  }
+  uint64_t runCycles = avr->cycle;
+  if (bench.uartLog != nullptr) fclose(bench.uartLog);
+  if (state == cpu_Crashed) {
+    fprintf(stderr, "ERROR,Firmware crashed at pc 0x%05x after %llu cycles\n", avr->pc,
+            static_cast<unsigned long long>(runCycles));
+    return 1;
+  }
+
+  // --------------------------------------------------------------------------
+  // Report
+  // --------------------------------------------------------------------------
+  std::vector<ReportRow> rows;
+  uint64_t taskCycles = 0;
+  for (const auto& entry : bench.isrStats) {
+    std::string name = VectorName(entry.first);
+    auto pins = bench.vectorPins.find(entry.first);
+    if (pins != bench.vectorPins.end()) name += " pin " + pins->second;
+    rows.push_back(StatsRow("isr", name, entry.second));
+  }
+  for (const auto& entry : bench.latencyStats) {
+    std::string name = VectorName(entry.first) + " pin " + bench.vectorPins[entry.first];
+    rows.push_back(StatsRow("latency", name, entry.second));
+  }
+  for (size_t i = 0; i < bench.probeNames.size(); i++) {
+    if (bench.probeStats[i].count == 0) continue;
+    bool task = i < bench.taskProbes;
+    if (task) taskCycles += bench.probeStats[i].total;
+    rows.push_back(StatsRow(task ? "task" : "function", bench.probeNames[i], bench.probeStats[i]));
+  }
+
+  // Where the cycles went
+  uint64_t accounted = taskCycles + bench.isrCycles + bench.idleCycles;
+  const char* phaseNames[] = {"tasks", "interrupts", "idle", "scheduler"};
+  uint64_t phaseCycles[] = {taskCycles, bench.isrCycles, bench.idleCycles,
+                            runCycles > accounted ? runCycles - accounted : 0};
+  for (int i = 0; i < 4; i++) {
+    ReportRow row;
+    row.kind = "phase";
+    row.name = phaseNames[i];
+    row.count = 1;
+    row.min = row.mean = row.max = row.total = static_cast<double>(phaseCycles[i]);
+    rows.push_back(row);
+  }
+
+  // Per emitted sample
+  if (bench.sampleLines > 0) {
+    double cycles = 0;
+    for (const char* name : SAMPLE_TASKS) {
+      auto it = std::find(bench.probeNames.begin(), bench.probeNames.end(), name);
+      cycles += bench.probeStats[it - bench.probeNames.begin()].total;
+    }
+    auto udre = bench.isrStats.find(VECTOR_USART0_UDRE);
+    if (udre != bench.isrStats.end()) cycles += udre->second.total;
+    ReportRow row;
+    row.kind = "sample";
+    row.name = "line";
+    row.count = bench.sampleLines;
+    row.min = row.max = row.mean = cycles / bench.sampleLines;
+    row.total = cycles;
+    rows.push_back(row);
+  }
+
+  // Edges lost by the decoder
+  for (int i = 0; i < NUM_AXES; i++) {
+    const AxisDrive& axis = bench.axes[i];
+    ReportRow row;
+    row.kind = "edges";
+    row.name = "axis" + std::to_string(i + 1);
+    row.count = axis.edges;
+    row.timing = false;
+    if (bench.haveEncoders) {
+      int64_t counted = static_cast<int64_t>(ReadEncoderCount(bench, i)) - axis.startCount;
+      row.total = static_cast<double>(std::llabs(axis.net - counted));
+    }
+    rows.push_back(row);
+  }
+
+  printf("kind,name,count,min,mean,max,total,share_percent\n");
+  for (const ReportRow& row : rows) PrintRow(stdout, row, runCycles);
+
+  fprintf(stderr, "INFO,%.3f s simulated, %llu sample lines, CPU %.1f%% busy\n",
+          runCycles / static_cast<double>(CPU_HZ), static_cast<unsigned long long>(bench.sampleLines),
+          runCycles ? 100.0 * (runCycles - bench.idleCycles) / runCycles : 0.0);
+  if (!bench.haveEncoders) fprintf(stderr, "INFO,No encoders symbol: lost edges not checked\n");
+
+  if (baselinePath != nullptr) {
+    int regressions = CompareWithBaseline(rows, baseline, tolerance);
+    if (regressions > 0) {
+      fprintf(stderr, "INFO,%d regression(s) against %s\n", regressions, baselinePath);
+      return 3;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,510 @@
+/*
+ * ============================================================================
+ * CCM_BENCH - Host pipeline benchmark over recorded sessions
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_bench [options] <capture|directory>...
+ *
+ * Options:
+ *   --runs N             Timed runs per capture; the median is reported (default: 3)
+ *   --speed X            0 = as fast as possible (default); otherwise the
+ *                        capture is paced like ccm_replay --speed X
+ *   --format xyz|ply|csv Export format (default: ply)
+ *   --export-dir DIR     Keep the exports in DIR (default: written to /dev/null)
+ *   --fit-window N       Points per geometry fit (default: 256)
+ *   --batch N            Points per PointBatch (default: 65536)
+ *
+ * Every capture (capture_file.h; directories are searched for *.ccmcap) is
+ * loaded into memory and the arm's side of it is pushed through the host
+ * pipeline in-process, one recorded read() at a time:
+ *
+ *   split   bytes -> lines (as SerialPort does)
+ *   parse   POS lines and SPOS frames (through FrameTracker) -> samples
+ *   store   samples -> PointBatch (the host's CSVExporter equivalent)
+ *   fit     circle, plane and line fits over the last --fit-window points
+ *           (geometry_fit.h, the app's GeometryCalculator algorithms)
+ *   export  full batches -> PointCloudExporter -> BufferedWriter
+ *
+ * Results go to stdout as CSV, one row per capture:
+ *
+ *   capture,arm_bytes,recorded_s,lines,samples,malformed,run_s,mb_per_s,
+ *   samples_per_s,x_realtime,split_ns,parse_ns,store_ns,fit_ns,export_ns,
+ *   lat_p50_us,lat_p90_us,lat_p99_us,lat_p999_us,lat_max_us,capture_mb,
+ *   peak_rss_mb
+ *
+ * Stage times are per line (split, parse) or per sample (store, fit,
+ * export). Latency is per recorded read: from its arrival (the moment it
+ * is handed over, or its paced due time with --speed) until every sample
+ * in it has been stored, fitted and, when a batch filled, exported.
+ * peak_rss_mb is the process's high-water mark so far, capture_mb the
+ * loaded capture's share of it. A first untimed pass counts the samples
+ * and warms the caches.
+ *
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/resource.h>
+#include <time.h>
+
+#include "../src/buffered_writer.h"
+#include "../src/capture_file.h"
+#include "../src/frame_tracker.h"
+#include "../src/geometry_fit.h"
+#include "../src/point_batch.h"
+#include "../src/point_cloud_exporter.h"
+#include "../src/serial_port.h"
+
+static const char* CAPTURE_EXTENSION = ".ccmcap";
+
+// Fit results land here so the compiler cannot drop the fits
+static volatile double fitSink;
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_bench [options] <capture|directory>...\n"
+          "  --runs N             Timed runs per capture (default: 3)\n"
+          "  --speed X            0 = as fast as possible (default), else paced\n"
+          "  --format xyz|ply|csv Export format (default: ply)\n"
+          "  --export-dir DIR     Keep the exports (default: /dev/null)\n"
+          "  --fit-window N       Points per geometry fit (default: 256)\n"
+          "  --batch N            Points per PointBatch (default: 65536)\n");
+}
+
+struct BenchOptions {
+  int runs = 3;
+  double speed = 0;
+  ExportOptions exportOptions;
+  std::string exportDir;
+  size_t fitWindow = 256;
+  size_t batchSize = 65536;
+};
+
+// The arm's side of a capture, in memory
+struct LoadedCapture {
+  std::string name;
+  std::vector<char> data;
+  std::vector<size_t> start;   // Record i is data[start[i], start[i + 1])
+  std::vector<int64_t> timeUs;
+  bool truncated = false;
+
+  size_t records() const { return timeUs.size(); }
+};
+
+struct RunResult {
+  uint64_t lines = 0;
+  uint64_t samples = 0;
+  uint64_t malformed = 0;
+  int64_t totalNs = 0;
+  int64_t splitNs = 0, parseNs = 0, storeNs = 0, fitNs = 0, exportNs = 0;
+  std::vector<int64_t> latencyNs;  // One per record
+  std::string error;
+};
+
+struct Sample {
+  int64_t time;
+  double xyz[3];
+};
+
+// ============================================================================
+// LOADING
+// ============================================================================
+static bool LoadCapture(const std::string& path, LoadedCapture& out, std::string& error) {
+  CaptureReader reader;
+  if (!reader.open(path)) {
+    error = reader.error();
+    return false;
+  }
+  out.name = std::filesystem::path(path).filename().string();
+  CaptureRecord record;
+  while (reader.next(record)) {
+    if (record.direction != CAPTURE_FROM_ARM) continue;
+    out.start.push_back(out.data.size());
+    out.timeUs.push_back(record.timeUs);
+    out.data.insert(out.data.end(), record.data, record.data + record.length);
+  }
+  out.start.push_back(out.data.size());
+  out.truncated = reader.truncated();
+  error = reader.error();
+  return error.empty();
+}
+
+static void FindCaptures(const char* arg, std::vector<std::string>& paths) {
+  std::error_code ec;
+  if (!std::filesystem::is_directory(arg, ec)) {
+    paths.push_back(arg);
+    return;
+  }
+  std::vector<std::string> found;
+  for (const auto& entry : std::filesystem::directory_iterator(arg, ec)) {
+    if (entry.path().extension() == CAPTURE_EXTENSION) found.push_back(entry.path().string());
+  }
+  std::sort(found.begin(), found.end());
+  paths.insert(paths.end(), found.begin(), found.end());
+}
+
+// ============================================================================
+// PIPELINE STAGES
+// ============================================================================
+// timestamp,x,y,z[,...] as in POS lines and SPOS frames (ArmConnection::addSample)
+static bool ParseSampleFields(const char* fields, Sample& sample) {
+  char* end;
+  sample.time = strtoll(fields, &end, 10);
+  if (end == fields || *end != ',') return false;
+  for (int i = 0; i < 3; i++) {
+    const char* start = end + 1;
+    sample.xyz[i] = strtod(start, &end);
+    if (end == start || (*end != ',' && *end != '\0' && *end != '\r' && *end != '\n')) return false;
+  }
+  return true;
+}
+
+class BenchPipeline {
+public:
+  BenchPipeline(const BenchOptions& options, PointCloudExporter* exporter)
+      : opts(options), exporter(exporter), batch(options.batchSize) {}
+
+  // One recorded read; nowUs is its capture time (drives RESEND give-up)
+  void process(const char* data, size_t length, int64_t nowUs, RunResult& result) {
+    int64_t t0 = HostClock_NowNs();
+    split(data, length);
+    int64_t t1 = HostClock_NowNs();
+    parse(nowUs, result);
+    int64_t t2 = HostClock_NowNs();
+    result.splitNs += t1 - t0;
+    result.parseNs += t2 - t1;
+    store(result);
+  }
+
+  // End of the capture: give up on frames still missing (nothing will
+  // answer the RESENDs), flush the batch
+  void finish(int64_t endUs, RunResult& result) {
+    for (int i = 1; i <= 16 && tracker.missingCount() > 0; i++) {
+      tracker.resendRequests((endUs + i * 1000000LL) * 1000);
+    }
+    popFrames(result);
+    store(result);
+    int64_t t0 = HostClock_NowNs();
+    flush();
+    result.exportNs += HostClock_NowNs() - t0;
+  }
+
+private:
+  void split(const char* data, size_t length) {
+    lines.clear();
+    const char* end = data + length;
+    const char* p = data;
+
+    if (!carry.empty()) {
+      const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+      if (newline == nullptr) {
+        carry.append(p, end - p);
+        return;
+      }
+      carry.append(p, newline - p);
+      joined.swap(carry);
+      carry.clear();
+      addLine(joined.data(), joined.size());
+      p = newline + 1;
+    }
+
+    while (p < end) {
+      const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+      if (newline == nullptr) {
+        carry.assign(p, end - p);
+        break;
+      }
+      addLine(p, newline - p);
+      p = newline + 1;
+    }
+  }
+
+  void addLine(const char* text, size_t length) {
+    if (length > 0 && text[length - 1] == '\r') length--;
+    lines.emplace_back(text, length);
+  }
+
+  void parse(int64_t nowUs, RunResult& result) {
+    parsed.clear();
+    for (std::string_view line : lines) {
+      result.lines++;
+      if (line.compare(0, 4, "POS,") == 0) {
+        Sample sample;
+        if (ParseSampleFields(line.data() + 4, sample)) parsed.push_back(sample);
+        else result.malformed++;
+      } else if (line.compare(0, 5, "SPOS,") == 0 || line.compare(0, 6, "SLOST,") == 0) {
+        frameLine.assign(line.data(), line.size());
+        tracker.handleLine(frameLine);
+        popFrames(result);
+        if (tracker.missingCount() > 0) tracker.resendRequests(nowUs * 1000);
+      }
+    }
+  }
+
+  void popFrames(RunResult& result) {
+    SequencedFrame frame;
+    while (tracker.popFrame(frame)) {
+      Sample sample;
+      if (ParseSampleFields(frame.fields.c_str(), sample)) parsed.push_back(sample);
+      else result.malformed++;
+    }
+  }
+
+  void store(RunResult& result) {
+    int64_t storeNs = 0, fitNs = 0, exportNs = 0;
+    int64_t t = HostClock_NowNs();
+
+    for (const Sample& s : parsed) {
+      if (batch.full()) {
+        int64_t t1 = HostClock_NowNs();
+        storeNs += t1 - t;
+        flush();
+        t = HostClock_NowNs();
+        exportNs += t - t1;
+      }
+      batch.push(++result.samples, POINT_TYPE_LIVE, s.xyz[0], s.xyz[1], s.xyz[2], "", s.time);
+
+      if (++sinceFit >= opts.fitWindow && batch.count >= opts.fitWindow) {
+        int64_t t1 = HostClock_NowNs();
+        storeNs += t1 - t;
+        fit();
+        sinceFit = 0;
+        t = HostClock_NowNs();
+        fitNs += t - t1;
+      }
+    }
+    storeNs += HostClock_NowNs() - t;
+    parsed.clear();
+
+    result.storeNs += storeNs;
+    result.fitNs += fitNs;
+    result.exportNs += exportNs;
+  }
+
+  void fit() {
+    size_t first = batch.count - opts.fitWindow;
+    const double* x = batch.x.data() + first;
+    const double* y = batch.y.data() + first;
+    const double* z = batch.z.data() + first;
+    CircleFit circle;
+    PlaneFit plane;
+    LineFit line;
+    Geometry_FitCircle(x, y, z, opts.fitWindow, circle);
+    Geometry_FitPlaneAppParity(x, y, z, opts.fitWindow, plane);
+    Geometry_FitLineAppParity(x, y, z, opts.fitWindow, line);
+    fitSink = circle.radius + plane.d + line.residual;
+  }
+
+  void flush() {
+    if (exporter != nullptr) exporter->writeBatch(batch);
+    batch.clear();
+  }
+
+  const BenchOptions& opts;
+  PointCloudExporter* exporter;
+  FrameTracker tracker;
+  PointBatch batch;
+
+  std::string carry;   // Partial line from the previous read
+  std::string joined;  // carry + the start of this read
+  std::string frameLine;
+  std::vector<std::string_view> lines;
+  std::vector<Sample> parsed;
+  size_t sinceFit = 0;
+};
+
+// ============================================================================
+// RUNS
+// ============================================================================
+static void SleepUntilNs(int64_t ns) {
+  timespec wake;
+  wake.tv_sec = static_cast<time_t>(ns / 1000000000LL);
+  wake.tv_nsec = static_cast<long>(ns % 1000000000LL);
+  clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr);
+}
+
+// exportPath empty = no export (counting pass)
+static RunResult RunCapture(const LoadedCapture& capture, const BenchOptions& opts,
+                            const std::string& exportPath, uint64_t expectedSamples) {
+  RunResult result;
+  result.latencyNs.reserve(capture.records());
+
+  BufferedWriter writer;
+  PointCloudExporter exporter(writer, opts.exportOptions);
+  bool exporting = !exportPath.empty();
+  if (exporting) {
+    exporter.setExpectedCount(expectedSamples);
+    if (!writer.open(exportPath) || !exporter.begin()) {
+      result.error = writer.error().empty() ? exporter.error() : writer.error();
+      return result;
+    }
+  }
+
+  BenchPipeline pipeline(opts, exporting ? &exporter : nullptr);
+  int64_t startNs = HostClock_NowNs();
+
+  for (size_t i = 0; i < capture.records(); i++) {
+    int64_t arrivalNs;
+    if (opts.speed > 0) {
+      arrivalNs = startNs + static_cast<int64_t>(capture.timeUs[i] * 1000.0 / opts.speed);
+      if (HostClock_NowNs() < arrivalNs) SleepUntilNs(arrivalNs);
+    } else {
+      arrivalNs = HostClock_NowNs();
+    }
+    pipeline.process(capture.data.data() + capture.start[i], capture.start[i + 1] - capture.start[i],
+                     capture.timeUs[i], result);
+    result.latencyNs.push_back(HostClock_NowNs() - arrivalNs);
+  }
+  pipeline.finish(capture.timeUs.empty() ? 0 : capture.timeUs.back(), result);
+
+  if (exporting) {
+    int64_t t0 = HostClock_NowNs();
+    if (!exporter.finish()) result.error = exporter.error();
+    if (!writer.close() && result.error.empty()) result.error = writer.error();
+    result.exportNs += HostClock_NowNs() - t0;
+  }
+  result.totalNs = HostClock_NowNs() - startNs;
+  return result;
+}
+
+static double Percentile(const std::vector<int64_t>& sorted, double p) {
+  if (sorted.empty()) return 0;
+  size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+  return static_cast<double>(sorted[index]);
+}
+
+static double PeakRssMb() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0;  // KB on Linux
+}
+
+static const char* FormatExtension(ExportFormat format) {
+  switch (format) {
+    case EXPORT_XYZ: return ".xyz";
+    case EXPORT_CSV: return ".csv";
+    default: return ".ply";
+  }
+}
+
+int main(int argc, char** argv) {
+  BenchOptions opts;
+  std::vector<std::string> paths;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--runs") == 0 && hasValue) {
+      opts.runs = atoi(argv[++i]);
+    } else if (strcmp(arg, "--speed") == 0 && hasValue) {
+      opts.speed = atof(argv[++i]);
+    } else if (strcmp(arg, "--format") == 0 && hasValue) {
+      if (!ExportFormat_FromName(argv[++i], opts.exportOptions.format)) {
+        fprintf(stderr, "ERROR,Unknown format: %s\n", argv[i]);
+        return 1;
+      }
+    } else if (strcmp(arg, "--export-dir") == 0 && hasValue) {
+      opts.exportDir = argv[++i];
+    } else if (strcmp(arg, "--fit-window") == 0 && hasValue) {
+      opts.fitWindow = static_cast<size_t>(atol(argv[++i]));
+    } else if (strcmp(arg, "--batch") == 0 && hasValue) {
+      opts.batchSize = static_cast<size_t>(atol(argv[++i]));
+    } else if (arg[0] == '-') {
+      printUsage();
+      return 1;
+    } else {
+      FindCaptures(arg, paths);
+    }
+  }
+
+  if (paths.empty() || opts.runs < 1 || opts.speed < 0 || opts.fitWindow < 3 ||
+      opts.batchSize < opts.fitWindow) {
+    printUsage();
+    return 1;
+  }
+
+  printf("capture,arm_bytes,recorded_s,lines,samples,malformed,run_s,mb_per_s,samples_per_s,"
+         "x_realtime,split_ns,parse_ns,store_ns,fit_ns,export_ns,lat_p50_us,lat_p90_us,"
+         "lat_p99_us,lat_p999_us,lat_max_us,capture_mb,peak_rss_mb\n");
+
+  int failures = 0;
+  for (const std::string& path : paths) {
+    LoadedCapture capture;
+    std::string error;
+    if (!LoadCapture(path, capture, error)) {
+      fprintf(stderr, "ERROR,%s: %s\n", path.c_str(), error.c_str());
+      failures++;
+      continue;
+    }
+    if (capture.truncated) fprintf(stderr, "INFO,%s ends in a partial record\n", capture.name.c_str());
+
+    std::string exportPath = "/dev/null";
+    if (!opts.exportDir.empty()) {
+      exportPath = (std::filesystem::path(opts.exportDir) /
+                    std::filesystem::path(capture.name).replace_extension(
+                        FormatExtension(opts.exportOptions.format))).string();
+    }
+
+    // Untimed counting pass (PLY needs the count up front on /dev/null)
+    BenchOptions countOpts = opts;
+    countOpts.speed = 0;
+    RunResult counted = RunCapture(capture, countOpts, "", 0);
+
+    std::vector<RunResult> runs;
+    for (int r = 0; r < opts.runs; r++) {
+      runs.push_back(RunCapture(capture, opts, exportPath, counted.samples));
+      if (!runs.back().error.empty()) break;
+    }
+    if (!runs.back().error.empty()) {
+      fprintf(stderr, "ERROR,%s: %s\n", capture.name.c_str(), runs.back().error.c_str());
+      failures++;
+      continue;
+    }
+
+    std::sort(runs.begin(), runs.end(),
+              [](const RunResult& a, const RunResult& b) { return a.totalNs < b.totalNs; });
+    RunResult& run = runs[runs.size() / 2];
+    std::sort(run.latencyNs.begin(), run.latencyNs.end());
+
+    double seconds = std::max(1e-9, run.totalNs / 1e9);
+    double recorded = capture.timeUs.empty() ? 0 : (capture.timeUs.back() - capture.timeUs.front()) / 1e6;
+    double lines = std::max<uint64_t>(run.lines, 1);
+    double samples = std::max<uint64_t>(run.samples, 1);
+    double captureMb = (capture.data.size() + capture.timeUs.size() * 16) / 1048576.0;
+
+    printf("%s,%zu,%.3f,%llu,%llu,%llu,%.4f,%.2f,%.0f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,"
+           "%.2f,%.2f,%.2f,%.2f,%.2f,%.1f,%.1f\n",
+           capture.name.c_str(), capture.data.size(), recorded,
+           static_cast<unsigned long long>(run.lines), static_cast<unsigned long long>(run.samples),
+           static_cast<unsigned long long>(run.malformed), seconds,
+           capture.data.size() / seconds / 1048576.0, run.samples / seconds,
+           recorded / seconds,
+           run.splitNs / lines, run.parseNs / lines, run.storeNs / samples,
+           run.fitNs / samples, run.exportNs / samples,
+           Percentile(run.latencyNs, 0.50) / 1000, Percentile(run.latencyNs, 0.90) / 1000,
+           Percentile(run.latencyNs, 0.99) / 1000, Percentile(run.latencyNs, 0.999) / 1000,
+           Percentile(run.latencyNs, 1.0) / 1000, captureMb, PeakRssMb());
+    fflush(stdout);
+
+    fprintf(stderr, "INFO,%s: %.1f s recorded, %llu samples in %.3f s (%.1fx real time), "
+            "latency p50 %.1f us, p99 %.1f us, max %.1f us\n",
+            capture.name.c_str(), recorded, static_cast<unsigned long long>(run.samples), seconds,
+            recorded / seconds, Percentile(run.latencyNs, 0.50) / 1000,
+            Percentile(run.latencyNs, 0.99) / 1000, Percentile(run.latencyNs, 1.0) / 1000);
+  }
+
+  return failures > 0 ? 2 : 0;
+}
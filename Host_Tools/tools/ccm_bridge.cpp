@@ -0,0 +1,558 @@
+/*
+ * ============================================================================
+ * CCM_BRIDGE - Share one arm between several local programs
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_bridge [options] <port>
+ *
+ * Options:
+ *   --baud N                Serial baud rate (default: 115200)
+ *   --socket PATH           Unix domain socket to listen on
+ *                           (default: /tmp/ccm_bridge.sock)
+ *   --tcp PORT              Also listen on 127.0.0.1:PORT
+ *   --ring N                Lines kept for slow clients (default: 8192)
+ *   --max-clients N         Connections accepted at once (default: 16)
+ *   --command-timeout-ms N  Longest wait for a command's reply (default: 200)
+ *   --metrics-s S           Metrics period on stderr (default: 0 = off)
+ *
+ * The bridge owns the serial port. Every client connected to the socket
+ * receives the arm's output exactly as the firmware sends it, one line per
+ * '\n', from the moment it connects. Anything a client writes is a command
+ * for the arm, one per line, in the firmware's own syntax.
+ *
+ * Output: every line from the arm is stored once in a shared ring
+ * (line_ring.h) and written to each client straight from there with
+ * sendmsg(). The arm is never held up by a client. A client that cannot
+ * keep up gets only every 2nd, 4th, ... POS / VEL line until it catches up;
+ * replies and other lines always get through. A client that still falls a
+ * whole ring behind loses the oldest lines.
+ *
+ * Commands: clients' commands go into one queue and are written to the arm
+ * one at a time. The next command goes out when the previous one has been
+ * answered (any line other than POS / VEL / SPOS / TRC; RESEND is answered
+ * by its SPOS or SLOST lines) or after --command-timeout-ms. Commands from two
+ * programs never interleave, and the Arduino's 64-byte receive buffer cannot
+ * overflow. Replies go to every client, like any other line.
+ *
+ * One command is handled by the bridge itself and never reaches the arm:
+ *
+ *   BRIDGE STATUS  ->  BRIDGE,<clients>,<lag>,<decimation>,<decimated>,<dropped>
+ *
+ * It is answered to the asking client only, with that client's own lag
+ * (lines behind), current decimation (keeps 1 sample line in N) and counts
+ * of lines decimated and dropped so far.
+ *
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../src/line_ring.h"
+#include "../src/serial_port.h"
+
+static const char* DEFAULT_SOCKET_PATH = "/tmp/ccm_bridge.sock";
+
+// Per-client limits
+static const size_t CLIENT_MAX_QUEUED_COMMANDS = 16;
+static const size_t CLIENT_MAX_LINE = 256;
+static const int CLIENT_MAX_IOV = 64;
+
+// Kept small so a slow client's backlog stays in the ring, where it can be
+// decimated, rather than in the kernel (the kernel doubles this value)
+static const int CLIENT_SEND_BUFFER = 16 * 1024;
+
+// epoll tags; client tags are their ids (from 1)
+static const uint64_t SIGNAL_TAG = UINT64_MAX;
+static const uint64_t SERIAL_TAG = UINT64_MAX - 1;
+static const uint64_t UNIX_LISTEN_TAG = UINT64_MAX - 2;
+static const uint64_t TCP_LISTEN_TAG = UINT64_MAX - 3;
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_bridge [options] <port>\n"
+          "  --baud N                Serial baud rate (default: 115200)\n"
+          "  --socket PATH           Unix socket (default: %s)\n"
+          "  --tcp PORT              Also listen on 127.0.0.1:PORT\n"
+          "  --ring N                Lines kept for slow clients (default: 8192)\n"
+          "  --max-clients N         Connections accepted at once (default: 16)\n"
+          "  --command-timeout-ms N  Longest wait for a reply (default: 200)\n"
+          "  --metrics-s S           Metrics period on stderr (default: 0 = off)\n",
+          DEFAULT_SOCKET_PATH);
+}
+
+static bool StartsWith(const std::string& s, const char* prefix) {
+  return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// ============================================================================
+// CLIENTS
+// ============================================================================
+struct Client {
+  Client(uint64_t clientId, int socket, const char* kind, const LineRing& ring)
+      : id(clientId), fd(socket), transport(kind), reader(ring) {}
+  ~Client() { close(fd); }
+
+  uint64_t id;
+  int fd;
+  const char* transport;   // "unix" or "tcp"
+  RingReader reader;
+  std::string inbound;     // Partial command line
+  size_t queued = 0;       // Commands waiting in the shared queue
+  bool wantWrite = false;  // Registered for EPOLLOUT
+  uint64_t windowSent = 0; // reader.stats().sent at the last metrics report
+};
+
+struct QueuedCommand {
+  uint64_t client;
+  std::string text;
+};
+
+// Send what the client's reader has ready. Returns false if the client
+// has gone away.
+static bool FlushClient(Client& c, int epollFd) {
+  iovec iov[CLIENT_MAX_IOV];
+  bool blocked = false;
+
+  for (;;) {
+    int n = c.reader.gather(iov, CLIENT_MAX_IOV);
+    if (n == 0) break;
+
+    msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = n;
+    ssize_t written = sendmsg(c.fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (written < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        blocked = true;
+        break;
+      }
+      if (errno == EINTR) continue;
+      return false;
+    }
+    c.reader.consumed(static_cast<size_t>(written));
+
+    size_t offered = 0;
+    for (int i = 0; i < n; i++) offered += iov[i].iov_len;
+    if (static_cast<size_t>(written) < offered) {
+      blocked = true;
+      break;
+    }
+  }
+
+  // Only wait for EPOLLOUT while the socket is full
+  if (blocked != c.wantWrite) {
+    epoll_event ev = {};
+    ev.events = blocked ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    ev.data.u64 = c.id;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+    c.wantWrite = blocked;
+  }
+  return true;
+}
+
+// ============================================================================
+// LISTENING SOCKETS
+// ============================================================================
+static int ListenUnix(const char* path) {
+  sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "ERROR,Socket path too long: %s\n", path);
+    return -1;
+  }
+  strcpy(addr.sun_path, path);
+
+  // A socket file left behind by a bridge that did not exit cleanly
+  struct stat st;
+  if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    bool inUse = connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    close(probe);
+    if (inUse) {
+      fprintf(stderr, "ERROR,Another bridge is listening on %s\n", path);
+      return -1;
+    }
+    unlink(path);
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(fd, 16) != 0) {
+    fprintf(stderr, "ERROR,Cannot listen on %s: %s\n", path, strerror(errno));
+    if (fd >= 0) close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int ListenTcp(int port) {
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // Local clients only
+
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  int one = 1;
+  if (fd >= 0) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(fd, 16) != 0) {
+    fprintf(stderr, "ERROR,Cannot listen on 127.0.0.1:%d: %s\n", port, strerror(errno));
+    if (fd >= 0) close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int main(int argc, char** argv) {
+  int baud = 115200;
+  const char* socketPath = DEFAULT_SOCKET_PATH;
+  int tcpPort = 0;
+  long ringSlots = 8192;
+  long maxClients = 16;
+  int commandTimeoutMs = 200;
+  double metricsSeconds = 0;
+  const char* portPath = nullptr;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--baud") == 0 && hasValue) {
+      baud = atoi(argv[++i]);
+    } else if (strcmp(arg, "--socket") == 0 && hasValue) {
+      socketPath = argv[++i];
+    } else if (strcmp(arg, "--tcp") == 0 && hasValue) {
+      tcpPort = atoi(argv[++i]);
+    } else if (strcmp(arg, "--ring") == 0 && hasValue) {
+      ringSlots = atol(argv[++i]);
+    } else if (strcmp(arg, "--max-clients") == 0 && hasValue) {
+      maxClients = atol(argv[++i]);
+    } else if (strcmp(arg, "--command-timeout-ms") == 0 && hasValue) {
+      commandTimeoutMs = atoi(argv[++i]);
+    } else if (strcmp(arg, "--metrics-s") == 0 && hasValue) {
+      metricsSeconds = atof(argv[++i]);
+    } else if (arg[0] == '-' && arg[1] != '\0') {
+      printUsage();
+      return 1;
+    } else if (portPath == nullptr) {
+      portPath = arg;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (portPath == nullptr || tcpPort < 0 || tcpPort > 65535 || ringSlots < 64 ||
+      maxClients < 1 || commandTimeoutMs < 1 || metricsSeconds < 0) {
+    printUsage();
+    return 1;
+  }
+
+  SerialPort port;
+  if (!port.open(portPath, baud)) {
+    fprintf(stderr, "ERROR,%s\n", port.error().c_str());
+    return 1;
+  }
+
+  // --------------------------------------------------------------------------
+  // Event loop setup
+  // --------------------------------------------------------------------------
+  int unixFd = ListenUnix(socketPath);
+  if (unixFd < 0) return 1;
+  int tcpFd = -1;
+  if (tcpPort > 0) {
+    tcpFd = ListenTcp(tcpPort);
+    if (tcpFd < 0) {
+      unlink(socketPath);
+      return 1;
+    }
+  }
+
+  sigset_t stopSignals;
+  sigemptyset(&stopSignals);
+  sigaddset(&stopSignals, SIGINT);
+  sigaddset(&stopSignals, SIGTERM);
+  sigprocmask(SIG_BLOCK, &stopSignals, nullptr);
+  int signalFd = signalfd(-1, &stopSignals, SFD_CLOEXEC);
+
+  int epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd < 0 || signalFd < 0) {
+    fprintf(stderr, "ERROR,Cannot set up the event loop: %s\n", strerror(errno));
+    unlink(socketPath);
+    return 1;
+  }
+  epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.u64 = SIGNAL_TAG;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &ev);
+  ev.data.u64 = SERIAL_TAG;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, port.descriptor(), &ev);
+  ev.data.u64 = UNIX_LISTEN_TAG;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, unixFd, &ev);
+  if (tcpFd >= 0) {
+    ev.data.u64 = TCP_LISTEN_TAG;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, tcpFd, &ev);
+  }
+
+  fprintf(stderr, "INFO,Bridging %s on %s", portPath, socketPath);
+  if (tcpFd >= 0) fprintf(stderr, " and 127.0.0.1:%d", tcpPort);
+  fprintf(stderr, "\n");
+
+  LineRing ring(static_cast<size_t>(ringSlots));
+  std::map<uint64_t, std::unique_ptr<Client>> clients;
+  uint64_t nextClientId = 1;
+
+  std::deque<QueuedCommand> commands;
+  bool awaitingReply = false;
+  bool awaitingResend = false;
+  int64_t replyDeadlineNs = INT64_MAX;
+  const int64_t commandTimeoutNs = commandTimeoutMs * 1000000LL;
+
+  uint64_t armLines = 0;
+  uint64_t cutLines = 0;
+  uint64_t commandsSent = 0;
+  uint64_t commandTimeouts = 0;
+  int64_t metricsPeriodNs = static_cast<int64_t>(metricsSeconds * 1e9);
+  int64_t windowStartNs = HostClock_NowNs();
+  int64_t nextMetricsNs = metricsPeriodNs > 0 ? windowStartNs + metricsPeriodNs : INT64_MAX;
+  uint64_t windowArmLines = 0;
+
+  auto dropClient = [&](uint64_t id) {
+    auto it = clients.find(id);
+    if (it == clients.end()) return;
+    const RingReaderStats& s = it->second->reader.stats();
+    fprintf(stderr, "INFO,Client %llu disconnected: %llu lines sent, %llu decimated, %llu dropped\n",
+            static_cast<unsigned long long>(id), static_cast<unsigned long long>(s.sent),
+            static_cast<unsigned long long>(s.decimated), static_cast<unsigned long long>(s.dropped));
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, it->second->fd, nullptr);
+    // Its queued commands are withdrawn; one already sent still completes
+    commands.erase(std::remove_if(commands.begin(), commands.end(),
+                                  [id](const QueuedCommand& q) { return q.client == id; }),
+                   commands.end());
+    clients.erase(it);
+  };
+
+  auto acceptClients = [&](int listenFd, const char* kind) {
+    for (;;) {
+      int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0) break;
+      if (clients.size() >= static_cast<size_t>(maxClients)) {
+        const char full[] = "ERROR,Bridge full\n";
+        send(fd, full, sizeof(full) - 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+        close(fd);
+        continue;
+      }
+      int sendBuffer = CLIENT_SEND_BUFFER;
+      setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+      if (listenFd == tcpFd) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      }
+      uint64_t id = nextClientId++;
+      clients[id].reset(new Client(id, fd, kind, ring));
+      epoll_event cev = {};
+      cev.events = EPOLLIN;
+      cev.data.u64 = id;
+      epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &cev);
+      fprintf(stderr, "INFO,Client %llu connected (%s), %zu connected\n",
+              static_cast<unsigned long long>(id), kind, clients.size());
+    }
+  };
+
+  auto sendNextCommand = [&](int64_t nowNs) {
+    while (!awaitingReply && !commands.empty()) {
+      QueuedCommand q = std::move(commands.front());
+      commands.pop_front();
+      auto it = clients.find(q.client);
+      if (it != clients.end()) it->second->queued--;
+      if (!port.writeLine(q.text)) continue;
+      commandsSent++;
+      awaitingReply = true;
+      awaitingResend = StartsWith(q.text, "RESEND");
+      replyDeadlineNs = nowNs + commandTimeoutNs;
+    }
+  };
+
+  auto handleCommand = [&](Client& c, std::string line) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty()) return;
+
+    if (line == "BRIDGE STATUS") {
+      const RingReaderStats& s = c.reader.stats();
+      char reply[160];
+      snprintf(reply, sizeof(reply), "BRIDGE,%zu,%llu,%u,%llu,%llu", clients.size(),
+               static_cast<unsigned long long>(c.reader.lag()), c.reader.decimation(),
+               static_cast<unsigned long long>(s.decimated),
+               static_cast<unsigned long long>(s.dropped));
+      c.reader.sendPrivate(reply);
+      return;
+    }
+    if (c.queued >= CLIENT_MAX_QUEUED_COMMANDS) {
+      c.reader.sendPrivate("ERROR,Bridge command queue full");
+      return;
+    }
+    commands.push_back({c.id, std::move(line)});
+    c.queued++;
+  };
+
+  // Returns false if the client has gone away
+  auto readClient = [&](Client& c) {
+    char buffer[1024];
+    for (;;) {
+      ssize_t n = read(c.fd, buffer, sizeof(buffer));
+      if (n == 0) return false;
+      if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+      for (ssize_t i = 0; i < n; i++) {
+        if (buffer[i] == '\n') {
+          handleCommand(c, std::move(c.inbound));
+          c.inbound.clear();
+        } else if (c.inbound.size() < CLIENT_MAX_LINE) {
+          c.inbound += buffer[i];
+        }
+      }
+    }
+  };
+
+  auto printMetrics = [&](int64_t nowNs) {
+    double seconds = std::max(1e-3, (nowNs - windowStartNs) / 1e9);
+    fprintf(stderr,
+            "INFO,Bridge: %.1f lines/s from the arm, %zu clients, %llu commands sent, "
+            "%llu timed out, %zu queued\n",
+            (armLines - windowArmLines) / seconds, clients.size(),
+            static_cast<unsigned long long>(commandsSent),
+            static_cast<unsigned long long>(commandTimeouts), commands.size());
+    for (auto& entry : clients) {
+      Client& c = *entry.second;
+      const RingReaderStats& s = c.reader.stats();
+      fprintf(stderr,
+              "INFO,Client %llu (%s): %.1f lines/s, lag %llu lines, keeps 1 sample in %u, "
+              "%llu decimated, %llu dropped\n",
+              static_cast<unsigned long long>(c.id), c.transport,
+              (s.sent - c.windowSent) / seconds, static_cast<unsigned long long>(c.reader.lag()),
+              c.reader.decimation(), static_cast<unsigned long long>(s.decimated),
+              static_cast<unsigned long long>(s.dropped));
+      c.windowSent = s.sent;
+    }
+    windowArmLines = armLines;
+    windowStartNs = nowNs;
+  };
+
+  // --------------------------------------------------------------------------
+  // Event loop
+  // --------------------------------------------------------------------------
+  epoll_event events[64];
+  bool stopping = false;
+  bool portOpen = true;
+  std::string line;
+  int64_t receivedNs;
+  while (!stopping && portOpen) {
+    int64_t now = HostClock_NowNs();
+    int64_t wakeNs = std::min(nextMetricsNs, awaitingReply ? replyDeadlineNs : INT64_MAX);
+    int timeoutMs = wakeNs == INT64_MAX ? -1
+                    : wakeNs <= now     ? 0
+                                        : static_cast<int>(std::min<int64_t>(
+                                              (wakeNs - now + 999999) / 1000000, 1000));
+
+    int n = epoll_wait(epollFd, events, 64, timeoutMs);
+    if (n < 0 && errno != EINTR) {
+      fprintf(stderr, "ERROR,epoll_wait: %s\n", strerror(errno));
+      break;
+    }
+
+    bool armOutput = false;
+    for (int i = 0; i < n; i++) {
+      uint64_t tag = events[i].data.u64;
+      if (tag == SIGNAL_TAG) {
+        stopping = true;
+      } else if (tag == SERIAL_TAG) {
+        portOpen = port.readAvailable();
+        while (port.nextLine(line, receivedNs)) {
+          bool sample = StartsWith(line, "POS,") || StartsWith(line, "VEL,");
+          bool trace = StartsWith(line, "TRC,");  // Follows a streamed line, never a reply
+          if (awaitingReply && !sample && !trace &&
+              (!StartsWith(line, "SPOS,") || awaitingResend || StartsWith(line, "SLOST,"))) {
+            awaitingReply = false;
+          }
+          if (ring.head() >= ring.capacity()) {
+            for (auto& entry : clients) entry.second->reader.beforeOverwrite();
+          }
+          if (!ring.push(line.data(), line.size(), sample)) cutLines++;
+          armLines++;
+          armOutput = true;
+        }
+      } else if (tag == UNIX_LISTEN_TAG) {
+        acceptClients(unixFd, "unix");
+      } else if (tag == TCP_LISTEN_TAG) {
+        acceptClients(tcpFd, "tcp");
+      } else {
+        auto it = clients.find(tag);
+        if (it == clients.end()) continue;
+        Client& c = *it->second;
+        bool alive = !(events[i].events & (EPOLLERR | EPOLLHUP)) || (events[i].events & EPOLLIN);
+        if (alive && (events[i].events & EPOLLIN)) alive = readClient(c);
+        if (alive && (events[i].events & EPOLLOUT)) alive = FlushClient(c, epollFd);
+        if (!alive) dropClient(tag);
+      }
+    }
+
+    now = HostClock_NowNs();
+    if (awaitingReply && now >= replyDeadlineNs) {
+      awaitingReply = false;
+      commandTimeouts++;
+    }
+    sendNextCommand(now);
+
+    // New arm output, or private replies, for every client that is not
+    // already waiting on a full socket
+    std::vector<uint64_t> gone;
+    for (auto& entry : clients) {
+      Client& c = *entry.second;
+      if ((armOutput || c.reader.pending()) && !c.wantWrite && !FlushClient(c, epollFd)) {
+        gone.push_back(entry.first);
+      }
+    }
+    for (uint64_t id : gone) dropClient(id);
+
+    if (now >= nextMetricsNs) {
+      printMetrics(now);
+      nextMetricsNs = now + metricsPeriodNs;
+    }
+  }
+
+  if (!portOpen) fprintf(stderr, "ERROR,%s\n", port.error().c_str());
+  if (cutLines > 0) {
+    fprintf(stderr, "INFO,%llu lines longer than %zu bytes were cut\n",
+            static_cast<unsigned long long>(cutLines), LINE_RING_SLOT_BYTES - 1);
+  }
+  clients.clear();
+  close(unixFd);
+  unlink(socketPath);
+  if (tcpFd >= 0) close(tcpFd);
+  close(epollFd);
+  close(signalFd);
+  return portOpen ? 0 : 2;
+}
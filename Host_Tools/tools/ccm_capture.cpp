@@ -0,0 +1,192 @@
+/*
+ * ============================================================================
+ * CCM_CAPTURE - Record the raw serial stream with host receive times
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_capture [options] <serial port> <capture file>
+ *
+ * Options:
+ *   --baud N          Serial baud rate (default: 115200)
+ *   --seconds S       Stop after S seconds (default: 0 = until SIGINT / SIGTERM)
+ *   --init "CMD;CMD"  Commands to send once the arm is up, e.g. "SETTS US;START"
+ *   --no-wait         Send --init at once instead of after the startup banner
+ *
+ * Every read() from the port is written to the capture file as it arrived,
+ * with its host monotonic receive time (capture_file.h). Nothing is parsed
+ * or dropped, so a field session can be played back byte for byte with
+ * ccm_replay and profiled with ccm_bench. The --init commands are recorded
+ * too, as traffic to the arm.
+ *
+ * Opening the port resets the Arduino; the --init commands go out when the
+ * "Ready for commands" banner has been seen, or after 3 seconds.
+ *
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include "../src/capture_file.h"
+#include "../src/serial_port.h"
+
+static const char* STARTUP_BANNER = "Ready for commands";
+static const int64_t BANNER_TIMEOUT_NS = 3000000000LL;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onStopSignal(int) {
+  stopRequested = 1;
+}
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_capture [options] <serial port> <capture file>\n"
+          "  --baud N          Serial baud rate (default: 115200)\n"
+          "  --seconds S       Stop after S seconds (default: 0 = until signal)\n"
+          "  --init \"CMD;CMD\"  Commands to send once the arm is up\n"
+          "  --no-wait         Send --init at once (port already open)\n");
+}
+
+int main(int argc, char** argv) {
+  int baud = 115200;
+  double runSeconds = 0;
+  std::string initCommands;
+  bool waitForBanner = true;
+  const char* portPath = nullptr;
+  const char* capturePath = nullptr;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--baud") == 0 && hasValue) {
+      baud = atoi(argv[++i]);
+    } else if (strcmp(arg, "--seconds") == 0 && hasValue) {
+      runSeconds = atof(argv[++i]);
+    } else if (strcmp(arg, "--init") == 0 && hasValue) {
+      initCommands = argv[++i];
+    } else if (strcmp(arg, "--no-wait") == 0) {
+      waitForBanner = false;
+    } else if (arg[0] == '-' && arg[1] != '\0') {
+      printUsage();
+      return 1;
+    } else if (portPath == nullptr) {
+      portPath = arg;
+    } else if (capturePath == nullptr) {
+      capturePath = arg;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (portPath == nullptr || capturePath == nullptr || runSeconds < 0) {
+    printUsage();
+    return 1;
+  }
+
+  std::vector<std::string> commands;
+  for (size_t start = 0; start < initCommands.size();) {
+    size_t end = initCommands.find(';', start);
+    if (end == std::string::npos) end = initCommands.size();
+    if (end > start) commands.push_back(initCommands.substr(start, end - start));
+    start = end + 1;
+  }
+
+  SerialPort port;
+  if (!port.open(portPath, baud)) {
+    fprintf(stderr, "ERROR,%s\n", port.error().c_str());
+    return 1;
+  }
+
+  int64_t startNs = HostClock_NowNs();
+  CaptureWriter capture;
+  if (!capture.open(capturePath, baud, startNs)) {
+    fprintf(stderr, "ERROR,%s\n", capture.error().c_str());
+    return 1;
+  }
+
+  signal(SIGINT, onStopSignal);
+  signal(SIGTERM, onStopSignal);
+
+  // --------------------------------------------------------------------------
+  // Capture loop
+  // --------------------------------------------------------------------------
+  int64_t endNs = runSeconds > 0 ? startNs + static_cast<int64_t>(runSeconds * 1e9) : INT64_MAX;
+  bool commandsSent = commands.empty();
+  std::string recent;  // Tail of the stream, to spot the banner across reads
+  uint64_t lines = 0;
+  bool portClosed = false;
+  char chunk[4096];
+
+  while (!stopRequested) {
+    int64_t now = HostClock_NowNs();
+    if (now >= endNs) break;
+
+    if (!commandsSent && (!waitForBanner || now - startNs >= BANNER_TIMEOUT_NS ||
+                          recent.find(STARTUP_BANNER) != std::string::npos)) {
+      for (const std::string& command : commands) {
+        std::string line = command + "\n";
+        if (!port.writeLine(command)) break;
+        capture.write(HostClock_NowNs(), CAPTURE_TO_ARM, line.data(), line.size());
+      }
+      commandsSent = true;
+    }
+
+    pollfd pfd = {port.descriptor(), POLLIN, 0};
+    int ready = poll(&pfd, 1, 100);
+    if (ready < 0) {
+      if (errno == EINTR) continue;
+      fprintf(stderr, "ERROR,Poll failed: %s\n", strerror(errno));
+      break;
+    }
+    if (ready == 0) continue;
+
+    ssize_t n = read(port.descriptor(), chunk, sizeof(chunk));
+    int64_t receivedNs = HostClock_NowNs();
+    if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+    if (n <= 0) {
+      portClosed = true;
+      break;
+    }
+
+    if (!capture.write(receivedNs, CAPTURE_FROM_ARM, chunk, static_cast<size_t>(n))) {
+      fprintf(stderr, "ERROR,%s\n", capture.error().c_str());
+      return 1;
+    }
+    lines += std::count(chunk, chunk + n, '\n');
+
+    if (!commandsSent) {
+      recent.append(chunk, static_cast<size_t>(n));
+      if (recent.size() > 256) recent.erase(0, recent.size() - 256);
+    }
+  }
+
+  // --------------------------------------------------------------------------
+  // Summary
+  // --------------------------------------------------------------------------
+  double seconds = std::max(1e-3, (HostClock_NowNs() - startNs) / 1e9);
+  if (!capture.close()) {
+    fprintf(stderr, "ERROR,%s\n", capture.error().c_str());
+    return 1;
+  }
+  if (portClosed) fprintf(stderr, "INFO,Port closed\n");
+  fprintf(stderr, "INFO,Captured %.1f s: %llu records, %llu bytes (%.1f KB/s), %llu lines\n",
+          seconds, static_cast<unsigned long long>(capture.records()),
+          static_cast<unsigned long long>(capture.bytes()), capture.bytes() / seconds / 1024,
+          static_cast<unsigned long long>(lines));
+  return 0;
+}
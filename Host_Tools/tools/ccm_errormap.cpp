@@ -0,0 +1,264 @@
+/*
+ * ============================================================================
+ * CCM_ERRORMAP - Volumetric error map from artefact measurements
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_errormap [options] <measurements.csv> <map>
+ *   ccm_errormap --check <map> <measurements.csv>
+ *
+ * Options:
+ *   --spacing MM      Grid node spacing (default: 50)
+ *   --margin MM       Grid extends this far past the measurements (default: one spacing)
+ *   --smoothing X     Weight of neighbouring-node differences (default: 0.1)
+ *   --check MAP       Evaluate MAP on the measurements instead of fitting one
+ *
+ * Measurements are one artefact feature per line: the arm's reading and
+ * the certified position, both in the arm's base frame (mm):
+ *
+ *   measured_x,measured_y,measured_z,reference_x,reference_y,reference_z
+ *
+ * A line that does not start with a number (a header) is skipped. Sphere
+ * centers from a calibrated sphere plate, ball-bar ends or the holes of a
+ * hole plate placed at several heights all work; what matters is that they
+ * cover the volume the arm is used in.
+ *
+ * The map (error_map.h) is fitted by least squares and written to <map>.
+ * Residuals before and after correction, and what a correction costs per
+ * sample, are reported on stderr. Measure a second set with the artefact
+ * moved and run --check on it: a map that only fits the points it was
+ * built from shows up as a small residual in the fit and a large one in
+ * the check. Raise --smoothing or --spacing in that case.
+ *
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/error_map.h"
+
+// Points corrected to measure the cost of one correction
+static const size_t BENCH_POINTS = 1 << 20;
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_errormap [options] <measurements.csv> <map>\n"
+          "       ccm_errormap --check <map> <measurements.csv>\n"
+          "  --spacing MM      Grid node spacing (default: 50)\n"
+          "  --margin MM       Grid margin past the measurements (default: one spacing)\n"
+          "  --smoothing X     Weight of neighbouring-node differences (default: 0.1)\n"
+          "  --check MAP       Evaluate MAP on the measurements\n"
+          "Measurement lines: mx,my,mz,rx,ry,rz (mm)\n");
+}
+
+static bool LoadMeasurements(const char* path, std::vector<ErrorSample>& out) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    fprintf(stderr, "ERROR,Cannot open %s: %s\n", path, strerror(errno));
+    return false;
+  }
+
+  char buffer[512];
+  int lineNumber = 0;
+  bool ok = true;
+  while (fgets(buffer, sizeof(buffer), file)) {
+    lineNumber++;
+    const char* p = buffer;
+    while (*p == ' ' || *p == '\t') p++;
+    if (!(isdigit(static_cast<unsigned char>(*p)) || *p == '-' || *p == '+' || *p == '.')) {
+      continue;  // Header, comment or blank line
+    }
+
+    double v[6];
+    int fields = 0;
+    while (fields < 6) {
+      while (*p == ' ' || *p == '\t' || *p == ',') p++;
+      char* end;
+      v[fields] = strtod(p, &end);
+      if (end == p) break;
+      p = end;
+      fields++;
+    }
+    if (fields < 6) {
+      fprintf(stderr, "ERROR,%s:%d: expected six numbers\n", path, lineNumber);
+      ok = false;
+      break;
+    }
+
+    ErrorSample sample;
+    std::copy(v, v + 3, sample.measured);
+    std::copy(v + 3, v + 6, sample.reference);
+    out.push_back(sample);
+  }
+  fclose(file);
+
+  if (ok && out.empty()) {
+    fprintf(stderr, "ERROR,No measurements in %s\n", path);
+    ok = false;
+  }
+  return ok;
+}
+
+// Residuals of a map over measurements it was not fitted to
+static void printCheck(const ErrorMap& map, const std::vector<ErrorSample>& samples) {
+  double sumBefore = 0, sumAfter = 0, maxBefore = 0, maxAfter = 0;
+  for (const ErrorSample& s : samples) {
+    double corrected[3];
+    map.apply(s.measured, corrected);
+    double before = 0, after = 0;
+    for (int a = 0; a < 3; a++) {
+      before += (s.reference[a] - s.measured[a]) * (s.reference[a] - s.measured[a]);
+      after += (s.reference[a] - corrected[a]) * (s.reference[a] - corrected[a]);
+    }
+    sumBefore += before;
+    sumAfter += after;
+    maxBefore = std::max(maxBefore, sqrt(before));
+    maxAfter = std::max(maxAfter, sqrt(after));
+  }
+  fprintf(stderr,
+          "INFO,Check: %zu samples, error rms %.4f mm max %.4f mm -> rms %.4f mm max %.4f mm",
+          samples.size(), sqrt(sumBefore / samples.size()), maxBefore,
+          sqrt(sumAfter / samples.size()), maxAfter);
+  if (map.outside() > 0) {
+    fprintf(stderr, ", %llu outside the grid", static_cast<unsigned long long>(map.outside()));
+  }
+  fprintf(stderr, "\n");
+}
+
+// Cost of one correction over points spread through the grid, as the
+// batch path (ccm_export) applies it
+static void printApplyCost(const ErrorMap& map) {
+  std::vector<double> x(BENCH_POINTS), y(BENCH_POINTS), z(BENCH_POINTS);
+  std::mt19937 random(1);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  for (size_t i = 0; i < BENCH_POINTS; i++) {
+    x[i] = map.origin()[0] + unit(random) * map.spacing()[0] * (map.size()[0] - 1);
+    y[i] = map.origin()[1] + unit(random) * map.spacing()[1] * (map.size()[1] - 1);
+    z[i] = map.origin()[2] + unit(random) * map.spacing()[2] * (map.size()[2] - 1);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  map.apply(x.data(), y.data(), z.data(), BENCH_POINTS);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  double sum = 0;
+  for (size_t i = 0; i < BENCH_POINTS; i += 4096) sum += x[i] + y[i] + z[i];
+  fprintf(stderr, "INFO,Apply: %.1f ns/sample (%.1f M samples/s)%s\n",
+          seconds * 1e9 / BENCH_POINTS, BENCH_POINTS / seconds / 1e6, std::isnan(sum) ? " NaN" : "");
+}
+
+int main(int argc, char** argv) {
+  double spacing = 50;
+  double margin = -1;
+  double smoothing = 0.1;
+  const char* checkPath = nullptr;
+  const char* measurementsPath = nullptr;
+  const char* mapPath = nullptr;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--spacing") == 0 && hasValue) {
+      spacing = atof(argv[++i]);
+    } else if (strcmp(arg, "--margin") == 0 && hasValue) {
+      margin = atof(argv[++i]);
+    } else if (strcmp(arg, "--smoothing") == 0 && hasValue) {
+      smoothing = atof(argv[++i]);
+    } else if (strcmp(arg, "--check") == 0 && hasValue) {
+      checkPath = argv[++i];
+    } else if (arg[0] == '-' && arg[1] != '\0') {
+      printUsage();
+      return 1;
+    } else if (measurementsPath == nullptr) {
+      measurementsPath = arg;
+    } else if (mapPath == nullptr) {
+      mapPath = arg;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (measurementsPath == nullptr || (checkPath == nullptr) == (mapPath == nullptr)) {
+    printUsage();
+    return 1;
+  }
+  if (!(spacing > 0) || smoothing < 0) {
+    fprintf(stderr, "ERROR,Spacing must be positive and smoothing not negative\n");
+    return 1;
+  }
+  if (margin < 0) margin = spacing;
+
+  std::vector<ErrorSample> samples;
+  if (!LoadMeasurements(measurementsPath, samples)) return 1;
+
+  // --------------------------------------------------------------------------
+  // Check an existing map
+  // --------------------------------------------------------------------------
+  if (checkPath != nullptr) {
+    ErrorMap map;
+    if (!map.load(checkPath)) {
+      fprintf(stderr, "ERROR,%s\n", map.error().c_str());
+      return 1;
+    }
+    printCheck(map, samples);
+    return 0;
+  }
+
+  // --------------------------------------------------------------------------
+  // Fit a new one over the measured volume plus the margin
+  // --------------------------------------------------------------------------
+  double low[3], high[3];
+  for (int a = 0; a < 3; a++) {
+    low[a] = high[a] = samples[0].measured[a];
+  }
+  for (const ErrorSample& s : samples) {
+    for (int a = 0; a < 3; a++) {
+      low[a] = std::min(low[a], s.measured[a]);
+      high[a] = std::max(high[a], s.measured[a]);
+    }
+  }
+
+  double origin[3], spacings[3];
+  int size[3];
+  for (int a = 0; a < 3; a++) {
+    origin[a] = low[a] - margin;
+    spacings[a] = spacing;
+    size[a] = std::max(2, static_cast<int>(ceil((high[a] + margin - origin[a]) / spacing)) + 1);
+  }
+
+  ErrorMap map;
+  ErrorMapFitStats stats;
+  if (!map.create(origin, spacings, size) || !map.fit(samples, smoothing, stats)) {
+    fprintf(stderr, "ERROR,%s\n", map.error().c_str());
+    return 1;
+  }
+  if (!map.save(mapPath)) {
+    fprintf(stderr, "ERROR,Cannot write %s: %s\n", mapPath, strerror(errno));
+    return 1;
+  }
+
+  fprintf(stderr, "INFO,Grid: %d x %d x %d nodes from (%.1f, %.1f, %.1f), spacing %.1f mm\n",
+          size[0], size[1], size[2], origin[0], origin[1], origin[2], spacing);
+  fprintf(stderr,
+          "INFO,Fit: %zu samples, %d iterations, error rms %.4f mm max %.4f mm -> "
+          "rms %.4f mm max %.4f mm\n",
+          stats.samples, stats.iterations, stats.rmsBefore, stats.maxBefore, stats.rmsAfter,
+          stats.maxAfter);
+  printApplyCost(map);
+  return 0;
+}
@@ -0,0 +1,185 @@
+/*
+ * ============================================================================
+ * CCM_EXPORT - Session CSV to point cloud converter
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_export [options] <session.csv|-> <output|->
+ *
+ * Options:
+ *   --format xyz|ply|csv   Output format (default: ply)
+ *   --units mm|inches      Output units (default: mm)
+ *   --input-units mm|inches
+ *                          Units of a session whose header does not say
+ *                          (saved before the app named them; default: mm)
+ *   --timestamp            PLY: add per-point timestamp attribute
+ *   --type                 PLY: add per-point type attribute
+ *   --precision N          ASCII formats: decimal places (default: 3)
+ *   --count N              PLY to stdout/pipe: number of points in the input
+ *   --compensate MAP       Apply a volumetric error map (ccm_errormap) first
+ *
+ * Sessions saved by the app name their units in the header ("X (mm)",
+ * "X (in)") and are converted to mm on reading, so --units and
+ * --compensate (a map in mm) always see mm. A header in other units, or
+ * contradicting --input-units, is an error.
+ *
+ * Memory use is constant: one input chunk, one PointBatch and a few output
+ * blocks, regardless of session size.
+ *
+ * ============================================================================
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "../src/buffered_writer.h"
+#include "../src/error_map.h"
+#include "../src/point_batch.h"
+#include "../src/point_cloud_exporter.h"
+#include "../src/session_reader.h"
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_export [options] <session.csv|-> <output|->\n"
+          "  --format xyz|ply|csv   Output format (default: ply)\n"
+          "  --units mm|inches      Output units (default: mm)\n"
+          "  --input-units mm|inches  Units of a session with no units in its header\n"
+          "  --timestamp            PLY: add per-point timestamp attribute\n"
+          "  --type                 PLY: add per-point type attribute\n"
+          "  --precision N          ASCII formats: decimal places (default: 3)\n"
+          "  --count N              PLY to a pipe: number of points in the input\n"
+          "  --compensate MAP       Apply a volumetric error map first\n");
+}
+
+int main(int argc, char** argv) {
+  ExportOptions options;
+  const char* inputPath = nullptr;
+  const char* outputPath = nullptr;
+  long long expectedCount = -1;
+  const char* mapPath = nullptr;
+  SessionUnits inputUnits = SESSION_UNITS_UNKNOWN;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--format") == 0 && hasValue) {
+      if (!ExportFormat_FromName(argv[++i], options.format)) {
+        fprintf(stderr, "ERROR,Unknown format: %s\n", argv[i]);
+        return 1;
+      }
+    } else if (strcmp(arg, "--units") == 0 && hasValue) {
+      std::string units = argv[++i];
+      if (units == "mm") options.units = UNITS_MM;
+      else if (units == "inches") options.units = UNITS_INCHES;
+      else {
+        fprintf(stderr, "ERROR,Unknown units: %s\n", units.c_str());
+        return 1;
+      }
+    } else if (strcmp(arg, "--input-units") == 0 && hasValue) {
+      std::string units = argv[++i];
+      if (units == "mm") inputUnits = SESSION_UNITS_MM;
+      else if (units == "inches") inputUnits = SESSION_UNITS_INCHES;
+      else {
+        fprintf(stderr, "ERROR,Unknown units: %s\n", units.c_str());
+        return 1;
+      }
+    } else if (strcmp(arg, "--timestamp") == 0) {
+      options.includeTimestamp = true;
+    } else if (strcmp(arg, "--type") == 0) {
+      options.includeType = true;
+    } else if (strcmp(arg, "--precision") == 0 && hasValue) {
+      options.precision = atoi(argv[++i]);
+      if (options.precision < 0 || options.precision > 9) {
+        fprintf(stderr, "ERROR,Invalid precision (0-9)\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "--count") == 0 && hasValue) {
+      expectedCount = atoll(argv[++i]);
+    } else if (strcmp(arg, "--compensate") == 0 && hasValue) {
+      mapPath = argv[++i];
+    } else if (arg[0] == '-' && arg[1] != '\0') {
+      printUsage();
+      return 1;
+    } else if (inputPath == nullptr) {
+      inputPath = arg;
+    } else if (outputPath == nullptr) {
+      outputPath = arg;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (inputPath == nullptr || outputPath == nullptr) {
+    printUsage();
+    return 1;
+  }
+
+  // --------------------------------------------------------------------------
+  // Stream input -> exporter -> writer thread
+  // --------------------------------------------------------------------------
+  auto startTime = std::chrono::steady_clock::now();
+
+  ErrorMap map;
+  if (mapPath != nullptr && !map.load(mapPath)) {
+    fprintf(stderr, "ERROR,%s\n", map.error().c_str());
+    return 1;
+  }
+
+  SessionReader reader;
+  if (!reader.open(inputPath, inputUnits)) {
+    fprintf(stderr, "ERROR,%s\n", reader.error().c_str());
+    return 1;
+  }
+
+  BufferedWriter writer;
+  if (!writer.open(outputPath)) {
+    fprintf(stderr, "ERROR,%s\n", writer.error().c_str());
+    return 1;
+  }
+
+  PointCloudExporter exporter(writer, options);
+  if (expectedCount >= 0) exporter.setExpectedCount(static_cast<uint64_t>(expectedCount));
+  if (!exporter.begin()) {
+    fprintf(stderr, "ERROR,%s\n", exporter.error().c_str());
+    return 1;
+  }
+
+  PointBatch batch;
+  while (reader.readBatch(batch)) {
+    map.apply(batch.x.data(), batch.y.data(), batch.z.data(), batch.count);
+    exporter.writeBatch(batch);
+  }
+
+  bool ok = exporter.finish();
+  if (!ok) fprintf(stderr, "ERROR,%s\n", exporter.error().c_str());
+  if (!reader.error().empty()) {
+    fprintf(stderr, "ERROR,%s\n", reader.error().c_str());
+    ok = false;
+  }
+  if (!writer.close()) {
+    fprintf(stderr, "ERROR,%s\n", writer.error().c_str());
+    ok = false;
+  }
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  fprintf(stderr, "INFO,Exported %llu points in %.3f s (%.1f Mpts/s)",
+          static_cast<unsigned long long>(exporter.pointsWritten()), seconds,
+          seconds > 0 ? exporter.pointsWritten() / seconds / 1e6 : 0.0);
+  if (reader.skippedLines() > 0) {
+    fprintf(stderr, ", skipped %zu malformed lines", reader.skippedLines());
+  }
+  if (map.outside() > 0) {
+    fprintf(stderr, ", %llu outside the error map", static_cast<unsigned long long>(map.outside()));
+  }
+  fprintf(stderr, "\n");
+
+  return ok ? 0 : 1;
+}
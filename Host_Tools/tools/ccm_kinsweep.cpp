@@ -0,0 +1,628 @@
+/*
+ * ============================================================================
+ * CCM_KINSWEEP - Accuracy and speed of the forward kinematics
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_kinsweep [options]
+ *
+ * Options:
+ *   --grid N         Grid points per axis over -180..180 deg (default: 64)
+ *   --random N       Random poses on top of the grid (default: 4000000)
+ *   --seed N         Seed for the random poses (default: 1)
+ *   --tool X,Y,Z     Tool offset in mm (default: 0,0,0)
+ *   --cell MM        Cell size of the error map (default: 25)
+ *   --map FILE       Write the error map (CSV) to FILE
+ *   --worst N        Worst poses kept per implementation (default: 10)
+ *   --worst-file F   Write the worst poses (CSV) to F
+ *   --limit UM       Largest acceptable error in micrometres (default: 5)
+ *   --jobs N         Worker processes (default: one per CPU)
+ *   --timing N       Poses timed per implementation (default: 1000000)
+ *
+ * Every pose of the sweep goes through each implementation of the forward
+ * kinematics and through a long double reference, and the distance between
+ * the two is the implementation's error:
+ *
+ * - firmware    Kinematics_Calculate() from the firmware sources, in float,
+ *               fed exactly as Encoder_Update() feeds it (count / counts
+ *               per radian, both float)
+ * - host-model  The double precision model of the host tools
+ *               (UncertaintyEngine::position, used by ccm_uncertainty)
+ *
+ * The reference multiplies rotation matrices instead of rotating the frame
+ * axes, so a mistake shared by the implementations does not cancel out.
+ * A new implementation (a faster or table-driven variant) is one entry in
+ * IMPLEMENTATIONS below.
+ *
+ * Poses are every combination of --grid whole counts per axis (half a turn
+ * either side of zero, so --grid 64 is 64^4 = 16.8M poses with 4 axes),
+ * then --random poses with fractional counts anywhere within a turn either
+ * side of zero, as the joint filter produces them. The joint chain, link
+ * lengths and counts per revolution are those of config.h.
+ *
+ * The sweep is split between --jobs worker processes. Processes rather
+ * than threads because Kinematics_Calculate() works on the firmware's
+ * globals (encoders, currentPosition), as it does on the board.
+ *
+ * Output:
+ * - stdout: one CSV line per implementation
+ *   impl,poses,rms_um,max_um,max_x_um,max_y_um,max_z_um,ns_per_eval
+ * - --map: impl,r_mm,z_mm,poses,rms_um,max_um per cell of the reference
+ *   tip position (r = distance from the base axis), the error over the
+ *   workspace
+ * - --worst-file: impl,rank,error_um,dx_um,dy_um,dz_um, then the counts and
+ *   the angles in degrees of each joint
+ *
+ * ns_per_eval is measured in one process, counts to position, over
+ * --timing random poses.
+ *
+ * Exit status is 3 when any implementation is further than --limit from
+ * the reference anywhere (POS lines carry 0.01 mm), 1 on other errors.
+ *
+ * ============================================================================
+ */
+
+#include "config.h"
+#include "encoder.h"
+#include "kinematics.h"
+
+#include "../src/uncertainty.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Globals Kinematics_Calculate() reads; the firmware defines them in the
+// .ino and encoder.cpp, which are not linked here
+EncoderState encoders;
+float xOffset = 0;
+float yOffset = 0;
+float zOffset = 0;
+
+static const int MAX_WORST = 100;
+static const long double PI_L = 3.141592653589793238462643383279502884L;
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_kinsweep [options]\n"
+          "  --grid N         Grid points per axis (default: 64)\n"
+          "  --random N       Random poses on top of the grid (default: 4000000)\n"
+          "  --seed N         Seed for the random poses (default: 1)\n"
+          "  --tool X,Y,Z     Tool offset in mm (default: 0,0,0)\n"
+          "  --cell MM        Cell size of the error map (default: 25)\n"
+          "  --map FILE       Write the error map (CSV) to FILE\n"
+          "  --worst N        Worst poses kept per implementation (default: 10)\n"
+          "  --worst-file F   Write the worst poses (CSV) to F\n"
+          "  --limit UM       Largest acceptable error in micrometres (default: 5)\n"
+          "  --jobs N         Worker processes (default: one per CPU)\n"
+          "  --timing N       Poses timed per implementation (default: 1000000)\n");
+}
+
+// ============================================================================
+// IMPLEMENTATIONS UNDER TEST
+// ============================================================================
+static const uint8_t jointTypes[] = JOINT_TYPES;
+static const float configLinkLengths[] = LINK_LENGTHS;
+static double toolOffsetMm[3] = {0, 0, 0};
+static UncertaintyEngine* hostModel = nullptr;
+
+// As Encoder_Update(): float count over float counts per radian
+static const float countsPerRadian = COUNTS_PER_REVOLUTION / (2.0 * PI);
+
+static void FirmwareEvaluate(const double* counts, double out[3]) {
+  for (int i = 0; i < NUM_AXES; i++) {
+    float adjustedCount = static_cast<float>(counts[i]);
+    encoders.angleRadians[i] = adjustedCount / countsPerRadian;
+  }
+  Kinematics_Calculate();
+  out[0] = currentPosition.x;
+  out[1] = currentPosition.y;
+  out[2] = currentPosition.z;
+}
+
+static void HostModelEvaluate(const double* counts, double out[3]) {
+  double degrees[NUM_AXES];
+  for (int i = 0; i < NUM_AXES; i++) degrees[i] = counts[i] * 360.0 / COUNTS_PER_REVOLUTION;
+  hostModel->position(degrees, out);
+}
+
+struct KinematicsImplementation {
+  const char* name;
+  void (*evaluate)(const double* counts, double out[3]);
+};
+
+static const KinematicsImplementation IMPLEMENTATIONS[] = {
+  {"firmware", FirmwareEvaluate},
+  {"host-model", HostModelEvaluate},
+};
+static const int IMPLEMENTATION_COUNT = sizeof(IMPLEMENTATIONS) / sizeof(IMPLEMENTATIONS[0]);
+
+// ============================================================================
+// REFERENCE (long double, rotation matrices)
+// ============================================================================
+// Frame after each joint: R = R * Rz(t) (yaw), R * Ry(-t) (pitch, positive
+// lifts the tip), R * Rx(t) (roll). Links run along the new frame's X.
+static void ReferenceEvaluate(const double* counts, double out[3]) {
+  long double R[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+  long double p[3] = {0, 0, 0}, tool[3] = {0, 0, 0};
+
+  for (int i = 0; i < NUM_AXES; i++) {
+    long double theta = counts[i] * (2 * PI_L / COUNTS_PER_REVOLUTION);
+    long double c = cosl(theta), s = sinl(theta);
+    long double M[3][3];
+    switch (jointTypes[i]) {
+      case JOINT_PITCH: {
+        long double m[3][3] = {{c, 0, -s}, {0, 1, 0}, {s, 0, c}};
+        memcpy(M, m, sizeof(M));
+        break;
+      }
+      case JOINT_ROLL: {
+        long double m[3][3] = {{1, 0, 0}, {0, c, -s}, {0, s, c}};
+        memcpy(M, m, sizeof(M));
+        break;
+      }
+      default: {
+        long double m[3][3] = {{c, -s, 0}, {s, c, 0}, {0, 0, 1}};
+        memcpy(M, m, sizeof(M));
+        break;
+      }
+    }
+    long double product[3][3];
+    for (int r = 0; r < 3; r++) {
+      for (int k = 0; k < 3; k++) {
+        product[r][k] = R[r][0] * M[0][k] + R[r][1] * M[1][k] + R[r][2] * M[2][k];
+      }
+    }
+    memcpy(R, product, sizeof(R));
+
+    if (i > 0) {
+      for (int r = 0; r < 3; r++) p[r] += (long double)configLinkLengths[i - 1] * R[r][0];
+    } else {
+      for (int r = 0; r < 3; r++) {
+        tool[r] = R[r][0] * toolOffsetMm[0] + R[r][1] * toolOffsetMm[1] + R[r][2] * toolOffsetMm[2];
+      }
+    }
+  }
+  for (int r = 0; r < 3; r++) {
+    out[r] = static_cast<double>(p[r] + (long double)configLinkLengths[NUM_AXES - 1] * R[r][0] +
+                                 tool[r]);
+  }
+}
+
+// ============================================================================
+// RESULTS (shared between the workers and the parent)
+// ============================================================================
+struct WorstPose {
+  double error;  // mm
+  double delta[3];
+  double counts[NUM_AXES];
+};
+
+struct SweepStats {
+  uint64_t poses;
+  double sumSquared;
+  double maxAxis[3];
+  int worstCount;
+  WorstPose worst[MAX_WORST];
+};
+
+struct MapCell {
+  uint64_t poses;
+  double sumSquared;
+  double max;
+};
+
+struct ErrorMapGrid {
+  double cell;
+  double reach;
+  int rCells, zCells;
+
+  int index(const double p[3]) const {
+    int r = static_cast<int>(std::hypot(p[0], p[1]) / cell);
+    int z = static_cast<int>(std::floor((p[2] + reach) / cell));
+    r = std::min(std::max(r, 0), rCells - 1);
+    z = std::min(std::max(z, 0), zCells - 1);
+    return z * rCells + r;
+  }
+  int size() const { return rCells * zCells; }
+};
+
+// Keep the 'limit' largest errors, largest first
+static void KeepWorst(SweepStats& stats, int limit, double error, const double delta[3],
+                      const double* counts) {
+  if (limit == 0) return;
+  if (stats.worstCount == limit && error <= stats.worst[limit - 1].error) return;
+  int at = std::min(stats.worstCount, limit - 1);
+  while (at > 0 && stats.worst[at - 1].error < error) {
+    stats.worst[at] = stats.worst[at - 1];
+    at--;
+  }
+  WorstPose& w = stats.worst[at];
+  w.error = error;
+  memcpy(w.delta, delta, sizeof(w.delta));
+  memcpy(w.counts, counts, sizeof(w.counts));
+  if (stats.worstCount < limit) stats.worstCount++;
+}
+
+static void Accumulate(SweepStats& stats, MapCell* map, const ErrorMapGrid& grid, int worstLimit,
+                       const double* counts, const double reference[3], const double position[3]) {
+  double delta[3] = {position[0] - reference[0], position[1] - reference[1],
+                     position[2] - reference[2]};
+  double squared = delta[0] * delta[0] + delta[1] * delta[1] + delta[2] * delta[2];
+  double error = std::sqrt(squared);
+
+  stats.poses++;
+  stats.sumSquared += squared;
+  for (int k = 0; k < 3; k++) stats.maxAxis[k] = std::max(stats.maxAxis[k], std::fabs(delta[k]));
+  KeepWorst(stats, worstLimit, error, delta, counts);
+
+  MapCell& c = map[grid.index(reference)];
+  c.poses++;
+  c.sumSquared += squared;
+  c.max = std::max(c.max, error);
+}
+
+// ============================================================================
+// WORKER
+// ============================================================================
+struct SweepPlan {
+  uint64_t gridPoses;  // gridSteps ^ NUM_AXES
+  long gridSteps;
+  uint64_t randomPoses;
+  uint64_t seed;
+  int jobs;
+  int worstLimit;
+};
+
+static void RunWorker(int job, const SweepPlan& plan, const ErrorMapGrid& grid,
+                      SweepStats* stats, MapCell* maps) {
+  double counts[NUM_AXES];
+  double reference[3], position[3];
+  const long cpr = COUNTS_PER_REVOLUTION;
+
+  auto evaluate = [&]() {
+    ReferenceEvaluate(counts, reference);
+    for (int m = 0; m < IMPLEMENTATION_COUNT; m++) {
+      IMPLEMENTATIONS[m].evaluate(counts, position);
+      Accumulate(stats[m], maps + static_cast<size_t>(m) * grid.size(), grid, plan.worstLimit,
+                 counts, reference, position);
+    }
+  };
+
+  // Grid: this worker's share of the pose indices, axis 1 fastest
+  uint64_t begin = plan.gridPoses * job / plan.jobs;
+  uint64_t end = plan.gridPoses * (job + 1) / plan.jobs;
+  for (uint64_t index = begin; index < end; index++) {
+    uint64_t rest = index;
+    for (int i = 0; i < NUM_AXES; i++) {
+      long step = static_cast<long>(rest % plan.gridSteps);
+      rest /= plan.gridSteps;
+      counts[i] = static_cast<double>(-cpr / 2 + step * cpr / plan.gridSteps);
+    }
+    evaluate();
+  }
+
+  // Random: fractional counts within a turn either side of zero
+  std::mt19937_64 rng(plan.seed * 1000003ULL + static_cast<uint64_t>(job));
+  std::uniform_real_distribution<double> uniform(-static_cast<double>(cpr), static_cast<double>(cpr));
+  uint64_t randomBegin = plan.randomPoses * job / plan.jobs;
+  uint64_t randomEnd = plan.randomPoses * (job + 1) / plan.jobs;
+  for (uint64_t n = randomBegin; n < randomEnd; n++) {
+    for (int i = 0; i < NUM_AXES; i++) counts[i] = uniform(rng);
+    evaluate();
+  }
+}
+
+// ============================================================================
+// TIMING
+// ============================================================================
+static double NanosecondsPerEvaluation(void (*evaluate)(const double*, double*),
+                                       const std::vector<double>& poses) {
+  size_t count = poses.size() / NUM_AXES;
+  if (count == 0) return 0;
+  double out[3], sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t n = 0; n < count; n++) {
+    evaluate(&poses[n * NUM_AXES], out);
+    sink += out[0] + out[1] + out[2];
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  // Keep the loop from being optimized away
+  if (sink == 1e300) fprintf(stderr, " ");
+  return seconds * 1e9 / count;
+}
+
+int main(int argc, char** argv) {
+  long gridSteps = 64;
+  long long randomPoses = 4000000;
+  long long seed = 1;
+  double cell = 25.0;
+  const char* mapPath = nullptr;
+  int worstLimit = 10;
+  const char* worstPath = nullptr;
+  double limitUm = 5.0;
+  long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  long long timingPoses = 1000000;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--grid") == 0 && hasValue) {
+      gridSteps = atol(argv[++i]);
+    } else if (strcmp(arg, "--random") == 0 && hasValue) {
+      randomPoses = atoll(argv[++i]);
+    } else if (strcmp(arg, "--seed") == 0 && hasValue) {
+      seed = atoll(argv[++i]);
+    } else if (strcmp(arg, "--tool") == 0 && hasValue) {
+      if (!ArmModel_ParseNumbers(argv[++i], toolOffsetMm, 3)) {
+        fprintf(stderr, "ERROR,--tool needs X,Y,Z\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "--cell") == 0 && hasValue) {
+      cell = atof(argv[++i]);
+    } else if (strcmp(arg, "--map") == 0 && hasValue) {
+      mapPath = argv[++i];
+    } else if (strcmp(arg, "--worst") == 0 && hasValue) {
+      worstLimit = atoi(argv[++i]);
+    } else if (strcmp(arg, "--worst-file") == 0 && hasValue) {
+      worstPath = argv[++i];
+    } else if (strcmp(arg, "--limit") == 0 && hasValue) {
+      limitUm = atof(argv[++i]);
+    } else if (strcmp(arg, "--jobs") == 0 && hasValue) {
+      jobs = atol(argv[++i]);
+    } else if (strcmp(arg, "--timing") == 0 && hasValue) {
+      timingPoses = atoll(argv[++i]);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (gridSteps < 0 || gridSteps > COUNTS_PER_REVOLUTION || randomPoses < 0 || !(cell > 0) ||
+      worstLimit < 0 || worstLimit > MAX_WORST || jobs < 1 || timingPoses < 0) {
+    printUsage();
+    return 1;
+  }
+
+  SweepPlan plan;
+  plan.gridSteps = gridSteps;
+  plan.gridPoses = gridSteps > 0 ? 1 : 0;
+  for (int i = 0; i < NUM_AXES && gridSteps > 0; i++) {
+    if (plan.gridPoses > (1ULL << 40) / static_cast<uint64_t>(gridSteps)) {
+      fprintf(stderr, "ERROR,--grid %ld gives more than 2^40 poses with %d axes\n", gridSteps,
+              NUM_AXES);
+      return 1;
+    }
+    plan.gridPoses *= static_cast<uint64_t>(gridSteps);
+  }
+  plan.randomPoses = static_cast<uint64_t>(randomPoses);
+  plan.seed = static_cast<uint64_t>(seed);
+  plan.jobs = static_cast<int>(jobs);
+  plan.worstLimit = worstLimit;
+
+  // --------------------------------------------------------------------------
+  // Set up the implementations (as the firmware does at startup)
+  // --------------------------------------------------------------------------
+  Kinematics_Init();
+  Kinematics_SetToolOffset(toolOffsetMm[0], toolOffsetMm[1], toolOffsetMm[2]);
+
+  ArmModel model;
+  model.axes = NUM_AXES;
+  for (int i = 0; i < NUM_AXES; i++) {
+    model.jointTypes[i] = static_cast<uint8_t>(jointTypes[i]);
+    model.linkLengths[i] = configLinkLengths[i];
+  }
+  memcpy(model.toolOffset, toolOffsetMm, sizeof(model.toolOffset));
+  UncertaintyEngine engine(model, UncertaintyInputs());
+  hostModel = &engine;
+
+  ErrorMapGrid grid;
+  grid.cell = cell;
+  grid.reach = std::sqrt(toolOffsetMm[0] * toolOffsetMm[0] + toolOffsetMm[1] * toolOffsetMm[1] +
+                         toolOffsetMm[2] * toolOffsetMm[2]);
+  for (int i = 0; i < NUM_AXES; i++) grid.reach += std::fabs(configLinkLengths[i]);
+  grid.rCells = static_cast<int>(std::ceil(grid.reach / cell)) + 1;
+  grid.zCells = static_cast<int>(std::ceil(2 * grid.reach / cell)) + 1;
+
+  // --------------------------------------------------------------------------
+  // Sweep in worker processes, results in shared memory
+  // --------------------------------------------------------------------------
+  size_t statsBytes = sizeof(SweepStats) * IMPLEMENTATION_COUNT;
+  size_t mapBytes = sizeof(MapCell) * IMPLEMENTATION_COUNT * grid.size();
+  size_t jobBytes = statsBytes + mapBytes;
+  void* shared = mmap(nullptr, jobBytes * jobs, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                      -1, 0);
+  if (shared == MAP_FAILED) {
+    fprintf(stderr, "ERROR,Cannot map %zu bytes of results: %s\n", jobBytes * jobs, strerror(errno));
+    return 1;
+  }
+  memset(shared, 0, jobBytes * jobs);
+  auto jobStats = [&](long job) {
+    return reinterpret_cast<SweepStats*>(static_cast<char*>(shared) + jobBytes * job);
+  };
+  auto jobMaps = [&](long job) {
+    return reinterpret_cast<MapCell*>(static_cast<char*>(shared) + jobBytes * job + statsBytes);
+  };
+
+  fprintf(stderr, "INFO,%llu grid + %llu random poses, %d implementations, %ld workers\n",
+          static_cast<unsigned long long>(plan.gridPoses),
+          static_cast<unsigned long long>(plan.randomPoses), IMPLEMENTATION_COUNT, jobs);
+  fflush(stderr);
+  auto startTime = std::chrono::steady_clock::now();
+
+  std::vector<pid_t> workers;
+  for (long job = 0; job < jobs; job++) {
+    pid_t pid = fork();
+    if (pid < 0) {
+      fprintf(stderr, "ERROR,fork failed: %s\n", strerror(errno));
+      for (pid_t w : workers) kill(w, SIGTERM);
+      return 1;
+    }
+    if (pid == 0) {
+      RunWorker(static_cast<int>(job), plan, grid, jobStats(job), jobMaps(job));
+      _exit(0);
+    }
+    workers.push_back(pid);
+  }
+
+  bool workersOk = true;
+  for (pid_t w : workers) {
+    int status = 0;
+    while (waitpid(w, &status, 0) < 0 && errno == EINTR) {
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) workersOk = false;
+  }
+  if (!workersOk) {
+    fprintf(stderr, "ERROR,A worker failed\n");
+    return 1;
+  }
+  double sweepSeconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+  // --------------------------------------------------------------------------
+  // Merge the workers
+  // --------------------------------------------------------------------------
+  std::vector<SweepStats> total(IMPLEMENTATION_COUNT);
+  std::vector<MapCell> maps(static_cast<size_t>(IMPLEMENTATION_COUNT) * grid.size());
+  memset(total.data(), 0, sizeof(SweepStats) * total.size());
+  memset(maps.data(), 0, sizeof(MapCell) * maps.size());
+  for (long job = 0; job < jobs; job++) {
+    const SweepStats* stats = jobStats(job);
+    const MapCell* cells = jobMaps(job);
+    for (int m = 0; m < IMPLEMENTATION_COUNT; m++) {
+      const SweepStats& s = stats[m];
+      SweepStats& t = total[m];
+      t.poses += s.poses;
+      t.sumSquared += s.sumSquared;
+      for (int k = 0; k < 3; k++) t.maxAxis[k] = std::max(t.maxAxis[k], s.maxAxis[k]);
+      for (int w = 0; w < s.worstCount; w++) {
+        KeepWorst(t, worstLimit, s.worst[w].error, s.worst[w].delta, s.worst[w].counts);
+      }
+    }
+    for (size_t c = 0; c < maps.size(); c++) {
+      maps[c].poses += cells[c].poses;
+      maps[c].sumSquared += cells[c].sumSquared;
+      maps[c].max = std::max(maps[c].max, cells[c].max);
+    }
+  }
+  munmap(shared, jobBytes * jobs);
+
+  // --------------------------------------------------------------------------
+  // Timing (one process, the same random poses for every implementation)
+  // --------------------------------------------------------------------------
+  std::vector<double> timingSet(static_cast<size_t>(timingPoses) * NUM_AXES);
+  std::mt19937_64 rng(static_cast<uint64_t>(seed));
+  std::uniform_real_distribution<double> uniform(-COUNTS_PER_REVOLUTION, COUNTS_PER_REVOLUTION);
+  for (double& c : timingSet) c = uniform(rng);
+  std::vector<double> nsPerEval(IMPLEMENTATION_COUNT);
+  for (int m = 0; m < IMPLEMENTATION_COUNT; m++) {
+    nsPerEval[m] = NanosecondsPerEvaluation(IMPLEMENTATIONS[m].evaluate, timingSet);
+  }
+  double referenceNs = NanosecondsPerEvaluation(ReferenceEvaluate, timingSet);
+
+  // --------------------------------------------------------------------------
+  // Report
+  // --------------------------------------------------------------------------
+  bool withinLimit = true;
+  printf("impl,poses,rms_um,max_um,max_x_um,max_y_um,max_z_um,ns_per_eval\n");
+  for (int m = 0; m < IMPLEMENTATION_COUNT; m++) {
+    const SweepStats& t = total[m];
+    double rms = t.poses > 0 ? std::sqrt(t.sumSquared / t.poses) : 0;
+    double max = t.worstCount > 0 ? t.worst[0].error : 0;
+    printf("%s,%llu,%.4f,%.4f,%.4f,%.4f,%.4f,%.1f\n", IMPLEMENTATIONS[m].name,
+           static_cast<unsigned long long>(t.poses), rms * 1000, max * 1000, t.maxAxis[0] * 1000,
+           t.maxAxis[1] * 1000, t.maxAxis[2] * 1000, nsPerEval[m]);
+
+    // Without a worst list, the largest axis error is the best bound we have
+    double bound = worstLimit > 0 ? max
+                                  : std::sqrt(t.maxAxis[0] * t.maxAxis[0] +
+                                              t.maxAxis[1] * t.maxAxis[1] +
+                                              t.maxAxis[2] * t.maxAxis[2]);
+    if (bound * 1000 > limitUm) {
+      withinLimit = false;
+      fprintf(stderr, "ERROR,%s: error up to %.3f um, limit %.3f um\n", IMPLEMENTATIONS[m].name,
+              bound * 1000, limitUm);
+    }
+    if (t.worstCount > 0) {
+      fprintf(stderr, "INFO,%s worst pose (deg):", IMPLEMENTATIONS[m].name);
+      for (int i = 0; i < NUM_AXES; i++) {
+        fprintf(stderr, " %.4f", t.worst[0].counts[i] * 360.0 / COUNTS_PER_REVOLUTION);
+      }
+      fprintf(stderr, " -> %.4f um\n", t.worst[0].error * 1000);
+    }
+  }
+  fprintf(stderr, "INFO,Sweep %.2f s, reference %.1f ns/eval\n", sweepSeconds, referenceNs);
+
+  bool ok = true;
+  if (mapPath != nullptr) {
+    FILE* f = fopen(mapPath, "w");
+    if (f == nullptr) {
+      fprintf(stderr, "ERROR,Cannot open %s: %s\n", mapPath, strerror(errno));
+      ok = false;
+    } else {
+      fprintf(f, "impl,r_mm,z_mm,poses,rms_um,max_um\n");
+      for (int m = 0; m < IMPLEMENTATION_COUNT; m++) {
+        const MapCell* cells = maps.data() + static_cast<size_t>(m) * grid.size();
+        for (int z = 0; z < grid.zCells; z++) {
+          for (int r = 0; r < grid.rCells; r++) {
+            const MapCell& c = cells[z * grid.rCells + r];
+            if (c.poses == 0) continue;
+            // Cell centres
+            fprintf(f, "%s,%.1f,%.1f,%llu,%.4f,%.4f\n", IMPLEMENTATIONS[m].name,
+                    (r + 0.5) * cell, (z + 0.5) * cell - grid.reach,
+                    static_cast<unsigned long long>(c.poses),
+                    std::sqrt(c.sumSquared / c.poses) * 1000, c.max * 1000);
+          }
+        }
+      }
+      fclose(f);
+    }
+  }
+
+  if (worstPath != nullptr) {
+    FILE* f = fopen(worstPath, "w");
+    if (f == nullptr) {
+      fprintf(stderr, "ERROR,Cannot open %s: %s\n", worstPath, strerror(errno));
+      ok = false;
+    } else {
+      fprintf(f, "impl,rank,error_um,dx_um,dy_um,dz_um");
+      for (int i = 1; i <= NUM_AXES; i++) fprintf(f, ",count%d", i);
+      for (int i = 1; i <= NUM_AXES; i++) fprintf(f, ",theta%d_deg", i);
+      fprintf(f, "\n");
+      for (int m = 0; m < IMPLEMENTATION_COUNT; m++) {
+        const SweepStats& t = total[m];
+        for (int w = 0; w < t.worstCount; w++) {
+          const WorstPose& p = t.worst[w];
+          fprintf(f, "%s,%d,%.4f,%.4f,%.4f,%.4f", IMPLEMENTATIONS[m].name, w + 1,
+                  p.error * 1000, p.delta[0] * 1000, p.delta[1] * 1000, p.delta[2] * 1000);
+          for (int i = 0; i < NUM_AXES; i++) fprintf(f, ",%.3f", p.counts[i]);
+          for (int i = 0; i < NUM_AXES; i++) {
+            fprintf(f, ",%.6f", p.counts[i] * 360.0 / COUNTS_PER_REVOLUTION);
+          }
+          fprintf(f, "\n");
+        }
+      }
+      fclose(f);
+    }
+  }
+
+  if (!ok) return 1;
+  return withinLimit ? 0 : 3;
+}
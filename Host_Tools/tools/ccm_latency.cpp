@@ -0,0 +1,417 @@
+/*
+ * ============================================================================
+ * CCM_LATENCY - Per-stage latency from encoder sample to rendered point
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_latency [options] <trace.csv>
+ *
+ * Options:
+ *   --histogram FILE   Write per-stage histograms (CSV) to FILE
+ *   --chrome FILE      Write a Chrome trace (chrome://tracing, Perfetto) to FILE
+ *
+ * Reads the trace the desktop app saves with latency tracing on (firmware
+ * SETTRACE, App/src/latency-trace.js), one row per traced POS line:
+ *
+ *   timestamp,snapshot_us,enqueue_us,tx_done_us,
+ *   received_ms,parsed_ms,delivered_ms,presented_ms
+ *
+ * and splits each line's trip into stages:
+ *
+ *   sample   encoders read -> line queued (kinematics, formatting)   device
+ *   queue    line queued -> line ending out of the UART               device
+ *   wire     UART -> the app's serial read (USB, driver, event loop)  both
+ *   parse    read -> position parsed                                  app
+ *   deliver  parsed -> position display updated                       app
+ *   present  display updated -> animation frame rendered              app
+ *   total    encoders read -> frame rendered
+ *
+ * Device times are 32-bit micros() (unwrapped here) on a clock that is
+ * neither synchronized nor the same rate as the host's. They are mapped
+ * onto the host clock with the lower envelope of (received - tx_done): the
+ * fastest lines in each stretch of the trace define the offset, and a
+ * line through those minima follows the crystal's drift. So the wire stage
+ * is measured above its own minimum - it shows USB and scheduling delays
+ * on top of the fastest transfer, not the absolute transit time, which a
+ * one-way measurement cannot separate from the clock offset. The total
+ * has the same floor. For an absolute figure add the minimum transit from
+ * ccm_sync (half its best round trip).
+ *
+ * A summary goes to stdout as CSV, one row per stage (milliseconds):
+ *
+ *   stage,count,min_ms,p50_ms,p90_ms,p99_ms,max_ms,mean_ms
+ *
+ * Stages a line did not reach (e.g. no frame drawn before the trace was
+ * saved) are left out of that stage and the total.
+ *
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../src/clock_sync.h"
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_latency [options] <trace.csv>\n"
+          "  --histogram FILE   Per-stage histograms (CSV)\n"
+          "  --chrome FILE      Chrome trace-event JSON\n");
+}
+
+static const char* TRACE_HEADER =
+    "timestamp,snapshot_us,enqueue_us,tx_done_us,received_ms,parsed_ms,delivered_ms,presented_ms";
+
+// Stretches of the trace whose fastest line sets the clock offset
+static const size_t ENVELOPE_WINDOWS = 16;
+static const size_t ENVELOPE_MIN_LINES = 8;  // Per window
+
+// Histogram bucket upper bounds (ms); one more bucket for anything above
+static const double BUCKET_MS[] = {0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1, 2, 5,
+                                   10, 20, 50, 100, 200, 500, 1000};
+static const size_t BUCKETS = sizeof(BUCKET_MS) / sizeof(BUCKET_MS[0]) + 1;
+
+// ============================================================================
+// TRACE
+// ============================================================================
+struct TracedLine {
+  unsigned long long timestamp = 0;
+  // Device, unwrapped micros()
+  int64_t snapshotUs = 0, enqueueUs = 0, txDoneUs = 0;
+  // Host, epoch ms (NAN = stage not reached)
+  double receivedMs = NAN, parsedMs = NAN, deliveredMs = NAN, presentedMs = NAN;
+};
+
+// Empty field -> NAN
+static double ParseField(const char*& p) {
+  char* end;
+  double value = strtod(p, &end);
+  if (end == p) value = NAN;
+  p = end;
+  while (*p != ',' && *p != '\0' && *p != '\n' && *p != '\r') p++;
+  if (*p == ',') p++;
+  return value;
+}
+
+static bool LoadTrace(const char* path, std::vector<TracedLine>& out, std::string& error) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    error = std::string("Cannot open ") + path + ": " + strerror(errno);
+    return false;
+  }
+
+  DeviceClock clock;  // Only for unwrapping
+  char buffer[512];
+  size_t lineNumber = 0;
+  bool ok = true;
+  while (fgets(buffer, sizeof(buffer), file)) {
+    lineNumber++;
+    if (lineNumber == 1) {
+      if (strncmp(buffer, TRACE_HEADER, strlen(TRACE_HEADER)) != 0) {
+        error = std::string(path) + " is not a latency trace (unexpected header)";
+        ok = false;
+        break;
+      }
+      continue;
+    }
+    if (buffer[0] == '\n' || buffer[0] == '\r' || buffer[0] == '\0') continue;
+
+    const char* p = buffer;
+    double fields[8];
+    for (double& field : fields) field = ParseField(p);
+    if (std::isnan(fields[0]) || std::isnan(fields[1]) || std::isnan(fields[2]) ||
+        std::isnan(fields[3]) || std::isnan(fields[4])) {
+      error = std::string(path) + " line " + std::to_string(lineNumber) + ": missing fields";
+      ok = false;
+      break;
+    }
+
+    TracedLine line;
+    line.timestamp = static_cast<unsigned long long>(fields[0]);
+    line.snapshotUs = clock.unwrap(static_cast<uint32_t>(fields[1]));
+    line.enqueueUs = clock.unwrap(static_cast<uint32_t>(fields[2]));
+    line.txDoneUs = clock.unwrap(static_cast<uint32_t>(fields[3]));
+    line.receivedMs = fields[4];
+    line.parsedMs = fields[5];
+    line.deliveredMs = fields[6];
+    line.presentedMs = fields[7];
+    out.push_back(line);
+  }
+  fclose(file);
+  if (ok && out.empty()) {
+    error = std::string(path) + " has no traced lines";
+    ok = false;
+  }
+  return ok;
+}
+
+// ============================================================================
+// DEVICE -> HOST CLOCK (lower envelope)
+// ============================================================================
+// hostMs = deviceUs / 1000 + offsetMs + slope * (deviceUs - originUs) / 1000
+struct ClockMap {
+  int64_t originUs = 0;
+  double offsetMs = 0;
+  double slope = 0;    // Drift, host ms per device ms - 1
+  size_t points = 0;   // Envelope points the fit used
+
+  double toHostMs(int64_t deviceUs) const {
+    double deviceMs = (deviceUs - originUs) / 1000.0;
+    return originUs / 1000.0 + deviceMs * (1 + slope) + offsetMs;
+  }
+};
+
+static ClockMap FitClock(const std::vector<TracedLine>& lines) {
+  ClockMap map;
+  map.originUs = lines.front().txDoneUs;
+
+  // Minimum of (received - txDone) in each stretch
+  size_t windows = std::max<size_t>(1, std::min(ENVELOPE_WINDOWS, lines.size() / ENVELOPE_MIN_LINES));
+  std::vector<double> xs, ys;
+  for (size_t w = 0; w < windows; w++) {
+    size_t from = lines.size() * w / windows;
+    size_t to = lines.size() * (w + 1) / windows;
+    double bestY = INFINITY, bestX = 0;
+    for (size_t i = from; i < to; i++) {
+      double x = (lines[i].txDoneUs - map.originUs) / 1000.0;
+      double y = lines[i].receivedMs - lines[i].txDoneUs / 1000.0;
+      if (y < bestY) {
+        bestY = y;
+        bestX = x;
+      }
+    }
+    xs.push_back(bestX);
+    ys.push_back(bestY);
+  }
+
+  // Least-squares line through the minima (flat with a single window)
+  double meanX = 0, meanY = 0;
+  for (size_t i = 0; i < xs.size(); i++) {
+    meanX += xs[i];
+    meanY += ys[i];
+  }
+  meanX /= xs.size();
+  meanY /= ys.size();
+  double sxx = 0, sxy = 0;
+  for (size_t i = 0; i < xs.size(); i++) {
+    sxx += (xs[i] - meanX) * (xs[i] - meanX);
+    sxy += (xs[i] - meanX) * (ys[i] - meanY);
+  }
+  map.slope = sxx > 0 ? sxy / sxx : 0;
+  map.offsetMs = meanY - map.slope * meanX;
+  map.points = xs.size();
+
+  // Shift down so that no line arrives before it was sent
+  double lowest = INFINITY;
+  for (const TracedLine& line : lines) {
+    lowest = std::min(lowest, line.receivedMs - map.toHostMs(line.txDoneUs));
+  }
+  map.offsetMs += lowest;
+  return map;
+}
+
+// ============================================================================
+// STAGES
+// ============================================================================
+enum StageId { STAGE_SAMPLE, STAGE_QUEUE, STAGE_WIRE, STAGE_PARSE, STAGE_DELIVER,
+               STAGE_PRESENT, STAGE_TOTAL, STAGE_COUNT };
+
+static const char* STAGE_NAMES[STAGE_COUNT] = {"sample", "queue", "wire", "parse",
+                                               "deliver", "present", "total"};
+
+// Which process each stage belongs to in the Chrome trace
+static const int STAGE_PID[STAGE_COUNT] = {1, 1, 2, 3, 3, 3, 4};
+static const char* PROCESS_NAMES[] = {"", "Arm firmware", "Link", "App", "End to end"};
+
+// Stage start / end on the host clock (ms), NAN if not reached
+struct Span {
+  double startMs;
+  double endMs;
+};
+
+static void LineSpans(const TracedLine& line, const ClockMap& map, Span spans[STAGE_COUNT]) {
+  double snapshot = map.toHostMs(line.snapshotUs);
+  double enqueue = map.toHostMs(line.enqueueUs);
+  double txDone = map.toHostMs(line.txDoneUs);
+  spans[STAGE_SAMPLE] = {snapshot, enqueue};
+  spans[STAGE_QUEUE] = {enqueue, txDone};
+  spans[STAGE_WIRE] = {txDone, line.receivedMs};
+  spans[STAGE_PARSE] = {line.receivedMs, line.parsedMs};
+  spans[STAGE_DELIVER] = {line.parsedMs, line.deliveredMs};
+  spans[STAGE_PRESENT] = {line.deliveredMs, line.presentedMs};
+  spans[STAGE_TOTAL] = {snapshot, line.presentedMs};
+}
+
+static double Percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0;
+  size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+static size_t Bucket(double ms) {
+  for (size_t b = 0; b + 1 < BUCKETS; b++) {
+    if (ms <= BUCKET_MS[b]) return b;
+  }
+  return BUCKETS - 1;
+}
+
+// ============================================================================
+// CHROME TRACE
+// ============================================================================
+// Trace-event format: one complete ("X") event per stage per line, one
+// process per layer and one thread per stage, times in microseconds from
+// the first sample
+static bool WriteChromeTrace(const char* path, const std::vector<TracedLine>& lines,
+                             const ClockMap& map, std::string& error) {
+  FILE* file = fopen(path, "w");
+  if (file == nullptr) {
+    error = std::string("Cannot create ") + path + ": " + strerror(errno);
+    return false;
+  }
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bool first = true;
+  auto separator = [&]() {
+    if (!first) fputs(",\n", file);
+    first = false;
+  };
+
+  for (int pid = 1; pid <= 4; pid++) {
+    separator();
+    fprintf(file, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,\"tid\":0,"
+                  "\"args\":{\"name\":\"%s\"}}", pid, PROCESS_NAMES[pid]);
+    separator();
+    fprintf(file, "{\"ph\":\"M\",\"name\":\"process_sort_index\",\"pid\":%d,\"tid\":0,"
+                  "\"args\":{\"sort_index\":%d}}", pid, pid);
+  }
+  for (int stage = 0; stage < STAGE_COUNT; stage++) {
+    separator();
+    fprintf(file, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,"
+                  "\"args\":{\"name\":\"%s\"}}", STAGE_PID[stage], stage + 1, STAGE_NAMES[stage]);
+  }
+
+  double zeroMs = map.toHostMs(lines.front().snapshotUs);
+  for (const TracedLine& line : lines) {
+    Span spans[STAGE_COUNT];
+    LineSpans(line, map, spans);
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+      const Span& span = spans[stage];
+      if (std::isnan(span.startMs) || std::isnan(span.endMs)) continue;
+      separator();
+      fprintf(file, "{\"ph\":\"X\",\"cat\":\"latency\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,"
+                    "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"timestamp\":%llu}}",
+              STAGE_NAMES[stage], STAGE_PID[stage], stage + 1,
+              (span.startMs - zeroMs) * 1000, std::max(0.0, span.endMs - span.startMs) * 1000,
+              line.timestamp);
+    }
+  }
+  fprintf(file, "\n]}\n");
+
+  if (fclose(file) != 0) {
+    error = std::string("Cannot write ") + path;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  const char* histogramPath = nullptr;
+  const char* chromePath = nullptr;
+  const char* tracePath = nullptr;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--histogram") == 0 && hasValue) {
+      histogramPath = argv[++i];
+    } else if (strcmp(arg, "--chrome") == 0 && hasValue) {
+      chromePath = argv[++i];
+    } else if (arg[0] == '-' || tracePath != nullptr) {
+      printUsage();
+      return 1;
+    } else {
+      tracePath = arg;
+    }
+  }
+
+  if (tracePath == nullptr) {
+    printUsage();
+    return 1;
+  }
+
+  std::vector<TracedLine> lines;
+  std::string error;
+  if (!LoadTrace(tracePath, lines, error)) {
+    fprintf(stderr, "ERROR,%s\n", error.c_str());
+    return 1;
+  }
+
+  ClockMap map = FitClock(lines);
+  fprintf(stderr, "INFO,%zu traced lines, device clock mapped from %zu envelope points, "
+                  "drift %.1f ppm\n", lines.size(), map.points, map.slope * 1e6);
+
+  // --------------------------------------------------------------------------
+  // Per-stage distributions
+  // --------------------------------------------------------------------------
+  std::vector<double> stageMs[STAGE_COUNT];
+  for (const TracedLine& line : lines) {
+    Span spans[STAGE_COUNT];
+    LineSpans(line, map, spans);
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+      double ms = spans[stage].endMs - spans[stage].startMs;
+      if (!std::isnan(ms)) stageMs[stage].push_back(ms);
+    }
+  }
+
+  printf("stage,count,min_ms,p50_ms,p90_ms,p99_ms,max_ms,mean_ms\n");
+  for (int stage = 0; stage < STAGE_COUNT; stage++) {
+    std::vector<double>& values = stageMs[stage];
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (double ms : values) sum += ms;
+    printf("%s,%zu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", STAGE_NAMES[stage], values.size(),
+           Percentile(values, 0), Percentile(values, 0.50), Percentile(values, 0.90),
+           Percentile(values, 0.99), Percentile(values, 1.0),
+           values.empty() ? 0.0 : sum / values.size());
+  }
+
+  // --------------------------------------------------------------------------
+  // Histograms: stage,upper_ms,count (upper_ms empty = above the last bound)
+  // --------------------------------------------------------------------------
+  if (histogramPath != nullptr) {
+    FILE* file = fopen(histogramPath, "w");
+    if (file == nullptr) {
+      fprintf(stderr, "ERROR,Cannot create %s: %s\n", histogramPath, strerror(errno));
+      return 1;
+    }
+    fprintf(file, "stage,upper_ms,count\n");
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+      size_t counts[BUCKETS] = {};
+      for (double ms : stageMs[stage]) counts[Bucket(ms)]++;
+      for (size_t b = 0; b < BUCKETS; b++) {
+        if (b + 1 < BUCKETS) fprintf(file, "%s,%g,%zu\n", STAGE_NAMES[stage], BUCKET_MS[b], counts[b]);
+        else fprintf(file, "%s,,%zu\n", STAGE_NAMES[stage], counts[b]);
+      }
+    }
+    if (fclose(file) != 0) {
+      fprintf(stderr, "ERROR,Cannot write %s\n", histogramPath);
+      return 1;
+    }
+  }
+
+  if (chromePath != nullptr && !WriteChromeTrace(chromePath, lines, map, error)) {
+    fprintf(stderr, "ERROR,%s\n", error.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,346 @@
+/*
+ * ============================================================================
+ * CCM_OCTREE - Benchmark of the viewer's level-of-detail point cloud
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_octree [options] [input|-]
+ *
+ * Options:
+ *   --points N       Synthetic scan size when no input is given
+ *                    (default: 10000000)
+ *   --skip N         Input lines: fields before x,y,z (default: 1)
+ *   --batch N        Points inserted per call, one display frame of
+ *                    streaming (default: 1000)
+ *   --half MM        Half size of the root cube (default: 2048)
+ *   --min-spacing MM Spacing below which nodes keep every point
+ *                    (default: 0.05)
+ *   --error PX       Allowed screen-space error (default: 1.5)
+ *   --budget N       Most points drawn per frame (default: 3000000)
+ *   --views N        Camera positions timed (default: 64)
+ *
+ * Builds the octree of src/point_octree.h as the viewer does while a scan
+ * streams in (--batch points per call), then selects what a 1920x1080
+ * view with the viewer's 75 degree field of view draws from --views camera
+ * positions, orbiting the cloud from close up to far away.
+ *
+ * Input is stream lines as written by ccm_sync (host_ns,x,y,z,...),
+ * ccm_record (--skip 2) or raw POS lines. Without one, a synthetic scan of
+ * --points points is used: strokes over a plate, a dome and a bore.
+ *
+ * Reports insert throughput and the slowest batch, memory, and per view
+ * the nodes and points selected and the time taken. The tree is checked:
+ * every point stored once, in a node whose cube contains it.
+ *
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/point_octree.h"
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_octree [options] [input|-]\n"
+          "  --points N       Synthetic scan size without input (default: 10000000)\n"
+          "  --skip N         Input lines: fields before x,y,z (default: 1)\n"
+          "  --batch N        Points inserted per call (default: 1000)\n"
+          "  --half MM        Half size of the root cube (default: 2048)\n"
+          "  --min-spacing MM Spacing below which nodes keep every point (default: 0.05)\n"
+          "  --error PX       Allowed screen-space error (default: 1.5)\n"
+          "  --budget N       Most points drawn per frame (default: 3000000)\n"
+          "  --views N        Camera positions timed (default: 64)\n");
+}
+
+// x,y,z after 'skip' fields
+static bool ParsePoint(const char* p, int skip, float xyz[3]) {
+  if (strncmp(p, "POS,", 4) == 0) p += 4;
+  for (int i = 0; i < skip; i++) {
+    p = strchr(p, ',');
+    if (p == nullptr) return false;
+    p++;
+  }
+  for (int i = 0; i < 3; i++) {
+    if (i > 0) {
+      if (*p != ',') return false;
+      p++;
+    }
+    char* end;
+    xyz[i] = strtof(p, &end);
+    if (end == p) return false;
+    p = end;
+  }
+  return true;
+}
+
+// A plate 300 x 300 mm at z = 0, a dome of radius 80 mm on it and a bore
+// of radius 40 mm through it, scanned in strokes of 2000 points 0.1 mm
+// apart as the probe is drawn over them (20 um noise)
+static void SyntheticScan(size_t count, std::vector<float>& positions) {
+  const float pi = static_cast<float>(M_PI);
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::normal_distribution<float> noise(0.0f, 0.02f);
+  positions.resize(3 * count);
+
+  int surface = 0;
+  float u = 0, v = 0, du = 0, dv = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (i % 2000 == 0) {
+      // New stroke: surface by area, random start and direction (u, v in mm)
+      float pick = unit(rng);
+      surface = pick < 0.6f ? 0 : (pick < 0.85f ? 1 : 2);
+      float heading = 2 * pi * unit(rng);
+      du = 0.1f * std::cos(heading);
+      dv = 0.1f * std::sin(heading);
+      u = 300 * unit(rng);
+      v = 300 * unit(rng);
+    }
+    u += du;
+    v += dv;
+
+    float x, y, z;
+    if (surface == 0) {
+      x = std::fabs(std::fmod(u, 600.0f) - 300) - 150;  // Bounce at the edges
+      y = std::fabs(std::fmod(v, 600.0f) - 300) - 150;
+      z = 0;
+    } else if (surface == 1) {
+      float a = u / 80;  // Around
+      float b = std::fabs(std::fmod(v / 80, pi) - pi / 2);  // Elevation 0..90 deg
+      x = 60 + 80 * std::cos(b) * std::cos(a);
+      y = 40 + 80 * std::cos(b) * std::sin(a);
+      z = 80 * std::sin(b);
+    } else {
+      float a = u / 40;
+      x = -70 + 40 * std::cos(a);
+      y = -60 + 40 * std::sin(a);
+      z = -std::fabs(std::fmod(v, 120.0f) - 60);
+    }
+    positions[3 * i] = x + noise(rng);
+    positions[3 * i + 1] = y + noise(rng);
+    positions[3 * i + 2] = z + noise(rng);
+  }
+}
+
+// Column-major perspective * look-at, as three.js builds it
+static void ViewProjection(const float eye[3], const float target[3], float fovDegrees,
+                           float aspect, float near, float far, float out[16]) {
+  float f[3], s[3], u[3];
+  float up[3] = {0, 0, 1};
+  for (int k = 0; k < 3; k++) f[k] = target[k] - eye[k];
+  float length = std::sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+  for (int k = 0; k < 3; k++) f[k] /= length;
+  s[0] = f[1] * up[2] - f[2] * up[1];
+  s[1] = f[2] * up[0] - f[0] * up[2];
+  s[2] = f[0] * up[1] - f[1] * up[0];
+  length = std::sqrt(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+  for (int k = 0; k < 3; k++) s[k] /= length;
+  u[0] = s[1] * f[2] - s[2] * f[1];
+  u[1] = s[2] * f[0] - s[0] * f[2];
+  u[2] = s[0] * f[1] - s[1] * f[0];
+
+  float view[16] = {s[0], u[0], -f[0], 0, s[1], u[1], -f[1], 0, s[2], u[2], -f[2], 0,
+                    -(s[0] * eye[0] + s[1] * eye[1] + s[2] * eye[2]),
+                    -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]),
+                    f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2], 1};
+  float t = 1.0f / std::tan(fovDegrees * static_cast<float>(M_PI) / 360.0f);
+  float projection[16] = {t / aspect, 0, 0, 0, 0, t, 0, 0, 0, 0, (far + near) / (near - far), -1,
+                          0, 0, 2 * far * near / (near - far), 0};
+  for (int col = 0; col < 4; col++) {
+    for (int row = 0; row < 4; row++) {
+      float sum = 0;
+      for (int k = 0; k < 4; k++) sum += projection[k * 4 + row] * view[col * 4 + k];
+      out[col * 4 + row] = sum;
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  long long points = 10000000;
+  int skip = 1;
+  long batch = 1000;
+  float half = 2048;
+  float minSpacing = 0.05f;
+  float errorPixels = 1.5f;
+  long long budget = 3000000;
+  int views = 64;
+  const char* inputPath = nullptr;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--points") == 0 && hasValue) {
+      points = atoll(argv[++i]);
+    } else if (strcmp(arg, "--skip") == 0 && hasValue) {
+      skip = atoi(argv[++i]);
+    } else if (strcmp(arg, "--batch") == 0 && hasValue) {
+      batch = atol(argv[++i]);
+    } else if (strcmp(arg, "--half") == 0 && hasValue) {
+      half = static_cast<float>(atof(argv[++i]));
+    } else if (strcmp(arg, "--min-spacing") == 0 && hasValue) {
+      minSpacing = static_cast<float>(atof(argv[++i]));
+    } else if (strcmp(arg, "--error") == 0 && hasValue) {
+      errorPixels = static_cast<float>(atof(argv[++i]));
+    } else if (strcmp(arg, "--budget") == 0 && hasValue) {
+      budget = atoll(argv[++i]);
+    } else if (strcmp(arg, "--views") == 0 && hasValue) {
+      views = atoi(argv[++i]);
+    } else if (arg[0] == '-' && arg[1] != '\0') {
+      printUsage();
+      return 1;
+    } else if (inputPath == nullptr) {
+      inputPath = arg;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (points < 1 || skip < 0 || batch < 1 || !(half > 0) || !(minSpacing > 0) ||
+      !(errorPixels > 0) || budget < 1 || views < 1) {
+    printUsage();
+    return 1;
+  }
+
+  // --------------------------------------------------------------------------
+  // Points
+  // --------------------------------------------------------------------------
+  std::vector<float> positions;
+  if (inputPath != nullptr) {
+    FILE* input = strcmp(inputPath, "-") == 0 ? stdin : fopen(inputPath, "r");
+    if (input == nullptr) {
+      fprintf(stderr, "ERROR,Cannot open %s\n", inputPath);
+      return 1;
+    }
+    char line[1024];
+    float xyz[3];
+    while (fgets(line, sizeof(line), input) != nullptr) {
+      if (ParsePoint(line, skip, xyz)) positions.insert(positions.end(), xyz, xyz + 3);
+    }
+    if (input != stdin) fclose(input);
+  } else {
+    SyntheticScan(static_cast<size_t>(points), positions);
+  }
+  size_t count = positions.size() / 3;
+  if (count == 0) {
+    fprintf(stderr, "ERROR,No points in %s\n", inputPath);
+    return 1;
+  }
+  std::vector<uint32_t> colors(count, 0xFF50AF4Cu);
+
+  // --------------------------------------------------------------------------
+  // Insert, one batch per display frame
+  // --------------------------------------------------------------------------
+  float center[3] = {0, 0, 0};
+  PointOctree octree(center, half, minSpacing);
+  double slowestBatch = 0;
+  auto startTime = std::chrono::steady_clock::now();
+  for (size_t start = 0; start < count; start += static_cast<size_t>(batch)) {
+    size_t n = std::min(static_cast<size_t>(batch), count - start);
+    auto batchStart = std::chrono::steady_clock::now();
+    octree.insert(&positions[3 * start], &colors[start], n);
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+    slowestBatch = std::max(slowestBatch, seconds);
+  }
+  double insertSeconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+  OctreeStats s = octree.stats();
+  fprintf(stderr,
+          "INFO,Inserted %llu points in %.2f s (%.1f ns/point, %.2f Mpts/s), slowest batch of "
+          "%ld: %.3f ms\n",
+          static_cast<unsigned long long>(s.inserted), insertSeconds,
+          insertSeconds * 1e9 / s.inserted, s.inserted / insertSeconds / 1e6, batch,
+          slowestBatch * 1000);
+  fprintf(stderr, "INFO,%llu stored, %llu outside the cube, %zu nodes, %.1f MB\n",
+          static_cast<unsigned long long>(s.stored), static_cast<unsigned long long>(s.outside),
+          s.nodes, s.bytes / 1048576.0);
+
+  // --------------------------------------------------------------------------
+  // Check: every point once, inside its node
+  // --------------------------------------------------------------------------
+  bool ok = s.stored + s.outside == s.inserted;
+  uint64_t total = 0;
+  for (uint32_t node = 0; node < octree.nodeCount(); node++) {
+    size_t n = octree.pointCount(node);
+    total += n;
+    const float* p = octree.positions(node);
+    const float* c = octree.center(node);
+    float limit = octree.halfSize(node) * 1.0001f;
+    for (size_t i = 0; i < n && ok; i++) {
+      for (int k = 0; k < 3; k++) {
+        if (!(std::fabs(p[3 * i + k] - c[k]) <= limit)) ok = false;
+      }
+    }
+  }
+  if (total != s.stored) ok = false;
+  if (!ok) {
+    fprintf(stderr,
+            "ERROR,Octree check failed: %llu inserted, %llu stored, %llu in nodes "
+            "(or a point outside its node)\n",
+            static_cast<unsigned long long>(s.inserted),
+            static_cast<unsigned long long>(s.stored), static_cast<unsigned long long>(total));
+    return 2;
+  }
+
+  // --------------------------------------------------------------------------
+  // Selection from orbiting cameras
+  // --------------------------------------------------------------------------
+  float low[3] = {1e30f, 1e30f, 1e30f}, high[3] = {-1e30f, -1e30f, -1e30f};
+  for (size_t i = 0; i < count; i++) {
+    for (int k = 0; k < 3; k++) {
+      low[k] = std::min(low[k], positions[3 * i + k]);
+      high[k] = std::max(high[k], positions[3 * i + k]);
+    }
+  }
+  float target[3], extent = 0;
+  for (int k = 0; k < 3; k++) {
+    target[k] = (low[k] + high[k]) / 2;
+    extent = std::max(extent, high[k] - low[k]);
+  }
+
+  const float width = 1920, height = 1080, fov = 75;
+  OctreeCamera camera;
+  camera.projectionScale = height / (2 * std::tan(fov * static_cast<float>(M_PI) / 360.0f));
+
+  printf("view,distance_mm,nodes,points,select_us\n");
+  std::vector<uint32_t> selected;
+  double slowestSelect = 0, sumSelect = 0;
+  uint64_t mostPoints = 0;
+  for (int v = 0; v < views; v++) {
+    // Close up (a tenth of the cloud) to two cloud sizes away
+    float distance = extent * (0.1f + 1.9f * v / std::max(1, views - 1));
+    float angle = 2 * static_cast<float>(M_PI) * v / 16.0f;
+    camera.eye[0] = target[0] + distance * 0.8f * std::cos(angle);
+    camera.eye[1] = target[1] + distance * 0.8f * std::sin(angle);
+    camera.eye[2] = target[2] + distance * 0.6f;
+    ViewProjection(camera.eye, target, fov, width / height, 0.1f, 5000, camera.viewProjection);
+
+    auto selectStart = std::chrono::steady_clock::now();
+    uint64_t drawn = octree.select(camera, errorPixels, static_cast<uint64_t>(budget), selected);
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - selectStart).count();
+    slowestSelect = std::max(slowestSelect, seconds);
+    sumSelect += seconds;
+    mostPoints = std::max(mostPoints, drawn);
+    printf("%d,%.1f,%zu,%llu,%.1f\n", v, distance, selected.size(),
+           static_cast<unsigned long long>(drawn), seconds * 1e6);
+  }
+  fprintf(stderr, "INFO,Select: mean %.1f us, slowest %.1f us, at most %llu of %llu points drawn\n",
+          sumSelect / views * 1e6, slowestSelect * 1e6, static_cast<unsigned long long>(mostPoints),
+          static_cast<unsigned long long>(s.stored));
+  return 0;
+}
@@ -0,0 +1,638 @@
+/*
+ * ============================================================================
+ * CCM_PIPELINE - Pipelined host processing with one thread per stage
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_pipeline [options] <serial port|file|->
+ *
+ * Options:
+ *   --baud N           Serial baud rate (default: 115200)
+ *   --no-wait          Do not wait for the startup banner (port already open)
+ *   --seconds S        Stop after S seconds (default: 0 = end of input / signal)
+ *   --kinematics       Recompute x,y,z from the joint angles (model below)
+ *   --joints LIST      Joint types, base to tip (default: "yaw pitch pitch pitch")
+ *   --links LIST       Link lengths in mm (default: "254 254 254 35")
+ *   --tool X,Y,Z       Tool offset in mm (default: 0,0,0)
+ *   --origin X,Y,Z     Added to recomputed x,y,z (default: 0,0,0)
+ *   --smooth N         Moving average over N samples (default: 1 = off)
+ *   --max-jump MM      Drop samples further than MM from the last one kept
+ *                      (default: 0 = off)
+ *   --compensate MAP   Correct x,y,z with a volumetric error map (ccm_errormap)
+ *   --output FILE      Processed stream to FILE (default: stdout)
+ *   --fit TYPE         Fit a plane, line or circle to the latest samples
+ *   --fit-window N     Samples per fit (default: 2000)
+ *   --fit-every N      Samples between fits (default: 1000)
+ *   --batch N          Largest batch, in samples (default: 256)
+ *   --queue N          Batches each queue holds (default: 256)
+ *   --pin LIST         CPUs for the stages in order, e.g. "0-3" or "2,3"
+ *   --metrics-s S      Metrics period on stderr (default: 5, 0 = only at exit)
+ *
+ * Every stage runs on its own thread and hands batches to the next one
+ * through a bounded lock-free queue (src/pipeline.h):
+ *
+ *   source -> decode -> [kinematics] -> [filter] -> [compensate] -+-> store
+ *                                                                 +-> [fit]
+ *
+ *   source      reads the port, pipe or file
+ *   decode      POS lines (firmware) or host_ns,x,y,z,... (ccm_sync)
+ *   kinematics  x,y,z from the angles with the host model (uncertainty.h);
+ *               the firmware's origin offset is not in the model: --origin
+ *   filter      jump rejection, then a moving average of x,y,z
+ *   compensate  error map correction
+ *   store       host_ns,x,y,z,theta1,...,thetaN to --output
+ *   fit         a geometry fit (geometry_fit.h) every --fit-every samples,
+ *               reported on stderr
+ *
+ * Stages in brackets only run when their option is given; a serial port is
+ * sent START first and STOP at the end. From a serial port or a pipe the
+ * source never waits: when every queue behind it is full it drops input
+ * and counts it. From a file nothing is dropped and the pipeline runs as
+ * fast as its slowest stage. The fit never slows storage: batches it has
+ * no room for are skipped.
+ *
+ * Per stage, stderr gets samples/s, where the thread's time went (busy,
+ * starved of input, blocked on a full queue downstream), its input queue's
+ * depth and largest depth, and anything dropped.
+ *
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../src/buffered_writer.h"
+#include "../src/error_map.h"
+#include "../src/geometry_fit.h"
+#include "../src/pipeline.h"
+#include "../src/serial_port.h"
+#include "../src/uncertainty.h"
+
+// A jump seen this many times in a row is a real move, not a glitch
+static const int JUMP_REANCHOR_SAMPLES = 3;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onStopSignal(int) {
+  stopRequested = 1;
+}
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_pipeline [options] <serial port|file|->\n"
+          "  --baud N           Serial baud rate (default: 115200)\n"
+          "  --no-wait          Do not wait for the startup banner\n"
+          "  --seconds S        Stop after S seconds (default: 0 = end of input)\n"
+          "  --kinematics       Recompute x,y,z from the joint angles\n"
+          "  --joints LIST      Joint types (default: \"yaw pitch pitch pitch\")\n"
+          "  --links LIST       Link lengths, mm (default: \"254 254 254 35\")\n"
+          "  --tool X,Y,Z       Tool offset, mm (default: 0,0,0)\n"
+          "  --origin X,Y,Z     Added to recomputed x,y,z (default: 0,0,0)\n"
+          "  --smooth N         Moving average over N samples (default: 1 = off)\n"
+          "  --max-jump MM      Drop jumps larger than MM (default: 0 = off)\n"
+          "  --compensate MAP   Correct x,y,z with a volumetric error map\n"
+          "  --output FILE      Processed stream to FILE (default: stdout)\n"
+          "  --fit TYPE         Fit a plane, line or circle to the latest samples\n"
+          "  --fit-window N     Samples per fit (default: 2000)\n"
+          "  --fit-every N      Samples between fits (default: 1000)\n"
+          "  --batch N          Largest batch, samples (default: 256)\n"
+          "  --queue N          Batches per queue (default: 256)\n"
+          "  --pin LIST         CPUs for the stages in order (\"0-3\", \"2,3\")\n"
+          "  --metrics-s S      Metrics period on stderr (default: 5, 0 = at exit)\n");
+}
+
+static double CpuSeconds() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// ============================================================================
+// STAGE FUNCTIONS
+// ============================================================================
+// Each runs on its stage's thread only; counters read by the main thread
+// are atomics.
+class Filter {
+public:
+  Filter(int smooth, double maxJump) : window(smooth), maxJump(maxJump), ring(smooth) {}
+
+  void operator()(PipelineBatch& batch) {
+    size_t kept = 0;
+    for (PipelineSample& s : batch.samples) {
+      if (maxJump > 0 && haveLast) {
+        double d = std::sqrt((s.xyz[0] - last[0]) * (s.xyz[0] - last[0]) +
+                             (s.xyz[1] - last[1]) * (s.xyz[1] - last[1]) +
+                             (s.xyz[2] - last[2]) * (s.xyz[2] - last[2]));
+        if (d > maxJump && ++jumps < JUMP_REANCHOR_SAMPLES) {
+          rejectedCount.fetch_add(1, std::memory_order_relaxed);
+          continue;
+        }
+        if (d > maxJump) filled = 0;  // Moved: do not average across it
+      }
+      jumps = 0;
+      haveLast = true;
+      std::copy(s.xyz, s.xyz + 3, last);
+
+      if (window > 1) {
+        if (filled == 0) sum[0] = sum[1] = sum[2] = 0;
+        Point& slot = ring[next];
+        for (int k = 0; k < 3; k++) {
+          if (filled == window) sum[k] -= slot.v[k];
+          slot.v[k] = s.xyz[k];
+          sum[k] += s.xyz[k];
+        }
+        next = (next + 1) % window;
+        if (filled < window) filled++;
+        for (int k = 0; k < 3; k++) s.xyz[k] = sum[k] / filled;
+      }
+      batch.samples[kept++] = s;
+    }
+    batch.samples.resize(kept);
+  }
+
+  uint64_t rejected() const { return rejectedCount.load(std::memory_order_relaxed); }
+
+private:
+  struct Point {
+    double v[3];
+  };
+
+  int window;
+  double maxJump;
+  std::vector<Point> ring;  // Last 'window' samples kept
+  int next = 0;
+  int filled = 0;
+  double sum[3] = {0, 0, 0};
+  double last[3] = {0, 0, 0};
+  bool haveLast = false;
+  int jumps = 0;
+  std::atomic<uint64_t> rejectedCount{0};
+};
+
+class Compensator {
+public:
+  explicit Compensator(const ErrorMap& map) : map(map) {}
+
+  void operator()(PipelineBatch& batch) {
+    size_t n = batch.samples.size();
+    for (auto& v : xyz) v.resize(n);
+    for (size_t i = 0; i < n; i++) {
+      for (int k = 0; k < 3; k++) xyz[k][i] = batch.samples[i].xyz[k];
+    }
+    map.apply(xyz[0].data(), xyz[1].data(), xyz[2].data(), n);
+    for (size_t i = 0; i < n; i++) {
+      for (int k = 0; k < 3; k++) batch.samples[i].xyz[k] = xyz[k][i];
+    }
+  }
+
+private:
+  const ErrorMap& map;
+  std::vector<double> xyz[3];
+};
+
+class Store {
+public:
+  Store(BufferedWriter& out, int axes) : out(out), axes(axes) {}
+
+  void operator()(PipelineBatch& batch) {
+    size_t lineBytes = FIELD_BYTES * (4 + static_cast<size_t>(axes)) + 1;
+    for (const PipelineSample& s : batch.samples) {
+      char* p = out.reserve(lineBytes);
+      p = std::to_chars(p, p + FIELD_BYTES, s.hostNs).ptr;
+      for (int k = 0; k < 3; k++) p = appendFixed(p, s.xyz[k], 3);
+      for (int a = 0; a < axes; a++) p = appendFixed(p, s.angles[a], 2);
+      *p++ = '\n';
+      out.commit(p);
+    }
+  }
+
+private:
+  static const size_t FIELD_BYTES = 48;
+
+  static char* appendFixed(char* p, double value, int precision) {
+    *p++ = ',';
+    return std::to_chars(p, p + FIELD_BYTES - 1, value, std::chars_format::fixed, precision).ptr;
+  }
+
+  BufferedWriter& out;
+  int axes;
+};
+
+class Fitter {
+public:
+  Fitter(const std::string& type, size_t window, size_t every)
+      : type(type), window(window), every(every) {
+    for (auto& v : xyz) v.resize(window);
+  }
+
+  void operator()(PipelineBatch& batch) {
+    for (const PipelineSample& s : batch.samples) {
+      for (int k = 0; k < 3; k++) xyz[k][next] = s.xyz[k];
+      next = (next + 1) % window;
+      if (filled < window) filled++;
+      if (++sinceFit >= every && filled >= 3) {
+        sinceFit = 0;
+        fit(s.hostNs);
+      }
+    }
+  }
+
+private:
+  // The window is a ring, but a fit does not care about point order
+  void fit(int64_t hostNs) {
+    const double* x = xyz[0].data();
+    const double* y = xyz[1].data();
+    const double* z = xyz[2].data();
+    if (type == "plane") {
+      PlaneFit f;
+      if (Geometry_FitPlane(x, y, z, filled, f)) {
+        fprintf(stderr, "INFO,Fit %lld plane: normal (%.6f, %.6f, %.6f), d %.4f, residual %.4f mm\n",
+                static_cast<long long>(hostNs), f.normal[0], f.normal[1], f.normal[2], f.d,
+                f.residual);
+      }
+    } else if (type == "line") {
+      LineFit f;
+      if (Geometry_FitLine(x, y, z, filled, f)) {
+        fprintf(stderr,
+                "INFO,Fit %lld line: point (%.4f, %.4f, %.4f), direction (%.6f, %.6f, %.6f), "
+                "residual %.4f mm\n",
+                static_cast<long long>(hostNs), f.point[0], f.point[1], f.point[2],
+                f.direction[0], f.direction[1], f.direction[2], f.residual);
+      }
+    } else {
+      CircleFit f;
+      if (Geometry_FitCircle(x, y, z, filled, f)) {
+        fprintf(stderr,
+                "INFO,Fit %lld circle: center (%.4f, %.4f, %.4f), radius %.4f, residual %.4f mm\n",
+                static_cast<long long>(hostNs), f.center[0], f.center[1], f.center[2], f.radius,
+                f.residual);
+      }
+    }
+  }
+
+  std::string type;
+  size_t window;
+  size_t every;
+  std::vector<double> xyz[3];
+  size_t next = 0;
+  size_t filled = 0;
+  size_t sinceFit = 0;
+};
+
+// ============================================================================
+// METRICS
+// ============================================================================
+// One INFO line per stage over a window (periodic, or the whole run at exit)
+static void printMetrics(const std::vector<std::unique_ptr<PipelineStage>>& stages,
+                         const SourceStage& source, std::vector<StageCounters>& previous,
+                         uint64_t& previousBytes, double seconds, double cpuSeconds,
+                         bool wholeRun) {
+  double windowNs = seconds * 1e9;
+  for (size_t i = 0; i < stages.size(); i++) {
+    const PipelineStage& stage = *stages[i];
+    StageCounters now = stage.counters();
+    StageCounters& was = previous[i];
+
+    char rate[64];
+    if (&stage == &source) {
+      uint64_t bytes = source.bytesRead();
+      snprintf(rate, sizeof(rate), "%.1f kB/s", (bytes - previousBytes) / seconds / 1e3);
+      previousBytes = bytes;
+    } else {
+      snprintf(rate, sizeof(rate), "%.1f samples/s", (now.samples - was.samples) / seconds);
+    }
+
+    char queue[160] = "";
+    PipelineLink* in = stage.inputLink();
+    if (in != nullptr) {
+      size_t most = wholeRun ? in->maxDepth.load(std::memory_order_relaxed)
+                             : in->windowMaxDepth.exchange(0, std::memory_order_relaxed);
+      snprintf(queue, sizeof(queue), ", queue %zu/%zu max %zu", in->queue.size(),
+               in->queue.capacity(), most);
+    }
+
+    fprintf(stderr,
+            "INFO,Stage %s: %s, %.1f batches/s, busy %.1f%%, starved %.1f%%, "
+            "blocked %.1f%% (%llu stalls)%s\n",
+            stage.name().c_str(), rate, (now.batches - was.batches) / seconds,
+            100.0 * (now.busyNs - was.busyNs) / windowNs,
+            100.0 * (now.starvedNs - was.starvedNs) / windowNs,
+            100.0 * (now.blockedNs - was.blockedNs) / windowNs,
+            static_cast<unsigned long long>(now.stalls - was.stalls), queue);
+    was = now;
+  }
+
+  // Drops are totals since the start: any at all is worth seeing
+  for (const auto& stage : stages) {
+    const PipelineLink* in = stage->inputLink();
+    if (in != nullptr && in->droppedBatches.load(std::memory_order_relaxed) > 0) {
+      fprintf(stderr, "INFO,Queue %s: %llu batches dropped (%llu samples, %.1f kB of input)\n",
+              in->name.c_str(),
+              static_cast<unsigned long long>(in->droppedBatches.load(std::memory_order_relaxed)),
+              static_cast<unsigned long long>(in->droppedSamples.load(std::memory_order_relaxed)),
+              in->droppedBytes.load(std::memory_order_relaxed) / 1e3);
+    }
+  }
+  fprintf(stderr, "INFO,CPU %.1f%%\n", 100.0 * cpuSeconds / seconds);
+}
+
+int main(int argc, char** argv) {
+  int baud = 115200;
+  bool waitForBanner = true;
+  double runSeconds = 0;
+  bool kinematics = false;
+  ArmModel model;
+  std::string linkText;
+  double origin[3] = {0, 0, 0};
+  int smooth = 1;
+  double maxJump = 0;
+  const char* mapPath = nullptr;
+  const char* outputPath = "-";
+  std::string fitType;
+  long fitWindow = 2000;
+  long fitEvery = 1000;
+  long batchSamples = 256;
+  long queueBatches = 256;
+  std::vector<int> cpus;
+  double metricsSeconds = 5;
+  const char* inputPath = nullptr;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--baud") == 0 && hasValue) {
+      baud = atoi(argv[++i]);
+    } else if (strcmp(arg, "--no-wait") == 0) {
+      waitForBanner = false;
+    } else if (strcmp(arg, "--seconds") == 0 && hasValue) {
+      runSeconds = atof(argv[++i]);
+    } else if (strcmp(arg, "--kinematics") == 0) {
+      kinematics = true;
+    } else if (strcmp(arg, "--joints") == 0 && hasValue) {
+      if (!ArmModel_ParseJoints(argv[++i], model)) {
+        fprintf(stderr, "ERROR,Joints must be 1-%d of yaw, pitch, roll\n", UNCERTAINTY_MAX_AXES);
+        return 1;
+      }
+    } else if (strcmp(arg, "--links") == 0 && hasValue) {
+      linkText = argv[++i];
+    } else if (strcmp(arg, "--tool") == 0 && hasValue) {
+      if (!ArmModel_ParseNumbers(argv[++i], model.toolOffset, 3)) {
+        fprintf(stderr, "ERROR,Tool offset must be three numbers\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "--origin") == 0 && hasValue) {
+      if (!ArmModel_ParseNumbers(argv[++i], origin, 3)) {
+        fprintf(stderr, "ERROR,Origin must be three numbers\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "--smooth") == 0 && hasValue) {
+      smooth = atoi(argv[++i]);
+    } else if (strcmp(arg, "--max-jump") == 0 && hasValue) {
+      maxJump = atof(argv[++i]);
+    } else if (strcmp(arg, "--compensate") == 0 && hasValue) {
+      mapPath = argv[++i];
+    } else if (strcmp(arg, "--output") == 0 && hasValue) {
+      outputPath = argv[++i];
+    } else if (strcmp(arg, "--fit") == 0 && hasValue) {
+      fitType = argv[++i];
+      if (fitType != "plane" && fitType != "line" && fitType != "circle") {
+        fprintf(stderr, "ERROR,Unknown fit: %s\n", fitType.c_str());
+        return 1;
+      }
+    } else if (strcmp(arg, "--fit-window") == 0 && hasValue) {
+      fitWindow = atol(argv[++i]);
+    } else if (strcmp(arg, "--fit-every") == 0 && hasValue) {
+      fitEvery = atol(argv[++i]);
+    } else if (strcmp(arg, "--batch") == 0 && hasValue) {
+      batchSamples = atol(argv[++i]);
+    } else if (strcmp(arg, "--queue") == 0 && hasValue) {
+      queueBatches = atol(argv[++i]);
+    } else if (strcmp(arg, "--pin") == 0 && hasValue) {
+      if (!Pipeline_ParseCpuList(argv[++i], cpus)) {
+        fprintf(stderr, "ERROR,CPU list must be like 0-3 or 2,3\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "--metrics-s") == 0 && hasValue) {
+      metricsSeconds = atof(argv[++i]);
+    } else if (arg[0] == '-' && arg[1] != '\0') {
+      printUsage();
+      return 1;
+    } else if (inputPath == nullptr) {
+      inputPath = arg;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (inputPath == nullptr || runSeconds < 0 || smooth < 1 || maxJump < 0 || fitWindow < 3 ||
+      fitEvery < 1 || batchSamples < 1 || queueBatches < 2 || metricsSeconds < 0) {
+    printUsage();
+    return 1;
+  }
+  // Links after joints: their count follows --joints
+  if (!linkText.empty() && !ArmModel_ParseNumbers(linkText, model.linkLengths, model.axes)) {
+    fprintf(stderr, "ERROR,Links must be %d numbers (one per joint)\n", model.axes);
+    return 1;
+  }
+
+  ErrorMap map;
+  if (mapPath != nullptr && !map.load(mapPath)) {
+    fprintf(stderr, "ERROR,%s\n", map.error().c_str());
+    return 1;
+  }
+
+  // --------------------------------------------------------------------------
+  // Input: a serial port is started and streams until stopped; a pipe is
+  // live too; a regular file is read to the end without dropping anything
+  // --------------------------------------------------------------------------
+  SerialPort port;
+  int fd = STDIN_FILENO;
+  bool live;
+  struct stat info;
+  if (strcmp(inputPath, "-") != 0 && stat(inputPath, &info) == 0 && S_ISCHR(info.st_mode)) {
+    if (!port.open(inputPath, baud)) {
+      fprintf(stderr, "ERROR,%s\n", port.error().c_str());
+      return 1;
+    }
+    std::string line;
+    int64_t receivedNs;
+    if (waitForBanner) {
+      while (port.readLine(line, receivedNs, 3000)) {
+        if (line == "Ready for commands") break;
+      }
+    }
+    if (!port.writeLine("START")) {
+      fprintf(stderr, "ERROR,%s\n", port.error().c_str());
+      return 1;
+    }
+    fd = port.descriptor();
+    live = true;
+  } else {
+    if (strcmp(inputPath, "-") != 0) {
+      fd = open(inputPath, O_RDONLY | O_CLOEXEC);
+      if (fd < 0) {
+        fprintf(stderr, "ERROR,Cannot open %s: %s\n", inputPath, strerror(errno));
+        return 1;
+      }
+    }
+    live = fstat(fd, &info) == 0 && !S_ISREG(info.st_mode);
+  }
+
+  BufferedWriter out;
+  if (!out.open(outputPath)) {
+    fprintf(stderr, "ERROR,%s\n", out.error().c_str());
+    return 1;
+  }
+
+  // --------------------------------------------------------------------------
+  // Stages and links
+  // --------------------------------------------------------------------------
+  UncertaintyEngine engine(model, UncertaintyInputs());
+  Filter filter(smooth, maxJump);
+  Compensator compensator(map);
+  Store store(out, model.axes);
+  Fitter fitter(fitType, static_cast<size_t>(fitWindow), static_cast<size_t>(fitEvery));
+
+  std::vector<std::unique_ptr<PipelineStage>> stages;
+  std::vector<std::unique_ptr<PipelineLink>> links;
+  auto connect = [&](PipelineStage* from, PipelineStage* to, LinkPolicy policy) {
+    links.emplace_back(new PipelineLink(from->name() + "->" + to->name(),
+                                        static_cast<size_t>(queueBatches), policy));
+    from->addOutput(links.back().get());
+    to->setInput(links.back().get());
+  };
+  auto append = [&](PipelineStage* stage) {
+    connect(stages.back().get(), stage, LINK_BLOCK);
+    stages.emplace_back(stage);
+  };
+
+  SourceStage* source = new SourceStage("source", fd);
+  stages.emplace_back(source);
+  DecodeStage* decode = new DecodeStage("decode", model.axes, static_cast<size_t>(batchSamples));
+  connect(source, decode, live ? LINK_DROP : LINK_BLOCK);
+  stages.emplace_back(decode);
+
+  if (kinematics) {
+    append(new FunctionStage("kinematics", [&engine, &origin](PipelineBatch& batch) {
+      for (PipelineSample& s : batch.samples) {
+        engine.position(s.angles, s.xyz);
+        for (int k = 0; k < 3; k++) s.xyz[k] += origin[k];
+      }
+    }));
+  }
+  if (smooth > 1 || maxJump > 0) {
+    append(new FunctionStage("filter", [&filter](PipelineBatch& batch) { filter(batch); }));
+  }
+  if (mapPath != nullptr) {
+    append(new FunctionStage("compensate",
+                             [&compensator](PipelineBatch& batch) { compensator(batch); }));
+  }
+
+  // Sinks: both read the same batches
+  PipelineStage* last = stages.back().get();
+  PipelineStage* storeStage =
+      new FunctionStage("store", [&store](PipelineBatch& batch) { store(batch); });
+  connect(last, storeStage, LINK_BLOCK);
+  stages.emplace_back(storeStage);
+  if (!fitType.empty()) {
+    PipelineStage* fitStage =
+        new FunctionStage("fit", [&fitter](PipelineBatch& batch) { fitter(batch); });
+    connect(last, fitStage, LINK_DROP);
+    stages.emplace_back(fitStage);
+  }
+
+  signal(SIGINT, onStopSignal);
+  signal(SIGTERM, onStopSignal);
+
+  // Consumers first, so nothing is dropped while the rest start
+  for (size_t i = stages.size(); i-- > 0;) {
+    int cpu = i < cpus.size() ? cpus[i] : -1;
+    if (!stages[i]->start(cpu)) {
+      fprintf(stderr, "ERROR,Cannot pin stage %s to CPU %d\n", stages[i]->name().c_str(), cpu);
+    }
+  }
+  fprintf(stderr, "INFO,Pipeline: %zu stages, %s input, batch %ld, queue %ld\n", stages.size(),
+          live ? "live" : "file", batchSamples, queueBatches);
+
+  // --------------------------------------------------------------------------
+  // Supervise: stop on signal or timeout, report metrics
+  // --------------------------------------------------------------------------
+  std::vector<StageCounters> window(stages.size()), total(stages.size());
+  uint64_t windowBytes = 0, totalBytes = 0;
+  int64_t startNs = HostClock_NowNs();
+  int64_t endNs = runSeconds > 0 ? startNs + static_cast<int64_t>(runSeconds * 1e9) : INT64_MAX;
+  int64_t metricsPeriodNs = static_cast<int64_t>(metricsSeconds * 1e9);
+  int64_t nextMetricsNs = metricsPeriodNs > 0 ? startNs + metricsPeriodNs : INT64_MAX;
+  int64_t windowStartNs = startNs;
+  double startCpu = CpuSeconds();
+  double windowCpu = startCpu;
+  bool stopping = false;
+
+  auto running = [&] {
+    for (auto& stage : stages) {
+      if (!stage->finished()) return true;
+    }
+    return false;
+  };
+  while (running()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    int64_t now = HostClock_NowNs();
+    if (!stopping && (stopRequested || now >= endNs)) {
+      source->stop();
+      stopping = true;
+    }
+    if (now >= nextMetricsNs) {
+      double cpu = CpuSeconds();
+      printMetrics(stages, *source, window, windowBytes, (now - windowStartNs) / 1e9,
+                   cpu - windowCpu, false);
+      windowStartNs = now;
+      windowCpu = cpu;
+      nextMetricsNs = now + metricsPeriodNs;
+    }
+  }
+  for (auto& stage : stages) stage->join();
+
+  if (port.isOpen()) port.writeLine("STOP");
+  bool written = out.close();
+  if (!written) fprintf(stderr, "ERROR,%s\n", out.error().c_str());
+  if (!source->error().empty()) fprintf(stderr, "ERROR,%s\n", source->error().c_str());
+
+  int64_t now = HostClock_NowNs();
+  fprintf(stderr, "INFO,Run summary:\n");
+  printMetrics(stages, *source, total, totalBytes, std::max(1e-3, (now - startNs) / 1e9),
+               CpuSeconds() - startCpu, true);
+  fprintf(stderr, "INFO,%llu samples stored, %llu lines skipped",
+          static_cast<unsigned long long>(storeStage->counters().samples),
+          static_cast<unsigned long long>(decode->skippedLines()));
+  if (maxJump > 0) {
+    fprintf(stderr, ", %llu jumps rejected", static_cast<unsigned long long>(filter.rejected()));
+  }
+  if (mapPath != nullptr) {
+    fprintf(stderr, ", %llu outside the error map", static_cast<unsigned long long>(map.outside()));
+  }
+  fprintf(stderr, "\n");
+  if (fd != STDIN_FILENO && !port.isOpen()) close(fd);
+  return written && source->error().empty() ? 0 : 2;
+}
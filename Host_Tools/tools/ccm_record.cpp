@@ -0,0 +1,224 @@
+/*
+ * ============================================================================
+ * CCM_RECORD - Lossless recording over the sequenced stream
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_record [options] <serial port>
+ *
+ * Options:
+ *   --baud N          Serial baud rate (default: 115200)
+ *   --seconds S       Record for S seconds (default: 10)
+ *   --retry-ms N      Wait before asking for a frame again (default: 300)
+ *   --attempts N      RESENDs per frame before giving up (default: 3)
+ *   --no-wait         Do not wait for the startup banner (port already open)
+ *
+ * Switches the device to sequenced frames (SETSEQ ON), records, and writes
+ * every frame to stdout in sequence order:
+ *
+ *   seq,timestamp,x,y,z,theta1,...,thetaN[,omega1,...,omegaN]
+ *
+ * Gaps (dropped or corrupted lines) are filled with RESEND while recording.
+ * After STOP, GETSEQ tells where the stream ended so missing tail frames
+ * are requested too. Frames that could not be recovered are left out and
+ * counted. Link statistics are reported on stderr as INFO lines; the
+ * device is switched back to plain POS lines (SETSEQ OFF) at the end.
+ *
+ * Exit status: 0 = complete recording, 1 = error, 2 = frames were lost.
+ *
+ * ============================================================================
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "../src/frame_tracker.h"
+#include "../src/serial_port.h"
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_record [options] <serial port>\n"
+          "  --baud N          Serial baud rate (default: 115200)\n"
+          "  --seconds S       Record for S seconds (default: 10)\n"
+          "  --retry-ms N      Wait before asking for a frame again (default: 300)\n"
+          "  --attempts N      RESENDs per frame before giving up (default: 3)\n"
+          "  --no-wait         Do not wait for the startup banner\n");
+}
+
+static void printStats(const FrameTrackerStats& st, unsigned long overruns) {
+  fprintf(stderr,
+          "INFO,Frames: %llu delivered, %llu missed, %llu recovered, %llu lost "
+          "(%lu overwritten on the device)\n",
+          static_cast<unsigned long long>(st.delivered), static_cast<unsigned long long>(st.missed),
+          static_cast<unsigned long long>(st.recovered), static_cast<unsigned long long>(st.lost),
+          overruns);
+  fprintf(stderr, "INFO,Link: %llu lines received, %llu corrupted, %llu duplicates, %llu RESENDs\n",
+          static_cast<unsigned long long>(st.received + st.corrupted),
+          static_cast<unsigned long long>(st.corrupted),
+          static_cast<unsigned long long>(st.duplicates),
+          static_cast<unsigned long long>(st.resendRequests));
+}
+
+// ============================================================================
+// SESSION STATE
+// ============================================================================
+struct RecordSession {
+  SerialPort port;
+  FrameTracker tracker;
+  bool haveEnd = false;           // SEQ reply received
+  unsigned long overruns = 0;
+
+  RecordSession(int64_t retryNs, int attempts) : tracker(retryNs, attempts) {}
+};
+
+// Handle one received line
+static void handleLine(RecordSession& s, const std::string& line) {
+  if (s.tracker.handleLine(line)) {
+    SequencedFrame frame;
+    while (s.tracker.popFrame(frame)) {
+      printf("%lu,%s\n", static_cast<unsigned long>(frame.seq), frame.fields.c_str());
+    }
+    return;
+  }
+
+  if (line.compare(0, 4, "SEQ,") == 0) {
+    // SEQ,next,oldest,overruns
+    char* end;
+    unsigned long next = strtoul(line.c_str() + 4, &end, 10);
+    if (*end != ',') return;
+    strtoul(end + 1, &end, 10);
+    if (*end != ',') return;
+    s.overruns = strtoul(end + 1, nullptr, 10);
+    s.tracker.setEnd(static_cast<uint32_t>(next));
+    s.haveEnd = true;
+    return;
+  }
+
+  if (line.compare(0, 6, "ERROR,") == 0) {
+    fprintf(stderr, "%s\n", line.c_str());
+  }
+}
+
+// Ask for whatever is missing (new gaps and timed-out requests)
+static void requestMissing(RecordSession& s) {
+  for (const std::string& request : s.tracker.resendRequests(HostClock_NowNs())) {
+    s.port.writeLine(request);
+  }
+}
+
+// Send a command and wait for its ACK (other lines are handled normally)
+static bool command(RecordSession& s, const char* text, const char* ack) {
+  if (!s.port.writeLine(text)) return false;
+  std::string line;
+  int64_t receivedNs;
+  std::string expected = std::string("ACK,") + ack;
+  while (s.port.readLine(line, receivedNs, 2000)) {
+    if (line == expected) return true;
+    handleLine(s, line);
+  }
+  return false;
+}
+
+int main(int argc, char** argv) {
+  int baud = 115200;
+  double seconds = 10;
+  int retryMs = 300;
+  int attempts = 3;
+  bool waitForBanner = true;
+  const char* portPath = nullptr;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--baud") == 0 && hasValue) {
+      baud = atoi(argv[++i]);
+    } else if (strcmp(arg, "--seconds") == 0 && hasValue) {
+      seconds = atof(argv[++i]);
+    } else if (strcmp(arg, "--retry-ms") == 0 && hasValue) {
+      retryMs = atoi(argv[++i]);
+    } else if (strcmp(arg, "--attempts") == 0 && hasValue) {
+      attempts = atoi(argv[++i]);
+    } else if (strcmp(arg, "--no-wait") == 0) {
+      waitForBanner = false;
+    } else if (arg[0] == '-' && arg[1] != '\0') {
+      printUsage();
+      return 1;
+    } else if (portPath == nullptr) {
+      portPath = arg;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (portPath == nullptr || seconds <= 0 || retryMs < 1 || attempts < 1) {
+    printUsage();
+    return 1;
+  }
+
+  RecordSession s(retryMs * 1000000LL, attempts);
+  if (!s.port.open(portPath, baud)) {
+    fprintf(stderr, "ERROR,%s\n", s.port.error().c_str());
+    return 1;
+  }
+
+  std::string line;
+  int64_t receivedNs;
+
+  // --------------------------------------------------------------------------
+  // Opening the port resets the Arduino: wait for it to come up
+  // --------------------------------------------------------------------------
+  if (waitForBanner) {
+    while (s.port.readLine(line, receivedNs, 3000)) {
+      if (line == "Ready for commands") break;
+    }
+  }
+
+  if (!command(s, "SETSEQ ON", "SEQUENCED_STREAM_ON")) {
+    fprintf(stderr, "ERROR,No response to SETSEQ ON (firmware too old?)\n");
+    return 1;
+  }
+  if (!command(s, "START", "RECORDING_STARTED")) {
+    fprintf(stderr, "ERROR,Could not start recording\n");
+    return 1;
+  }
+
+  // --------------------------------------------------------------------------
+  // Record, filling gaps as they are found
+  // --------------------------------------------------------------------------
+  int64_t endNs = HostClock_NowNs() + static_cast<int64_t>(seconds * 1e9);
+  while (HostClock_NowNs() < endNs) {
+    if (s.port.readLine(line, receivedNs, 20)) handleLine(s, line);
+    else if (!s.port.error().empty()) break;
+    requestMissing(s);
+  }
+
+  // --------------------------------------------------------------------------
+  // Stop, find where the stream ended and collect the missing tail
+  // --------------------------------------------------------------------------
+  command(s, "STOP", "RECORDING_STOPPED");
+  s.port.writeLine("GETSEQ");
+
+  // Every frame gets at most 'attempts' requests, so this is bounded
+  int64_t drainEndNs = HostClock_NowNs() + (attempts + 2) * retryMs * 1000000LL + 2000000000LL;
+  while (!(s.haveEnd && s.tracker.complete()) && HostClock_NowNs() < drainEndNs) {
+    if (s.port.readLine(line, receivedNs, 20)) handleLine(s, line);
+    else if (!s.port.error().empty()) break;
+    if (s.haveEnd) requestMissing(s);
+  }
+
+  command(s, "SETSEQ OFF", "SEQUENCED_STREAM_OFF");
+  fflush(stdout);
+
+  if (!s.haveEnd) {
+    fprintf(stderr, "ERROR,No GETSEQ reply: frames at the end may be missing\n");
+  }
+  printStats(s.tracker.stats(), s.overruns);
+  return s.tracker.stats().lost > 0 ? 2 : 0;
+}
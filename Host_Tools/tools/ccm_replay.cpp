@@ -0,0 +1,252 @@
+/*
+ * ============================================================================
+ * CCM_REPLAY - Play a capture back on a pseudo-terminal or into a file
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_replay [options] <capture file>
+ *
+ * Options:
+ *   --speed X       1 = as recorded (default), 10 = ten times faster,
+ *                   0 = as fast as the reader takes it
+ *   --output PATH   Write the bytes to PATH ("-" = stdout) instead of a
+ *                   pseudo-terminal
+ *   --link PATH     Also make PATH a symlink to the pseudo-terminal
+ *   --repeat N      Play the capture N times (default: 1, 0 = until SIGINT)
+ *   --no-wait       Start at once instead of when a program opens the
+ *                   pseudo-terminal
+ *
+ * Only the arm's side of the capture is played back (capture_file.h), with
+ * the original spacing between reads divided by --speed. The desktop app,
+ * ccm_sync, ccm_record or any other tool can open the pseudo-terminal (its
+ * path is printed on stdout) as if it were the arm. Commands they send are
+ * read and ignored: the replay is the recording, not a live arm.
+ *
+ * Playback starts when a program opens the pseudo-terminal and stops when
+ * it closes it. A summary on stderr gives the achieved rate and how far
+ * behind the recorded timing playback fell (the reader could not keep up).
+ *
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/capture_file.h"
+#include "../src/serial_port.h"
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onStopSignal(int) {
+  stopRequested = 1;
+}
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_replay [options] <capture file>\n"
+          "  --speed X       1 = as recorded (default), 0 = as fast as possible\n"
+          "  --output PATH   Write to PATH (\"-\" = stdout) instead of a pseudo-terminal\n"
+          "  --link PATH     Symlink PATH to the pseudo-terminal\n"
+          "  --repeat N      Play N times (default: 1, 0 = until signal)\n"
+          "  --no-wait       Start at once, not when the pseudo-terminal is opened\n");
+}
+
+static void SleepUntilNs(int64_t ns) {
+  // HostClock_NowNs() is steady_clock, which is CLOCK_MONOTONIC on Linux
+  timespec wake;
+  wake.tv_sec = static_cast<time_t>(ns / 1000000000LL);
+  wake.tv_nsec = static_cast<long>(ns % 1000000000LL);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr) == EINTR) {
+    if (stopRequested) return;
+  }
+}
+
+// Pseudo-terminal master state: POLLHUP while no program has the slave open
+static bool PeerOpen(int master) {
+  pollfd pfd = {master, POLLIN, 0};
+  return poll(&pfd, 1, 0) >= 0 && (pfd.revents & POLLHUP) == 0;
+}
+
+// Write everything, discarding whatever the reader sends back. Returns
+// false if the reader went away.
+static bool WriteAll(int fd, bool pty, const char* data, size_t length, uint64_t& ignored) {
+  size_t done = 0;
+  while (done < length) {
+    pollfd pfd = {fd, static_cast<short>(pty ? POLLIN | POLLOUT : POLLOUT), 0};
+    if (poll(&pfd, 1, 500) < 0) {
+      if (errno == EINTR && !stopRequested) continue;
+      return false;
+    }
+    if (pfd.revents & (POLLHUP | POLLERR)) return false;
+    if (pfd.revents & POLLIN) {
+      char sink[512];
+      ssize_t n = read(fd, sink, sizeof(sink));
+      if (n > 0) ignored += static_cast<uint64_t>(n);
+    }
+    if (pfd.revents & POLLOUT) {
+      ssize_t n = write(fd, data + done, length - done);
+      if (n < 0 && errno != EAGAIN && errno != EINTR) return false;
+      if (n > 0) done += static_cast<size_t>(n);
+    }
+    if (stopRequested) return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  double speed = 1.0;
+  const char* outputPath = nullptr;
+  const char* linkPath = nullptr;
+  long repeat = 1;
+  bool waitForOpen = true;
+  const char* capturePath = nullptr;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--speed") == 0 && hasValue) {
+      speed = atof(argv[++i]);
+    } else if (strcmp(arg, "--output") == 0 && hasValue) {
+      outputPath = argv[++i];
+    } else if (strcmp(arg, "--link") == 0 && hasValue) {
+      linkPath = argv[++i];
+    } else if (strcmp(arg, "--repeat") == 0 && hasValue) {
+      repeat = atol(argv[++i]);
+    } else if (strcmp(arg, "--no-wait") == 0) {
+      waitForOpen = false;
+    } else if (arg[0] == '-' || capturePath != nullptr) {
+      printUsage();
+      return 1;
+    } else {
+      capturePath = arg;
+    }
+  }
+
+  if (capturePath == nullptr || speed < 0 || repeat < 0) {
+    printUsage();
+    return 1;
+  }
+
+  CaptureReader capture;
+  if (!capture.open(capturePath)) {
+    fprintf(stderr, "ERROR,%s\n", capture.error().c_str());
+    return 1;
+  }
+
+  signal(SIGINT, onStopSignal);
+  signal(SIGTERM, onStopSignal);
+  signal(SIGPIPE, SIG_IGN);
+
+  // --------------------------------------------------------------------------
+  // Output: a pseudo-terminal, or a file / pipe
+  // --------------------------------------------------------------------------
+  int out = -1;
+  bool pty = outputPath == nullptr;
+  if (pty) {
+    int slave;
+    char path[128];
+    termios tty;
+    memset(&tty, 0, sizeof(tty));
+    cfmakeraw(&tty);
+    if (openpty(&out, &slave, path, &tty, nullptr) != 0) {
+      fprintf(stderr, "ERROR,Cannot open a pseudo-terminal: %s\n", strerror(errno));
+      return 1;
+    }
+    // Only the reader holds the slave open, so its close is seen as POLLHUP
+    close(slave);
+    fcntl(out, F_SETFL, fcntl(out, F_GETFL) | O_NONBLOCK);
+    if (linkPath != nullptr) {
+      unlink(linkPath);
+      if (symlink(path, linkPath) != 0) {
+        fprintf(stderr, "ERROR,Cannot create %s: %s\n", linkPath, strerror(errno));
+        return 1;
+      }
+    }
+    printf("%s\n", path);
+    fflush(stdout);
+
+    while (waitForOpen && !stopRequested && !PeerOpen(out)) usleep(10000);
+  } else if (strcmp(outputPath, "-") == 0) {
+    out = STDOUT_FILENO;
+  } else {
+    out = open(outputPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+      fprintf(stderr, "ERROR,Cannot create %s: %s\n", outputPath, strerror(errno));
+      return 1;
+    }
+  }
+
+  // --------------------------------------------------------------------------
+  // Playback
+  // --------------------------------------------------------------------------
+  uint64_t bytesOut = 0, recordsOut = 0, ignored = 0;
+  int64_t maxBehindNs = 0;
+  int64_t startNs = HostClock_NowNs();
+  bool readerGone = false;
+
+  for (long pass = 0; (repeat == 0 || pass < repeat) && !stopRequested && !readerGone; pass++) {
+    if (pass > 0 && !capture.rewind()) break;
+    int64_t passStartNs = HostClock_NowNs();
+
+    CaptureRecord record;
+    while (!stopRequested && capture.next(record)) {
+      if (record.direction != CAPTURE_FROM_ARM) continue;
+
+      if (speed > 0) {
+        int64_t dueNs = passStartNs + static_cast<int64_t>(record.timeUs * 1000.0 / speed);
+        int64_t now = HostClock_NowNs();
+        if (now < dueNs) SleepUntilNs(dueNs);
+        else maxBehindNs = std::max(maxBehindNs, now - dueNs);
+      }
+
+      if (!WriteAll(out, pty, record.data, record.length, ignored)) {
+        readerGone = true;
+        break;
+      }
+      bytesOut += record.length;
+      recordsOut++;
+    }
+    if (!capture.error().empty()) {
+      fprintf(stderr, "ERROR,%s\n", capture.error().c_str());
+      break;
+    }
+  }
+
+  // Let a pseudo-terminal reader drain what is still buffered
+  if (pty && !readerGone && !stopRequested) {
+    for (int i = 0; i < 50 && PeerOpen(out); i++) usleep(10000);
+  }
+
+  // --------------------------------------------------------------------------
+  // Summary
+  // --------------------------------------------------------------------------
+  double seconds = std::max(1e-3, (HostClock_NowNs() - startNs) / 1e9);
+  if (capture.truncated()) fprintf(stderr, "INFO,Capture ends in a partial record (cut short)\n");
+  if (readerGone) fprintf(stderr, "INFO,Reader closed the output\n");
+  fprintf(stderr,
+          "INFO,Replayed %llu records, %llu bytes in %.2f s (%.1f KB/s), "
+          "at most %.1f ms behind the recorded timing, %llu bytes from the reader ignored\n",
+          static_cast<unsigned long long>(recordsOut), static_cast<unsigned long long>(bytesOut),
+          seconds, bytesOut / seconds / 1024, maxBehindNs / 1e6,
+          static_cast<unsigned long long>(ignored));
+
+  if (pty && linkPath != nullptr) unlink(linkPath);
+  if (out != STDOUT_FILENO) close(out);
+  return 0;
+}
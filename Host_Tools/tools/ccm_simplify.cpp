@@ -0,0 +1,252 @@
+/*
+ * ============================================================================
+ * CCM_SIMPLIFY - Streaming path simplification of recordings
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_simplify [options] <input|->
+ *
+ * Options:
+ *   --tolerance MM   Largest distance of a dropped point from the kept path
+ *                    (default: 0.1)
+ *   --window N       Look-ahead: most points held undecided (default: 1024)
+ *   --skip N         Stream lines: fields before x,y,z (default: 1)
+ *   --raw FILE       Also write the input, unchanged, to FILE
+ *
+ * Two kinds of input are recognized:
+ *
+ * - Session CSV saved by the app (Point,Type,X,Y,Z,GeometryID,Timestamp):
+ *   LIVE points are simplified, every other type (BOUNDARY, HOLE_CENTER,
+ *   ...) is a captured point and always kept. The geometry section is
+ *   passed through.
+ * - Stream lines as written by ccm_sync (host_ns,x,y,z,...), ccm_record
+ *   or ccm_aggregate (--skip 2), or raw POS lines.
+ *
+ * Kept lines are written to stdout exactly as they were read. A line that
+ * is not a sample (a header, a log line, the geometry section) ends the
+ * current path: what is held is written first, then the line, so nothing
+ * is reordered and no segment bridges a gap in the recording.
+ *
+ * Input is read as it arrives, so the tool can sit in a live pipe; a kept
+ * point is written at most --window points after it was read:
+ *
+ *   ccm_sync --stream 600 /dev/ttyACM0 | ccm_simplify --raw raw.csv - > run.csv
+ *
+ * Memory is bounded by the window (path_simplifier.h) whatever the length
+ * of the recording. A summary goes to stderr.
+ *
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../src/buffered_writer.h"
+#include "../src/path_simplifier.h"
+
+static const char* SESSION_HEADER = "Point,Type,X,Y,Z";
+
+// Small blocks so the raw copy reaches the disk soon during a live stream
+static const size_t RAW_BLOCK_BYTES = 256 * 1024;
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_simplify [options] <input|->\n"
+          "  --tolerance MM   Largest distance of a dropped point (default: 0.1)\n"
+          "  --window N       Most points held undecided (default: 1024)\n"
+          "  --skip N         Stream lines: fields before x,y,z (default: 1)\n"
+          "  --raw FILE       Also write the input, unchanged, to FILE\n");
+}
+
+// x,y,z after 'skip' fields; for session lines 'type' is the field before
+static bool ParsePoint(const char* p, int skip, double xyz[3], const char** type) {
+  if (strncmp(p, "POS,", 4) == 0) p += 4;
+  const char* previous = p;
+  for (int i = 0; i < skip; i++) {
+    previous = p;
+    p = strchr(p, ',');
+    if (p == nullptr) return false;
+    p++;
+  }
+  *type = previous;
+  for (int i = 0; i < 3; i++) {
+    if (i > 0) {
+      if (*p != ',') return false;
+      p++;
+    }
+    char* end;
+    xyz[i] = strtod(p, &end);
+    if (end == p) return false;
+    p = end;
+  }
+  return *p == ',' || *p == '\0' || *p == '\r';
+}
+
+int main(int argc, char** argv) {
+  double tolerance = 0.1;
+  long window = 1024;
+  int skip = 1;
+  const char* rawPath = nullptr;
+  const char* inputPath = nullptr;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--tolerance") == 0 && hasValue) {
+      tolerance = atof(argv[++i]);
+    } else if (strcmp(arg, "--window") == 0 && hasValue) {
+      window = atol(argv[++i]);
+    } else if (strcmp(arg, "--skip") == 0 && hasValue) {
+      skip = atoi(argv[++i]);
+    } else if (strcmp(arg, "--raw") == 0 && hasValue) {
+      rawPath = argv[++i];
+    } else if (arg[0] == '-' && arg[1] != '\0') {
+      printUsage();
+      return 1;
+    } else if (inputPath == nullptr) {
+      inputPath = arg;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (inputPath == nullptr || !(tolerance >= 0) || window < 3 || skip < 0) {
+    printUsage();
+    return 1;
+  }
+
+  int fd = STDIN_FILENO;
+  if (strcmp(inputPath, "-") != 0) {
+    fd = open(inputPath, O_RDONLY);
+    if (fd < 0) {
+      fprintf(stderr, "ERROR,Cannot open %s: %s\n", inputPath, strerror(errno));
+      return 1;
+    }
+  }
+
+  BufferedWriter raw(RAW_BLOCK_BYTES);
+  if (rawPath != nullptr && !raw.open(rawPath)) {
+    fprintf(stderr, "ERROR,%s\n", raw.error().c_str());
+    return 1;
+  }
+
+  // --------------------------------------------------------------------------
+  // Lines -> simplifier -> kept lines
+  // --------------------------------------------------------------------------
+  // Lines of undecided points, by id; an id is decided before the ring
+  // comes round to it again
+  PathSimplifier simplifier(tolerance, static_cast<size_t>(window));
+  std::vector<std::string> ring(static_cast<size_t>(window) + 1);
+  std::vector<uint64_t> kept;
+  uint64_t nextId = 0;
+
+  bool session = false;
+  bool firstLine = true;
+  uint64_t lines = 0;
+  std::string pending, output;
+  std::vector<char> chunk(1 << 20);
+  auto startTime = std::chrono::steady_clock::now();
+
+  auto writeKept = [&]() {
+    for (uint64_t id : kept) {
+      output += ring[id % ring.size()];
+      output += '\n';
+    }
+    kept.clear();
+  };
+
+  for (;;) {
+    ssize_t got = read(fd, chunk.data(), chunk.size());
+    if (got < 0 && errno == EINTR) continue;
+    if (got < 0) {
+      fprintf(stderr, "ERROR,Read failed: %s\n", strerror(errno));
+      return 1;
+    }
+    if (got > 0) {
+      pending.append(chunk.data(), static_cast<size_t>(got));
+      if (rawPath != nullptr) raw.write(chunk.data(), static_cast<size_t>(got));
+    } else if (!pending.empty() && pending.back() != '\n') {
+      pending += '\n';  // Last line without a line ending
+    }
+
+    output.clear();
+    size_t start = 0, newline;
+    while ((newline = pending.find('\n', start)) != std::string::npos) {
+      const char* line = pending.c_str() + start;
+      size_t length = newline - start;
+      start = newline + 1;
+      if (length > 0 && line[length - 1] == '\r') length--;
+      lines++;
+
+      if (firstLine) {
+        session = strncmp(line, SESSION_HEADER, strlen(SESSION_HEADER)) == 0;
+        if (session) skip = 2;
+        firstLine = false;
+      }
+
+      double xyz[3];
+      const char* type;
+      pending[start - 1] = '\0';  // Terminate the line for parsing
+      if (!ParsePoint(line, skip, xyz, &type)) {
+        // Not a sample: the path ends here
+        simplifier.finish(kept);
+        writeKept();
+        output.append(line, length);
+        output += '\n';
+        continue;
+      }
+
+      bool force = session && strncmp(type, "LIVE,", 5) != 0;
+      uint64_t id = nextId++;
+      ring[id % ring.size()].assign(line, length);
+      simplifier.push(xyz, id, force, kept);
+      writeKept();
+    }
+    pending.erase(0, start);
+
+    if (got == 0) {
+      simplifier.finish(kept);
+      writeKept();
+    }
+    if (!output.empty()) {
+      fwrite(output.data(), 1, output.size(), stdout);
+      fflush(stdout);
+    }
+    if (got == 0) break;
+  }
+  if (fd != STDIN_FILENO) close(fd);
+
+  bool ok = true;
+  if (rawPath != nullptr && !raw.close()) {
+    fprintf(stderr, "ERROR,%s\n", raw.error().c_str());
+    ok = false;
+  }
+
+  // --------------------------------------------------------------------------
+  // Summary
+  // --------------------------------------------------------------------------
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  const PathSimplifierStats& s = simplifier.stats();
+  fprintf(stderr,
+          "INFO,%llu points -> %llu kept (%.1f%%, %llu forced), %llu other lines, "
+          "%.3f s (%.2f Mpts/s)\n",
+          static_cast<unsigned long long>(s.points), static_cast<unsigned long long>(s.kept),
+          s.points > 0 ? 100.0 * s.kept / s.points : 0.0, static_cast<unsigned long long>(s.forced),
+          static_cast<unsigned long long>(lines - s.points), seconds,
+          seconds > 0 ? s.points / seconds / 1e6 : 0.0);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,273 @@
+/*
+ * ============================================================================
+ * CCM_SYNC - Clock synchronization and host-timestamped streaming
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_sync [options] <serial port>
+ *
+ * Options:
+ *   --baud N          Serial baud rate (default: 115200)
+ *   --probes N        SYNC exchanges before streaming (default: 16)
+ *   --interval-ms N   Time between SYNC exchanges (default: 250)
+ *   --stream S        Record for S seconds after syncing (default: 0 = sync only)
+ *   --no-wait         Do not wait for the startup banner (port already open)
+ *   --compensate MAP  Correct x,y,z with a volumetric error map (ccm_errormap)
+ *
+ * The device is switched to microsecond timestamps (SETTS US). While
+ * streaming, SYNC exchanges continue at --interval-ms so drift is tracked,
+ * and every POS line is written to stdout with its device timestamp
+ * replaced by host monotonic time:
+ *
+ *   host_ns,x,y,z,theta1,...,thetaN
+ *
+ * Sync metrics (offset, drift, residual error, round trip, one-way
+ * latency) are reported on stderr as INFO lines.
+ *
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "../src/clock_sync.h"
+#include "../src/error_map.h"
+#include "../src/serial_port.h"
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_sync [options] <serial port>\n"
+          "  --baud N          Serial baud rate (default: 115200)\n"
+          "  --probes N        SYNC exchanges before streaming (default: 16)\n"
+          "  --interval-ms N   Time between SYNC exchanges (default: 250)\n"
+          "  --stream S        Record for S seconds after syncing (default: 0)\n"
+          "  --no-wait         Do not wait for the startup banner\n"
+          "  --compensate MAP  Correct x,y,z with a volumetric error map\n");
+}
+
+static void printMetrics(const ClockSyncMetrics& m) {
+  fprintf(stderr,
+          "INFO,Sync: %llu exchanges (%zu used), offset %.1f us, drift %.2f ppm, "
+          "residual %.1f us rms, uncertainty +/-%.1f us, rtt min %.1f us last %.1f us\n",
+          static_cast<unsigned long long>(m.exchanges), m.exchangesUsed, m.offsetUs,
+          m.driftPpm, m.residualUs, m.uncertaintyUs, m.minRttUs, m.lastRttUs);
+  if (m.latencySamples > 0) {
+    fprintf(stderr, "INFO,Latency: %llu samples, min %.1f us, mean %.1f us, max %.1f us\n",
+            static_cast<unsigned long long>(m.latencySamples), m.latencyMinUs,
+            m.latencyMeanUs, m.latencyMaxUs);
+  }
+}
+
+// ============================================================================
+// SESSION STATE
+// ============================================================================
+struct SyncSession {
+  SerialPort port;
+  DeviceClock clock;
+  ErrorMap compensation;
+  unsigned long nextSeq = 1;
+  unsigned long pendingSeq = 0;   // Outstanding SYNC, 0 = none
+  int64_t pendingSentNs = 0;
+  uint64_t samples = 0;
+};
+
+static bool sendProbe(SyncSession& s) {
+  s.pendingSeq = s.nextSeq++;
+  s.pendingSentNs = HostClock_NowNs();
+  return s.port.writeLine("SYNC " + std::to_string(s.pendingSeq));
+}
+
+// Handle one received line. Returns true if it completed the pending SYNC.
+static bool handleLine(SyncSession& s, const std::string& line, int64_t receivedNs) {
+  if (line.compare(0, 5, "SYNC,") == 0) {
+    // SYNC,seq,rxMicros,txMicros
+    char* end;
+    unsigned long seq = strtoul(line.c_str() + 5, &end, 10);
+    if (*end != ',') return false;
+    uint32_t rxUs = static_cast<uint32_t>(strtoul(end + 1, &end, 10));
+    if (*end != ',') return false;
+    uint32_t txUs = static_cast<uint32_t>(strtoul(end + 1, &end, 10));
+
+    if (seq != s.pendingSeq) return false;  // Late reply to a timed-out probe
+    s.clock.addExchange(s.pendingSentNs, rxUs, txUs, receivedNs);
+    s.pendingSeq = 0;
+    return true;
+  }
+
+  if (line.compare(0, 4, "POS,") == 0 && s.clock.synchronized()) {
+    // POS,timestamp,x,y,z,... -> host_ns,x,y,z,...
+    char* rest;
+    uint32_t deviceUs = static_cast<uint32_t>(strtoul(line.c_str() + 4, &rest, 10));
+    if (*rest != ',') return false;
+    int64_t hostNs = s.clock.toHostNs(deviceUs);
+    s.clock.observeLatency(deviceUs, receivedNs);
+    if (s.compensation.empty()) {
+      printf("%lld%s\n", static_cast<long long>(hostNs), rest);
+    } else {
+      double p[3];
+      char* end = rest;
+      for (int i = 0; i < 3; i++) {
+        const char* start = end + 1;
+        p[i] = strtod(start, &end);
+        if (end == start || (*end != ',' && *end != '\0')) return false;
+      }
+      s.compensation.apply(p, p);
+      printf("%lld,%.3f,%.3f,%.3f%s\n", static_cast<long long>(hostNs), p[0], p[1], p[2], end);
+    }
+    s.samples++;
+    return false;
+  }
+
+  if (line.compare(0, 6, "ERROR,") == 0) {
+    fprintf(stderr, "%s\n", line.c_str());
+  }
+  return false;
+}
+
+// Send a command and wait for its ACK (other lines are handled normally)
+static bool command(SyncSession& s, const char* text, const char* ack) {
+  if (!s.port.writeLine(text)) return false;
+  std::string line;
+  int64_t receivedNs;
+  std::string expected = std::string("ACK,") + ack;
+  while (s.port.readLine(line, receivedNs, 2000)) {
+    if (line == expected) return true;
+    handleLine(s, line, receivedNs);
+  }
+  return false;
+}
+
+int main(int argc, char** argv) {
+  int baud = 115200;
+  int probes = 16;
+  int intervalMs = 250;
+  double streamSeconds = 0;
+  bool waitForBanner = true;
+  const char* portPath = nullptr;
+  const char* mapPath = nullptr;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--baud") == 0 && hasValue) {
+      baud = atoi(argv[++i]);
+    } else if (strcmp(arg, "--probes") == 0 && hasValue) {
+      probes = atoi(argv[++i]);
+    } else if (strcmp(arg, "--interval-ms") == 0 && hasValue) {
+      intervalMs = atoi(argv[++i]);
+    } else if (strcmp(arg, "--stream") == 0 && hasValue) {
+      streamSeconds = atof(argv[++i]);
+    } else if (strcmp(arg, "--no-wait") == 0) {
+      waitForBanner = false;
+    } else if (strcmp(arg, "--compensate") == 0 && hasValue) {
+      mapPath = argv[++i];
+    } else if (arg[0] == '-' && arg[1] != '\0') {
+      printUsage();
+      return 1;
+    } else if (portPath == nullptr) {
+      portPath = arg;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (portPath == nullptr || probes < 1 || intervalMs < 1) {
+    printUsage();
+    return 1;
+  }
+
+  SyncSession s;
+  if (mapPath != nullptr && !s.compensation.load(mapPath)) {
+    fprintf(stderr, "ERROR,%s\n", s.compensation.error().c_str());
+    return 1;
+  }
+  if (!s.port.open(portPath, baud)) {
+    fprintf(stderr, "ERROR,%s\n", s.port.error().c_str());
+    return 1;
+  }
+
+  std::string line;
+  int64_t receivedNs;
+
+  // --------------------------------------------------------------------------
+  // Opening the port resets the Arduino: wait for it to come up
+  // --------------------------------------------------------------------------
+  if (waitForBanner) {
+    while (s.port.readLine(line, receivedNs, 3000)) {
+      if (line == "Ready for commands") break;
+    }
+  }
+
+  if (!command(s, "SETTS US", "TIMESTAMP_US")) {
+    fprintf(stderr, "ERROR,No response to SETTS US (firmware too old?)\n");
+    return 1;
+  }
+
+  // --------------------------------------------------------------------------
+  // Initial sync
+  // --------------------------------------------------------------------------
+  for (int i = 0; i < probes; i++) {
+    if (!sendProbe(s)) break;
+    int64_t deadline = s.pendingSentNs + intervalMs * 1000000LL;
+    bool answered = false;
+    while (!answered) {
+      int waitMs = static_cast<int>((deadline - HostClock_NowNs()) / 1000000);
+      if (waitMs < 0 || !s.port.readLine(line, receivedNs, waitMs)) break;
+      answered = handleLine(s, line, receivedNs);
+    }
+    // Pace the probes
+    while (HostClock_NowNs() < deadline && s.port.readLine(line, receivedNs,
+           static_cast<int>((deadline - HostClock_NowNs()) / 1000000))) {
+      handleLine(s, line, receivedNs);
+    }
+  }
+
+  if (!s.clock.synchronized()) {
+    fprintf(stderr, "ERROR,No SYNC replies received\n");
+    return 1;
+  }
+  printMetrics(s.clock.metrics());
+
+  // --------------------------------------------------------------------------
+  // Stream with host timestamps, re-syncing periodically
+  // --------------------------------------------------------------------------
+  if (streamSeconds > 0) {
+    if (!command(s, "START", "RECORDING_STARTED")) {
+      fprintf(stderr, "ERROR,Could not start recording\n");
+      return 1;
+    }
+
+    int64_t endNs = HostClock_NowNs() + static_cast<int64_t>(streamSeconds * 1e9);
+    int64_t nextProbeNs = HostClock_NowNs();
+    while (HostClock_NowNs() < endNs) {
+      int64_t now = HostClock_NowNs();
+      if (now >= nextProbeNs) {
+        // A probe that got no reply is simply replaced
+        sendProbe(s);
+        nextProbeNs = now + intervalMs * 1000000LL;
+      }
+      int waitMs = static_cast<int>((std::min(nextProbeNs, endNs) - now) / 1000000) + 1;
+      if (s.port.readLine(line, receivedNs, waitMs)) handleLine(s, line, receivedNs);
+      else if (!s.port.error().empty()) break;
+    }
+
+    command(s, "STOP", "RECORDING_STOPPED");
+    fflush(stdout);
+    fprintf(stderr, "INFO,Streamed %llu samples\n", static_cast<unsigned long long>(s.samples));
+    if (s.compensation.outside() > 0) {
+      fprintf(stderr, "INFO,%llu samples outside the error map\n",
+              static_cast<unsigned long long>(s.compensation.outside()));
+    }
+    printMetrics(s.clock.metrics());
+  }
+
+  return 0;
+}
@@ -0,0 +1,404 @@
+/*
+ * ============================================================================
+ * CCM_UNCERTAINTY - Per-point measurement uncertainty
+ * ============================================================================
+ *
+ * Usage:
+ *   ccm_uncertainty [options] <input|->
+ *
+ * Options:
+ *   --joints LIST      Joint types, base to tip (default: "yaw pitch pitch pitch")
+ *   --links LIST       Link lengths in mm (default: "254 254 254 35")
+ *   --tool X,Y,Z       Tool offset in mm (default: 0,0,0)
+ *   --cpr N            Encoder counts per revolution (default: 2400)
+ *   --joint-sigma DEG  Extra joint error per axis, 1-sigma (default: 0)
+ *   --link-sigma MM    Link-length tolerance, 1-sigma (default: 0.05)
+ *   --tool-sigma MM    Tool-offset tolerance, 1-sigma (default: 0.02)
+ *   --skip N           Fields before x,y,z (default: 1)
+ *   --fit TYPE         Also fit a plane, line or circle through all points,
+ *                      unweighted and weighted by uncertainty
+ *
+ * Reads lines with x,y,z and the joint angles (degrees), as written by
+ * ccm_sync (host_ns,x,y,z,theta1,...: --skip 1), ccm_record
+ * (seq,timestamp,x,y,z,...: --skip 2), ccm_aggregate (--skip 2) or the
+ * firmware itself (POS,timestamp,x,y,z,...: the POS, is ignored), and
+ * writes each line back with the covariance of its position appended:
+ *
+ *   ...,cxx,cxy,cxz,cyy,cyz,czz          (mm^2)
+ *
+ * Lines that are not samples are passed through unchanged. The model
+ * (--joints, --links, --tool) must be the one the firmware uses, or the
+ * covariances are for another arm; the first samples are checked against
+ * the firmware's x,y,z and a mismatch is reported.
+ *
+ * Input is read as it arrives and every read is processed as one batch
+ * (uncertainty.h), so the tool can sit in a live pipe:
+ *
+ *   ccm_sync --stream 600 /dev/ttyACM0 | ccm_uncertainty - > run.csv
+ *
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../src/geometry_fit.h"
+#include "../src/uncertainty.h"
+
+// Samples checked against the firmware's x,y,z
+static const size_t MODEL_CHECK_SAMPLES = 100;
+// Largest spread of (model - firmware) that still counts as the same model:
+// the difference is the origin offset, constant up to float rounding
+static const double MODEL_CHECK_MM = 0.5;
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: ccm_uncertainty [options] <input|->\n"
+          "  --joints LIST      Joint types (default: \"yaw pitch pitch pitch\")\n"
+          "  --links LIST       Link lengths, mm (default: \"254 254 254 35\")\n"
+          "  --tool X,Y,Z       Tool offset, mm (default: 0,0,0)\n"
+          "  --cpr N            Encoder counts per revolution (default: 2400)\n"
+          "  --joint-sigma DEG  Extra joint error, 1-sigma (default: 0)\n"
+          "  --link-sigma MM    Link-length tolerance, 1-sigma (default: 0.05)\n"
+          "  --tool-sigma MM    Tool-offset tolerance, 1-sigma (default: 0.02)\n"
+          "  --skip N           Fields before x,y,z (default: 1)\n"
+          "  --fit TYPE         Fit plane|line|circle through all points\n");
+}
+
+// ============================================================================
+// BATCH
+// ============================================================================
+struct SampleBatch {
+  std::vector<std::string> lines;   // Input line, or a pass-through line
+  std::vector<int> sample;          // Index into the arrays below, -1 = pass through
+  std::vector<double> xyz[3];
+  std::vector<double> angles;       // angles[axis * capacity + i]
+  size_t samples = 0;
+  size_t capacity = 0;
+
+  void clear() {
+    lines.clear();
+    sample.clear();
+    samples = 0;
+  }
+
+  void reserve(size_t count, int axes) {
+    if (count <= capacity) return;
+    std::vector<double> grown(count * axes);
+    for (int a = 0; a < axes; a++) {
+      std::copy(angles.begin() + a * capacity, angles.begin() + a * capacity + samples,
+                grown.begin() + a * count);
+    }
+    angles.swap(grown);
+    for (auto& v : xyz) v.resize(count);
+    capacity = count;
+  }
+};
+
+// x,y,z and 'axes' angles after 'skip' fields; false if the line is not a sample
+static bool ParseSample(const char* p, int skip, int axes, double* xyz, double* angles) {
+  if (strncmp(p, "POS,", 4) == 0) p += 4;
+  for (int i = 0; i < skip; i++) {
+    p = strchr(p, ',');
+    if (p == nullptr) return false;
+    p++;
+  }
+  for (int i = 0; i < 3 + axes; i++) {
+    if (i > 0) {
+      if (*p != ',') return false;
+      p++;
+    }
+    char* end;
+    double value = strtod(p, &end);
+    if (end == p) return false;
+    if (i < 3) xyz[i] = value;
+    else angles[i - 3] = value;
+    p = end;
+  }
+  return *p == ',' || *p == '\0' || *p == '\r';
+}
+
+// ============================================================================
+// FITS
+// ============================================================================
+static void fitAll(const std::string& type, const std::vector<double> (&xyz)[3],
+                   const PointCovariance& cov) {
+  const double* x = xyz[0].data();
+  const double* y = xyz[1].data();
+  const double* z = xyz[2].data();
+  size_t n = xyz[0].size();
+  std::vector<double> weights(n);
+
+  // Unweighted first; its geometry gives the direction each point's
+  // variance matters in, and the inverse of that variance is its weight
+  if (type == "plane") {
+    PlaneFit plain, weighted;
+    if (!Geometry_FitPlane(x, y, z, n, plain)) {
+      fprintf(stderr, "ERROR,Plane fit failed\n");
+      return;
+    }
+    for (size_t i = 0; i < n; i++) weights[i] = 1.0 / cov.along(i, plain.normal);
+    Geometry_FitPlane(x, y, z, n, weighted, weights.data());
+    for (const PlaneFit* f : {&plain, &weighted}) {
+      fprintf(stderr, "INFO,Plane %s: normal (%.6f, %.6f, %.6f), d %.4f, residual %.4f mm\n",
+              f == &plain ? "unweighted" : "weighted", f->normal[0], f->normal[1], f->normal[2],
+              f->d, f->residual);
+    }
+  } else if (type == "line") {
+    LineFit plain, weighted;
+    if (!Geometry_FitLine(x, y, z, n, plain)) {
+      fprintf(stderr, "ERROR,Line fit failed\n");
+      return;
+    }
+    for (size_t i = 0; i < n; i++) {
+      double across = (cov.xx[i] + cov.yy[i] + cov.zz[i] - cov.along(i, plain.direction)) / 2;
+      weights[i] = 1.0 / across;
+    }
+    Geometry_FitLine(x, y, z, n, weighted, weights.data());
+    for (const LineFit* f : {&plain, &weighted}) {
+      fprintf(stderr,
+              "INFO,Line %s: point (%.4f, %.4f, %.4f), direction (%.6f, %.6f, %.6f), "
+              "residual %.4f mm\n",
+              f == &plain ? "unweighted" : "weighted", f->point[0], f->point[1], f->point[2],
+              f->direction[0], f->direction[1], f->direction[2], f->residual);
+    }
+  } else {
+    CircleFit plain, weighted;
+    if (!Geometry_FitCircle(x, y, z, n, plain)) {
+      fprintf(stderr, "ERROR,Circle fit failed\n");
+      return;
+    }
+    for (size_t i = 0; i < n; i++) {
+      double radial[3] = {x[i] - plain.center[0], y[i] - plain.center[1], 0};
+      double length = std::hypot(radial[0], radial[1]);
+      if (length > 0) {
+        radial[0] /= length;
+        radial[1] /= length;
+      }
+      weights[i] = 1.0 / cov.along(i, radial);
+    }
+    Geometry_FitCircle(x, y, z, n, weighted, weights.data());
+    for (const CircleFit* f : {&plain, &weighted}) {
+      fprintf(stderr, "INFO,Circle %s: center (%.4f, %.4f, %.4f), radius %.4f, residual %.4f mm\n",
+              f == &plain ? "unweighted" : "weighted", f->center[0], f->center[1], f->center[2],
+              f->radius, f->residual);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  ArmModel model;
+  UncertaintyInputs inputs;
+  inputs.linkSigmaMm = 0.05;
+  inputs.toolSigmaMm = 0.02;
+  int skip = 1;
+  std::string fitType;
+  const char* inputPath = nullptr;
+  std::string linkText;
+
+  // --------------------------------------------------------------------------
+  // Parse arguments
+  // --------------------------------------------------------------------------
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--joints") == 0 && hasValue) {
+      if (!ArmModel_ParseJoints(argv[++i], model)) {
+        fprintf(stderr, "ERROR,Joints must be 1-%d of yaw, pitch, roll\n", UNCERTAINTY_MAX_AXES);
+        return 1;
+      }
+    } else if (strcmp(arg, "--links") == 0 && hasValue) {
+      linkText = argv[++i];
+    } else if (strcmp(arg, "--tool") == 0 && hasValue) {
+      if (!ArmModel_ParseNumbers(argv[++i], model.toolOffset, 3)) {
+        fprintf(stderr, "ERROR,Tool offset must be three numbers\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "--cpr") == 0 && hasValue) {
+      inputs.countsPerRevolution = atol(argv[++i]);
+    } else if (strcmp(arg, "--joint-sigma") == 0 && hasValue) {
+      inputs.jointSigmaDeg = atof(argv[++i]);
+    } else if (strcmp(arg, "--link-sigma") == 0 && hasValue) {
+      inputs.linkSigmaMm = atof(argv[++i]);
+    } else if (strcmp(arg, "--tool-sigma") == 0 && hasValue) {
+      inputs.toolSigmaMm = atof(argv[++i]);
+    } else if (strcmp(arg, "--skip") == 0 && hasValue) {
+      skip = atoi(argv[++i]);
+    } else if (strcmp(arg, "--fit") == 0 && hasValue) {
+      fitType = argv[++i];
+      if (fitType != "plane" && fitType != "line" && fitType != "circle") {
+        fprintf(stderr, "ERROR,Unknown fit: %s\n", fitType.c_str());
+        return 1;
+      }
+    } else if (arg[0] == '-' && arg[1] != '\0') {
+      printUsage();
+      return 1;
+    } else if (inputPath == nullptr) {
+      inputPath = arg;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (inputPath == nullptr || skip < 0 || inputs.countsPerRevolution < 1) {
+    printUsage();
+    return 1;
+  }
+  // Links after joints: their count follows --joints
+  if (!linkText.empty() && !ArmModel_ParseNumbers(linkText, model.linkLengths, model.axes)) {
+    fprintf(stderr, "ERROR,Links must be %d numbers (one per joint)\n", model.axes);
+    return 1;
+  }
+
+  int fd = STDIN_FILENO;
+  if (strcmp(inputPath, "-") != 0) {
+    fd = open(inputPath, O_RDONLY);
+    if (fd < 0) {
+      fprintf(stderr, "ERROR,Cannot open %s: %s\n", inputPath, strerror(errno));
+      return 1;
+    }
+  }
+
+  // --------------------------------------------------------------------------
+  // One batch per read
+  // --------------------------------------------------------------------------
+  UncertaintyEngine engine(model, inputs);
+  SampleBatch batch;
+  PointCovariance cov;
+  PointCovariance fitCov;
+  std::vector<double> fitXyz[3];
+  std::vector<double> point(3 + model.axes);
+  std::string pending, output;
+  std::vector<char> chunk(1 << 16);
+
+  uint64_t samples = 0;
+  double sigmaSum = 0, sigmaMin = INFINITY, sigmaMax = 0;
+  double propagateSeconds = 0;
+  double offsetLow[3] = {INFINITY, INFINITY, INFINITY};
+  double offsetHigh[3] = {-INFINITY, -INFINITY, -INFINITY};
+
+  for (;;) {
+    ssize_t got = read(fd, chunk.data(), chunk.size());
+    if (got < 0 && errno == EINTR) continue;
+    if (got < 0) {
+      fprintf(stderr, "ERROR,Read failed: %s\n", strerror(errno));
+      return 1;
+    }
+    if (got > 0) pending.append(chunk.data(), static_cast<size_t>(got));
+    else if (!pending.empty() && pending.back() != '\n') pending += '\n';  // Last line
+
+    // Split complete lines into the batch
+    batch.clear();
+    size_t start = 0, newline;
+    while ((newline = pending.find('\n', start)) != std::string::npos) {
+      batch.lines.emplace_back(pending, start, newline - start);
+      start = newline + 1;
+      std::string& line = batch.lines.back();
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+
+      if (!ParseSample(line.c_str(), skip, model.axes, point.data(), point.data() + 3)) {
+        batch.sample.push_back(-1);
+        continue;
+      }
+      if (batch.samples == batch.capacity) {
+        batch.reserve(std::max<size_t>(1024, batch.capacity * 2), model.axes);
+      }
+      for (int k = 0; k < 3; k++) batch.xyz[k][batch.samples] = point[k];
+      for (int a = 0; a < model.axes; a++) {
+        batch.angles[a * batch.capacity + batch.samples] = point[3 + a];
+      }
+      batch.sample.push_back(static_cast<int>(batch.samples++));
+    }
+    pending.erase(0, start);
+
+    // Propagate the whole batch, then write it back out
+    auto begin = std::chrono::steady_clock::now();
+    engine.propagate(batch.angles.data(), batch.capacity, batch.samples, cov);
+    propagateSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    output.clear();
+    for (size_t i = 0; i < batch.lines.size(); i++) {
+      output += batch.lines[i];
+      int s = batch.sample[i];
+      if (s >= 0) {
+        char tail[128];
+        int n = snprintf(tail, sizeof(tail), ",%.6g,%.6g,%.6g,%.6g,%.6g,%.6g", cov.xx[s],
+                         cov.xy[s], cov.xz[s], cov.yy[s], cov.yz[s], cov.zz[s]);
+        output.append(tail, static_cast<size_t>(std::min<int>(n, sizeof(tail) - 1)));
+
+        double sigma = cov.rms(s);
+        sigmaSum += sigma;
+        sigmaMin = std::min(sigmaMin, sigma);
+        sigmaMax = std::max(sigmaMax, sigma);
+        if (samples < MODEL_CHECK_SAMPLES) {
+          double angles[UNCERTAINTY_MAX_AXES], modelXyz[3];
+          for (int a = 0; a < model.axes; a++) angles[a] = batch.angles[a * batch.capacity + s];
+          engine.position(angles, modelXyz);
+          for (int k = 0; k < 3; k++) {
+            double offset = modelXyz[k] - batch.xyz[k][s];
+            offsetLow[k] = std::min(offsetLow[k], offset);
+            offsetHigh[k] = std::max(offsetHigh[k], offset);
+          }
+        }
+        samples++;
+
+        if (!fitType.empty()) {
+          size_t at = fitXyz[0].size();
+          for (int k = 0; k < 3; k++) fitXyz[k].push_back(batch.xyz[k][s]);
+          fitCov.resize(at + 1);
+          fitCov.xx[at] = cov.xx[s];
+          fitCov.xy[at] = cov.xy[s];
+          fitCov.xz[at] = cov.xz[s];
+          fitCov.yy[at] = cov.yy[s];
+          fitCov.yz[at] = cov.yz[s];
+          fitCov.zz[at] = cov.zz[s];
+        }
+      }
+      output += '\n';
+    }
+    if (!output.empty()) {
+      fwrite(output.data(), 1, output.size(), stdout);
+      fflush(stdout);
+    }
+    if (got == 0) break;
+  }
+  if (fd != STDIN_FILENO) close(fd);
+
+  // --------------------------------------------------------------------------
+  // Summary
+  // --------------------------------------------------------------------------
+  if (samples == 0) {
+    fprintf(stderr, "ERROR,No samples with x,y,z and %d angles after %d field(s)\n", model.axes,
+            skip);
+    return 1;
+  }
+  fprintf(stderr,
+          "INFO,%llu samples, sigma rms min %.4f mm mean %.4f mm max %.4f mm, "
+          "%.0f ns/sample\n",
+          static_cast<unsigned long long>(samples), sigmaMin, sigmaSum / samples, sigmaMax,
+          propagateSeconds * 1e9 / samples);
+
+  double spread = 0;
+  for (int k = 0; k < 3; k++) spread = std::max(spread, offsetHigh[k] - offsetLow[k]);
+  if (spread > MODEL_CHECK_MM) {
+    fprintf(stderr,
+            "INFO,Model does not match the firmware's x,y,z (%.2f mm apart over the first %zu "
+            "samples): check --joints, --links and --tool\n",
+            spread, std::min<size_t>(samples, MODEL_CHECK_SAMPLES));
+  }
+
+  if (!fitType.empty()) fitAll(fitType, fitXyz, fitCov);
+  return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * ============================================================================
+ * POINT OCTREE - WEBASSEMBLY EXPORTS FOR THE APP
+ * ============================================================================
+ *
+ * Plain C functions around one PointOctree, for App/src/point-cloud-lod.js.
+ * Built as a standalone module (no Emscripten JavaScript glue); the app
+ * loads it with WebAssembly.instantiate() and reads node arrays straight
+ * out of the module's memory.
+ *
+ * Data crosses as pointers into that memory:
+ * - octree_input(n) returns room for n points: n * 3 floats, followed by
+ *   n colors (octree_input_colors()); fill them, then octree_insert(n)
+ * - octree_camera() returns the OctreeCamera to fill before octree_select()
+ * - octree_select() leaves the chosen node ids at octree_selected()
+ * - octree_node_positions(id) / octree_node_colors(id) point at a node's
+ *   arrays, octree_node_count(id) points long
+ *
+ * Any call that inserts may grow the memory and move the arrays, so take
+ * pointers again after it.
+ *
+ * ============================================================================
+ */
+
+#include "../src/point_octree.h"
+
+#include <vector>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/emscripten.h>
+#define OCTREE_EXPORT extern "C" EMSCRIPTEN_KEEPALIVE
+#else
+#define OCTREE_EXPORT extern "C"
+#endif
+
+static PointOctree* octree = nullptr;
+static std::vector<float> inputPositions;
+static std::vector<uint32_t> inputColors;
+static OctreeCamera camera;
+static std::vector<uint32_t> selected;
+
+// Cube of half size 'halfSize' around 'center' (mm); see point_octree.h
+OCTREE_EXPORT void octree_init(float centerX, float centerY, float centerZ, float halfSize,
+                               float minSpacing) {
+  float center[3] = {centerX, centerY, centerZ};
+  delete octree;
+  octree = new PointOctree(center, halfSize, minSpacing);
+}
+
+OCTREE_EXPORT void octree_clear() {
+  if (octree != nullptr) octree->clear();
+  selected.clear();
+}
+
+OCTREE_EXPORT float* octree_input(uint32_t count) {
+  if (inputColors.size() < count) {
+    inputPositions.resize(3 * static_cast<size_t>(count));
+    inputColors.resize(count);
+  }
+  return inputPositions.data();
+}
+
+OCTREE_EXPORT uint32_t* octree_input_colors() {
+  return inputColors.data();
+}
+
+OCTREE_EXPORT void octree_insert(uint32_t count) {
+  if (octree == nullptr || count > inputColors.size()) return;
+  octree->insert(inputPositions.data(), inputColors.data(), count);
+}
+
+OCTREE_EXPORT OctreeCamera* octree_camera() {
+  return &camera;
+}
+
+// Returns the number of nodes chosen; their points total at most 'budget'
+OCTREE_EXPORT uint32_t octree_select(float errorPixels, uint32_t budget) {
+  if (octree == nullptr) return 0;
+  octree->select(camera, errorPixels, budget, selected);
+  return static_cast<uint32_t>(selected.size());
+}
+
+OCTREE_EXPORT const uint32_t* octree_selected() {
+  return selected.data();
+}
+
+OCTREE_EXPORT uint32_t octree_node_count(uint32_t node) {
+  if (octree == nullptr || node >= octree->nodeCount()) return 0;
+  return static_cast<uint32_t>(octree->pointCount(node));
+}
+
+OCTREE_EXPORT const float* octree_node_positions(uint32_t node) {
+  if (octree == nullptr || node >= octree->nodeCount()) return nullptr;
+  return octree->positions(node);
+}
+
+OCTREE_EXPORT const uint32_t* octree_node_colors(uint32_t node) {
+  if (octree == nullptr || node >= octree->nodeCount()) return nullptr;
+  return octree->colors(node);
+}
+
+// Points stored and points left out (outside the cube) since the last clear
+OCTREE_EXPORT uint32_t octree_stored() {
+  return octree != nullptr ? static_cast<uint32_t>(octree->stored()) : 0;
+}
+
+OCTREE_EXPORT uint32_t octree_outside() {
+  return octree != nullptr ? static_cast<uint32_t>(octree->outside()) : 0;
+}